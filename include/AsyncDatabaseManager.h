@@ -0,0 +1,273 @@
+#pragma once
+
+#include "Common.h"
+#include "StorageBackend.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <thread>
+
+/**
+ * 取消令牌
+ * 可拷贝，副本共享同一取消状态。排队中的调用不再执行；执行中的调用立即以"操作已取消"完成，
+ * SQLite 语句随即中断，MySQL 已发出的语句在服务端继续执行到结束或到达语句时限
+ */
+class CancellationToken {
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled;
+
+public:
+    CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { *cancelled = true; }
+    bool isCancelled() const { return *cancelled; }
+};
+
+// 单次异步调用的选项
+struct AsyncCallOptions {
+    // 截止时间：到期时调用以超时失败（无论仍在排队还是正在执行）；
+    // 剩余时间同时作为 SQLite 的中断期限和 MySQL 连接的服务端语句时限。0 表示不限
+    std::chrono::milliseconds timeout{0};
+    CancellationToken cancellation;
+};
+
+/**
+ * 数据库专用执行器：固定数量的工作线程从队列中取任务
+ * 关闭时未执行的任务以"执行器已关闭"失败，不会丢失回调
+ */
+class DatabaseExecutor {
+private:
+    // 参数为 false 表示任务不会被执行（执行器关闭），需要以失败结束
+    using Task = std::function<void(bool)>;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<Task> tasks;
+    std::vector<std::thread> workers;
+    bool stopping;
+
+    void workerLoop();
+
+public:
+    explicit DatabaseExecutor(size_t workerCount);
+    ~DatabaseExecutor();
+
+    DatabaseExecutor(const DatabaseExecutor&) = delete;
+    DatabaseExecutor& operator=(const DatabaseExecutor&) = delete;
+
+    bool post(Task task);
+    void shutdown();
+    size_t pendingTasks();
+    size_t workerCount() const { return workers.size(); }
+};
+
+/**
+ * 执行中调用的看门狗：单独的线程在截止时间到达或取消令牌被触发时完成调用，
+ * 等待方不必等工作线程上的语句真正返回
+ */
+class CallWatchdog {
+public:
+    using Expire = std::function<void(const std::string& error)>;
+
+private:
+    struct Entry {
+        std::chrono::steady_clock::time_point deadline;
+        CancellationToken cancellation;
+        Expire expire;
+    };
+
+    std::mutex watchMutex;
+    std::condition_variable watchCondition;
+    std::map<uint64_t, Entry> entries;
+    uint64_t nextId;
+    bool stopping;
+    std::thread watcher;
+
+    void watchLoop();
+
+public:
+    CallWatchdog();
+    ~CallWatchdog();
+
+    CallWatchdog(const CallWatchdog&) = delete;
+    CallWatchdog& operator=(const CallWatchdog&) = delete;
+
+    // 登记一个调用，返回的编号用于 unwatch；expire 在看门狗线程上最多调用一次
+    uint64_t watch(std::chrono::steady_clock::time_point deadline, const CancellationToken& cancellation, Expire expire);
+    void unwatch(uint64_t id);
+    void shutdown();
+};
+
+/**
+ * 存储后端的异步门面
+ * 每个方法把调用投递到数据库执行器并立即返回 future；带 callback 的重载在工作线程上回调，
+ * 调用超时或被取消时在看门狗线程上回调（GUI 中需自行切回主线程，例如 QMetaObject::invokeMethod）。
+ * 每个调用只完成一次：超时后工作线程上迟到的结果被丢弃。
+ * 事务与连接绑定在线程上，不提供单独的 begin/commit 异步方法：
+ * 需要事务时用 submit() 在同一个任务里完成 begin..commit
+ */
+class AsyncDatabaseManager {
+private:
+    StorageBackend* dbManager;
+    CallWatchdog watchdog;           // 先于执行器构造、后于执行器析构，工作线程退出前看门狗一直可用
+    DatabaseExecutor executor;
+
+public:
+    AsyncDatabaseManager(StorageBackend* dbManager, size_t workerCount = 4);
+    ~AsyncDatabaseManager();
+
+    AsyncDatabaseManager(const AsyncDatabaseManager&) = delete;
+    AsyncDatabaseManager& operator=(const AsyncDatabaseManager&) = delete;
+
+    void shutdown();
+    size_t pendingTasks() { return executor.pendingTasks(); }
+
+    // 通用提交：operation 在工作线程上以存储后端为参数执行
+    template<typename T>
+    std::future<Result<T>> submit(std::function<Result<T>(StorageBackend&)> operation,
+                                  const AsyncCallOptions& options = AsyncCallOptions());
+
+    template<typename T>
+    void submit(std::function<Result<T>(StorageBackend&)> operation,
+                std::function<void(const Result<T>&)> callback,
+                const AsyncCallOptions& options = AsyncCallOptions());
+
+    // User operations
+    std::future<Result<User>> createUser(const std::string& username, const std::string& passwordHash,
+                                         const std::string& email, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<User>> getUserById(int userId, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<User>> getUserByUsername(const std::string& username, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<User>>> getAllUsers(int limit = 100, int offset = 0,
+                                                       const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> updateUser(const User& user, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> deleteUser(int userId, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> updateUserLastLogin(int userId, const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Document operations
+    std::future<Result<Document>> createDocument(const std::string& title, const std::string& description,
+                                                 const std::string& filePath, const std::string& minioKey,
+                                                 int ownerId, size_t fileSize, const std::string& contentType,
+                                                 const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<Document>> getDocumentById(int docId, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<Document>>> getDocumentsByOwner(int ownerId, int limit = 100, int offset = 0,
+                                                                   const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<Document>>> getAllDocuments(int limit = 100, int offset = 0,
+                                                               const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> updateDocument(const Document& doc, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> deleteDocument(int docId, const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Document sharing operations
+    std::future<Result<DocumentShare>> createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
+                                                           int sharedDocumentId, const std::string& sharedMinioKey,
+                                                           const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<Document>>> getSharedDocuments(int userId, int limit = 100, int offset = 0,
+                                                                  const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<DocumentShare>>> getDocumentShares(int documentId, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> deleteDocumentShare(int shareId, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<bool>> isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId,
+                                               const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Batch operations
+    std::future<Result<std::vector<int>>> createUsersBatch(const std::vector<User>& users, size_t chunkSize = 500,
+                                                           const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<int>>> createDocumentsBatch(const std::vector<Document>& documents, size_t chunkSize = 500,
+                                                               const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Keyset pagination
+    std::future<Result<Page<User>>> getUsersPage(int pageSize, const std::string& pageToken = "",
+                                                 const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<Page<Document>>> getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken = "",
+                                                                const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<Page<Document>>> getAllDocumentsPage(int pageSize, const std::string& pageToken = "",
+                                                            const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<Page<Document>>> getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken = "",
+                                                               const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Streaming operations（visitor 在工作线程上被调用）
+    std::future<Result<size_t>> forEachUser(UserVisitor visitor, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<size_t>> forEachDocument(const DocumentFilter& filter, DocumentVisitor visitor,
+                                                const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Search operations
+    std::future<Result<std::vector<User>>> searchUsers(const std::string& query, int limit = 50,
+                                                       const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<std::vector<Document>>> searchDocuments(const std::string& query, const DocumentSearchOptions& searchOptions,
+                                                               const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<size_t>> rebuildSearchIndex(const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Statistics
+    std::future<Result<int>> getUserCount(const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<int>> getDocumentCount(const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<size_t>> getTotalFileSize(const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<UsageStats>> getUsageStats(int ownerId = 0, const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<size_t>> reconcileUsageStats(const AsyncCallOptions& options = AsyncCallOptions());
+
+    // Utility
+    std::future<Result<bool>> vacuum(const AsyncCallOptions& options = AsyncCallOptions());
+    std::future<Result<QueryResult>> executeQuery(const std::string& query, const AsyncCallOptions& options = AsyncCallOptions());
+};
+
+// ================== 模板实现 ==================
+
+template<typename T>
+void AsyncDatabaseManager::submit(std::function<Result<T>(StorageBackend&)> operation,
+                                  std::function<void(const Result<T>&)> callback,
+                                  const AsyncCallOptions& options) {
+    auto deadline = options.timeout.count() > 0
+                    ? std::chrono::steady_clock::now() + options.timeout
+                    : std::chrono::steady_clock::time_point::max();
+    CancellationToken cancellation = options.cancellation;
+    StorageBackend* db = dbManager;
+    CallWatchdog* guard = &watchdog;
+
+    // 工作线程与看门狗谁先完成调用谁生效，另一方的结果被丢弃
+    auto finished = std::make_shared<std::atomic<bool>>(false);
+    auto finish = [finished, callback](const Result<T>& result) {
+        if (!finished->exchange(true) && callback) {
+            callback(result);
+        }
+    };
+    uint64_t watchId = watchdog.watch(deadline, cancellation, [finish](const std::string& error) {
+        finish(Result<T>::Error(error));
+    });
+
+    bool posted = executor.post([db, guard, watchId, operation, finish, finished, deadline, cancellation](bool run) {
+        Result<T> result = Result<T>::Error("执行器已关闭");
+        if (run && !finished->load()) {
+            if (cancellation.isCancelled()) {
+                result = Result<T>::Error("操作已取消");
+            } else if (std::chrono::steady_clock::now() >= deadline) {
+                result = Result<T>::Error("操作超时（排队超过截止时间）");
+            } else {
+                CallDeadline scope(deadline, [cancellation] { return cancellation.isCancelled(); });
+                try {
+                    result = operation(*db);
+                } catch (const std::exception& e) {
+                    result = Result<T>::Error("数据库操作异常: " + std::string(e.what()));
+                }
+            }
+        }
+        guard->unwatch(watchId);
+        finish(result);
+    });
+
+    if (!posted) {
+        watchdog.unwatch(watchId);
+        finish(Result<T>::Error("执行器已关闭"));
+    }
+}
+
+template<typename T>
+std::future<Result<T>> AsyncDatabaseManager::submit(std::function<Result<T>(StorageBackend&)> operation,
+                                                    const AsyncCallOptions& options) {
+    auto promise = std::make_shared<std::promise<Result<T>>>();
+    std::future<Result<T>> future = promise->get_future();
+    submit<T>(std::move(operation), [promise](const Result<T>& result) {
+        promise->set_value(result);
+    }, options);
+    return future;
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Common.h"
-#include "DatabaseManager.h"
+#include "StorageBackend.h"
 #include "RedisManager.h"
 #include <mutex>
 
@@ -11,7 +11,7 @@
  */
 class AuthManager {
 private:
-    DatabaseManager* dbManager;                                    // 数据库管理器指针
+    StorageBackend* dbManager;                                     // 存储后端指针
     RedisManager* redisManager;                                    // Redis管理器指针
     std::map<std::string, Session> activeSessions;                // 活跃会话映射表 (会话令牌 -> 会话信息) - 本地缓存
     std::map<std::string, int> loginAttempts;                     // 登录尝试次数映射表 (IP/用户名 -> 尝试次数)
@@ -68,7 +68,7 @@ public:
      * @param db 数据库管理器指针
      * @param redis Redis管理器指针（可选）
      */
-    explicit AuthManager(DatabaseManager* db, RedisManager* redis = nullptr);
+    explicit AuthManager(StorageBackend* db, RedisManager* redis = nullptr);
     
     /**
      * 析构函数
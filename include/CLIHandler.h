@@ -3,6 +3,11 @@
 #include "Common.h"
 #include "AuthManager.h"
 #include "DatabaseManager.h"
+#include "SqliteStorageBackend.h"
+#include "StorageBenchmark.h"
+#include "RespBenchmark.h"
+#include "RowDecodeBenchmark.h"
+#include "AsyncDatabaseManager.h"
 #include "RedisManager.h"
 #include "MinioClient.h"
 #include "ImportExportManager.h"
@@ -27,8 +32,11 @@ class CLIHandler {
 private:
     // ==================== 私有成员变量 ====================
 
-    /** @brief 数据库管理器 - 负责所有数据库操作 */
-    std::unique_ptr<DatabaseManager> dbManager;
+    /** @brief 存储后端 - 负责所有数据库操作，按 database.type 创建 MySQL 或 SQLite 实现 */
+    std::unique_ptr<StorageBackend> dbManager;
+
+    /** @brief 异步数据库门面 - 在专用线程上执行数据库调用，便于与MinIO/Redis I/O并行（须在dbManager之后声明） */
+    std::unique_ptr<AsyncDatabaseManager> asyncDbManager;
 
     /** @brief 认证管理器 - 负责用户登录、注册、会话管理 */
     std::unique_ptr<AuthManager> authManager;
@@ -81,7 +89,10 @@ public:
     MinioClient* getMinioClient() const { return minioClient.get(); }
 
     /** @brief 获取数据库管理器实例 */
-    DatabaseManager* getDbManager() const { return dbManager.get(); }
+    StorageBackend* getDbManager() const { return dbManager.get(); }
+
+    /** @brief 获取异步数据库门面 - 数据库连接成功前为nullptr */
+    AsyncDatabaseManager* getAsyncDbManager() const { return asyncDbManager.get(); }
 
     /** @brief 获取认证管理器实例 */
     AuthManager* getAuthManager() const { return authManager.get(); }
@@ -98,9 +109,12 @@ public:
 
     // ==================== GUI数据提供方法 ====================
 
-    /** @brief 获取所有用户列表 - 供GUI界面显示 */
+    /** @brief 获取所有用户列表（不分页、不截断） - 供GUI界面显示 */
     std::vector<User> getAllUsersForUI();
 
+    /** @brief 逐个回调所有用户 - 供大表场景的GUI列表流式填充，回调返回false停止；返回遍历的用户数 */
+    size_t forEachUserForUI(const UserVisitor& visitor);
+
     /** @brief 根据关键词搜索用户 - 供GUI搜索功能使用 */
     std::vector<User> getSearchedUsersForUI(const std::string& keyword);
 
@@ -110,12 +124,24 @@ public:
     /** @brief 获取指定用户的文档列表 - 供GUI文档管理使用 */
     std::vector<Document> getUserDocsForUI(int userId);
 
-    /** @brief 搜索指定用户的文档 - 根据关键词过滤用户文档 */
-    std::vector<Document> getSearchedDocsForUI(int userId, const std::string& keyword);
+    /** @brief 按页获取指定用户的文档 - pageToken为空取第一页，nextPageToken为空表示没有更多 */
+    std::vector<Document> getUserDocsForUI(int userId, const std::string& pageToken, std::string& nextPageToken, int pageSize = 100);
+
+    /** @brief 搜索指定用户的文档 - 全文检索按相关度排序，limit/offset分页 */
+    std::vector<Document> getSearchedDocsForUI(int userId, const std::string& keyword, int limit = 100, int offset = 0);
+
+    /** @brief 即时搜索指定用户的文档 - 查内存倒排索引（子串匹配），索引未就绪时回退到数据库搜索 */
+    std::vector<Document> quickSearchDocsForUI(int userId, const std::string& keyword, int limit = 100);
 
     /** @brief 获取分享给指定用户的文档列表 */
     std::vector<Document> getSharedDocsForUI(int userId);
 
+    /** @brief 获取各数据库方法的查询统计与最近的慢查询 - 当前后端不收集统计时返回false */
+    bool getQueryStatsForUI(std::vector<QueryMethodStats>& stats, std::vector<SlowQueryRecord>& slowQueries);
+
+    /** @brief 清零查询统计与慢查询日志 */
+    void resetQueryStatsForUI();
+
     // ==================== 输出格式化方法 ====================
 
     /** @brief 打印用户信息 - 格式化输出用户详细信息 */
@@ -167,8 +193,8 @@ public:
     /** @brief 获取文档详情 - 根据文档ID显示详细信息 */
     bool handleGetDocument(int docId);
 
-    /** @brief 列出文档 - 分页显示当前用户的文档列表 */
-    bool handleListDocuments(int limit = 50, int offset = 0);
+    /** @brief 列出文档 - 按创建时间倒序分页显示当前用户的文档，pageToken为上一页输出的令牌，includeArchived 时包含已归档的文档（仅 MySQL） */
+    bool handleListDocuments(int limit = 50, const std::string& pageToken = "", bool includeArchived = false);
 
     /** @brief 更新文档 - 修改文档标题、描述或替换文件 */
     bool handleUpdateDocument(int docId, const std::string& title, const std::string& description, const std::string& newFilePath = "");
@@ -182,8 +208,8 @@ public:
     /** @brief 分享文档 - 将文档分享给指定用户 */
     bool handleShareDocument(int docId, const std::string& targetUsername);
 
-    /** @brief 列出分享文档 - 显示分享给当前用户的文档 */
-    bool handleListSharedDocuments(int limit = 50, int offset = 0);
+    /** @brief 列出分享文档 - 显示分享给当前用户的文档，includeArchived 时包含已归档的分享（仅 MySQL） */
+    bool handleListSharedDocuments(int limit = 50, const std::string& pageToken = "", bool includeArchived = false);
 
     // ==================== 文件管理命令 ====================
 
@@ -196,6 +222,24 @@ public:
     /** @brief 检查MinIO状态 - 显示MinIO连接和存储状态 */
     bool handleMinioStatus();
 
+    /** @brief 检查Redis状态 - 显示连接池、重连与熔断计数 */
+    bool handleRedisStatus();
+
+    // ==================== 诊断命令 ====================
+
+    /** @brief 输出数据库查询统计 - 各方法的延迟分位数、行数、字节数及最近的慢查询，reset为true时输出后清零 */
+    bool handleQueryStats(bool reset = false);
+
+    /** @brief 存储层基准测试 - 生成测试数据并压测各方法，结果写入outputFile；baselineFile非空时与之对比吞吐 */
+    bool handleBenchmark(const BenchmarkOptions& options, const std::string& outputFile,
+                         const std::string& baselineFile = "");
+
+    /** @brief RESP解析器基准测试 - 校验随机切分与畸形数据下的解析结果并测吞吐，不需要连接Redis */
+    bool handleRespBenchmark(const RespBenchmarkOptions& options);
+
+    /** @brief 结果行解码基准测试 - 用合成的文本协议行对比旧的stoi映射与RowDecoder的吞吐，不需要连接数据库 */
+    bool handleRowDecodeBenchmark(const RowDecodeBenchmarkOptions& options);
+
     // ==================== Excel导入导出功能 ====================
 
     /** @brief 导出用户数据到Excel - 将所有用户信息导出为Excel文件 */
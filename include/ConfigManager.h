@@ -19,11 +19,40 @@ public:
     // Database configuration
     std::string getDatabaseType() const;
     std::string getSqliteFilename() const;
+    long long getSqliteMmapSize() const;
+    int getSqliteBusyTimeout() const;
+    int getSqliteReadConnections() const;
+    int getSqliteStatementCacheSize() const;
     std::string getMysqlHost() const;
     int getMysqlPort() const;
     std::string getMysqlUsername() const;
     std::string getMysqlPassword() const;
     std::string getMysqlDatabase() const;
+    int getMysqlPoolMinSize() const;
+    int getMysqlPoolMaxSize() const;
+    int getMysqlPoolIdleTimeout() const;
+    int getMysqlPoolCheckoutTimeout() const;
+    int getMysqlPoolHealthCheckInterval() const;
+    int getMysqlStatementCacheSize() const;
+    int getMysqlBatchInsertSize() const;
+    int getMysqlAsyncWorkers() const;
+    int getMysqlStatsReconcileInterval() const;
+    json getMysqlReplicas() const;
+    int getMysqlReplicaHealthCheckInterval() const;
+    int getMysqlReplicaMaxLag() const;
+    int getMysqlReadYourWritesWindow() const;
+    int getMysqlSlowQueryThreshold() const;
+    bool getMysqlExplainSlowQueries() const;
+    int getMysqlSlowQueryLogSize() const;
+    int getMysqlArchiveInterval() const;
+    int getMysqlArchiveHotDays() const;
+    int getMysqlArchiveBatchSize() const;
+    int getMysqlArchivePause() const;
+    int getMysqlArchiveMaxBatches() const;
+    int getPurgeInterval() const;
+    int getPurgeBatchSize() const;
+    int getPurgePause() const;
+    int getPurgeMaxBatches() const;
 
     // Redis configuration
     std::string getRedisHost() const;
@@ -31,6 +60,15 @@ public:
     std::string getRedisPassword() const;
     int getRedisDatabase() const;
     int getRedisTimeout() const;
+    int getRedisPoolMinSize() const;
+    int getRedisPoolMaxSize() const;
+    int getRedisPoolCheckoutTimeout() const;
+    int getRedisPoolHealthCheckInterval() const;
+    int getRedisBreakerThreshold() const;
+    int getRedisBackoffInitial() const;
+    int getRedisBackoffMax() const;
+    bool getRedisAsyncEnabled() const;
+    int getRedisAsyncMaxPending() const;
 
     // MinIO configuration
     std::string getMinioEndpoint() const;
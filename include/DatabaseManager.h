@@ -1,71 +1,331 @@
 #pragma once
 
 #include "Common.h"
+#include "StorageBackend.h"
+#include "MySqlConnectionPool.h"
+#include "RowDecoder.h"
+#include "QueryStats.h"
 #include <mysql/mysql.h>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
 
-class DatabaseManager {
+// 只读副本地址（对应 config.json 中 database.mysql.replication.replicas 的一项）
+struct MySqlReplicaEndpoint {
+    std::string host;
+    int port = 3306;
+    std::string username;
+    std::string password;
+    std::string database;
+};
+
+// 读写分离配置：副本为空时所有读写都走主库
+struct MySqlReplicationOptions {
+    std::vector<MySqlReplicaEndpoint> replicas;
+    int healthCheckSeconds = 5;      // 副本健康检查间隔
+    int maxLagSeconds = 30;          // 复制延迟超过该值的副本暂停接收读流量，0 表示不检查延迟
+    int readYourWritesMs = 2000;     // 写入提交后该时间内的读仍走主库，保证读到自己刚写的数据
+};
+
+// 读写分离运行统计
+struct MySqlReplicationStats {
+    int replicas = 0;
+    int healthyReplicas = 0;
+    uint64_t replicaReads = 0;       // 路由到副本的读
+    uint64_t primaryReads = 0;       // 可路由但留在主库的读（事务中、写后窗口内或没有可用副本）
+};
+
+// 冷数据归档配置（对应 config.json 中的 database.mysql.archive）
+struct MySqlArchiveOptions {
+    int hotDays = 365;               // 创建早于该天数、且涉及的分享也都早于该天数的文档移入归档表
+    int batchSize = 500;             // 每个事务移动的文档数
+    int pauseMs = 200;               // 批次之间的停顿，给在线事务让出行锁与 IO
+    int maxBatches = 200;            // 单次运行最多执行的批数，0 表示直到没有可归档的文档
+};
+
+// 一次归档运行的结果
+struct MySqlArchiveStats {
+    size_t documents = 0;
+    size_t shares = 0;
+    size_t batches = 0;
+    bool completed = false;          // 已没有可归档的文档（没有因 maxBatches 或被要求停止而中断）
+};
+
+/**
+ * MySQL 存储后端
+ * 连接池 + 线程绑定的事务连接；热点查询走服务端预处理语句缓存。
+ * 配置了只读副本时，get 系列、search 系列与统计读取按轮询分发到健康副本；写入、事务内的读
+ * 以及写入后 readYourWritesMs 内的读留在主库。isDocumentShared 是写前检查，固定读主库
+ */
+class DatabaseManager : public StorageBackend {
 private:
-    MYSQL* db;
-    std::recursive_mutex dbMutex;
-    bool isConnected;
+    std::unique_ptr<MySqlConnectionPool> pool;
+    std::atomic<bool> isConnected;
+    std::atomic<bool> fulltextSearchEnabled;   // documents 上的 ngram 全文索引是否就绪
+
+    // 事务期间连接绑定到发起事务的线程，保证 begin/commit 之间的语句落在同一连接上
+    std::mutex transactionMutex;
+    std::unordered_map<std::thread::id, PooledConnection> transactionConnections;
+
+    // 文档元数据的内存倒排索引；事务中的变更暂存到提交后再应用
+    DocumentSearchIndex searchIndex;
+    std::unordered_map<std::thread::id, std::vector<std::function<void()>>> pendingIndexChanges;
+    // 各线程事务中的保存点及建立时暂存索引变更的条数，回滚到保存点时据此丢弃之后的变更
+    std::unordered_map<std::thread::id, std::vector<std::pair<std::string, size_t>>> savepointMarks;
+    void applyIndexChange(std::function<void()> change);
+
+    // 每次调用借用一条连接；当前线程处于事务中时返回事务连接
+    PooledConnection acquireConnection();
+    // 当前线程的调用带截止时间（见 CallDeadline）时，把剩余时间设为连接的服务端语句时限
+    void applyCallDeadline(PooledConnection& conn);
+
+    // 只读副本：连接池建立后不再替换（直到断开），healthy 由健康检查线程和读路径共同维护
+    struct Replica {
+        MySqlReplicaEndpoint endpoint;
+        std::unique_ptr<MySqlConnectionPool> pool;
+        std::atomic<bool> healthy{false};
+        bool failureReported = false;    // 只由健康检查线程访问，避免不可用期间重复告警
+        bool lagUnknownReported = false;
+        std::string label() const { return endpoint.host + ":" + std::to_string(endpoint.port); }
+    };
+    MySqlReplicationOptions replication;
+    MySqlPoolOptions replicaPoolOptions;
+    std::vector<std::unique_ptr<Replica>> replicas;
+    std::atomic<size_t> nextReplica;
+    std::atomic<uint64_t> replicaReadCount;
+    std::atomic<uint64_t> primaryReadCount;
+
+    // 最近一次写入提交的时间（steady_clock 纳秒）。本进程即一个用户会话，
+    // 异步门面会把同一会话的读写分派到不同工作线程，所以按进程而不是按线程记录
+    std::atomic<long long> lastWriteAt;
+    void noteWrite();
+    bool withinReadYourWritesWindow() const;
+
+    std::thread replicaMonitor;
+    std::mutex replicaMonitorMutex;
+    std::condition_variable replicaMonitorWakeup;
+    bool replicaMonitorStopping;
+    void replicaMonitorLoop();
+    void checkReplica(Replica& replica);
+    void setReplicaHealth(Replica& replica, bool healthy, const std::string& reason);
+    void stopReplicas();
+
+    // 从健康副本中轮询借一条连接；事务中、写后窗口内或没有可用副本时返回空句柄
+    PooledConnection acquireReplicaConnection();
+    // 只读方法使用：优先副本，否则同 acquireConnection
+    PooledConnection acquireReadConnection();
+
+    // 从当前连接的语句缓存取预处理语句；执行失败时按错误码决定是否丢弃缓存
+    MYSQL_STMT* acquireStatement(PooledConnection& conn, const std::string& sql);
+    void handleStatementError(PooledConnection& conn, const std::string& sql, const BoundStatement& stmt);
+
+    // 各公开方法的延迟、行数与字节数；超过阈值的调用记入慢查询日志并 EXPLAIN 其最后一条语句
+    QueryStatsRegistry queryStats;
+    std::string explainStatement(const std::string& sql, const std::vector<QueryParameter>& params);
 
-    bool createTables();
+    // 以 mysql_use_result 逐行读取结果，内存占用与结果集大小无关；返回访问过的行数。
+    // allowReplica 为 false 时固定读主库（重建内存索引必须与已提交的写入一致）
+    Result<size_t> streamQuery(const std::string& sql, const std::function<bool(const RowDecoder&)>& visitor,
+                               bool allowReplica = true);
+    // includeArchived 时先遍历归档表再遍历在线表，两段各自有序
+    Result<size_t> streamDocuments(const DocumentFilter& filter, const DocumentVisitor& visitor, bool allowReplica,
+                                   bool includeArchived = false);
+
+    // 执行一页键集查询：按 keyPrefix 表的 (created_at, id) 倒序，onRow 依次收到本页的行，返回下一页令牌。
+    // archiveFrom 非空时与 from 各取一页再合并（两者列名相同）。fromCondition/archiveCondition 为各表自身的
+    // 可见条件（不含参数，可为空），filter 两张表共用
+    Result<std::string> fetchKeysetPage(const std::string& columns, const std::string& from, const std::string& fromCondition,
+                                        const std::string& archiveFrom, const std::string& archiveCondition,
+                                        const std::string& filter, int filterId, const std::string& keyPrefix,
+                                        int pageSize, const std::string& pageToken,
+                                        const std::function<void(const BoundStatement&)>& onRow);
+
+    // 多行 INSERT：每 chunkSize 行拼成一条语句，在调用方 runInTransaction 的连接 db 上执行，返回自增ID
+    Result<std::vector<int>> insertBatch(MYSQL* db, const std::string& insertPrefix, size_t rowCount, size_t chunkSize,
+                                         const std::function<std::string(MYSQL*, size_t)>& rowValues);
+
+    // 在事务中执行 body：调用方已开启事务时直接加入，否则经 runTransaction 自行开启，
+    // body 失败回滚、成功提交，遇到死锁或锁等待超时时整体重试
+    template<typename T>
+    Result<T> runInTransaction(const std::function<Result<T>(PooledConnection&)>& body);
+
+    // usage_stats 增量：键为 owner_id（0 为全局），按键升序写入以固定加锁顺序
+    bool applyStatsDeltas(MYSQL* db, const std::map<int, UsageStats>& deltas);
+    // 统计即将被删除的分享记录（where 为 document_shares 上的条件），计入双方及全局增量并加锁；
+    // 已软删除的一方其统计行已在删除用户时整行扣除，不再计入
+    bool collectShareDeltas(MYSQL* db, const std::string& where, std::map<int, UsageStats>& deltas);
+    // 读取并锁定一个 owner_id 的统计行，行不存在时计数均为0
+    Result<UsageStats> lockUsageStats(MYSQL* db, int ownerId);
+    // 按明细表计算 owner_id 在 [low, high] 内的统计，与 usage_stats 中的值比较，把差值计入 deltas；
+    // high 为 0 时只算全局行。只做普通查询，由调用方放在一致性快照中执行
+    bool collectStatsDrift(MYSQL* db, long long low, long long high, std::map<int, UsageStats>& deltas);
+
+    // 结构迁移：按版本号递增执行；DDL 会隐式提交，每一步都必须可重复执行（中途失败后下次连接从该步重来）
+    struct SchemaMigration {
+        int version;
+        std::string description;
+        std::function<bool(MYSQL*)> apply;
+    };
+    std::vector<SchemaMigration> schemaMigrations();
+    // 连接时只用一条查询读出 schema_migrations 的当前版本，落后时才加锁执行迁移
+    bool migrateSchema(MYSQL* db);
+    bool readSchemaVersion(MYSQL* db, int& version);
+    bool createTables(MYSQL* db);
+    // excludeDeletedUsers 时排除软删除的用户；迁移 2 执行时 users 还没有 deleted_at 列，由迁移 9 重建视图
+    bool createUserPermissionsView(MYSQL* db, bool excludeDeletedUsers);
+    // 收件箱表：分享副本的列表字段按 (shared_to_user_id, created_at, id) 聚簇存放，并从已有分享回填
+    bool createShareInbox(MYSQL* db);
+    // 归档表按 created_at 的月份 RANGE 分区，初始只有 p_max；归档前为截止时间之前缺少的月份补建分区
+    bool createArchiveTables(MYSQL* db);
+    bool ensureArchivePartitions(MYSQL* db, const std::string& table, const std::string& cutoff);
+    // 移动一批冷文档：cursor 为本次运行已处理到的 (created_at, id)，成功后前移
+    Result<MySqlArchiveStats> archiveBatch(const std::string& cutoff, int batchSize,
+                                           std::string& cursorCreatedAt, long long& cursorId);
+    // 清理一批软删除的数据：依次删除涉及已删除用户或文档的分享、归档分享、文档（先删文件再删行）和
+    // 已没有文档的用户，前一步还有积压时不进入下一步
+    Result<PurgeStats> purgeBatch(int batchSize, const ObjectRemover& removeObject);
+    // 各删除至多 batchSize 条，返回删除的行数
+    Result<size_t> purgeShares(int batchSize);
+    Result<size_t> purgeArchivedShares(int batchSize);
+    bool ensureIndex(MYSQL* db, const std::string& table, const std::string& indexName, const std::string& columns,
+                     const std::string& indexKind = "INDEX", const std::string& indexOptions = "");
+    bool ensureColumn(MYSQL* db, const std::string& table, const std::string& column, const std::string& definition);
+    Result<User> fetchUserById(PooledConnection& conn, int userId);
+    Result<Document> fetchDocumentById(PooledConnection& conn, int docId);
     std::string getLastError() const;
 
 public:
     DatabaseManager();
-    ~DatabaseManager();
+    ~DatabaseManager() override;
 
     bool connect(const std::string& host, int port, const std::string& username, 
-                 const std::string& password, const std::string& database);
-    void disconnect();
-    bool isConnectionValid() const;
+                 const std::string& password, const std::string& database,
+                 const MySqlPoolOptions& poolOptions = MySqlPoolOptions(),
+                 const MySqlReplicationOptions& replicationOptions = MySqlReplicationOptions());
+    std::string backendName() const override { return "MySQL"; }
+    void disconnect() override;
+    bool isConnectionValid() const override;
+    MySqlPoolStats getPoolStats() const;
+    StatementCacheStats getStatementCacheStats() const;
+    MySqlReplicationStats getReplicationStats() const;
+
+    // 查询统计：按累计耗时从高到低排列；forEach 系列的耗时包含回调本身
+    void setQueryProfiling(const QueryProfilingOptions& options) { queryStats.configure(options); }
+    QueryProfilingOptions getQueryProfiling() const { return queryStats.getOptions(); }
+    std::vector<QueryMethodStats> getQueryStats() const { return queryStats.snapshot(); }
+    std::vector<SlowQueryRecord> getSlowQueries() const { return queryStats.slowQueries(); }
+    void resetQueryStats() { queryStats.reset(); }
 
     // User operations
     Result<User> createUser(const std::string& username, const std::string& passwordHash,
-                            const std::string& email);
-    Result<User> getUserById(int userId);
-    Result<User> getUserByUsername(const std::string& username);
-    Result<std::vector<User>> getAllUsers(int limit = 100, int offset = 0);
-    Result<bool> updateUser(const User& user);
-    Result<bool> deleteUser(int userId);
-    Result<bool> updateUserLastLogin(int userId);
+                            const std::string& email) override;
+    Result<User> getUserById(int userId) override;
+    Result<User> getUserByUsername(const std::string& username) override;
+    Result<std::vector<User>> getAllUsers(int limit = 100, int offset = 0) override;
+    Result<bool> updateUser(const User& user) override;
+    Result<bool> deleteUser(int userId) override;
+    Result<bool> updateUserLastLogin(int userId) override;
 
     // Document operations
     Result<Document> createDocument(const std::string& title, const std::string& description,
                                     const std::string& filePath, const std::string& minioKey,
-                                    int ownerId, size_t fileSize, const std::string& contentType);
+                                    int ownerId, size_t fileSize, const std::string& contentType) override;
 
-    Result<Document> getDocumentById(int docId);
-    Result<std::vector<Document>> getDocumentsByOwner(int ownerId, int limit = 100, int offset = 0);
-    Result<std::vector<Document>> getAllDocuments(int limit = 100, int offset = 0);
-    Result<bool> updateDocument(const Document& doc);
-    Result<bool> deleteDocument(int docId);
+    Result<Document> getDocumentById(int docId) override;
+    Result<std::vector<Document>> getDocumentsByOwner(int ownerId, int limit = 100, int offset = 0) override;
+    Result<std::vector<Document>> getAllDocuments(int limit = 100, int offset = 0) override;
+    Result<bool> updateDocument(const Document& doc) override;
+    Result<bool> deleteDocument(int docId) override;
 
     // Document sharing operations
     Result<DocumentShare> createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
-                                              int sharedDocumentId, const std::string& sharedMinioKey);
-    Result<std::vector<Document>> getSharedDocuments(int userId, int limit = 100, int offset = 0);
-    Result<std::vector<DocumentShare>> getDocumentShares(int documentId);
-    Result<bool> deleteDocumentShare(int shareId);
-    Result<bool> isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId);
+                                              int sharedDocumentId, const std::string& sharedMinioKey) override;
+    Result<std::vector<Document>> getSharedDocuments(int userId, int limit = 100, int offset = 0) override;
+    Result<std::vector<DocumentShare>> getDocumentShares(int documentId) override;
+    Result<bool> deleteDocumentShare(int shareId) override;
+    Result<bool> isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId) override;
+
+    // Batch operations
+    // 使用 User 的 username/password_hash/email 与 Document 的可写字段；任一行失败则整批回滚。
+    // 返回的ID与输入顺序一致；若当前线程已在事务中则并入该事务
+    Result<std::vector<int>> createUsersBatch(const std::vector<User>& users, size_t chunkSize = 500) override;
+    Result<std::vector<int>> createDocumentsBatch(const std::vector<Document>& documents, size_t chunkSize = 500) override;
+
+    // Keyset pagination
+    // 按 (created_at, id) 从新到旧翻页，每页都是一次有界的索引范围扫描；
+    // pageToken 传上一页返回的 nextPageToken，空串表示第一页
+    Result<Page<User>> getUsersPage(int pageSize, const std::string& pageToken = "") override;
+    Result<Page<Document>> getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken = "") override;
+    Result<Page<Document>> getAllDocumentsPage(int pageSize, const std::string& pageToken = "") override;
+    Result<Page<Document>> getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken = "") override;
+
+    // Streaming operations
+    // 按 id 顺序逐行回调，不把结果集整体装入内存。遍历期间独占一条池连接，
+    // 回调内可以调用其他 DatabaseManager 方法，但应尽快返回以免服务端写超时
+    Result<size_t> forEachUser(const UserVisitor& visitor) override;
+    Result<size_t> forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor) override;
+
+    // 以上列表与遍历只读在线表；includeArchived 为 true 时同时读取归档表（各取一页再合并，代价更高），
+    // 为 false 时与同名的接口方法相同
+    Result<Page<Document>> getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken, bool includeArchived);
+    Result<Page<Document>> getAllDocumentsPage(int pageSize, const std::string& pageToken, bool includeArchived);
+    Result<Page<Document>> getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken, bool includeArchived);
+    Result<size_t> forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor, bool includeArchived);
+
+    // Archive
+    // 把冷文档及涉及它们的分享分批移入 documents_archive / document_shares_archive：每批一个事务，
+    // 批间停顿 pauseMs；shouldContinue 返回 false 时在批次之间停止。归档的分享保留归档时副本的列表字段。
+    // usage_stats 与内存索引只覆盖在线表，归档视同移出；删除用户后其归档数据由 purgeDeleted 清理。
+    // 经 GET_LOCK 互斥，其他客户端正在归档时直接跳过
+    Result<MySqlArchiveStats> archiveColdDocuments(const MySqlArchiveOptions& options,
+                                                   const std::function<bool()>& shouldContinue = nullptr);
+
+    // Purge
+    // 被删除用户的文档没有逐行标记，按所有者找出，归档表中的一并清理
+    Result<PurgeStats> purgeDeleted(const PurgeOptions& options, const ObjectRemover& removeObject,
+                                    const std::function<bool()>& shouldContinue = nullptr) override;
 
     // Search operations
-    Result<std::vector<User>> searchUsers(const std::string& query, int limit = 50);
-    Result<std::vector<Document>> searchDocuments(const std::string& query, int limit = 50);
+    Result<std::vector<User>> searchUsers(const std::string& query, int limit = 50) override;
+    using StorageBackend::searchDocuments;
+    Result<std::vector<Document>> searchDocuments(const std::string& query, const DocumentSearchOptions& options) override;
+    bool isFulltextSearchEnabled() const override { return fulltextSearchEnabled; }
+
+    // 内存索引搜索：不访问数据库，索引未就绪时返回空结果（调用方可回退到 searchDocuments）
+    Result<size_t> rebuildSearchIndex() override;
+    bool isSearchIndexReady() const override { return searchIndex.isReady(); }
+    std::vector<Document> quickSearchDocuments(const std::string& query, int ownerId = 0, size_t limit = 100,
+                                               IndexMatchMode mode = IndexMatchMode::Substring) const override;
+    DocumentSearchIndexStats getSearchIndexStats() const override { return searchIndex.getStats(); }
 
     // Statistics
-    Result<int> getUserCount();
-    Result<int> getDocumentCount();
-    Result<size_t> getTotalFileSize();
+    // 读取 usage_stats 汇总表（主键查询），与文档/分享/用户写入在同一事务内增量维护
+    Result<int> getUserCount() override;
+    Result<int> getDocumentCount() override;
+    Result<size_t> getTotalFileSize() override;
+    Result<UsageStats> getUsageStats(int ownerId = 0) override;
+    // 按明细表重算全部计数，修复异常中断或手工改库造成的偏差；按 owner_id 分段读快照、只补写有偏差的行，
+    // 不阻塞在线写入。经 GET_LOCK 互斥，其他客户端正在执行时直接跳过。返回修正的统计行数
+    Result<size_t> reconcileUsageStats() override;
 
     // Transaction support
-    bool beginTransaction();
-    bool commitTransaction();
-    bool rollbackTransaction();
+    bool beginTransaction() override;
+    bool commitTransaction() override;
+    bool rollbackTransaction() override;
+    bool inTransaction() override;
+    bool createSavepoint(const std::string& name) override;
+    bool releaseSavepoint(const std::string& name) override;
+    bool rollbackToSavepoint(const std::string& name) override;
+    bool lastErrorRetryable() const override;
 
     // Utility
-    Result<bool> vacuum();
-    Result<std::vector<std::map<std::string, std::string>>> executeQuery(const std::string& query);
+    Result<bool> vacuum() override;
+    Result<QueryResult> executeQuery(const std::string& query) override;
+    std::string currentTimestampSql() const override { return "NOW()"; }
+    std::string upsertClause(const std::string& conflictColumns, const std::string& assignments) const override {
+        (void)conflictColumns;
+        return " ON DUPLICATE KEY UPDATE " + assignments;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+#include <shared_mutex>
+#include <unordered_map>
+
+// 索引统计
+struct DocumentSearchIndexStats {
+    size_t documents = 0;        // 已索引的文档数
+    size_t grams = 0;            // 不同 bigram 的数量
+    size_t postings = 0;         // 倒排表条目总数
+    size_t memoryBytes = 0;      // 估算的内存占用（字符串、倒排表与哈希表节点）
+};
+
+// 匹配方式
+enum class IndexMatchMode {
+    Substring,   // 标题/描述/文件路径任一字段包含关键词
+    Prefix       // 任一字段以关键词开头
+};
+
+/**
+ * 文档元数据的内存倒排索引
+ * 对 title/description/file_path 按 Unicode 码点切分 bigram（中文无需分词），
+ * 查询时求关键词各 bigram 倒排表的交集，再对候选文档做子串/前缀校验；
+ * 单字符关键词没有 bigram，直接扫描全部文档。ASCII 字母不区分大小写。
+ * 读写使用读写锁，可在多线程中同时查询
+ */
+class DocumentSearchIndex {
+private:
+    struct Entry {
+        Document doc;
+        std::string title;           // 归一化（小写）后的字段，用于校验匹配
+        std::string description;
+        std::string filePath;
+    };
+
+    mutable std::shared_mutex indexMutex;
+    std::unordered_map<int, Entry> documents;
+    std::unordered_map<uint64_t, std::vector<int>> postings;   // bigram -> 有序文档ID
+    bool ready;
+
+    static std::string normalize(const std::string& text);
+    static void collectGrams(const std::string& normalized, std::vector<uint64_t>& grams);
+    static void collectEntryGrams(const Entry& entry, std::vector<uint64_t>& grams);
+    static bool matches(const Entry& entry, const std::string& query, IndexMatchMode mode);
+
+    void indexEntry(int docId, const Entry& entry);
+    void unindexEntry(int docId, const Entry& entry);
+
+public:
+    DocumentSearchIndex();
+
+    DocumentSearchIndex(const DocumentSearchIndex&) = delete;
+    DocumentSearchIndex& operator=(const DocumentSearchIndex&) = delete;
+
+    void clear();
+    void addOrUpdate(const Document& doc);
+    void remove(int docId);
+    void removeOwner(int ownerId);
+
+    // 全量构建完成后置为就绪；未就绪时调用方应回退到数据库查询
+    void markReady();
+    bool isReady() const;
+
+    // ownerId 为0表示不限所有者；结果按文档ID倒序（新文档在前）
+    std::vector<Document> search(const std::string& query, int ownerId = 0, size_t limit = 100,
+                                 IndexMatchMode mode = IndexMatchMode::Substring) const;
+
+    DocumentSearchIndexStats getStats() const;
+};
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Common.h"
-#include "DatabaseManager.h"
+#include "StorageBackend.h"
 #include <functional>
 #include <memory>
 
@@ -45,13 +45,14 @@ using ProgressCallback = std::function<void(int current, int total, const std::s
 
 class ImportExportManager {
 private:
-    DatabaseManager* dbManager;
+    StorageBackend* dbManager;
     
     // 配置选项
     std::string dateFormat;
     std::string encoding;
     bool skipEmptyRows;
     bool trimWhitespace;
+    size_t batchSize;       // 批量插入时每条多行INSERT的行数
     
     // 进度回调
     ProgressCallback progressCallback;
@@ -73,6 +74,10 @@ private:
     std::map<std::string, std::string> userToMap(const User& user);
     std::map<std::string, std::string> documentToMap(const Document& doc);
     
+    // 批量写入缓冲的行；整批失败时逐行重试以记录具体出错的行号
+    void flushUsers(std::vector<User>& users, std::vector<int>& lineNumbers, ImportResult& result);
+    void flushDocuments(std::vector<Document>& documents, std::vector<int>& lineNumbers, ImportResult& result);
+    
     // 进度更新
     void updateProgress(int current, int total, const std::string& status);
     
@@ -81,7 +86,7 @@ private:
     void clearErrors();
 
 public:
-    ImportExportManager(DatabaseManager* db);
+    ImportExportManager(StorageBackend* db);
     ~ImportExportManager();
     
     // 用户数据导入导出
@@ -105,6 +110,7 @@ public:
     void setEncoding(const std::string& encoding);
     void setSkipEmptyRows(bool skip);
     void setTrimWhitespace(bool trim);
+    void setBatchSize(size_t size);
     
     // 进度回调设置
     void setProgressCallback(ProgressCallback callback);
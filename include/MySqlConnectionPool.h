@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Common.h"
+#include "PreparedStatementCache.h"
+#include <mysql/mysql.h>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+
+// 连接池配置（对应 config.json 中的 database.mysql.pool）
+struct MySqlPoolOptions {
+    int minSize = 2;                 // 常驻的最小连接数
+    int maxSize = 10;                // 允许同时存在的最大连接数
+    int idleTimeoutSeconds = 300;    // 空闲超过该时间且总数多于minSize的连接会被回收
+    int checkoutTimeoutMs = 5000;    // 借用连接的最长等待时间
+    int healthCheckSeconds = 30;     // 空闲超过该时间的连接借出前先 ping 一次
+    int connectTimeoutSeconds = 5;   // 建立新连接的超时时间
+    int statementCacheSize = 64;     // 每条连接缓存的预处理语句上限
+};
+
+// 连接池运行统计
+struct MySqlPoolStats {
+    int totalConnections = 0;
+    int idleConnections = 0;
+    int inUseConnections = 0;
+    uint64_t checkouts = 0;          // 成功借出次数
+    uint64_t waits = 0;              // 因连接耗尽而等待的次数
+    uint64_t timeouts = 0;           // 等待超时次数
+    uint64_t reaped = 0;             // 被回收的空闲连接数
+    uint64_t brokenReplaced = 0;     // 健康检查失败或断线后被替换的连接数
+};
+
+// 连接池中的一条物理连接
+struct MySqlConnection {
+    MYSQL* handle = nullptr;
+    bool mariaDb = false;                 // 服务端为 MariaDB（语句时限的变量名与单位不同）
+    long long statementTimeoutMs = 0;     // 当前会话的语句执行时限，0 为不限；归还时恢复为 0
+    std::chrono::steady_clock::time_point createdAt;
+    std::chrono::steady_clock::time_point lastUsed;
+    std::unique_ptr<PreparedStatementCache> statements;   // 必须先于 handle 关闭
+};
+
+class MySqlConnectionPool;
+
+/**
+ * 连接借用句柄（RAII）
+ * 析构时自动把连接归还给连接池；borrow() 得到的别名句柄不负责归还
+ */
+class PooledConnection {
+private:
+    MySqlConnectionPool* pool;
+    MySqlConnection* conn;
+    bool owned;
+    bool broken;
+
+public:
+    PooledConnection();
+    PooledConnection(MySqlConnectionPool* pool, MySqlConnection* conn, bool owned = true);
+    ~PooledConnection();
+
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+    PooledConnection(PooledConnection&& other) noexcept;
+    PooledConnection& operator=(PooledConnection&& other) noexcept;
+
+    MYSQL* get() const { return conn ? conn->handle : nullptr; }
+    MySqlConnection* connection() const { return conn; }
+    PreparedStatementCache* statements() const { return conn ? conn->statements.get() : nullptr; }
+    explicit operator bool() const { return conn != nullptr; }
+
+    // 标记连接已损坏，归还时直接关闭而不是放回空闲队列
+    void markBroken() { broken = true; }
+
+    // 限制本会话此后每条语句的服务端执行时间，0 取消限制；值未变时不发语句。
+    // MariaDB 的 max_statement_time 覆盖所有语句，MySQL 的 max_execution_time 只对只读 SELECT 生效
+    bool setStatementTimeout(long long timeoutMs);
+
+    // 得到一个不拥有连接的别名句柄（事务内复用同一连接）
+    PooledConnection borrow() const;
+
+    // 提前归还连接
+    void release();
+};
+
+/**
+ * MySQL 连接池
+ * 有界（minSize..maxSize），借用超时、空闲回收、借出前健康检查
+ */
+class MySqlConnectionPool {
+private:
+    std::string host;
+    int port;
+    std::string username;
+    std::string password;
+    std::string database;
+    MySqlPoolOptions options;
+
+    std::mutex poolMutex;
+    std::condition_variable connectionAvailable;
+    std::deque<MySqlConnection*> idleConnections;   // 尾部为最近归还的连接，头部最久未用
+    int totalConnections;
+    bool shuttingDown;
+
+    std::thread reaperThread;
+    std::condition_variable reaperWakeup;
+
+    mutable std::mutex errorMutex;
+    std::string lastError;
+
+    std::atomic<uint64_t> checkoutCount;
+    std::atomic<uint64_t> waitCount;
+    std::atomic<uint64_t> timeoutCount;
+    std::atomic<uint64_t> reapedCount;
+    std::atomic<uint64_t> brokenCount;
+
+    StatementCacheCounters statementCounters;
+
+    MySqlConnection* openConnection();
+    void closeConnection(MySqlConnection* conn);
+    void reaperLoop();
+    void reapIdleConnections();
+    void setLastError(const std::string& error);
+
+public:
+    MySqlConnectionPool(const std::string& host, int port, const std::string& username,
+                        const std::string& password, const std::string& database,
+                        const MySqlPoolOptions& options = MySqlPoolOptions());
+    ~MySqlConnectionPool();
+
+    // 预先建立 minSize 条连接并启动回收线程，第一条连接失败即返回false
+    bool initialize();
+    void shutdown();
+
+    PooledConnection acquire();
+    PooledConnection acquire(std::chrono::milliseconds timeout);
+    void release(MySqlConnection* conn, bool broken);
+
+    // 设置连接的会话级语句时限（毫秒），失败时返回false并记录日志
+    static bool applyStatementTimeout(MySqlConnection* conn, long long timeoutMs);
+
+    MySqlPoolStats getStats();
+    StatementCacheStats getStatementCacheStats() const { return statementCounters.snapshot(); }
+    std::string getLastError() const;
+    const MySqlPoolOptions& getOptions() const { return options; }
+
+    // 判断错误码是否表示连接已断开（2006 CR_SERVER_GONE_ERROR / 2013 CR_SERVER_LOST）
+    static bool isConnectionLostError(unsigned int errorCode);
+};
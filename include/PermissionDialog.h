@@ -96,7 +96,6 @@ private:
     
     // 数据缓存
     std::vector<Role> m_roles;
-    std::vector<User> m_users;
     std::vector<MenuItem> m_menus;
     int m_selectedUserId;
     int m_selectedRoleId;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.h"
+#include "QueryResult.h"
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -8,7 +9,7 @@
 #include <memory>
 
 // 前向声明
-class DatabaseManager;
+class StorageBackend;
 
 // 用户权限信息结构体
 struct UserPermission {
@@ -22,7 +23,7 @@ struct UserPermission {
 // 权限管理器类
 class PermissionManager {
 private:
-    DatabaseManager* dbManager;
+    StorageBackend* dbManager;
 
     // 缓存
     std::unordered_map<int, MenuItem> menuCache;
@@ -31,9 +32,10 @@ private:
 
     // 私有方法
     void clearCache();
+    MenuItem menuFromRow(const QueryResult::Row& row);
     
 public:
-    explicit PermissionManager(DatabaseManager* dbManager);
+    explicit PermissionManager(StorageBackend* dbManager);
     ~PermissionManager();
     
     // 角色管理
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Common.h"
+#include <mysql/mysql.h>
+#include <atomic>
+#include <unordered_map>
+
+// 预处理语句缓存统计（所有连接汇总）
+struct StatementCacheStats {
+    uint64_t hits = 0;               // 命中已缓存语句
+    uint64_t misses = 0;             // 未命中，需要 mysql_stmt_prepare
+    uint64_t evictions = 0;          // 超出容量被淘汰
+    uint64_t prepareErrors = 0;      // 预处理失败次数
+    uint64_t cachedStatements = 0;   // 当前缓存的语句总数
+};
+
+// 连接池持有的共享计数器，各连接的缓存共同累加
+struct StatementCacheCounters {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> prepareErrors{0};
+    std::atomic<uint64_t> cachedStatements{0};
+
+    StatementCacheStats snapshot() const;
+};
+
+/**
+ * 单条连接上的服务端预处理语句缓存
+ * 以SQL文本为键，语句句柄随连接一起关闭；连接同一时刻只被一个线程借用，因此不加锁
+ */
+class PreparedStatementCache {
+private:
+    struct Entry {
+        MYSQL_STMT* stmt;
+        uint64_t lastUsed;
+    };
+
+    MYSQL* connection;
+    StatementCacheCounters* counters;
+    size_t capacity;
+    uint64_t useTick;
+    std::unordered_map<std::string, Entry> statements;
+
+    void evictLeastRecentlyUsed();
+
+public:
+    PreparedStatementCache(MYSQL* connection, StatementCacheCounters* counters, size_t capacity = 64);
+    ~PreparedStatementCache();
+
+    PreparedStatementCache(const PreparedStatementCache&) = delete;
+    PreparedStatementCache& operator=(const PreparedStatementCache&) = delete;
+
+    // 取得已预处理的语句，未缓存时预处理并放入缓存；失败返回nullptr
+    MYSQL_STMT* acquire(const std::string& sql);
+
+    // 语句执行出错后丢弃，下次重新预处理
+    void invalidate(const std::string& sql);
+
+    void clear();
+    size_t size() const { return statements.size(); }
+};
+
+/**
+ * 一次预处理语句执行：按顺序绑定参数，以二进制协议读取结果行
+ * 整数列读入 long long，TIMESTAMP/DATETIME 读入 MYSQL_TIME，其余按字符串读取
+ */
+class BoundStatement {
+private:
+    struct Param {
+        enum_field_types type;
+        long long intValue;
+        std::string stringValue;
+        unsigned long length;
+        my_bool isNull;
+    };
+
+    struct Column {
+        enum_field_types type;
+        long long intValue;
+        MYSQL_TIME timeValue;
+        std::vector<char> buffer;
+        unsigned long length;
+        my_bool isNull;
+        my_bool error;
+    };
+
+    MYSQL_STMT* stmt;
+    std::vector<Param> params;
+    std::vector<MYSQL_BIND> paramBinds;
+    std::vector<Column> columns;
+    std::vector<MYSQL_BIND> resultBinds;
+    bool executed;
+    bool needsRebind;
+
+    bool bindResults();
+
+public:
+    explicit BoundStatement(MYSQL_STMT* stmt);
+    ~BoundStatement();
+
+    BoundStatement(const BoundStatement&) = delete;
+    BoundStatement& operator=(const BoundStatement&) = delete;
+
+    // 参数绑定（顺序对应SQL中的 ?）
+    BoundStatement& bind(int value);
+    BoundStatement& bind(long long value);
+    BoundStatement& bind(size_t value);
+    BoundStatement& bind(const std::string& value);
+    BoundStatement& bindNull();
+
+    bool execute();
+    bool fetch();
+
+    // 结果列读取（下标从0开始）
+    size_t columnCount() const { return columns.size(); }
+    bool isNull(size_t index) const;
+    int getInt(size_t index) const;
+    long long getInt64(size_t index) const;
+    std::string getString(size_t index) const;
+    std::chrono::system_clock::time_point getTimestamp(size_t index) const;
+
+    uint64_t insertId() const;
+    uint64_t affectedRows() const;
+    unsigned int errorCode() const;
+    std::string error() const;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Common.h"
+#include "TextDecoding.h"
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * 紧凑的查询结果集
+ * 列名只保存一份；所有单元格的值首尾相接存放在一块连续缓冲区中，按 (行, 列) 下标取偏移，
+ * 按下标或列名（哈希表）O(1) 定位。不返回结果集的语句只记录影响行数与自增ID
+ */
+class QueryResult {
+private:
+    std::vector<std::string> columnNames;
+    std::unordered_map<std::string, size_t> columnIndex;
+    std::string buffer;
+    std::vector<size_t> offsets;      // 第 i 个单元格为 [offsets[i], offsets[i+1])，共 rows*cols+1 项
+    std::vector<bool> nulls;
+    size_t rows;
+    uint64_t affected;
+    uint64_t lastInsertId;
+
+public:
+    // 结果集中的一行；只在所属 QueryResult 存活期间有效
+    class Row {
+    private:
+        const QueryResult* result;
+        size_t row;
+
+    public:
+        Row(const QueryResult* result, size_t row) : result(result), row(row) {}
+
+        // 不存在的列名按 NULL 处理
+        bool isNull(size_t column) const;
+        bool isNull(const std::string& column) const;
+        std::string_view getView(size_t column) const;
+        std::string_view getView(const std::string& column) const;
+
+        std::string getString(size_t column) const;
+        std::string getString(const std::string& column) const;
+        int getInt(size_t column, int defaultValue = 0) const;
+        int getInt(const std::string& column, int defaultValue = 0) const;
+        long long getInt64(size_t column, long long defaultValue = 0) const;
+        long long getInt64(const std::string& column, long long defaultValue = 0) const;
+        bool getBool(const std::string& column) const { return getInt64(column) != 0; }
+        std::chrono::system_clock::time_point getTimestamp(const std::string& column,
+                                                           std::chrono::system_clock::time_point fallback =
+                                                               std::chrono::system_clock::time_point()) const;
+    };
+
+    class const_iterator {
+    private:
+        const QueryResult* result;
+        size_t row;
+
+    public:
+        const_iterator(const QueryResult* result, size_t row) : result(result), row(row) {}
+        Row operator*() const { return Row(result, row); }
+        const_iterator& operator++() { ++row; return *this; }
+        bool operator!=(const const_iterator& other) const { return row != other.row; }
+    };
+
+    QueryResult();
+
+    // 由各存储后端构造结果集（MySQL 见 RowDecoder.h 的 readQueryResult）：先 setColumns，
+    // 已知行数时 reserve，再逐行 appendRow 或按行优先顺序逐格 appendCell（data 为 nullptr 表示 NULL）
+    void setColumns(std::vector<std::string> names);
+    void reserve(size_t rowCount);
+    // values/lengths 各 columnCount() 项，与 mysql_fetch_row/mysql_fetch_lengths 的布局相同
+    void appendRow(const char* const* values, const unsigned long* lengths);
+    void appendCell(const char* data, size_t length);
+    // 全部行追加完毕后释放缓冲区多余的容量
+    void shrinkToFit() { buffer.shrink_to_fit(); }
+    void setModification(uint64_t affectedRows, uint64_t insertId);
+
+    size_t rowCount() const { return rows; }
+    size_t columnCount() const { return columnNames.size(); }
+    // 全部单元格数据的字节数
+    size_t dataSize() const { return buffer.size(); }
+    bool empty() const { return rows == 0; }
+    const std::string& columnName(size_t column) const { return columnNames.at(column); }
+    // 未找到返回 -1
+    int findColumn(const std::string& name) const;
+
+    Row operator[](size_t row) const { return Row(this, row); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, rows); }
+
+    uint64_t affectedRows() const { return affected; }
+    uint64_t insertId() const { return lastInsertId; }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+// 慢查询记录配置（对应 config.json 中的 database.mysql.profiling）
+struct QueryProfilingOptions {
+    int slowQueryMs = 200;           // 单次方法调用超过该耗时记为慢查询，0 表示关闭慢查询日志
+    bool explainSlowQueries = true;  // 慢查询附带最后一条语句的 EXPLAIN
+    int explainIntervalSeconds = 60; // 同一条语句（按去除字面量后的文本）在该时间内只 EXPLAIN 一次
+    size_t slowLogSize = 50;         // 内存中保留的最近慢查询条数
+};
+
+/**
+ * 延迟直方图（微秒）
+ * 对数-线性分桶：每个 2 的幂区间再均分 8 个子桶，相对误差不超过 12.5%，上限约 4.7 小时；
+ * 计数器为原子量，记录时不加锁
+ */
+class LatencyHistogram {
+public:
+    static const size_t SUB_BUCKETS = 8;
+    static const size_t BUCKET_COUNT = 32 * SUB_BUCKETS;
+
+    void record(uint64_t micros);
+    // q 取 (0, 1]；返回所在桶的上界，没有样本时为 0
+    uint64_t percentile(double q) const;
+    uint64_t count() const { return samples.load(); }
+    uint64_t max() const { return maxMicros.load(); }
+    uint64_t total() const { return totalMicros.load(); }
+    void reset();
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> totalMicros{0};
+    std::atomic<uint64_t> maxMicros{0};
+
+    static size_t bucketIndex(uint64_t micros);
+    static uint64_t bucketUpperBound(size_t index);
+};
+
+// 单个方法的统计快照
+struct QueryMethodStats {
+    std::string method;
+    uint64_t calls = 0;
+    uint64_t errors = 0;             // 执行失败的语句数
+    uint64_t rowsRead = 0;           // 读到客户端的结果行
+    uint64_t rowsAffected = 0;       // 写语句影响的行
+    uint64_t bytesRead = 0;          // 结果行中各列数据的字节数
+    uint64_t p50Micros = 0;
+    uint64_t p99Micros = 0;
+    uint64_t maxMicros = 0;
+    uint64_t totalMicros = 0;
+};
+
+struct SlowQueryRecord {
+    std::chrono::system_clock::time_point time;
+    std::string method;
+    uint64_t micros = 0;
+    uint64_t rows = 0;
+    std::string statement;           // 去除字面量后的最后一条语句
+    std::string plan;                // EXPLAIN 结果，未取得时为空
+};
+
+// 预处理语句的一个参数值，慢查询 EXPLAIN 时代回语句中
+struct QueryParameter {
+    enum class Kind { Null, Integer, Text };
+    Kind kind = Kind::Null;
+    long long intValue = 0;
+    std::string text;
+};
+
+// 把SQL中的字符串与数字字面量替换为 ?，结果超过 maxLength 时截断（批量 INSERT 可能很长）
+std::string redactSqlLiterals(const std::string& sql, size_t maxLength = 1024);
+
+/**
+ * 按方法汇总的查询统计与慢查询日志
+ * 由 QueryTimer 在方法结束时写入；快照与重置可在任意线程调用
+ */
+class QueryStatsRegistry {
+public:
+    // 返回 sql 的 EXPLAIN 结果（多行文本）；params 非空时按顺序替换语句中的 ?
+    using Explainer = std::function<std::string(const std::string& sql, const std::vector<QueryParameter>& params)>;
+
+    void configure(const QueryProfilingOptions& options);
+    QueryProfilingOptions getOptions() const;
+    void setExplainer(Explainer explainer);
+
+    std::vector<QueryMethodStats> snapshot() const;
+    // 从新到旧
+    std::vector<SlowQueryRecord> slowQueries() const;
+    void reset();
+
+private:
+    friend class QueryTimer;
+
+    struct MethodEntry {
+        LatencyHistogram latency;
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> rowsRead{0};
+        std::atomic<uint64_t> rowsAffected{0};
+        std::atomic<uint64_t> bytesRead{0};
+    };
+
+    mutable std::mutex mutex;
+    QueryProfilingOptions options;
+    std::atomic<int> slowQueryMs{QueryProfilingOptions().slowQueryMs};   // options.slowQueryMs 的副本，每次调用结束时免锁读取
+    Explainer explainer;
+    // 方法名取自字符串常量，条目创建后不删除（reset 只清零），调用方可以在锁外更新计数
+    std::unordered_map<std::string, std::unique_ptr<MethodEntry>> methods;
+    std::deque<SlowQueryRecord> slowLog;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastExplained;
+
+    MethodEntry& entry(const char* method);
+    void reportSlow(const char* method, uint64_t micros, uint64_t rows,
+                    const std::string& sql, const std::vector<QueryParameter>& params);
+};
+
+/**
+ * 一次方法调用的计时（RAII）
+ * 构造时成为当前线程的活动计时器，析构时把耗时、行数、字节数记入所属方法；
+ * 底层的语句执行与结果读取通过 current() 把数据记到最内层的计时器上，没有计时器时什么也不做
+ */
+class QueryTimer {
+public:
+    QueryTimer(QueryStatsRegistry& registry, const char* method);
+    ~QueryTimer();
+
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+
+    static QueryTimer* current();
+
+    // 记录即将执行的语句（预处理语句为带 ? 的文本），同时清空上一条语句的参数
+    void noteStatement(const std::string& sql);
+    void setParameters(std::vector<QueryParameter> params);
+    void addRow(size_t bytes);
+    void addRows(uint64_t rows, uint64_t bytes);
+    void addAffected(uint64_t rows);
+    void markFailed();
+
+private:
+    QueryStatsRegistry& registry;
+    const char* method;
+    QueryTimer* previous;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t rowsRead;
+    uint64_t rowsAffected;
+    uint64_t bytesRead;
+    uint64_t errors;
+    std::string lastSql;
+    std::vector<QueryParameter> lastParams;
+};
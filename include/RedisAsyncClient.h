@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Common.h"
+#include "RedisConnectionPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+// 异步客户端配置（对应 config.json 中的 redis.async）
+struct RedisAsyncOptions {
+    bool enabled = true;
+    int maxPending = 65536;          // 已提交未完成的请求上限，超过时新请求立即失败
+    int backoffInitialMs = 100;      // 断线后第一次重连前的等待时间，失败时翻倍
+    int backoffMaxMs = 10000;
+};
+
+// 异步客户端运行统计
+struct RedisAsyncStats {
+    bool connected = false;
+    uint64_t inFlight = 0;           // 已提交未完成的请求数
+    uint64_t submitted = 0;
+    uint64_t completed = 0;          // 收到回复的请求数（含 Redis 返回的错误回复）
+    uint64_t failed = 0;             // 因断线、超时、队列满或关闭而失败的请求数
+    uint64_t reconnects = 0;
+};
+
+/**
+ * 事件循环驱动的异步Redis客户端
+ * 所有请求复用一条连接：提交线程只把命令编码进发送队列并唤醒事件循环，不做任何socket读写；
+ * 事件循环线程批量写出命令，按到达顺序把回复交给对应的回调（Redis 对同一连接上的命令按顺序回复）。
+ * Linux 下用 epoll + eventfd 驱动非阻塞socket；其他平台退化为一个后台线程，
+ * 每轮把排队的命令作为一条流水线发出并依次读回，同样不阻塞提交线程。
+ * 回调在事件循环线程上执行，应尽快返回（GUI 中需自行切回主线程）
+ */
+class RedisAsyncClient {
+public:
+    // reply 只在回调期间有效；ok 为 false 时请求未得到回复，reply 是描述原因的错误回复
+    using ReplyHandler = std::function<void(const RespReply& reply, bool ok)>;
+
+    RedisAsyncClient(const std::string& host, int port, const std::string& password, int database,
+                     int timeoutMs, const RedisAsyncOptions& options = RedisAsyncOptions());
+    ~RedisAsyncClient();
+
+    RedisAsyncClient(const RedisAsyncClient&) = delete;
+    RedisAsyncClient& operator=(const RedisAsyncClient&) = delete;
+
+    // 建立连接并启动事件循环线程，连接失败返回false
+    bool start();
+    // 停止事件循环，未完成的请求以失败回调结束
+    void shutdown();
+
+    /**
+     * 提交一条命令
+     * 参数在返回前已编码进发送队列，调用方无需保持其有效；不可用时 handler 在当前线程立即以失败回调
+     */
+    void submit(std::initializer_list<std::string_view> args, ReplyHandler handler);
+
+    RedisAsyncStats getStats() const;
+
+private:
+    std::string host;
+    int port;
+    std::string password;
+    int database;
+    int timeoutMs;
+    RedisAsyncOptions options;
+
+    // 提交队列：outgoing 中的命令与 queued 中的回调一一对应，始终在同一把锁下追加
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::string outgoing;
+    std::deque<ReplyHandler> queued;
+    bool wakeRequested;                  // 已请求唤醒、事件循环尚未取走队列，避免每次提交都写 eventfd
+    bool stopping;
+    std::thread loopThread;
+
+    std::atomic<bool> connected;
+    std::atomic<int64_t> reconnectAtMs;  // 断线后下一次允许重连的时间（steady_clock 毫秒），之前的提交立即失败
+    std::atomic<uint64_t> inFlightCount;
+    std::atomic<uint64_t> submittedCount;
+    std::atomic<uint64_t> completedCount;
+    std::atomic<uint64_t> failedCount;
+    std::atomic<uint64_t> reconnectCount;
+
+    // 以下只由事件循环线程访问
+    RedisConnection connection;
+    RespParser parser;
+    std::string sending;                 // 正在写出的命令，写完后清空复用
+    size_t sendOffset;
+    std::deque<ReplyHandler> inflight;   // 已取出队列、等待回复的请求，顺序与发出顺序一致
+    std::chrono::steady_clock::time_point lastActivity;
+    int backoffMs;
+    bool everConnected;
+#ifdef __linux__
+    int epollFd;
+    int wakeFd;
+    bool writeWatched;                   // 是否在等待 EPOLLOUT（发送缓冲区满）
+#endif
+
+    void run();
+    // 取走提交队列中的命令与回调；返回是否收到停止请求
+    bool drainQueue();
+    bool ensureConnected();
+    void connectionLost(const std::string& reason);
+    void complete(ReplyHandler& handler, const RespReply& reply, bool ok);
+    void failAll(std::deque<ReplyHandler>& handlers, const std::string& reason);
+    void wake();
+#ifdef __linux__
+    bool flush();
+    bool readAvailable();
+    void watchWrite(bool enable);
+#else
+    void runBatch();
+#endif
+};
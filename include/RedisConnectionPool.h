@@ -0,0 +1,201 @@
+#pragma once
+
+#include "Common.h"
+#include "RespParser.h"
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <random>
+
+// 连接池配置（对应 config.json 中的 redis.pool）
+struct RedisPoolOptions {
+    int minSize = 1;                 // connect 时预先建立的连接数
+    int maxSize = 8;                 // 允许同时存在的最大连接数
+    int checkoutTimeoutMs = 2000;    // 借用连接的最长等待时间
+    int healthCheckSeconds = 30;     // 空闲超过该时间的连接借出前先 PING 一次
+
+    // 熔断与重连退避（对应 config.json 中的 redis.reconnect）
+    int breakerThreshold = 3;        // 连续多少次连接级失败后熔断
+    int backoffInitialMs = 100;      // 熔断后第一次探测前的等待时间
+    int backoffMaxMs = 10000;        // 探测失败时等待时间翻倍，不超过该值
+};
+
+// 连接池运行统计
+struct RedisPoolStats {
+    int totalConnections = 0;
+    int idleConnections = 0;
+    int inUseConnections = 0;
+    uint64_t checkouts = 0;          // 成功借出次数
+    uint64_t waits = 0;              // 因连接耗尽而等待的次数
+    uint64_t timeouts = 0;           // 等待超时次数
+    uint64_t reconnects = 0;         // 借出时发现断线并重新建立的次数
+    uint64_t healthCheckFailures = 0;
+    uint64_t breakerTrips = 0;       // 熔断次数
+    uint64_t rejected = 0;           // 熔断期间被直接拒绝的借用次数
+    uint64_t failedCommands = 0;     // 因连接问题最终失败的命令数（Redis 返回的错误回复不计）
+    bool breakerOpen = false;
+};
+
+// 一段待发送的数据，用于一次系统调用发出多段（流水线）
+struct RedisSendSpan {
+    const char* data;
+    size_t length;
+};
+
+/**
+ * 一条Redis物理连接
+ * 持有socket、复用的接收解析器与命令编码缓冲区；同一时刻只由借到它的线程使用，自身不加锁
+ */
+class RedisConnection {
+private:
+    int sockfd;
+    RespParser parser;                   // 接收缓冲区与回复解析器，跨命令复用
+    std::string commandBuffer;           // 命令编码缓冲区，跨命令复用
+    bool requestWritten;                 // 最近一次 send 是否已有数据写入 socket
+
+    // 两条命令之间 socket 上不应有可读数据；可读说明对端已关闭、连接被重置或收到了无法对应的数据
+    bool peerClosed() const;
+
+public:
+    std::chrono::steady_clock::time_point lastUsed;
+
+    RedisConnection();
+    ~RedisConnection();
+
+    RedisConnection(const RedisConnection&) = delete;
+    RedisConnection& operator=(const RedisConnection&) = delete;
+
+    /**
+     * 建立连接并完成 AUTH / SELECT
+     * @param error 失败时写入原因
+     * @return 成功返回true
+     */
+    bool open(const std::string& host, int port, const std::string& password, int database,
+              int timeoutMs, std::string& error);
+    void close();
+    bool isOpen() const { return sockfd >= 0; }
+    // 底层socket，供事件循环自行以非阻塞方式收发（此时不要再调用 command/send/readReply）
+    int nativeHandle() const { return sockfd; }
+
+    /**
+     * 发送一条命令并读取回复
+     * @param reply 回复指向本连接的接收缓冲区，在下一条命令之前有效；连接失败时为描述原因的错误回复
+     * @return 收到完整回复返回true；连接中断或协议错误时关闭连接并返回false
+     */
+    bool command(std::initializer_list<std::string_view> args, RespReply& reply);
+
+    // 一次发出多段数据（Linux writev / Windows WSASend），失败时关闭连接。
+    // 写入前先检查连接是否已被对端关闭（空闲期间服务器超时断开或重启），是则直接失败
+    bool send(std::vector<RedisSendSpan>& spans);
+
+    // 最近一次请求是否已有数据写入 socket。为 false 时失败发生在写入之前，服务器不可能执行过这些命令，
+    // 换一条连接重试是安全的；为 true 时服务器可能已经执行，不能重发
+    bool wroteRequest() const { return requestWritten; }
+
+    // 读取一条完整回复，失败时关闭连接
+    bool readReply(RespReply& reply);
+};
+
+class RedisConnectionPool;
+
+/**
+ * 连接借用句柄（RAII）
+ * 析构时自动把连接归还给连接池
+ */
+class PooledRedisConnection {
+private:
+    RedisConnectionPool* pool;
+    RedisConnection* conn;
+
+public:
+    PooledRedisConnection();
+    PooledRedisConnection(RedisConnectionPool* pool, RedisConnection* conn);
+    ~PooledRedisConnection();
+
+    PooledRedisConnection(const PooledRedisConnection&) = delete;
+    PooledRedisConnection& operator=(const PooledRedisConnection&) = delete;
+    PooledRedisConnection(PooledRedisConnection&& other) noexcept;
+    PooledRedisConnection& operator=(PooledRedisConnection&& other) noexcept;
+
+    RedisConnection* operator->() const { return conn; }
+    explicit operator bool() const { return conn != nullptr; }
+
+    // 提前归还连接
+    void release();
+};
+
+/**
+ * Redis 连接池
+ * 每个并发调用方借到独占的连接，互不交错读写同一个socket。
+ * 有界（最多 maxSize 条）、借用超时；空闲较久的连接借出前 PING 一次，
+ * 断开的连接留在池中，下一次被借出时才重新建立（惰性重连，重新执行 AUTH 与 SELECT）。
+ * 连续 breakerThreshold 次连接级失败后熔断：借用立即失败，不再等待建连或socket超时；
+ * 每隔一段退避时间放行一次探测，探测成功即恢复，失败则退避时间翻倍直到 backoffMaxMs
+ */
+class RedisConnectionPool {
+private:
+    std::string host;
+    int port;
+    std::string password;
+    int database;
+    int connectTimeoutMs;
+    RedisPoolOptions options;
+
+    std::mutex poolMutex;
+    std::condition_variable connectionAvailable;
+    std::deque<RedisConnection*> idleConnections;   // 尾部为最近归还的连接
+    int totalConnections;
+    bool shuttingDown;
+
+    mutable std::mutex errorMutex;
+    std::string lastError;
+
+    std::atomic<uint64_t> checkoutCount;
+    std::atomic<uint64_t> waitCount;
+    std::atomic<uint64_t> timeoutCount;
+    std::atomic<uint64_t> reconnectCount;
+    std::atomic<uint64_t> healthCheckFailureCount;
+    std::atomic<uint64_t> breakerTripCount;
+    std::atomic<uint64_t> rejectedCount;
+    std::atomic<uint64_t> failedCommandCount;
+
+    // 熔断器状态；熔断期间 retryAt 之前的借用全部拒绝，到点后放行一次探测并把 retryAt 推后一个退避周期
+    std::mutex breakerMutex;
+    std::atomic<bool> breakerOpen;
+    std::atomic<int> consecutiveFailures;
+    std::chrono::milliseconds backoff;
+    std::chrono::steady_clock::time_point retryAt;
+    std::mt19937 jitter;
+
+    // 熔断时判断是否放行本次借用（作为探测）；拒绝时写入原因
+    bool allowCheckout(std::string& error);
+
+    // 借出前确保连接可用：断开的重新建立，空闲较久的先 PING；失败返回false
+    bool prepareForCheckout(RedisConnection* conn);
+    void setLastError(const std::string& error);
+
+public:
+    RedisConnectionPool(const std::string& host, int port, const std::string& password, int database,
+                        int connectTimeoutMs, const RedisPoolOptions& options = RedisPoolOptions());
+    ~RedisConnectionPool();
+
+    // 预先建立 minSize 条连接，第一条连接失败即返回false
+    bool initialize();
+    void shutdown();
+
+    PooledRedisConnection acquire();
+    PooledRedisConnection acquire(std::chrono::milliseconds timeout);
+    void release(RedisConnection* conn);
+
+    // 连接级成功/失败（建连、收发），驱动熔断器；Redis 返回的错误回复不算失败
+    void recordSuccess();
+    void recordFailure();
+    // 一条命令因连接问题最终失败（重试之后）
+    void recordFailedCommand() { failedCommandCount++; }
+    // 未熔断，或熔断已到下一次探测时间
+    bool isAvailable();
+
+    RedisPoolStats getStats();
+    std::string getLastError() const;
+    const RedisPoolOptions& getOptions() const { return options; }
+};
@@ -1,14 +1,89 @@
 #pragma once
 
 #include "Common.h"
+#include "RespParser.h"
+#include "RedisConnectionPool.h"
+#include "RedisAsyncClient.h"
+#include <deque>
+#include <future>
+
+class RedisManager;
+
+/**
+ * 流水线中一条命令的回复
+ * 与 RespReply 不同，内容已拷贝出接收缓冲区，execute 返回后仍然有效
+ */
+struct RedisReply {
+    RespType type = RespType::Null;
+    std::string text;                    // Status/Error/Bulk 的内容
+    long long integer = 0;               // Integer 的值
+
+    bool isNull() const { return type == RespType::Null; }
+    bool isError() const { return type == RespType::Error; }
+    bool isStatus(const std::string& expected) const { return type == RespType::Status && text == expected; }
+};
+
+/**
+ * Redis命令流水线
+ * 先把多条命令排进队列，execute() 时一次 writev 全部发出，再按顺序读回全部回复，
+ * N 条命令只花一次往返。队列中的命令编码进同一块复用的缓冲区；
+ * 较大的值按值传入并移动到流水线内部，发送时作为独立的 iovec，不再拷进命令缓冲区。
+ * 不是线程安全的，每个线程使用自己的流水线对象
+ */
+class RedisPipeline {
+public:
+    explicit RedisPipeline(RedisManager* manager);
+
+    // 以下方法排入一条命令并返回 *this，回复在 execute() 结果中的下标与排入顺序一致
+    RedisPipeline& set(const std::string& key, std::string value, int ttl = 0);
+    RedisPipeline& get(const std::string& key);
+    RedisPipeline& del(const std::string& key);
+    RedisPipeline& expire(const std::string& key, int seconds);
+    RedisPipeline& exists(const std::string& key);
+
+    size_t size() const { return commandCount; }
+    bool empty() const { return commandCount == 0; }
+    // 丢弃已排队的命令，保留缓冲区容量
+    void clear();
+
+    /**
+     * 发送全部排队命令并按顺序读回回复，完成后清空队列
+     * 单条命令失败（如类型错误）体现为对应的错误回复；连接失败时整体返回错误
+     * @return 与排入顺序一一对应的回复
+     */
+    Result<std::vector<RedisReply>> execute();
+
+private:
+    friend class RedisManager;
+
+    // 一段待发送的数据：命令缓冲区中的区间，或一个移入流水线的大值
+    struct Segment {
+        size_t offset = 0;
+        size_t length = 0;
+        const std::string* external = nullptr;
+    };
+
+    RedisManager* manager;
+    std::string buffer;                  // 编码后的命令，大值除外
+    std::deque<std::string> largeValues; // 移入的大值，deque 保证元素地址不随追加改变
+    std::vector<Segment> segments;
+    size_t inlineStart = 0;              // buffer 中尚未记入 segments 的起点
+    size_t commandCount = 0;
+
+    // 排入一条命令；value 非空时作为最后一个参数，超过阈值的移入 largeValues 单独发送
+    void queue(std::initializer_list<std::string_view> args, std::string* value = nullptr);
+};
 
 /**
  * Redis管理器类
  * 使用原始TCP socket实现的简单Redis客户端
- * 主要用于会话存储和管理
+ * 主要用于会话存储和管理；内部持有连接池，可被多个线程同时调用。
+ * 另有一组 *Async 接口走异步客户端：一条连接上由事件循环复用大量未完成的请求，调用线程不阻塞
  * 生产环境建议使用 cpp-redis 或 hiredis 库
  */
 class RedisManager {
+    friend class RedisPipeline;
+
 private:
     std::string host;                    // Redis服务器地址
     int port;                            // Redis服务器端口
@@ -16,33 +91,35 @@ private:
     int database;                        // Redis数据库编号
     int timeout;                         // 连接超时时间（毫秒）
 
-    int sockfd;                          // Socket文件描述符
-    bool connected;                      // 连接状态标志
-    std::mutex redisMutex;               // Redis操作互斥锁
+    std::unique_ptr<RedisConnectionPool> pool;  // 每个并发调用方借用独占的连接
+    std::atomic<bool> connected;         // connect 成功且尚未 disconnect；单条连接断开由连接池惰性重连
+    std::unique_ptr<RedisAsyncClient> asyncClient;  // 异步接口使用的事件循环客户端，未启用或启动失败时为空
 
     /**
-     * 建立Socket连接
-     * @return 连接成功返回true，失败返回false
-     */
-    bool connectSocket();
-    
-    /**
-     * 断开Socket连接
+     * 借用一条连接
+     * @param error 借用失败时写入原因
+     * @return 连接句柄，失败时为空
      */
-    void disconnectSocket();
+    PooledRedisConnection acquire(std::string& error);
     
     /**
-     * 发送Redis命令
-     * @param command 要发送的命令字符串
-     * @return Redis服务器的响应
+     * 借用连接并执行一条命令
+     * 命令写入之前发现连接已断开（空闲时被服务端关闭等）时换一条连接重试一次；
+     * 已发出后读取失败或超时不重试，避免服务器重复执行。结果计入熔断器
+     * @param conn 执行命令的连接，reply 在其归还之前有效
+     * @param reply Redis的回复（可能是Redis返回的错误回复）
+     * @param error 连接不可用或收发失败时写入原因
+     * @return 收到回复返回true
      */
-    std::string sendCommand(const std::string& command);
+    bool command(PooledRedisConnection& conn, std::initializer_list<std::string_view> args,
+                 RespReply& reply, std::string& error);
     
     /**
-     * 读取Redis响应
-     * @return Redis服务器的响应字符串
+     * 发送并读回一条流水线（RedisPipeline::execute 调用），重试规则与 command 相同
+     * @param pipeline 已排队的流水线
+     * @return 按顺序排列的回复
      */
-    std::string readResponse();
+    Result<std::vector<RedisReply>> executePipeline(RedisPipeline& pipeline);
     
     /**
      * 字符串转义处理
@@ -71,20 +148,24 @@ public:
      * @param password Redis认证密码（可选）
      * @param database 要使用的数据库编号（默认0）
      * @param timeout 连接超时时间（毫秒，默认5000）
+     * @param poolOptions 连接池配置
+     * @param asyncOptions 异步客户端配置；异步客户端启动失败只记录警告，不影响同步接口
      * @return 连接成功返回true，失败返回false
      */
     bool connect(const std::string& host, int port, const std::string& password = "",
-                 int database = 0, int timeout = 5000);
+                 int database = 0, int timeout = 5000,
+                 const RedisPoolOptions& poolOptions = RedisPoolOptions(),
+                 const RedisAsyncOptions& asyncOptions = RedisAsyncOptions());
     
     /**
      * 断开Redis连接
-     * 关闭socket连接并重置连接状态
+     * 停止异步客户端（未完成的异步请求以失败回调结束），关闭连接池中的全部连接并重置连接状态
      */
     void disconnect();
     
     /**
      * 检查Redis连接状态
-     * @return 如果已连接返回true，否则返回false
+     * @return 已连接且未熔断返回true；熔断期间返回false，到了探测时间重新返回true
      */
     bool isConnected() const;
     
@@ -94,6 +175,31 @@ public:
      * @return 服务器响应PONG返回true，否则返回false
      */
     bool ping();
+    
+    /**
+     * 获取连接池统计
+     * @return 连接数、借用次数、等待与超时次数、重连次数、熔断次数、失败命令数
+     */
+    RedisPoolStats getPoolStats() const;
+    
+    /**
+     * 异步客户端是否可用
+     * @return connect 时启用并成功启动了异步客户端返回true
+     */
+    bool isAsyncEnabled() const;
+    
+    /**
+     * 获取异步客户端统计
+     * @return 连接状态、未完成请求数、完成/失败数、重连次数
+     */
+    RedisAsyncStats getAsyncStats() const;
+    
+    /**
+     * 创建命令流水线
+     * 需要连续执行多条命令（批量删除、缓存预热、刷新多个会话）时使用，只花一次往返
+     * @return 绑定到本管理器的空流水线，执行时借用一条连接
+     */
+    RedisPipeline pipeline();
 
     // ==================== 基本操作 ====================
     
@@ -142,6 +248,27 @@ public:
      */
     Result<bool> expire(const std::string& key, int seconds);
 
+    // ==================== 异步操作 ====================
+    // 语义与同名同步方法一致。带 callback 的重载在事件循环线程上回调，回调应尽快返回，
+    // 不要在其中调用同步接口或等待其他异步结果（GUI 中需自行切回主线程）；
+    // 返回 future 的重载不要在回调里 get()，否则会阻塞事件循环
+
+    std::future<Result<bool>> setAsync(const std::string& key, const std::string& value, int ttl = 0);
+    void setAsync(const std::string& key, const std::string& value, int ttl,
+                  std::function<void(const Result<bool>&)> callback);
+    
+    std::future<Result<std::string>> getAsync(const std::string& key);
+    void getAsync(const std::string& key, std::function<void(const Result<std::string>&)> callback);
+    
+    std::future<Result<bool>> delAsync(const std::string& key);
+    void delAsync(const std::string& key, std::function<void(const Result<bool>&)> callback);
+    
+    std::future<Result<bool>> existsAsync(const std::string& key);
+    void existsAsync(const std::string& key, std::function<void(const Result<bool>&)> callback);
+    
+    std::future<Result<bool>> expireAsync(const std::string& key, int seconds);
+    void expireAsync(const std::string& key, int seconds, std::function<void(const Result<bool>&)> callback);
+
     // ==================== 统计和监控 ====================
     
     /**
@@ -190,6 +317,15 @@ public:
      */
     Result<Session> getSession(const std::string& sessionToken);
     
+    /**
+     * 异步获取会话信息
+     * 高频会话校验使用，不占用调用线程等待 Redis 回复
+     * @param sessionToken 会话令牌
+     * @return 完成时给出 Session 对象或错误信息
+     */
+    std::future<Result<Session>> getSessionAsync(const std::string& sessionToken);
+    void getSessionAsync(const std::string& sessionToken, std::function<void(const Result<Session>&)> callback);
+    
     /**
      * 删除会话
      * 从Redis中删除指定的会话
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Common.h"
+#include "RespParser.h"
+#include <functional>
+#include <random>
+
+// RESP 解析器基准测试配置（对应命令行 --benchmark-resp 的各参数）
+struct RespBenchmarkOptions {
+    uint32_t seed = 20240601;
+    int replies = 20000;                 // 生成的回复条数（混合状态、整数、Bulk、嵌套数组与 RESP3 类型）
+    int durationMs = 3000;               // 吞吐测试时长
+    int splitRounds = 50;                // 随机切分一致性检查轮数
+    int corruptionRounds = 20000;        // 随机破坏数据检查轮数
+};
+
+struct RespBenchmarkReport {
+    uint64_t streamBytes = 0;            // 生成的回复流大小
+    uint64_t replies = 0;                // 吞吐测试期间解析的回复数
+    double repliesPerSecond = 0;
+    double megabytesPerSecond = 0;
+    size_t parserCapacity = 0;           // 吞吐测试结束时解析器缓冲区大小（复用后应保持稳定）
+    int splitRounds = 0;
+    int corruptionRounds = 0;
+    uint64_t protocolErrors = 0;         // 破坏数据检查中被识别为协议错误的轮数
+};
+
+/**
+ * RESP 解析器基准测试
+ * 以固定随机种子生成一段回复流，按 recv 的方式分块送入解析器测吞吐；再用随机切分检查分块方式
+ * 不影响解析结果，用随机破坏（翻转、截断、插入字节）检查畸形数据只会得到协议错误或等待更多数据。
+ * 不需要 Redis 服务器；配合 -fsanitize=address 构建时破坏检查同时可发现越界读
+ */
+class RespBenchmark {
+public:
+    explicit RespBenchmark(const RespBenchmarkOptions& options);
+
+    // 生成数据、检查一致性与健壮性、测吞吐；一致性检查失败时返回错误
+    Result<RespBenchmarkReport> run(const std::function<void(const std::string&)>& progress = nullptr);
+
+    static std::string formatReport(const RespBenchmarkReport& report);
+
+private:
+    RespBenchmarkOptions options;
+    std::string stream;
+    std::vector<std::string> expected;   // 每条回复的指纹，生成时同步记录
+
+    void generate();
+    void appendValue(std::mt19937_64& rng, int depth, std::string& fingerprint);
+    // 把回复的类型与内容完整序列化，用于比较两次解析的结果
+    static void fingerprint(const RespReply& reply, std::string& out);
+
+    Result<bool> checkSplits(std::mt19937_64& rng);
+    Result<bool> checkCorruption(std::mt19937_64& rng, uint64_t& protocolErrors);
+    void measure(RespBenchmarkReport& report);
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// RESP 回复类型；RESP3 的大数、Verbatim 字符串与 Blob 错误分别归入文本、Bulk 与错误
+enum class RespType {
+    Status,          // +OK
+    Error,           // -ERR ...（以及 RESP3 的 !<len> Blob 错误）
+    Integer,         // :1
+    Bulk,            // $<len>（以及 RESP3 的 =<len> Verbatim 字符串，已去掉 "txt:" 格式前缀）
+    Array,           // *<n>
+    Null,            // $-1、*-1、RESP3 的 _
+    Double,          // RESP3 ,<浮点文本>，text 保留原文
+    Boolean,         // RESP3 #t / #f，integer 为 1 或 0
+    BigNumber,       // RESP3 (<十进制文本>
+    Map,             // RESP3 %<n>，elements 依次为键、值，count 为 2n
+    Set,             // RESP3 ~<n>
+    Push             // RESP3 ><n>，服务端主动推送（订阅消息、客户端缓存失效通知）
+};
+
+/**
+ * 一条 RESP 回复
+ * text 与 elements 都指向解析器内部的缓冲区，只在解析下一条回复或向解析器写入数据之前有效，
+ * 需要保留时请用 toString() 拷贝
+ */
+struct RespReply {
+    RespType type = RespType::Null;
+    std::string_view text;               // Status/Error/Bulk/Double/BigNumber 的内容
+    long long integer = 0;               // Integer/Boolean 的值
+    const RespReply* elements = nullptr; // Array/Map/Set/Push 的子元素，连续存放
+    size_t count = 0;
+
+    bool isNull() const { return type == RespType::Null; }
+    bool isError() const { return type == RespType::Error; }
+    bool isAggregate() const;
+    // 状态回复等于 expected（如 "OK"、"PONG"）
+    bool isStatus(std::string_view expected) const { return type == RespType::Status && text == expected; }
+    const RespReply& operator[](size_t index) const { return elements[index]; }
+
+    std::string toString() const { return std::string(text); }
+    // 便于日志与错误信息：聚合类型展开为 [a, b, ...]，过长时截断
+    std::string describe(size_t maxLength = 256) const;
+};
+
+/**
+ * 流式 RESP2/RESP3 解析器
+ * 接收缓冲区在多次命令之间复用：数据经 prepare()/commit() 直接 recv 进缓冲区（或经 feed() 拷入），
+ * next() 每次解出一条完整回复。数据不完整时返回 Incomplete，等更多数据到达后从该回复开头重新解析——
+ * Bulk 字符串按长度前缀跳过，不扫描内容，因此重试代价只与回复的结构有关。
+ * 单线程使用
+ */
+class RespParser {
+public:
+    enum class Status {
+        Complete,        // 解出一条回复
+        Incomplete,      // 缓冲区中的数据不足一条回复
+        ProtocolError    // 数据不是合法的 RESP，error() 给出原因；之后必须 reset() 并丢弃连接
+    };
+
+    static const size_t MAX_DEPTH = 32;                      // 聚合类型的最大嵌套层数
+    static const long long MAX_BULK_LENGTH = 512LL << 20;    // 与服务端 proto-max-bulk-len 默认值一致
+    static const long long MAX_AGGREGATE_COUNT = 1LL << 24;
+
+    explicit RespParser(size_t initialCapacity = 16 * 1024);
+
+    // 取得至少 minSize 字节的可写空间（必要时先把未读数据移到缓冲区开头或扩容），写入后调用 commit
+    char* prepare(size_t minSize);
+    size_t writableSize() const { return buffer.size() - writePos; }
+    void commit(size_t length);
+    void feed(const char* data, size_t length);
+
+    Status next(RespReply& reply);
+
+    // 缓冲区中尚未解析的字节数；读完一条回复后不为 0 说明服务端多发了数据（或流水线中还有后续回复）
+    size_t buffered() const { return writePos - readPos; }
+    size_t capacity() const { return buffer.size(); }
+    const std::string& error() const { return lastError; }
+    // 丢弃全部未读数据与错误状态，保留已分配的缓冲区
+    void reset();
+
+private:
+    std::vector<char> buffer;
+    size_t readPos = 0;
+    size_t writePos = 0;
+    // 所有聚合类型的子元素；每个聚合的子元素占用一段连续的槽位
+    std::vector<RespReply> nodes;
+    std::vector<std::pair<size_t, size_t>> links;           // (聚合所在槽位, 第一个子元素的槽位)
+    // 上次返回 Incomplete 时，从 readPos 起至少需要的字节数；数据未达到前不必重新解析
+    size_t incompleteUntil = 0;
+    std::string lastError;
+
+    // 从 pos 开始解析一条回复写入 nodes[slot]；成功时 pos 前进到回复末尾
+    Status parseValue(size_t& pos, size_t slot, size_t depth);
+    Status parseLine(size_t& pos, std::string_view& line);
+    Status parseInteger(std::string_view line, long long& value);
+    Status incomplete(size_t needed);
+    Status fail(const std::string& message);
+};
+
+// 追加 "<prefix><value>\r\n"，如数组头 *3 与 Bulk 长度 $5；用于自行拼接部分参数不落入 out 的命令
+void appendRespHeader(std::string& out, char prefix, size_t value);
+// 把一条命令按 RESP 数组格式追加到 out；调用方复用 out 即可避免每条命令重新分配
+void appendRespCommand(std::string& out, std::initializer_list<std::string_view> args);
+void appendRespCommand(std::string& out, const std::vector<std::string_view>& args);
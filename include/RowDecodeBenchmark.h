@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Common.h"
+#include "RowDecoder.h"
+#include <functional>
+#include <random>
+
+// 结果行解码基准测试配置（对应命令行 --benchmark-rows 的各参数）
+struct RowDecodeBenchmarkOptions {
+    uint32_t seed = 20240601;
+    int rows = 20000;                    // 生成的文档行数与用户行数（各 rows 行）
+    int durationMs = 3000;               // 每种解码方式的测试时长
+};
+
+struct RowDecodeBenchmarkReport {
+    uint64_t rows = 0;                   // 生成的行数（文档与用户合计）
+    uint64_t rowBytes = 0;               // 全部单元格的字节数
+    double legacyRowsPerSecond = 0;      // 旧映射：std::stoi/std::stoull + Utils::parseTimestamp + const char* 赋值
+    double decoderRowsPerSecond = 0;     // RowDecoder：from_chars + 按长度原地赋值 + 缓存时区偏移的时间解析
+    double speedup = 0;
+};
+
+/**
+ * 结果行解码基准测试
+ * 以固定随机种子生成 documents/users 查询形状的文本协议行（MYSQL_ROW + 各列长度，含 NULL 列），
+ * 分别用改造前的 stoi/stoull 映射与 RowDecoder 解码同一批行并比较吞吐；
+ * 开始前先校验 RowDecoder 的解码结果与生成的原值一致。不需要数据库服务器
+ */
+class RowDecodeBenchmark {
+public:
+    explicit RowDecodeBenchmark(const RowDecodeBenchmarkOptions& options);
+
+    // 生成数据、校验解码结果、分别测两种解码方式；校验失败时返回错误
+    Result<RowDecodeBenchmarkReport> run(const std::function<void(const std::string&)>& progress = nullptr);
+
+    static std::string formatReport(const RowDecodeBenchmarkReport& report);
+
+private:
+    // 一张合成结果集：cells 按行优先存放，null 列在 rows 中为 nullptr
+    struct SyntheticRows {
+        unsigned int fieldCount = 0;
+        std::vector<std::string> cells;
+        std::vector<bool> nulls;
+        std::vector<char*> rows;
+        std::vector<unsigned long> lengths;
+
+        size_t rowCount() const { return fieldCount ? rows.size() / fieldCount : 0; }
+        MYSQL_ROW row(size_t index) { return rows.data() + index * fieldCount; }
+        const unsigned long* rowLengths(size_t index) const { return lengths.data() + index * fieldCount; }
+    };
+
+    RowDecodeBenchmarkOptions options;
+    SyntheticRows documents;
+    SyntheticRows users;
+
+    void generate();
+    // 按行追加单元格；null 为 true 时该列为 NULL
+    static void appendCell(SyntheticRows& rows, std::string value, bool null = false);
+    // cells 追加完毕后建立行指针与长度（cells 不再变动，指针保持有效）
+    static void finish(SyntheticRows& rows);
+
+    Result<bool> verify();
+    double measure(bool legacy);
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Common.h"
+#include "QueryResult.h"
+#include "TextDecoding.h"
+#include <mysql/mysql.h>
+#include <string_view>
+
+/**
+ * 文本协议结果行的类型化读取
+ * 借助 mysql_fetch_lengths 直接在行缓冲区上用 std::from_chars 解析数值和时间，
+ * 不产生临时 std::string；字符串列按长度原地 assign 到目标字段
+ */
+class RowDecoder {
+private:
+    MYSQL_ROW row;
+    const unsigned long* lengths;
+    unsigned int fieldCount;
+
+public:
+    RowDecoder(MYSQL_RES* result, MYSQL_ROW row);
+    // 直接给出行与各列长度（如基准测试中的合成行）；lengths 须与 row 一一对应
+    RowDecoder(MYSQL_ROW row, const unsigned long* lengths, unsigned int fieldCount);
+
+    unsigned int columnCount() const { return fieldCount; }
+    bool isNull(size_t index) const;
+    std::string_view getView(size_t index) const;
+
+    int getInt(size_t index, int defaultValue = 0) const;
+    long long getInt64(size_t index, long long defaultValue = 0) const;
+    unsigned long long getUInt64(size_t index, unsigned long long defaultValue = 0) const;
+    bool getBool(size_t index) const { return getInt64(index) != 0; }
+
+    void getString(size_t index, std::string& out, std::string_view defaultValue = std::string_view()) const;
+    std::string getString(size_t index) const;
+
+    // NULL 或无法解析时返回 fallback
+    std::chrono::system_clock::time_point getTimestamp(size_t index,
+                                                       std::chrono::system_clock::time_point fallback =
+                                                           std::chrono::system_clock::time_point()) const;
+};
+
+// 列顺序：id, username, password_hash, email, created_at, last_login, is_active
+void decodeUser(const RowDecoder& row, User& user);
+
+// 列顺序：id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type
+void decodeDocument(const RowDecoder& row, Document& doc);
+
+// 列顺序：id, document_id, shared_by_user_id, shared_to_user_id, shared_document_id, shared_minio_key, created_at
+void decodeDocumentShare(const RowDecoder& row, DocumentShare& share);
+
+// 把 mysql_store_result 得到的结果集读成 QueryResult；result 为 nullptr 表示语句没有结果集，
+// 此时从连接上读取影响行数与自增ID
+QueryResult readQueryResult(MYSQL* db, MYSQL_RES* result);
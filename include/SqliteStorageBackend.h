@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Common.h"
+#include "StorageBackend.h"
+#include <sqlite3.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// SQLite 后端配置（对应 config.json 中的 database.sqlite）
+struct SqliteOptions {
+    std::string filename = "data/management.db";
+    long long mmapSize = 268435456;  // 以内存映射方式读取的上限字节数，0 表示关闭
+    int busyTimeoutMs = 5000;        // 数据库文件被其他进程锁住时的等待时间
+    int readConnections = 4;         // 常驻的只读连接数（WAL 模式下读写互不阻塞）
+    int statementCacheSize = 64;     // 每条连接缓存的预处理语句上限
+};
+
+/**
+ * 单条 SQLite 连接及其预处理语句缓存
+ * 语句以 SQLITE_PREPARE_PERSISTENT 预处理，用完 reset 后留在缓存中复用；
+ * 连接同一时刻只被一个线程使用，因此不加锁
+ */
+class SqliteConnection {
+private:
+    struct Entry {
+        sqlite3_stmt* stmt;
+        uint64_t lastUsed;
+        bool inUse;
+    };
+
+    sqlite3* handle;
+    size_t capacity;
+    uint64_t useTick;
+    std::unordered_map<std::string, Entry> statements;
+    std::string lastError;
+
+    void evictLeastRecentlyUsed();
+
+public:
+    SqliteConnection();
+    ~SqliteConnection();
+
+    SqliteConnection(const SqliteConnection&) = delete;
+    SqliteConnection& operator=(const SqliteConnection&) = delete;
+
+    // 打开连接并设置 WAL、synchronous=NORMAL、mmap_size、busy_timeout、外键约束
+    bool open(const SqliteOptions& options, bool readOnly);
+    void close();
+    sqlite3* get() const { return handle; }
+
+    // 执行不带参数的SQL（可包含多条语句）
+    bool exec(const std::string& sql);
+
+    // 取得已预处理的语句；同一条SQL正被使用时（如遍历回调中再次查询）另行预处理一条不缓存的语句。
+    // 失败返回 nullptr，用完必须交给 release
+    sqlite3_stmt* acquire(const std::string& sql);
+    void release(const std::string& sql, sqlite3_stmt* stmt);
+
+    long long lastInsertId() const;
+    int changes() const;
+    std::string error() const { return lastError; }
+};
+
+/**
+ * 一次语句执行：按顺序绑定参数，逐行读取结果
+ * 析构时 reset 并清除绑定，把语句交还连接的缓存（同时结束该语句的读事务）
+ */
+class SqliteStatement {
+private:
+    SqliteConnection* conn;
+    std::string sql;
+    sqlite3_stmt* stmt;
+    int paramIndex;
+    bool failed;
+    bool finished;
+    std::string errorMessage;
+
+    void fail();
+
+public:
+    SqliteStatement(SqliteConnection& conn, const std::string& sql);
+    ~SqliteStatement();
+
+    SqliteStatement(const SqliteStatement&) = delete;
+    SqliteStatement& operator=(const SqliteStatement&) = delete;
+
+    // 参数绑定（顺序对应SQL中的 ?）
+    SqliteStatement& bind(int value);
+    SqliteStatement& bind(long long value);
+    SqliteStatement& bind(size_t value);
+    SqliteStatement& bind(const std::string& value);
+    SqliteStatement& bindNull();
+
+    // 执行到结束（写语句）；出错返回 false
+    bool execute();
+    // 取下一行；没有更多行或出错时返回 false，用 ok() 区分
+    bool fetch();
+    bool ok() const { return !failed; }
+
+    // 结果列读取（下标从0开始）
+    size_t columnCount() const;
+    bool isNull(size_t index) const;
+    int getInt(size_t index) const;
+    long long getInt64(size_t index) const;
+    std::string getString(size_t index) const;
+    std::chrono::system_clock::time_point getTimestamp(size_t index,
+                                                       std::chrono::system_clock::time_point fallback =
+                                                           std::chrono::system_clock::time_point()) const;
+
+    std::string error() const { return errorMessage; }
+};
+
+/**
+ * SQLite 存储后端（嵌入式，单文件）
+ * WAL 模式：一条写连接串行执行写事务，多条只读连接并发读取且不被写事务阻塞。
+ * 事务与调用线程绑定，事务期间该线程的读也走写连接以读到未提交的修改
+ */
+class SqliteStorageBackend : public StorageBackend {
+private:
+    SqliteOptions options;
+    std::atomic<bool> isConnected;
+
+    // 唯一的写连接；持有 writerMutex 的线程即当前事务的所有者
+    std::unique_ptr<SqliteConnection> writer;
+    std::mutex writerMutex;
+    std::atomic<std::thread::id> transactionOwner;
+
+    // 空闲的只读连接；全部借出时临时新开，归还时超出 readConnections 的直接关闭
+    std::mutex readerMutex;
+    std::vector<std::unique_ptr<SqliteConnection>> idleReaders;
+
+    // 文档元数据的内存倒排索引；事务中的变更暂存到提交后再应用（只有事务所有者线程访问）
+    DocumentSearchIndex searchIndex;
+    std::vector<std::function<void()>> pendingIndexChanges;
+    // 当前事务中的保存点及建立时 pendingIndexChanges 的长度，回滚到保存点时据此丢弃之后的索引变更
+    std::vector<std::pair<std::string, size_t>> savepointMarks;
+    void applyIndexChange(std::function<void()> change);
+
+    // 读连接借用句柄：析构时把只读连接归还；借用的是写连接时不做任何事
+    class ReadLease {
+    private:
+        SqliteStorageBackend* owner;
+        std::unique_ptr<SqliteConnection> reader;
+        SqliteConnection* conn;
+
+    public:
+        ReadLease(SqliteStorageBackend* owner, std::unique_ptr<SqliteConnection> reader, SqliteConnection* conn);
+        ReadLease(ReadLease&& other) noexcept;
+        ~ReadLease();
+
+        SqliteConnection& operator*() const { return *conn; }
+        explicit operator bool() const { return conn != nullptr; }
+    };
+
+    ReadLease acquireReader();
+    void releaseReader(std::unique_ptr<SqliteConnection> reader);
+
+    // 在写事务中执行 body：调用方已开启事务时直接加入，否则经 runTransaction 自行开启，
+    // body 失败回滚、成功提交，遇到 SQLITE_BUSY 时整体重试
+    template<typename T>
+    Result<T> runInTransaction(const std::function<Result<T>(SqliteConnection&)>& body);
+
+    // 在只读连接上逐行执行查询；bindParams 为空表示没有参数，visitor 返回 false 提前结束。返回访问过的行数
+    Result<size_t> streamQuery(const std::string& sql, const std::function<void(SqliteStatement&)>& bindParams,
+                               const std::function<bool(const SqliteStatement&)>& visitor);
+
+    // fromCondition 为表自身的可见条件（不含参数，可为空）
+    Result<std::string> fetchKeysetPage(const std::string& columns, const std::string& from, const std::string& fromCondition,
+                                        const std::string& filter, int filterId, const std::string& keyPrefix,
+                                        int pageSize, const std::string& pageToken,
+                                        const std::function<void(const SqliteStatement&)>& onRow);
+
+    // usage_stats 增量：键为 owner_id（0 为全局）
+    bool applyStatsDeltas(SqliteConnection& db, const std::map<int, UsageStats>& deltas);
+    // 统计即将被删除的分享记录（where 为 document_shares 上的条件），计入双方及全局增量；
+    // 已软删除的一方其统计行已在删除用户时整行扣除，不再计入
+    bool collectShareDeltas(SqliteConnection& db, const std::string& where, std::map<int, UsageStats>& deltas);
+
+    // 按 PRAGMA user_version 判断，结构落后时才执行建表脚本
+    bool createTables(SqliteConnection& db);
+    Result<User> fetchUserById(SqliteConnection& db, int userId);
+    Result<Document> fetchDocumentById(SqliteConnection& db, int docId);
+    // 清理一批软删除的数据：先删除涉及已删除用户或文档的分享，没有积压时再删文档（先删文件再删行），
+    // 文档不足一批时接着删除已没有文档的用户
+    Result<PurgeStats> purgeBatch(int batchSize, const ObjectRemover& removeObject);
+    // 删除至多 batchSize 条涉及已删除用户或文档的分享，返回删除的行数
+    Result<size_t> purgeShares(int batchSize);
+
+public:
+    SqliteStorageBackend();
+    ~SqliteStorageBackend() override;
+
+    bool connect(const SqliteOptions& options);
+    std::string backendName() const override { return "SQLite"; }
+    void disconnect() override;
+    bool isConnectionValid() const override;
+
+    // User operations
+    Result<User> createUser(const std::string& username, const std::string& passwordHash,
+                            const std::string& email) override;
+    Result<User> getUserById(int userId) override;
+    Result<User> getUserByUsername(const std::string& username) override;
+    Result<std::vector<User>> getAllUsers(int limit = 100, int offset = 0) override;
+    Result<bool> updateUser(const User& user) override;
+    Result<bool> deleteUser(int userId) override;
+    Result<bool> updateUserLastLogin(int userId) override;
+
+    // Document operations
+    Result<Document> createDocument(const std::string& title, const std::string& description,
+                                    const std::string& filePath, const std::string& minioKey,
+                                    int ownerId, size_t fileSize, const std::string& contentType) override;
+    Result<Document> getDocumentById(int docId) override;
+    Result<std::vector<Document>> getDocumentsByOwner(int ownerId, int limit = 100, int offset = 0) override;
+    Result<std::vector<Document>> getAllDocuments(int limit = 100, int offset = 0) override;
+    Result<bool> updateDocument(const Document& doc) override;
+    Result<bool> deleteDocument(int docId) override;
+
+    // Document sharing operations
+    Result<DocumentShare> createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
+                                              int sharedDocumentId, const std::string& sharedMinioKey) override;
+    Result<std::vector<Document>> getSharedDocuments(int userId, int limit = 100, int offset = 0) override;
+    Result<std::vector<DocumentShare>> getDocumentShares(int documentId) override;
+    Result<bool> deleteDocumentShare(int shareId) override;
+    Result<bool> isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId) override;
+
+    // Batch operations
+    // SQLite 没有网络往返，单行 INSERT 预处理一次、在同一事务内逐行执行即可，chunkSize 不起作用
+    Result<std::vector<int>> createUsersBatch(const std::vector<User>& users, size_t chunkSize = 500) override;
+    Result<std::vector<int>> createDocumentsBatch(const std::vector<Document>& documents, size_t chunkSize = 500) override;
+
+    // Keyset pagination
+    Result<Page<User>> getUsersPage(int pageSize, const std::string& pageToken = "") override;
+    Result<Page<Document>> getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken = "") override;
+    Result<Page<Document>> getAllDocumentsPage(int pageSize, const std::string& pageToken = "") override;
+    Result<Page<Document>> getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken = "") override;
+
+    // Streaming operations
+    // 遍历期间独占一条只读连接；回调内可以调用其他方法（会借用另一条连接）
+    Result<size_t> forEachUser(const UserVisitor& visitor) override;
+    Result<size_t> forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor) override;
+
+    // Search operations
+    // 没有 ngram 全文索引，统一使用 LIKE 子串匹配；需要更快的即时搜索请用内存索引
+    Result<std::vector<User>> searchUsers(const std::string& query, int limit = 50) override;
+    using StorageBackend::searchDocuments;
+    Result<std::vector<Document>> searchDocuments(const std::string& query, const DocumentSearchOptions& options) override;
+    bool isFulltextSearchEnabled() const override { return false; }
+
+    Result<size_t> rebuildSearchIndex() override;
+    bool isSearchIndexReady() const override { return searchIndex.isReady(); }
+    std::vector<Document> quickSearchDocuments(const std::string& query, int ownerId = 0, size_t limit = 100,
+                                               IndexMatchMode mode = IndexMatchMode::Substring) const override;
+    DocumentSearchIndexStats getSearchIndexStats() const override { return searchIndex.getStats(); }
+
+    // Statistics
+    Result<int> getUserCount() override;
+    Result<int> getDocumentCount() override;
+    Result<size_t> getTotalFileSize() override;
+    Result<UsageStats> getUsageStats(int ownerId = 0) override;
+    Result<size_t> reconcileUsageStats() override;
+
+    // Transaction support
+    // BEGIN IMMEDIATE 在开始时就取得写锁，避免读升级为写时的 SQLITE_BUSY
+    bool beginTransaction() override;
+    bool commitTransaction() override;
+    bool rollbackTransaction() override;
+    bool inTransaction() override { return transactionOwner.load() == std::this_thread::get_id(); }
+    bool createSavepoint(const std::string& name) override;
+    bool releaseSavepoint(const std::string& name) override;
+    bool rollbackToSavepoint(const std::string& name) override;
+    // 写连接已由 writerMutex 串行化，只有其他进程持有文件锁超过 busyTimeoutMs 时才会出现
+    bool lastErrorRetryable() const override;
+
+    // Purge
+    // 没有归档表，只清理 documents 与 users
+    Result<PurgeStats> purgeDeleted(const PurgeOptions& options, const ObjectRemover& removeObject,
+                                    const std::function<bool()>& shouldContinue = nullptr) override;
+
+    // Utility
+    // VACUUM 重建数据库文件并执行 PRAGMA optimize；不能在事务中调用
+    Result<bool> vacuum() override;
+    Result<QueryResult> executeQuery(const std::string& query) override;
+    std::string currentTimestampSql() const override { return "datetime('now', 'localtime')"; }
+    std::string upsertClause(const std::string& conflictColumns, const std::string& assignments) const override {
+        return " ON CONFLICT (" + conflictColumns + ") DO UPDATE SET " + assignments;
+    }
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "Common.h"
+#include "QueryResult.h"
+#include "DocumentSearchIndex.h"
+#include <functional>
+
+// 流式遍历文档的过滤条件（0 表示不限制）
+struct DocumentFilter {
+    int ownerId = 0;             // 只遍历该用户拥有的文档
+    int sharedToUserId = 0;      // 只遍历分享给该用户的文档（minio_key 为分享副本的键）
+};
+
+// 文档搜索方式
+enum class DocumentSearchMode {
+    Auto,        // 全文索引可用且关键词至少2个字符时走全文检索，否则退回 LIKE
+    FullText,    // 强制使用 FULLTEXT(ngram) 索引，按相关度排序
+    Like         // 子串匹配，按 id 倒序
+};
+
+// 文档搜索条件（0 表示不限制）
+struct DocumentSearchOptions {
+    DocumentSearchMode mode = DocumentSearchMode::Auto;
+    int ownerId = 0;             // 只搜索该用户拥有的文档
+    int visibleToUserId = 0;     // 只搜索该用户拥有或被分享给该用户的文档
+    int limit = 50;
+    int offset = 0;
+};
+
+// 键集分页结果：nextPageToken 为空表示已经是最后一页
+template<typename T>
+struct Page {
+    std::vector<T> items;
+    std::string nextPageToken;
+};
+
+// 用量统计：ownerId 为 0 时是全局汇总（userCount 只在全局行有意义）
+struct UsageStats {
+    long long userCount = 0;
+    long long documentCount = 0;
+    long long totalBytes = 0;
+    long long sharesGiven = 0;       // 该用户分享出去的记录数
+    long long sharesReceived = 0;    // 分享给该用户的记录数
+};
+
+// 软删除数据的清理配置（对应 config.json 中的 database.purge）
+struct PurgeOptions {
+    int batchSize = 200;             // 每批物理删除的文档数
+    int pauseMs = 500;               // 批次之间的停顿，给在线事务让出行锁与 IO
+    int maxBatches = 100;            // 单次运行最多执行的批数，0 表示直到清理完毕
+};
+
+// 一次清理运行的结果
+struct PurgeStats {
+    size_t shares = 0;               // 物理删除的分享记录（含归档的），涉及已删除的用户或文档
+    size_t documents = 0;            // 物理删除的文档行（含归档表中的）
+    size_t objects = 0;              // 删除的对象存储文件
+    size_t objectFailures = 0;       // 文件删除失败、行留到下次重试的文档
+    size_t users = 0;
+    size_t batches = 0;
+    bool completed = false;          // 已没有待清理的数据（没有因 maxBatches、删除文件失败或被要求停止而中断）
+};
+
+// 删除对象存储中的一个文件；文件本就不存在时也应返回 true
+using ObjectRemover = std::function<bool(const std::string& key)>;
+
+// 行访问回调：返回 false 提前结束遍历；传入的对象在各行之间复用，需要保留时请拷贝
+using UserVisitor = std::function<bool(const User&)>;
+using DocumentVisitor = std::function<bool(const Document&)>;
+
+// 分页令牌：对 "created_at#id" 做十六进制编码，调用方只需原样回传；各后端共用同一格式
+std::string encodePageToken(const std::string& createdAt, long long id);
+bool decodePageToken(const std::string& token, std::string& createdAt, long long& id);
+
+// 以反斜杠转义 LIKE 通配符，使关键词按字面匹配
+std::string escapeLikePattern(const std::string& text);
+
+/**
+ * 当前线程上正在执行的调用的截止时间与取消检查
+ * AsyncDatabaseManager 在工作线程上执行每个调用时设置（作用域对象，可嵌套，析构时恢复外层）。
+ * 后端据此限制执行中的语句：SQLite 经 progress handler 中断，MySQL 为借出的连接设置服务端语句时限
+ */
+class CallDeadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CallDeadline(Clock::time_point deadline, std::function<bool()> isCancelled);
+    ~CallDeadline();
+
+    CallDeadline(const CallDeadline&) = delete;
+    CallDeadline& operator=(const CallDeadline&) = delete;
+
+    // 当前线程上的调用已超时或被取消；不在调用作用域内时返回 false
+    static bool interrupted();
+    // 距截止时间的剩余毫秒数（已到期为 0）；没有截止时间时返回 -1
+    static long long remainingMs();
+
+private:
+    Clock::time_point deadline;
+    std::function<bool()> isCancelled;
+    CallDeadline* outer;
+};
+
+/**
+ * 存储后端接口
+ * 业务层（认证、导入导出、权限、CLI/GUI）只依赖这里的方法；具体实现负责连接管理与SQL方言，
+ * 由 config.json 的 database.type 选择（mysql -> DatabaseManager，sqlite -> SqliteStorageBackend）。
+ * 连接参数各不相同，connect 不在接口中，由创建方调用具体类型的 connect。
+ * 事务与调用线程绑定：同一线程 begin..commit 之间的调用都落在同一个事务中
+ */
+class StorageBackend {
+public:
+    // 软删除时用户名与邮箱改写为该前缀加用户 id；注册时不能使用此前缀
+    static inline const std::string DELETED_USER_PREFIX = "#deleted#";
+
+    virtual ~StorageBackend() = default;
+
+    // 后端名称，用于日志与状态输出
+    virtual std::string backendName() const = 0;
+    virtual void disconnect() = 0;
+    virtual bool isConnectionValid() const = 0;
+
+    // User operations
+    virtual Result<User> createUser(const std::string& username, const std::string& passwordHash,
+                                    const std::string& email) = 0;
+    virtual Result<User> getUserById(int userId) = 0;
+    virtual Result<User> getUserByUsername(const std::string& username) = 0;
+    virtual Result<std::vector<User>> getAllUsers(int limit = 100, int offset = 0) = 0;
+    virtual Result<bool> updateUser(const User& user) = 0;
+    // 删除用户与文档均为软删除：只写 deleted_at 并从用量统计中扣除，提交后所有读取立即不可见。
+    // 涉及的分享记录在读取时隐藏，与行本身、对象存储中的文件一起由 purgeDeleted 在后台分批清理
+    // （用户名与邮箱改写为占位值，立即可以重新注册；分享计数在清理时才扣除仍在线的另一方）
+    virtual Result<bool> deleteUser(int userId) = 0;
+    virtual Result<bool> updateUserLastLogin(int userId) = 0;
+
+    // Document operations
+    virtual Result<Document> createDocument(const std::string& title, const std::string& description,
+                                            const std::string& filePath, const std::string& minioKey,
+                                            int ownerId, size_t fileSize, const std::string& contentType) = 0;
+    virtual Result<Document> getDocumentById(int docId) = 0;
+    virtual Result<std::vector<Document>> getDocumentsByOwner(int ownerId, int limit = 100, int offset = 0) = 0;
+    virtual Result<std::vector<Document>> getAllDocuments(int limit = 100, int offset = 0) = 0;
+    virtual Result<bool> updateDocument(const Document& doc) = 0;
+    virtual Result<bool> deleteDocument(int docId) = 0;
+
+    // Document sharing operations
+    // 同一 (原文档, 分享人, 接收人) 上已失效、尚未清理的旧分享会被替换；isDocumentShared 只看仍有效的分享
+    virtual Result<DocumentShare> createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
+                                                      int sharedDocumentId, const std::string& sharedMinioKey) = 0;
+    virtual Result<std::vector<Document>> getSharedDocuments(int userId, int limit = 100, int offset = 0) = 0;
+    virtual Result<std::vector<DocumentShare>> getDocumentShares(int documentId) = 0;
+    virtual Result<bool> deleteDocumentShare(int shareId) = 0;
+    virtual Result<bool> isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId) = 0;
+
+    // Batch operations
+    // 使用 User 的 username/password_hash/email 与 Document 的可写字段；任一行失败则整批回滚。
+    // 返回的ID与输入顺序一致；若当前线程已在事务中则并入该事务
+    virtual Result<std::vector<int>> createUsersBatch(const std::vector<User>& users, size_t chunkSize = 500) = 0;
+    virtual Result<std::vector<int>> createDocumentsBatch(const std::vector<Document>& documents, size_t chunkSize = 500) = 0;
+
+    // Keyset pagination
+    // 按 (created_at, id) 从新到旧翻页；pageToken 传上一页返回的 nextPageToken，空串表示第一页
+    virtual Result<Page<User>> getUsersPage(int pageSize, const std::string& pageToken = "") = 0;
+    virtual Result<Page<Document>> getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken = "") = 0;
+    virtual Result<Page<Document>> getAllDocumentsPage(int pageSize, const std::string& pageToken = "") = 0;
+    virtual Result<Page<Document>> getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken = "") = 0;
+
+    // Streaming operations
+    // 按 id 顺序逐行回调，不把结果集整体装入内存；回调内可以调用其他存储方法，但应尽快返回
+    virtual Result<size_t> forEachUser(const UserVisitor& visitor) = 0;
+    virtual Result<size_t> forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor) = 0;
+
+    // Search operations
+    virtual Result<std::vector<User>> searchUsers(const std::string& query, int limit = 50) = 0;
+    virtual Result<std::vector<Document>> searchDocuments(const std::string& query, const DocumentSearchOptions& options) = 0;
+    Result<std::vector<Document>> searchDocuments(const std::string& query, int limit = 50) {
+        DocumentSearchOptions options;
+        options.limit = limit;
+        return searchDocuments(query, options);
+    }
+    virtual bool isFulltextSearchEnabled() const = 0;
+
+    // 内存索引搜索：不访问数据库，索引未就绪时返回空结果（调用方可回退到 searchDocuments）
+    virtual Result<size_t> rebuildSearchIndex() = 0;
+    virtual bool isSearchIndexReady() const = 0;
+    virtual std::vector<Document> quickSearchDocuments(const std::string& query, int ownerId = 0, size_t limit = 100,
+                                                       IndexMatchMode mode = IndexMatchMode::Substring) const = 0;
+    virtual DocumentSearchIndexStats getSearchIndexStats() const = 0;
+
+    // Statistics
+    // 读取 usage_stats 汇总表，与文档/分享/用户写入在同一事务内增量维护
+    virtual Result<int> getUserCount() = 0;
+    virtual Result<int> getDocumentCount() = 0;
+    virtual Result<size_t> getTotalFileSize() = 0;
+    virtual Result<UsageStats> getUsageStats(int ownerId = 0) = 0;
+    // 按明细表重算全部计数，修复异常中断或手工改库造成的偏差；返回写入的统计行数
+    virtual Result<size_t> reconcileUsageStats() = 0;
+
+    // Transaction support
+    // 业务代码优先使用 TransactionScope / runTransaction，它们负责配对、嵌套与冲突重试
+    virtual bool beginTransaction() = 0;
+    virtual bool commitTransaction() = 0;
+    virtual bool rollbackTransaction() = 0;
+    virtual bool inTransaction() = 0;
+    // 保存点只能在当前线程的事务中使用；rollbackToSavepoint 回滚后同时释放该保存点
+    virtual bool createSavepoint(const std::string& name) = 0;
+    virtual bool releaseSavepoint(const std::string& name) = 0;
+    virtual bool rollbackToSavepoint(const std::string& name) = 0;
+    // 当前线程最近一次失败是否为可重试的锁冲突（MySQL 死锁/锁等待超时，SQLite 忙），开启事务时清零
+    virtual bool lastErrorRetryable() const = 0;
+
+    // Purge
+    // 分批物理删除软删除的文档与用户：每批先经 removeObject 删除文件，删除成功的文档再在一个短事务中删行，
+    // 文档清理完的用户最后删除。批间停顿 pauseMs；shouldContinue 返回 false 时在批次之间停止。不能在事务中调用。
+    // removeObject 为空表示对象存储不可用：只清理没有文件的文档以及文档已清理完的用户，其余留到下次
+    virtual Result<PurgeStats> purgeDeleted(const PurgeOptions& options, const ObjectRemover& removeObject,
+                                            const std::function<bool()>& shouldContinue = nullptr) = 0;
+
+    // Utility
+    virtual Result<bool> vacuum() = 0;
+    // 原样执行一条SQL（方言由具体后端决定），结果统一装入 QueryResult
+    virtual Result<QueryResult> executeQuery(const std::string& query) = 0;
+
+    // 供 executeQuery 拼接的方言片段
+    // 当前本地时间的表达式，与各表 DATETIME/TEXT 时间列的存储形式一致
+    virtual std::string currentTimestampSql() const = 0;
+    // 接在 INSERT ... VALUES (...) 之后：唯一键 conflictColumns 冲突时改为执行 assignments（SET 部分）
+    virtual std::string upsertClause(const std::string& conflictColumns, const std::string& assignments) const = 0;
+};
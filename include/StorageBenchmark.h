@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common.h"
+#include "StorageBackend.h"
+#include <functional>
+#include <random>
+
+// 基准测试配置（对应命令行 --benchmark 的各参数）
+struct BenchmarkOptions {
+    int users = 200;
+    int documents = 5000;
+    int shares = 2000;
+    uint32_t seed = 20240601;
+    int maxThreads = 8;                  // 并发度依次取 1, 2, 4 ... 直到 maxThreads
+    int durationMs = 3000;               // 每个方法在每个并发度下的压测时长
+    bool keepData = false;               // 结束后保留生成的数据（默认删除测试用户并立即清理其文档与分享）
+};
+
+// 一个方法在一个并发度下的结果
+struct BenchmarkResult {
+    std::string operation;
+    int threads = 0;
+    uint64_t operations = 0;
+    uint64_t errors = 0;
+    double opsPerSecond = 0;
+    uint64_t p50Micros = 0;
+    uint64_t p99Micros = 0;
+    uint64_t maxMicros = 0;
+};
+
+/**
+ * 存储层基准测试
+ * 以固定随机种子生成用户、文档与分享（同一种子在任何平台上生成的数据集相同），再对各个
+ * StorageBackend 方法分别用 1..maxThreads 个线程压测，统计吞吐与延迟分位。
+ * 生成的用户名带 bench_<seed>_ 前缀；目标库中已有同一种子的数据时拒绝运行，避免把结果混进旧数据
+ */
+class StorageBenchmark {
+public:
+    StorageBenchmark(StorageBackend* backend, const BenchmarkOptions& options);
+
+    // 生成数据、逐项压测、按需清理；progress 接收进度文本
+    Result<std::vector<BenchmarkResult>> run(const std::function<void(const std::string&)>& progress = nullptr);
+
+    // 每行一个方法和并发度；baseline 非空时追加与同名同并发度基线的吞吐变化
+    static std::string formatTable(const std::vector<BenchmarkResult>& results,
+                                   const std::vector<BenchmarkResult>& baseline = std::vector<BenchmarkResult>());
+    // 结果连同配置与后端名写成 JSON；readJson 读回其中的结果用作基线
+    Result<bool> writeJson(const std::vector<BenchmarkResult>& results, const std::string& path) const;
+    static Result<std::vector<BenchmarkResult>> readJson(const std::string& path);
+
+private:
+    // 压测用的一次调用：rng 为调用线程私有，返回调用是否成功
+    using Operation = std::function<bool(std::mt19937_64& rng)>;
+
+    StorageBackend* backend;
+    BenchmarkOptions options;
+
+    std::vector<int> userIds;
+    std::vector<std::string> usernames;
+    std::vector<Document> documents;                     // 原始文档（含ID），updateDocument 以此为模板
+    std::vector<std::pair<size_t, int>> shares;          // (documents 下标, sharedToUserId)
+
+    Result<bool> seedData(const std::function<void(const std::string&)>& progress);
+    void cleanup(const std::function<void(const std::string&)>& progress);
+    std::vector<std::pair<std::string, Operation>> operations();
+    BenchmarkResult measure(const std::string& name, const Operation& operation, int threads);
+};
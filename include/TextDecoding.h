@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Common.h"
+#include <charconv>
+#include <string_view>
+
+// 本地时间的年月日时分秒转换为时间点；时区偏移按小时缓存，避免每行调用 mktime
+std::chrono::system_clock::time_point localDateTimeToTimePoint(int year, unsigned month, unsigned day,
+                                                               unsigned hour, unsigned minute, unsigned second);
+
+// 用 std::from_chars 解析整数；空串或格式错误时返回 defaultValue
+template<typename T>
+T parseNumber(std::string_view text, T defaultValue) {
+    T value = defaultValue;
+    auto parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+    return parsed.ec == std::errc() ? value : defaultValue;
+}
+
+// 解析固定格式的 "YYYY-MM-DD HH:MM:SS[.ffffff]"（也接受 'T' 分隔）；格式不符或零日期返回 false
+bool parseDateTime(std::string_view text, std::chrono::system_clock::time_point& out);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Common.h"
+#include "StorageBackend.h"
+#include "Logger.h"
+#include <chrono>
+#include <functional>
+#include <thread>
+
+// 锁冲突重试策略
+struct TransactionRetryOptions {
+    int maxAttempts = 5;                             // 含第一次执行
+    std::chrono::milliseconds baseBackoff{20};       // 第一次重试前等待时间的上限，之后逐次翻倍
+    std::chrono::milliseconds maxBackoff{1000};
+};
+
+// 事务运行统计：只计最外层事务（进程内累计）
+struct TransactionStats {
+    uint64_t committed = 0;
+    uint64_t rolledBack = 0;
+    uint64_t retries = 0;            // 因锁冲突整体重试的次数
+    uint64_t totalMicros = 0;        // 已结束事务的累计耗时
+    uint64_t maxMicros = 0;
+};
+
+/**
+ * 事务作用域（RAII）
+ * 当前线程没有事务时开启事务，已在事务中时建立保存点；析构时未提交的作用域自动回滚
+ * （最外层 ROLLBACK，嵌套层 ROLLBACK TO SAVEPOINT）。作用域只能在创建它的线程上、
+ * 按后进先出的顺序结束。最外层结束时记录耗时，超过 1 秒记一条警告
+ */
+class TransactionScope {
+private:
+    StorageBackend* backend;
+    std::string name;
+    std::string savepoint;
+    bool nested;
+    bool active;
+    std::chrono::steady_clock::time_point startTime;
+
+    void finish(bool committed);
+
+public:
+    explicit TransactionScope(StorageBackend* backend, const std::string& name = "transaction");
+    ~TransactionScope();
+
+    TransactionScope(const TransactionScope&) = delete;
+    TransactionScope& operator=(const TransactionScope&) = delete;
+
+    // 开启事务或建立保存点是否成功
+    bool isActive() const { return active; }
+    bool isNested() const { return nested; }
+
+    bool commit();
+    bool rollback();
+};
+
+// 第 attempt 次重试前的等待时间：上限按 baseBackoff * 2^(attempt-1) 增长到 maxBackoff，在 [0, 上限] 内均匀取值
+std::chrono::milliseconds transactionBackoff(int attempt, const TransactionRetryOptions& options);
+void recordTransactionRetry();
+TransactionStats getTransactionStats();
+
+/**
+ * 在事务作用域中执行 body，成功则提交，失败或抛异常则回滚
+ * 最外层事务遇到锁冲突（见 StorageBackend::lastErrorRetryable）时退避后整体重做，body 必须可以重复执行；
+ * 嵌套调用只回滚到自己的保存点并返回失败，由最外层决定是否重试
+ */
+template<typename T>
+Result<T> runTransaction(StorageBackend* backend, const std::string& name, const std::function<Result<T>()>& body,
+                         const TransactionRetryOptions& options = TransactionRetryOptions()) {
+    for (int attempt = 1; ; ++attempt) {
+        Result<T> result = Result<T>::Error("开启事务失败");
+        bool nested = false;
+        {
+            TransactionScope scope(backend, name);
+            nested = scope.isNested();
+            if (scope.isActive()) {
+                result = body();
+                if (result.success && !scope.commit()) {
+                    result = Result<T>::Error("提交事务失败");
+                }
+            }
+        }
+
+        if (result.success || nested || !backend || !backend->lastErrorRetryable()) {
+            return result;
+        }
+        if (attempt >= options.maxAttempts) {
+            LOG_WARNING("事务 " + name + " 重试 " + std::to_string(attempt - 1) + " 次后仍有锁冲突: " + result.message);
+            return result;
+        }
+        recordTransactionRetry();
+        auto delay = transactionBackoff(attempt, options);
+        LOG_WARNING("事务 " + name + " 遇到锁冲突，" + std::to_string(delay.count()) + "ms 后第 " +
+                    std::to_string(attempt) + " 次重试: " + result.message);
+        std::this_thread::sleep_for(delay);
+    }
+}
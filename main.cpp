@@ -4,6 +4,7 @@
 #include <QTranslator>
 #include <QLocale>
 #include <QStringList>
+#include <QCommandLineParser>
 
 // CLI 模块引入
 #include <iostream>
@@ -38,6 +39,28 @@ int main(int argc, char *argv[]) {
             break;
         }
     }
+    // --benchmark：不打开窗口，生成测试数据压测存储层后退出
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption benchmarkOption("benchmark", "运行存储层基准测试后退出");
+    QCommandLineOption usersOption("users", "测试用户数", "n", "200");
+    QCommandLineOption documentsOption("documents", "测试文档数", "n", "5000");
+    QCommandLineOption sharesOption("shares", "测试分享数", "n", "2000");
+    QCommandLineOption seedOption("seed", "随机种子，相同种子生成相同数据集", "n", "20240601");
+    QCommandLineOption threadsOption("threads", "最大并发线程数（依次测试 1, 2, 4 ... 直到该值）", "n", "8");
+    QCommandLineOption durationOption("duration-ms", "每个方法在每个并发度下的压测时长", "ms", "3000");
+    QCommandLineOption outputOption("output", "结果 JSON 文件", "file", "benchmark_results.json");
+    QCommandLineOption baselineOption("baseline", "与之对比的上次结果 JSON 文件", "file");
+    QCommandLineOption keepDataOption("keep-data", "结束后保留生成的测试数据");
+    // --benchmark-resp：不连接任何服务，只测 RESP 解析器（沿用 --seed 与 --duration-ms）
+    QCommandLineOption respBenchmarkOption("benchmark-resp", "运行 RESP 解析器基准测试与随机数据检查后退出");
+    // --benchmark-rows：不连接数据库，用合成行对比旧的 stoi 映射与 RowDecoder（沿用 --seed 与 --duration-ms）
+    QCommandLineOption rowBenchmarkOption("benchmark-rows", "运行结果行解码基准测试后退出");
+    parser.addOptions({benchmarkOption, usersOption, documentsOption, sharesOption, seedOption, threadsOption,
+                       durationOption, outputOption, baselineOption, keepDataOption, respBenchmarkOption,
+                       rowBenchmarkOption});
+    parser.process(a);
+
     std::string configFile = "config.json";
     ConfigManager::getInstance()->loadConfig(configFile);
     Logger::getInstance()->initialize("cli.log", LogLevel::INFO, 1024 * 1024, 3);
@@ -48,10 +71,38 @@ int main(int argc, char *argv[]) {
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
 
+    if (parser.isSet(respBenchmarkOption)) {
+        RespBenchmarkOptions options;
+        options.seed = parser.value(seedOption).toUInt();
+        options.durationMs = parser.value(durationOption).toInt();
+        return cli.handleRespBenchmark(options) ? 0 : 1;
+    }
+
+    if (parser.isSet(rowBenchmarkOption)) {
+        RowDecodeBenchmarkOptions options;
+        options.seed = parser.value(seedOption).toUInt();
+        options.durationMs = parser.value(durationOption).toInt();
+        return cli.handleRowDecodeBenchmark(options) ? 0 : 1;
+    }
+
     if (!cli.initialize()) {
         std::cerr << "初始化 CLIHandler 失败\n";
         return 1;
     }
+
+    if (parser.isSet(benchmarkOption)) {
+        BenchmarkOptions options;
+        options.users = parser.value(usersOption).toInt();
+        options.documents = parser.value(documentsOption).toInt();
+        options.shares = parser.value(sharesOption).toInt();
+        options.seed = parser.value(seedOption).toUInt();
+        options.maxThreads = parser.value(threadsOption).toInt();
+        options.durationMs = parser.value(durationOption).toInt();
+        options.keepData = parser.isSet(keepDataOption);
+        return cli.handleBenchmark(options, parser.value(outputOption).toStdString(),
+                                   parser.value(baselineOption).toStdString()) ? 0 : 1;
+    }
+
     MainWindow w;
     w.show();
     return a.exec();
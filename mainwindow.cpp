@@ -32,6 +32,7 @@
 #include <QRandomGenerator>
 #include <QPainter>
 #include <QFontMetrics>
+#include <QPointer>
 
 extern CLIHandler* g_cliHandler; // 假设有全局CLIHandler指针
 
@@ -1005,6 +1006,10 @@ void MainWindow::setupMenuTree()
     permissionItem->setText(0, "权限管理");
     permissionItem->setData(0, Qt::UserRole, "permission_management");
     permissionItem->setExpanded(true);
+
+    QTreeWidgetItem *queryStatsItem = new QTreeWidgetItem(treeWidgetMenu);
+    queryStatsItem->setText(0, "查询性能");
+    queryStatsItem->setData(0, Qt::UserRole, "query_stats");
 }
 
 void MainWindow::setupContentPages()
@@ -1274,6 +1279,8 @@ void MainWindow::onMenuItemClicked(QTreeWidgetItem *item, int column)
         showSharedDocumentsPage();
     } else if (itemData == "permission_management") {
         showPermissionManagementDialog();
+    } else if (itemData == "query_stats") {
+        showQueryStatsDialog();
     }
 }
 
@@ -1307,18 +1314,38 @@ void MainWindow::updateDocumentList()
         return;
     }
 
-    User currentUser = currentUserResult.second;
+    int userId = currentUserResult.second.id;
+    quint64 generation = ++documentListGeneration;
 
-    // 查找文档表格
-    QTableWidget *docTable = findChild<QTableWidget*>("tableWidgetDocuments");
-    if (!docTable) {
+    AsyncDatabaseManager *asyncDb = g_cliHandler->getAsyncDbManager();
+    if (!asyncDb) {
+        QTableWidget *docTable = findChild<QTableWidget*>("tableWidgetDocuments");
+        if (docTable) {
+            updateDocumentTableWithData(docTable, g_cliHandler->getUserDocsForUI(userId));
+        }
         return;
     }
 
-    // 获取用户文档列表
-    std::vector<Document> docs = g_cliHandler->getUserDocsForUI(currentUser.id);
-
-    updateDocumentTableWithData(docTable, docs);
+    // 查询在数据库工作线程上执行，界面线程不等待；结果经 invokeMethod 切回界面线程填表
+    QPointer<MainWindow> self(this);
+    asyncDb->submit<Page<Document>>([userId](StorageBackend& db) {
+        return db.getDocumentsByOwnerPage(userId, 100);
+    }, [self, generation](const Result<Page<Document>>& result) {
+        std::vector<Document> docs = result.success ? result.data->items : std::vector<Document>();
+        QString error = result.success ? QString() : QString::fromUtf8(result.message.c_str());
+        QMetaObject::invokeMethod(qApp, [self, generation, docs, error]() {
+            if (!self || generation != self->documentListGeneration) {
+                return;
+            }
+            if (!error.isEmpty()) {
+                qWarning() << "加载文档列表失败:" << error;
+            }
+            QTableWidget *docTable = self->findChild<QTableWidget*>("tableWidgetDocuments");
+            if (docTable) {
+                self->updateDocumentTableWithData(docTable, docs);
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::updateSharedDocumentList()
@@ -1333,18 +1360,38 @@ void MainWindow::updateSharedDocumentList()
         return;
     }
 
-    User currentUser = currentUserResult.second;
+    int userId = currentUserResult.second.id;
+    quint64 generation = ++sharedDocumentListGeneration;
 
-    // 查找分享文档表格
-    QTableWidget *sharedDocTable = findChild<QTableWidget*>("tableWidgetSharedDocuments");
-    if (!sharedDocTable) {
+    AsyncDatabaseManager *asyncDb = g_cliHandler->getAsyncDbManager();
+    if (!asyncDb) {
+        QTableWidget *sharedDocTable = findChild<QTableWidget*>("tableWidgetSharedDocuments");
+        if (sharedDocTable) {
+            updateSharedDocumentTableWithData(sharedDocTable, g_cliHandler->getSharedDocsForUI(userId));
+        }
         return;
     }
 
-    // 获取分享给当前用户的文档列表
-    std::vector<Document> docs = g_cliHandler->getSharedDocsForUI(currentUser.id);
-
-    updateSharedDocumentTableWithData(sharedDocTable, docs);
+    // 与 updateDocumentList 相同：后台查询收件箱，结果切回界面线程
+    QPointer<MainWindow> self(this);
+    asyncDb->submit<Page<Document>>([userId](StorageBackend& db) {
+        return db.getSharedDocumentsPage(userId, 100);
+    }, [self, generation](const Result<Page<Document>>& result) {
+        std::vector<Document> docs = result.success ? result.data->items : std::vector<Document>();
+        QString error = result.success ? QString() : QString::fromUtf8(result.message.c_str());
+        QMetaObject::invokeMethod(qApp, [self, generation, docs, error]() {
+            if (!self || generation != self->sharedDocumentListGeneration) {
+                return;
+            }
+            if (!error.isEmpty()) {
+                qWarning() << "加载分享文档列表失败:" << error;
+            }
+            QTableWidget *sharedDocTable = self->findChild<QTableWidget*>("tableWidgetSharedDocuments");
+            if (sharedDocTable) {
+                self->updateSharedDocumentTableWithData(sharedDocTable, docs);
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::onUploadDocumentClicked()
@@ -1457,9 +1504,10 @@ void MainWindow::onSearchDocumentsClicked()
     if (!currentUserResult.first) return;
 
     User currentUser = currentUserResult.second;
+    ++documentListGeneration;  // 尚未返回的异步列表加载不再覆盖搜索结果
 
-    // 搜索文档
-    std::vector<Document> docs = g_cliHandler->getSearchedDocsForUI(currentUser.id, keyword.toUtf8().toStdString());
+    // 搜索文档：查内存倒排索引，不走数据库往返（索引未就绪时内部回退到数据库搜索）
+    std::vector<Document> docs = g_cliHandler->quickSearchDocsForUI(currentUser.id, keyword.toUtf8().toStdString());
 
     // 更新表格显示
     QTableWidget *docTable = findChild<QTableWidget*>("tableWidgetDocuments");
@@ -1518,6 +1566,7 @@ void MainWindow::onSearchSharedDocumentsClicked()
     if (!currentUserResult.first) return;
 
     User currentUser = currentUserResult.second;
+    ++sharedDocumentListGeneration;  // 尚未返回的异步列表加载不再覆盖搜索结果
 
     // 获取分享文档并进行本地过滤
     std::vector<Document> allDocs = g_cliHandler->getSharedDocsForUI(currentUser.id);
@@ -2358,6 +2407,128 @@ void MainWindow::showPermissionManagementDialog()
     dialog.exec();
 }
 
+void MainWindow::showQueryStatsDialog()
+{
+    // 查询统计包含SQL语句与执行计划，与权限管理一样只对管理员开放
+    if (!HAS_PERMISSION("permission:assign")) {
+        QMessageBox::warning(this, "权限不足", "您没有查看查询性能的权限");
+        return;
+    }
+
+    if (!g_cliHandler) {
+        QMessageBox::warning(this, "错误", "系统未初始化");
+        return;
+    }
+
+    std::vector<QueryMethodStats> stats;
+    std::vector<SlowQueryRecord> slowQueries;
+    if (!g_cliHandler->getQueryStatsForUI(stats, slowQueries)) {
+        QMessageBox::information(this, "查询性能", "当前存储后端不收集查询统计");
+        return;
+    }
+
+    QDialog statsDialog(this);
+    statsDialog.setWindowTitle("查询性能");
+    statsDialog.setModal(true);
+    statsDialog.resize(1000, 650);
+
+    QVBoxLayout *layout = new QVBoxLayout(&statsDialog);
+
+    QLabel *methodLabel = new QLabel("各方法统计（按累计耗时排序，耗时单位 ms）:");
+    layout->addWidget(methodLabel);
+
+    QTableWidget *table = new QTableWidget(&statsDialog);
+    QStringList headers;
+    headers << "方法" << "调用" << "失败" << "p50" << "p99" << "max" << "累计" << "返回行" << "影响行" << "字节";
+    table->setColumnCount(headers.size());
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSortingEnabled(true);
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    layout->addWidget(table, 3);
+
+    QLabel *slowLabel = new QLabel("最近的慢查询（字面量已替换为 ?）:");
+    layout->addWidget(slowLabel);
+
+    QTextEdit *slowEdit = new QTextEdit(&statsDialog);
+    slowEdit->setReadOnly(true);
+    slowEdit->setLineWrapMode(QTextEdit::NoWrap);
+    slowEdit->setStyleSheet("QTextEdit { font-family: Consolas, monospace; }");
+    layout->addWidget(slowEdit, 2);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    QPushButton *refreshBtn = new QPushButton("刷新");
+    QPushButton *resetBtn = new QPushButton("清零");
+    QPushButton *closeBtn = new QPushButton("关闭");
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(refreshBtn);
+    buttonLayout->addWidget(resetBtn);
+    buttonLayout->addWidget(closeBtn);
+    layout->addLayout(buttonLayout);
+
+    // 数值列按数值排序：耗时以毫秒填入 Qt::DisplayRole
+    auto numberItem = [](double value) {
+        QTableWidgetItem *item = new QTableWidgetItem();
+        item->setData(Qt::DisplayRole, value);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        return item;
+    };
+
+    auto fill = [&]() {
+        table->setSortingEnabled(false);
+        table->setRowCount(static_cast<int>(stats.size()));
+        for (int row = 0; row < static_cast<int>(stats.size()); ++row) {
+            const QueryMethodStats& item = stats[row];
+            table->setItem(row, 0, new QTableWidgetItem(QString::fromUtf8(item.method.c_str())));
+            table->setItem(row, 1, numberItem(static_cast<double>(item.calls)));
+            table->setItem(row, 2, numberItem(static_cast<double>(item.errors)));
+            table->setItem(row, 3, numberItem(item.p50Micros / 1000.0));
+            table->setItem(row, 4, numberItem(item.p99Micros / 1000.0));
+            table->setItem(row, 5, numberItem(item.maxMicros / 1000.0));
+            table->setItem(row, 6, numberItem(item.totalMicros / 1000.0));
+            table->setItem(row, 7, numberItem(static_cast<double>(item.rowsRead)));
+            table->setItem(row, 8, numberItem(static_cast<double>(item.rowsAffected)));
+            table->setItem(row, 9, numberItem(static_cast<double>(item.bytesRead)));
+        }
+        table->setSortingEnabled(true);
+
+        QString text;
+        for (const SlowQueryRecord& record : slowQueries) {
+            QDateTime time = QDateTime::fromSecsSinceEpoch(std::chrono::system_clock::to_time_t(record.time));
+            text += QString("[%1] %2  %3 ms, %4 行\n")
+                        .arg(time.toString("yyyy-MM-dd hh:mm:ss"))
+                        .arg(QString::fromUtf8(record.method.c_str()))
+                        .arg(record.micros / 1000.0, 0, 'f', 1)
+                        .arg(record.rows);
+            text += "    " + QString::fromUtf8(record.statement.c_str()) + "\n";
+            if (!record.plan.empty()) {
+                text += "    EXPLAIN:\n  " + QString::fromUtf8(record.plan.c_str()).replace("\n", "\n  ") + "\n";
+            }
+            text += "\n";
+        }
+        slowEdit->setPlainText(text.isEmpty() ? QString("暂无慢查询") : text);
+    };
+    fill();
+
+    connect(refreshBtn, &QPushButton::clicked, [&]() {
+        g_cliHandler->getQueryStatsForUI(stats, slowQueries);
+        fill();
+    });
+
+    connect(resetBtn, &QPushButton::clicked, [&]() {
+        g_cliHandler->resetQueryStatsForUI();
+        g_cliHandler->getQueryStatsForUI(stats, slowQueries);
+        fill();
+    });
+
+    connect(closeBtn, &QPushButton::clicked, [&]() {
+        statsDialog.accept();
+    });
+
+    statsDialog.exec();
+}
+
 void MainWindow::showErrorDialog(const QString& title, const QString& message)
 {
     // 创建自定义消息框以支持更长的错误消息
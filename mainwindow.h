@@ -50,6 +50,10 @@ private:
     int loginFailCount;
     int registerFailCount;
 
+    // 列表异步加载的序号：每次刷新或搜索递增，回到界面线程时序号已变的旧结果直接丢弃
+    quint64 documentListGeneration = 0;
+    quint64 sharedDocumentListGeneration = 0;
+
     // 初始化方法
     void setupNewUI();
     void setupMenuTree();
@@ -58,6 +62,7 @@ private:
     void showDocumentManagementPage();
     void showSharedDocumentsPage();
     void showPermissionManagementDialog();
+    void showQueryStatsDialog();
     void updateDocumentList();
     void updateSharedDocumentList();
     void onUploadDocumentClicked();
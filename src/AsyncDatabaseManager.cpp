@@ -0,0 +1,377 @@
+#include "AsyncDatabaseManager.h"
+#include "Logger.h"
+
+// ================== DatabaseExecutor ==================
+
+DatabaseExecutor::DatabaseExecutor(size_t workerCount) : stopping(false) {
+    if (workerCount == 0) {
+        workerCount = 1;
+    }
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&DatabaseExecutor::workerLoop, this);
+    }
+}
+
+DatabaseExecutor::~DatabaseExecutor() {
+    shutdown();
+}
+
+void DatabaseExecutor::workerLoop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task(true);
+    }
+}
+
+bool DatabaseExecutor::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopping) {
+            return false;
+        }
+        tasks.push_back(std::move(task));
+    }
+    queueCondition.notify_one();
+    return true;
+}
+
+void DatabaseExecutor::shutdown() {
+    std::deque<Task> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+        abandoned.swap(tasks);
+    }
+    queueCondition.notify_all();
+
+    // 正在执行的任务会跑完；排队中的任务以失败结束，等待方不会永远阻塞
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    for (auto& task : abandoned) {
+        task(false);
+    }
+    if (!abandoned.empty()) {
+        LOG_WARNING("数据库执行器关闭，放弃 " + std::to_string(abandoned.size()) + " 个排队任务");
+    }
+}
+
+size_t DatabaseExecutor::pendingTasks() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return tasks.size();
+}
+
+// ================== CallWatchdog ==================
+
+namespace {
+    // 登记了调用时轮询取消令牌的间隔
+    constexpr auto CANCELLATION_POLL_INTERVAL = std::chrono::milliseconds(50);
+}
+
+CallWatchdog::CallWatchdog() : nextId(0), stopping(false) {
+    watcher = std::thread(&CallWatchdog::watchLoop, this);
+}
+
+CallWatchdog::~CallWatchdog() {
+    shutdown();
+}
+
+uint64_t CallWatchdog::watch(std::chrono::steady_clock::time_point deadline,
+                             const CancellationToken& cancellation, Expire expire) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(watchMutex);
+        id = ++nextId;
+        entries.emplace(id, Entry{deadline, cancellation, std::move(expire)});
+    }
+    watchCondition.notify_one();
+    return id;
+}
+
+void CallWatchdog::unwatch(uint64_t id) {
+    std::lock_guard<std::mutex> lock(watchMutex);
+    entries.erase(id);
+}
+
+void CallWatchdog::watchLoop() {
+    std::unique_lock<std::mutex> lock(watchMutex);
+    while (!stopping) {
+        if (entries.empty()) {
+            watchCondition.wait(lock, [this] { return stopping || !entries.empty(); });
+            continue;
+        }
+
+        // 取出已到期或已取消的调用，回调在锁外执行（回调里可能再提交调用）
+        auto now = std::chrono::steady_clock::now();
+        auto wakeAt = now + CANCELLATION_POLL_INTERVAL;
+        std::vector<std::pair<Expire, std::string>> expired;
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.cancellation.isCancelled()) {
+                expired.emplace_back(std::move(it->second.expire), "操作已取消");
+                it = entries.erase(it);
+            } else if (now >= it->second.deadline) {
+                expired.emplace_back(std::move(it->second.expire), "操作超时（超过截止时间）");
+                it = entries.erase(it);
+            } else {
+                wakeAt = std::min(wakeAt, it->second.deadline);
+                ++it;
+            }
+        }
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (auto& item : expired) {
+                item.first(item.second);
+            }
+            lock.lock();
+            continue;
+        }
+        watchCondition.wait_until(lock, wakeAt);
+    }
+}
+
+void CallWatchdog::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    watchCondition.notify_all();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+}
+
+// ================== AsyncDatabaseManager ==================
+
+AsyncDatabaseManager::AsyncDatabaseManager(StorageBackend* dbManager, size_t workerCount)
+    : dbManager(dbManager), executor(workerCount) {
+    LOG_INFO("异步数据库执行器已启动，工作线程数: " + std::to_string(executor.workerCount()));
+}
+
+AsyncDatabaseManager::~AsyncDatabaseManager() {
+    shutdown();
+}
+
+void AsyncDatabaseManager::shutdown() {
+    // 执行器关闭时被放弃的调用会先从看门狗注销，之后再停看门狗
+    executor.shutdown();
+    watchdog.shutdown();
+}
+
+// User operations
+std::future<Result<User>> AsyncDatabaseManager::createUser(const std::string& username, const std::string& passwordHash,
+                                                           const std::string& email, const AsyncCallOptions& options) {
+    return submit<User>([=](StorageBackend& db) { return db.createUser(username, passwordHash, email); }, options);
+}
+
+std::future<Result<User>> AsyncDatabaseManager::getUserById(int userId, const AsyncCallOptions& options) {
+    return submit<User>([=](StorageBackend& db) { return db.getUserById(userId); }, options);
+}
+
+std::future<Result<User>> AsyncDatabaseManager::getUserByUsername(const std::string& username, const AsyncCallOptions& options) {
+    return submit<User>([=](StorageBackend& db) { return db.getUserByUsername(username); }, options);
+}
+
+std::future<Result<std::vector<User>>> AsyncDatabaseManager::getAllUsers(int limit, int offset, const AsyncCallOptions& options) {
+    return submit<std::vector<User>>([=](StorageBackend& db) { return db.getAllUsers(limit, offset); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::updateUser(const User& user, const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) { return db.updateUser(user); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::deleteUser(int userId, const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) { return db.deleteUser(userId); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::updateUserLastLogin(int userId, const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) { return db.updateUserLastLogin(userId); }, options);
+}
+
+// Document operations
+std::future<Result<Document>> AsyncDatabaseManager::createDocument(const std::string& title, const std::string& description,
+                                                                   const std::string& filePath, const std::string& minioKey,
+                                                                   int ownerId, size_t fileSize, const std::string& contentType,
+                                                                   const AsyncCallOptions& options) {
+    return submit<Document>([=](StorageBackend& db) {
+        return db.createDocument(title, description, filePath, minioKey, ownerId, fileSize, contentType);
+    }, options);
+}
+
+std::future<Result<Document>> AsyncDatabaseManager::getDocumentById(int docId, const AsyncCallOptions& options) {
+    return submit<Document>([=](StorageBackend& db) { return db.getDocumentById(docId); }, options);
+}
+
+std::future<Result<std::vector<Document>>> AsyncDatabaseManager::getDocumentsByOwner(int ownerId, int limit, int offset,
+                                                                                     const AsyncCallOptions& options) {
+    return submit<std::vector<Document>>([=](StorageBackend& db) {
+        return db.getDocumentsByOwner(ownerId, limit, offset);
+    }, options);
+}
+
+std::future<Result<std::vector<Document>>> AsyncDatabaseManager::getAllDocuments(int limit, int offset,
+                                                                                 const AsyncCallOptions& options) {
+    return submit<std::vector<Document>>([=](StorageBackend& db) { return db.getAllDocuments(limit, offset); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::updateDocument(const Document& doc, const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) { return db.updateDocument(doc); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::deleteDocument(int docId, const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) { return db.deleteDocument(docId); }, options);
+}
+
+// Document sharing operations
+std::future<Result<DocumentShare>> AsyncDatabaseManager::createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
+                                                                             int sharedDocumentId, const std::string& sharedMinioKey,
+                                                                             const AsyncCallOptions& options) {
+    return submit<DocumentShare>([=](StorageBackend& db) {
+        return db.createDocumentShare(documentId, sharedByUserId, sharedToUserId, sharedDocumentId, sharedMinioKey);
+    }, options);
+}
+
+std::future<Result<std::vector<Document>>> AsyncDatabaseManager::getSharedDocuments(int userId, int limit, int offset,
+                                                                                    const AsyncCallOptions& options) {
+    return submit<std::vector<Document>>([=](StorageBackend& db) {
+        return db.getSharedDocuments(userId, limit, offset);
+    }, options);
+}
+
+std::future<Result<std::vector<DocumentShare>>> AsyncDatabaseManager::getDocumentShares(int documentId, const AsyncCallOptions& options) {
+    return submit<std::vector<DocumentShare>>([=](StorageBackend& db) { return db.getDocumentShares(documentId); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::deleteDocumentShare(int shareId, const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) { return db.deleteDocumentShare(shareId); }, options);
+}
+
+std::future<Result<bool>> AsyncDatabaseManager::isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId,
+                                                                 const AsyncCallOptions& options) {
+    return submit<bool>([=](StorageBackend& db) {
+        return db.isDocumentShared(documentId, sharedByUserId, sharedToUserId);
+    }, options);
+}
+
+// Batch operations
+std::future<Result<std::vector<int>>> AsyncDatabaseManager::createUsersBatch(const std::vector<User>& users, size_t chunkSize,
+                                                                             const AsyncCallOptions& options) {
+    return submit<std::vector<int>>([=](StorageBackend& db) { return db.createUsersBatch(users, chunkSize); }, options);
+}
+
+std::future<Result<std::vector<int>>> AsyncDatabaseManager::createDocumentsBatch(const std::vector<Document>& documents, size_t chunkSize,
+                                                                                 const AsyncCallOptions& options) {
+    return submit<std::vector<int>>([=](StorageBackend& db) { return db.createDocumentsBatch(documents, chunkSize); }, options);
+}
+
+// Keyset pagination
+std::future<Result<Page<User>>> AsyncDatabaseManager::getUsersPage(int pageSize, const std::string& pageToken,
+                                                                   const AsyncCallOptions& options) {
+    return submit<Page<User>>([=](StorageBackend& db) { return db.getUsersPage(pageSize, pageToken); }, options);
+}
+
+std::future<Result<Page<Document>>> AsyncDatabaseManager::getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken,
+                                                                                  const AsyncCallOptions& options) {
+    return submit<Page<Document>>([=](StorageBackend& db) {
+        return db.getDocumentsByOwnerPage(ownerId, pageSize, pageToken);
+    }, options);
+}
+
+std::future<Result<Page<Document>>> AsyncDatabaseManager::getAllDocumentsPage(int pageSize, const std::string& pageToken,
+                                                                              const AsyncCallOptions& options) {
+    return submit<Page<Document>>([=](StorageBackend& db) { return db.getAllDocumentsPage(pageSize, pageToken); }, options);
+}
+
+std::future<Result<Page<Document>>> AsyncDatabaseManager::getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken,
+                                                                                 const AsyncCallOptions& options) {
+    return submit<Page<Document>>([=](StorageBackend& db) {
+        return db.getSharedDocumentsPage(userId, pageSize, pageToken);
+    }, options);
+}
+
+// Streaming operations
+std::future<Result<size_t>> AsyncDatabaseManager::forEachUser(UserVisitor visitor, const AsyncCallOptions& options) {
+    // 取消令牌同样作用于遍历过程：取消后下一行即停止
+    CancellationToken cancellation = options.cancellation;
+    return submit<size_t>([=](StorageBackend& db) {
+        return db.forEachUser([&](const User& user) {
+            return !cancellation.isCancelled() && visitor(user);
+        });
+    }, options);
+}
+
+std::future<Result<size_t>> AsyncDatabaseManager::forEachDocument(const DocumentFilter& filter, DocumentVisitor visitor,
+                                                                  const AsyncCallOptions& options) {
+    CancellationToken cancellation = options.cancellation;
+    return submit<size_t>([=](StorageBackend& db) {
+        return db.forEachDocument(filter, [&](const Document& doc) {
+            return !cancellation.isCancelled() && visitor(doc);
+        });
+    }, options);
+}
+
+// Search operations
+std::future<Result<std::vector<User>>> AsyncDatabaseManager::searchUsers(const std::string& query, int limit,
+                                                                         const AsyncCallOptions& options) {
+    return submit<std::vector<User>>([=](StorageBackend& db) { return db.searchUsers(query, limit); }, options);
+}
+
+std::future<Result<std::vector<Document>>> AsyncDatabaseManager::searchDocuments(const std::string& query,
+                                                                                 const DocumentSearchOptions& searchOptions,
+                                                                                 const AsyncCallOptions& options) {
+    return submit<std::vector<Document>>([=](StorageBackend& db) {
+        return db.searchDocuments(query, searchOptions);
+    }, options);
+}
+
+std::future<Result<size_t>> AsyncDatabaseManager::rebuildSearchIndex(const AsyncCallOptions& options) {
+    return submit<size_t>([](StorageBackend& db) { return db.rebuildSearchIndex(); }, options);
+}
+
+// Statistics
+std::future<Result<int>> AsyncDatabaseManager::getUserCount(const AsyncCallOptions& options) {
+    return submit<int>([](StorageBackend& db) { return db.getUserCount(); }, options);
+}
+
+std::future<Result<int>> AsyncDatabaseManager::getDocumentCount(const AsyncCallOptions& options) {
+    return submit<int>([](StorageBackend& db) { return db.getDocumentCount(); }, options);
+}
+
+std::future<Result<size_t>> AsyncDatabaseManager::getTotalFileSize(const AsyncCallOptions& options) {
+    return submit<size_t>([](StorageBackend& db) { return db.getTotalFileSize(); }, options);
+}
+
+std::future<Result<UsageStats>> AsyncDatabaseManager::getUsageStats(int ownerId, const AsyncCallOptions& options) {
+    return submit<UsageStats>([=](StorageBackend& db) { return db.getUsageStats(ownerId); }, options);
+}
+
+std::future<Result<size_t>> AsyncDatabaseManager::reconcileUsageStats(const AsyncCallOptions& options) {
+    return submit<size_t>([](StorageBackend& db) { return db.reconcileUsageStats(); }, options);
+}
+
+// Utility
+std::future<Result<bool>> AsyncDatabaseManager::vacuum(const AsyncCallOptions& options) {
+    return submit<bool>([](StorageBackend& db) { return db.vacuum(); }, options);
+}
+
+std::future<Result<QueryResult>> AsyncDatabaseManager::executeQuery(const std::string& query, const AsyncCallOptions& options) {
+    return submit<QueryResult>([=](StorageBackend& db) { return db.executeQuery(query); }, options);
+}
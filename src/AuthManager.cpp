@@ -6,7 +6,7 @@
 #include <random>
 #include <chrono>
 #include <QDebug>
-AuthManager::AuthManager(DatabaseManager* db, RedisManager* redis)
+AuthManager::AuthManager(StorageBackend* db, RedisManager* redis)
         : dbManager(db), redisManager(redis), isLoggedIn(false), currentUserId(-1) {
     // 其他初始化逻辑可写可不写
 }
@@ -73,6 +73,10 @@ Result<User> AuthManager::registerUser(const std::string& username, const std::s
     if (!Utils::isValidEmail(email)) {
         return Result<User>::Error("邮箱格式不正确");
     }
+    // 该前缀留给已删除用户的占位用户名
+    if (username.compare(0, StorageBackend::DELETED_USER_PREFIX.size(), StorageBackend::DELETED_USER_PREFIX) == 0) {
+        return Result<User>::Error("用户名不能以 " + StorageBackend::DELETED_USER_PREFIX + " 开头");
+    }
     // 检查用户名是否已存在
     auto userRes = dbManager->getUserByUsername(username);
     if (userRes.success) {
@@ -8,25 +8,123 @@
 
 #include "Common.h"
 #include <QDebug>
+#include <cstdio>
+
+namespace {
+    // 微秒格式化为 "850us" / "12.3ms" / "1.25s"
+    std::string formatMicros(uint64_t micros) {
+        char buffer[32];
+        if (micros < 1000) {
+            std::snprintf(buffer, sizeof(buffer), "%lluus", static_cast<unsigned long long>(micros));
+        } else if (micros < 1000000) {
+            std::snprintf(buffer, sizeof(buffer), "%.1fms", micros / 1000.0);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%.2fs", micros / 1000000.0);
+        }
+        return buffer;
+    }
+
+    std::string formatQueryStatsTable(const std::vector<QueryMethodStats>& stats) {
+        std::ostringstream out;
+        out << std::left << std::setw(26) << "方法" << std::right << std::setw(9) << "调用" << std::setw(7) << "失败"
+            << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "max" << std::setw(10) << "累计"
+            << std::setw(11) << "返回行" << std::setw(11) << "影响行" << std::setw(12) << "字节" << "\n";
+        for (const auto& item : stats) {
+            out << std::left << std::setw(26) << item.method << std::right << std::setw(9) << item.calls
+                << std::setw(7) << item.errors << std::setw(10) << formatMicros(item.p50Micros)
+                << std::setw(10) << formatMicros(item.p99Micros) << std::setw(10) << formatMicros(item.maxMicros)
+                << std::setw(10) << formatMicros(item.totalMicros) << std::setw(11) << item.rowsRead
+                << std::setw(11) << item.rowsAffected << std::setw(12) << item.bytesRead << "\n";
+        }
+        return out.str();
+    }
+}
+
 CLIHandler* CLIHandler::instance = nullptr;
 
 CLIHandler::CLIHandler()
         : running(false) {
     instance = this; // 设置静态指针，供补全回调用
-    dbManager = std::make_unique<DatabaseManager>();
+    // 配置在构造前已加载，按数据库类型选择存储后端；类型无效时由 initialize 报错
+    if (ConfigManager::getInstance()->getDatabaseType() == "sqlite") {
+        dbManager = std::make_unique<SqliteStorageBackend>();
+    } else {
+        dbManager = std::make_unique<DatabaseManager>();
+    }
     redisManager = std::make_unique<RedisManager>();
     authManager = std::make_unique<AuthManager>(dbManager.get(), redisManager.get());  // ✅ 传递RedisManager
     minioClient = std::make_unique<MinioClient>();
     importExportManager = std::make_unique<ImportExportManager>(dbManager.get());  // ✅ 传参
     permissionManager = std::make_unique<PermissionManager>(dbManager.get());  // ✅ 初始化权限管理器
 
-    // 启动定时线程，定期清理过期会话（每60秒）
+    // 启动定时线程，定期清理过期会话（每60秒），并按配置间隔重算用量统计、归档冷数据（仅 MySQL）、
+    // 物理删除软删除的文档与用户。MySQL 下这些任务经 GET_LOCK 互斥，多个客户端同时到点时只有一个执行
     cleanupThreadRunning = true;
     cleanupThread = std::thread([this]() {
+        auto lastReconcile = std::chrono::steady_clock::now();
+        auto lastArchive = std::chrono::steady_clock::now();
+        auto lastPurge = std::chrono::steady_clock::now();
         while (cleanupThreadRunning) {
             std::this_thread::sleep_for(std::chrono::seconds(60));
             if (!cleanupThreadRunning) break;
             authManager->cleanupExpiredSessions();
+
+            int reconcileInterval = ConfigManager::getInstance()->getMysqlStatsReconcileInterval();
+            auto now = std::chrono::steady_clock::now();
+            if (reconcileInterval > 0 && dbManager->isConnectionValid() &&
+                now - lastReconcile >= std::chrono::seconds(reconcileInterval)) {
+                lastReconcile = now;
+                auto result = dbManager->reconcileUsageStats();
+                if (!result.success) {
+                    LOG_WARNING("定时重算用量统计失败: " + result.message);
+                }
+            }
+
+            ConfigManager* config = ConfigManager::getInstance();
+            int archiveInterval = config->getMysqlArchiveInterval();
+            auto* mysql = dynamic_cast<DatabaseManager*>(dbManager.get());
+            now = std::chrono::steady_clock::now();
+            if (archiveInterval > 0 && mysql && mysql->isConnectionValid() &&
+                now - lastArchive >= std::chrono::seconds(archiveInterval)) {
+                lastArchive = now;
+                MySqlArchiveOptions archiveOptions;
+                archiveOptions.hotDays = config->getMysqlArchiveHotDays();
+                archiveOptions.batchSize = config->getMysqlArchiveBatchSize();
+                archiveOptions.pauseMs = config->getMysqlArchivePause();
+                archiveOptions.maxBatches = config->getMysqlArchiveMaxBatches();
+                // 退出时在批次之间停下，未完成的部分留给下一轮
+                auto result = mysql->archiveColdDocuments(archiveOptions, [this]() { return cleanupThreadRunning.load(); });
+                if (!result.success) {
+                    LOG_WARNING("定时归档失败: " + result.message);
+                }
+            }
+
+            // 文件必须先从对象存储删掉；MinIO 不可用时只清理没有文件的文档和文档已清理完的用户，其余留到下一轮
+            int purgeInterval = config->getPurgeInterval();
+            now = std::chrono::steady_clock::now();
+            if (purgeInterval > 0 && dbManager->isConnectionValid() &&
+                now - lastPurge >= std::chrono::seconds(purgeInterval)) {
+                lastPurge = now;
+                PurgeOptions purgeOptions;
+                purgeOptions.batchSize = config->getPurgeBatchSize();
+                purgeOptions.pauseMs = config->getPurgePause();
+                purgeOptions.maxBatches = config->getPurgeMaxBatches();
+                ObjectRemover removeObject;
+                if (minioClient->isInitialized()) {
+                    removeObject = [this](const std::string& key) {
+                        auto removed = minioClient->removeObject(key);
+                        if (!removed.success) {
+                            LOG_WARNING("清理文件 " + key + " 失败: " + removed.message);
+                        }
+                        return removed.success;
+                    };
+                }
+                auto result = dbManager->purgeDeleted(purgeOptions, removeObject,
+                                                      [this]() { return cleanupThreadRunning.load(); });
+                if (!result.success) {
+                    LOG_WARNING("定时清理已删除数据失败: " + result.message);
+                }
+            }
         }
     });
 }
@@ -48,15 +146,59 @@ bool CLIHandler::initialize() {
     bool dbOk = false;
     
     if (dbType == "mysql") {
-        dbOk = dbManager->connect(
+        MySqlPoolOptions poolOptions;
+        poolOptions.minSize = config->getMysqlPoolMinSize();
+        poolOptions.maxSize = config->getMysqlPoolMaxSize();
+        poolOptions.idleTimeoutSeconds = config->getMysqlPoolIdleTimeout();
+        poolOptions.checkoutTimeoutMs = config->getMysqlPoolCheckoutTimeout();
+        poolOptions.healthCheckSeconds = config->getMysqlPoolHealthCheckInterval();
+        poolOptions.statementCacheSize = config->getMysqlStatementCacheSize();
+
+        // 副本未写的账号、密码、库名沿用主库配置
+        MySqlReplicationOptions replicationOptions;
+        replicationOptions.healthCheckSeconds = config->getMysqlReplicaHealthCheckInterval();
+        replicationOptions.maxLagSeconds = config->getMysqlReplicaMaxLag();
+        replicationOptions.readYourWritesMs = config->getMysqlReadYourWritesWindow();
+        for (const auto& item : config->getMysqlReplicas()) {
+            if (!item.is_object() || !item.contains("host")) {
+                printWarning("忽略无效的只读副本配置: " + item.dump());
+                continue;
+            }
+            MySqlReplicaEndpoint endpoint;
+            endpoint.host = item.value("host", std::string());
+            endpoint.port = item.value("port", config->getMysqlPort());
+            endpoint.username = item.value("username", config->getMysqlUsername());
+            endpoint.password = item.value("password", config->getMysqlPassword());
+            endpoint.database = item.value("database", config->getMysqlDatabase());
+            replicationOptions.replicas.push_back(endpoint);
+        }
+
+        QueryProfilingOptions profilingOptions;
+        profilingOptions.slowQueryMs = config->getMysqlSlowQueryThreshold();
+        profilingOptions.explainSlowQueries = config->getMysqlExplainSlowQueries();
+        profilingOptions.slowLogSize = static_cast<size_t>(std::max(0, config->getMysqlSlowQueryLogSize()));
+        static_cast<DatabaseManager*>(dbManager.get())->setQueryProfiling(profilingOptions);
+
+        dbOk = static_cast<DatabaseManager*>(dbManager.get())->connect(
             config->getMysqlHost(),
             config->getMysqlPort(),
             config->getMysqlUsername(),
             config->getMysqlPassword(),
-            config->getMysqlDatabase()
+            config->getMysqlDatabase(),
+            poolOptions,
+            replicationOptions
         );
+    } else if (dbType == "sqlite") {
+        SqliteOptions sqliteOptions;
+        sqliteOptions.filename = config->getSqliteFilename();
+        sqliteOptions.mmapSize = config->getSqliteMmapSize();
+        sqliteOptions.busyTimeoutMs = config->getSqliteBusyTimeout();
+        sqliteOptions.readConnections = config->getSqliteReadConnections();
+        sqliteOptions.statementCacheSize = config->getSqliteStatementCacheSize();
+
+        dbOk = static_cast<SqliteStorageBackend*>(dbManager.get())->connect(sqliteOptions);
     } else {
-        printError("不支持的数据库类型: " + dbType + "，目前只支持 MySQL");
+        printError("不支持的数据库类型: " + dbType + "，目前支持 mysql 和 sqlite");
         return false;
     }
     
@@ -64,13 +206,33 @@ bool CLIHandler::initialize() {
         printError("数据库连接失败！");
         return false;
     }
+    importExportManager->setBatchSize(static_cast<size_t>(std::max(1, config->getMysqlBatchInsertSize())));
+    asyncDbManager = std::make_unique<AsyncDatabaseManager>(
+        dbManager.get(), static_cast<size_t>(std::max(1, config->getMysqlAsyncWorkers())));
     
-    // 尝试连接Redis（可选）
+    // 尝试连接Redis（可选）；界面线程与后台清理线程各自借用连接池中的连接
+    RedisPoolOptions redisPoolOptions;
+    redisPoolOptions.minSize = config->getRedisPoolMinSize();
+    redisPoolOptions.maxSize = config->getRedisPoolMaxSize();
+    redisPoolOptions.checkoutTimeoutMs = config->getRedisPoolCheckoutTimeout();
+    redisPoolOptions.healthCheckSeconds = config->getRedisPoolHealthCheckInterval();
+    redisPoolOptions.breakerThreshold = config->getRedisBreakerThreshold();
+    redisPoolOptions.backoffInitialMs = config->getRedisBackoffInitial();
+    redisPoolOptions.backoffMaxMs = config->getRedisBackoffMax();
+    // 异步客户端另占一条连接，断线重连沿用同一组退避参数
+    RedisAsyncOptions redisAsyncOptions;
+    redisAsyncOptions.enabled = config->getRedisAsyncEnabled();
+    redisAsyncOptions.maxPending = std::max(1, config->getRedisAsyncMaxPending());
+    redisAsyncOptions.backoffInitialMs = redisPoolOptions.backoffInitialMs;
+    redisAsyncOptions.backoffMaxMs = redisPoolOptions.backoffMaxMs;
     bool redisOk = redisManager->connect(
         config->getRedisHost(),
         config->getRedisPort(),
         config->getRedisPassword(),
-        config->getRedisDatabase()
+        config->getRedisDatabase(),
+        config->getRedisTimeout(),
+        redisPoolOptions,
+        redisAsyncOptions
     );
     
     if (redisOk) {
@@ -132,6 +294,17 @@ void CLIHandler::shutdown() {
     if (cleanupThread.joinable()) {
         cleanupThread.join();
     }
+    // 排队中的异步数据库调用以失败结束，正在执行的调用等待完成
+    if (asyncDbManager) {
+        asyncDbManager->shutdown();
+    }
+
+    // 退出前把本次运行的查询统计写入日志，便于事后对比调优效果
+    std::vector<QueryMethodStats> stats;
+    std::vector<SlowQueryRecord> slowQueries;
+    if (getQueryStatsForUI(stats, slowQueries) && !stats.empty()) {
+        LOG_INFO("数据库查询统计:\n" + formatQueryStatsTable(stats));
+    }
 }
 
 
@@ -193,11 +366,21 @@ void CLIHandler::printInfo(const std::string& message) {
 
 
 std::vector<User> CLIHandler::getAllUsersForUI() {
-    auto result = authManager->getAllUsers();
+    // 流式遍历全部用户，不受 getAllUsers 默认 100 行上限的截断
+    std::vector<User> users;
+    forEachUserForUI([&users](const User& user) {
+        users.push_back(user);
+        return true;
+    });
+    return users;
+}
+
+size_t CLIHandler::forEachUserForUI(const UserVisitor& visitor) {
+    auto result = dbManager->forEachUser(visitor);
     if (result.success) {
         return result.data.value();
     }
-    return {};
+    return 0;
 }
 
 std::vector<User> CLIHandler::getSearchedUsersForUI(const std::string& keyword) {
@@ -217,32 +400,61 @@ std::pair<bool, User> CLIHandler::getCurrentUserForUI() {
 }
 
 std::vector<Document> CLIHandler::getUserDocsForUI(int userId) {
-    auto result = dbManager->getDocumentsByOwner(userId, 100, 0);
+    std::string nextPageToken;
+    return getUserDocsForUI(userId, "", nextPageToken);
+}
+
+std::vector<Document> CLIHandler::getUserDocsForUI(int userId, const std::string& pageToken, std::string& nextPageToken, int pageSize) {
+    nextPageToken.clear();
+    auto result = dbManager->getDocumentsByOwnerPage(userId, pageSize, pageToken);
     if (result.success) {
-        return result.data.value();
+        nextPageToken = result.data->nextPageToken;
+        return result.data->items;
     }
     return {};
 }
 
-std::vector<Document> CLIHandler::getSearchedDocsForUI(int userId, const std::string& keyword) {
-    auto result = dbManager->searchDocuments(keyword, 100);
+std::vector<Document> CLIHandler::getSearchedDocsForUI(int userId, const std::string& keyword, int limit, int offset) {
+    // 所有者过滤在SQL中完成，结果按相关度排序
+    DocumentSearchOptions options;
+    options.ownerId = userId;
+    options.limit = limit;
+    options.offset = offset;
+    auto result = dbManager->searchDocuments(keyword, options);
     if (result.success) {
-        std::vector<Document> allDocs = result.data.value();
-        std::vector<Document> filtered;
-        for (const auto& doc : allDocs) {
-            if (doc.owner_id == userId) {
-                filtered.push_back(doc);
-            }
-        }
-        return filtered;
+        return result.data.value();
     }
     return {};
 }
 
+std::vector<Document> CLIHandler::quickSearchDocsForUI(int userId, const std::string& keyword, int limit) {
+    if (!dbManager->isSearchIndexReady()) {
+        return getSearchedDocsForUI(userId, keyword, limit);
+    }
+    return dbManager->quickSearchDocuments(keyword, userId, static_cast<size_t>(std::max(0, limit)));
+}
+
+bool CLIHandler::getQueryStatsForUI(std::vector<QueryMethodStats>& stats, std::vector<SlowQueryRecord>& slowQueries) {
+    // 目前只有 MySQL 后端按方法统计
+    auto* mysql = dynamic_cast<DatabaseManager*>(dbManager.get());
+    if (!mysql) {
+        return false;
+    }
+    stats = mysql->getQueryStats();
+    slowQueries = mysql->getSlowQueries();
+    return true;
+}
+
+void CLIHandler::resetQueryStatsForUI() {
+    if (auto* mysql = dynamic_cast<DatabaseManager*>(dbManager.get())) {
+        mysql->resetQueryStats();
+    }
+}
+
 std::vector<Document> CLIHandler::getSharedDocsForUI(int userId) {
-    auto result = dbManager->getSharedDocuments(userId, 100, 0);
+    auto result = dbManager->getSharedDocumentsPage(userId, 100);
     if (result.success) {
-        return result.data.value();
+        return result.data->items;
     }
     return {};
 }
@@ -329,7 +541,7 @@ bool CLIHandler::handleGetDocument(int docId) {
     }
 }
 
-bool CLIHandler::handleListDocuments(int limit, int offset) {
+bool CLIHandler::handleListDocuments(int limit, const std::string& pageToken, bool includeArchived) {
     if (!authManager->isCurrentlyLoggedIn()) {
         printError("请先登录");
         return false;
@@ -344,9 +556,11 @@ bool CLIHandler::handleListDocuments(int limit, int offset) {
     
     User currentUser = userResult.data.value();
     
-    auto result = dbManager->getDocumentsByOwner(currentUser.id, limit, offset);
+    auto* mysql = dynamic_cast<DatabaseManager*>(dbManager.get());
+    auto result = includeArchived && mysql ? mysql->getDocumentsByOwnerPage(currentUser.id, limit, pageToken, true)
+                                           : dbManager->getDocumentsByOwnerPage(currentUser.id, limit, pageToken);
     if (result.success) {
-        std::vector<Document> docs = result.data.value();
+        const std::vector<Document>& docs = result.data->items;
         qDebug() << QString::fromUtf8("文档列表 (共 " + std::to_string(docs.size()) + " 个文档):");
         qDebug() << "ID\t标题\t\t\t大小\t\t创建时间\n";
         qDebug() << "------------------------------------------------\n";
@@ -356,6 +570,9 @@ bool CLIHandler::handleListDocuments(int limit, int offset) {
                       << doc.file_size << " bytes\t" 
                       << Utils::formatTimestamp(doc.created_at) +"\n";
         }
+        if (!result.data->nextPageToken.empty()) {
+            printInfo("下一页令牌: " + result.data->nextPageToken);
+        }
         return true;
     } else {
         printError("获取文档列表失败: " + result.message);
@@ -459,27 +676,7 @@ bool CLIHandler::handleUpdateDocument(int docId, const std::string& title, const
 }
 
 bool CLIHandler::handleDeleteDocument(int docId) {
-    
-    // 先获取文档信息
-    auto getResult = dbManager->getDocumentById(docId);
-    if (!getResult.success) {
-        printError("文档不存在: " + getResult.message);
-        return false;
-    }
-    
-    Document doc = getResult.data.value();
-    
-    // 删除MinIO中的文件
-    if (minioClient && minioClient->isInitialized() && !doc.minio_key.empty()) {
-        auto deleteResult = minioClient->removeObject(doc.minio_key);
-        if (!deleteResult.success) {
-            printWarning("MinIO文件删除失败: " + deleteResult.message);
-        } else {
-            printSuccess("MinIO文件删除成功");
-        }
-    }
-    
-    // 删除数据库记录
+    // 只做软删除，MinIO中的文件由定时线程在清理该文档时删除
     auto result = dbManager->deleteDocument(docId);
     if (result.success) {
         printSuccess("文档删除成功");
@@ -625,7 +822,7 @@ bool CLIHandler::handleShareDocument(int docId, const std::string& targetUsernam
     return true;
 }
 
-bool CLIHandler::handleListSharedDocuments(int limit, int offset) {
+bool CLIHandler::handleListSharedDocuments(int limit, const std::string& pageToken, bool includeArchived) {
     // 获取当前用户
     auto currentUserResult = authManager->getCurrentUser();
     if (!currentUserResult.success) {
@@ -635,9 +832,11 @@ bool CLIHandler::handleListSharedDocuments(int limit, int offset) {
     User currentUser = currentUserResult.data.value();
 
     // 获取分享给当前用户的文档
-    auto result = dbManager->getSharedDocuments(currentUser.id, limit, offset);
+    auto* mysql = dynamic_cast<DatabaseManager*>(dbManager.get());
+    auto result = includeArchived && mysql ? mysql->getSharedDocumentsPage(currentUser.id, limit, pageToken, true)
+                                           : dbManager->getSharedDocumentsPage(currentUser.id, limit, pageToken);
     if (result.success) {
-        std::vector<Document> docs = result.data.value();
+        const std::vector<Document>& docs = result.data->items;
         qDebug() << QString::fromUtf8("分享给我的文档 (共 " + std::to_string(docs.size()) + " 个):");
         qDebug() << "ID\t标题\t\t\t大小\t\t分享时间\n";
         qDebug() << "------------------------------------------------\n";
@@ -647,6 +846,9 @@ bool CLIHandler::handleListSharedDocuments(int limit, int offset) {
                       << doc.file_size << " bytes\t"
                       << Utils::formatTimestamp(doc.created_at) +"\n";
         }
+        if (!result.data->nextPageToken.empty()) {
+            printInfo("下一页令牌: " + result.data->nextPageToken);
+        }
         return true;
     } else {
         printError("获取分享文档失败: " + result.message);
@@ -713,6 +915,168 @@ void CLIHandler::printDocument(const Document& doc) {
         + "\n==================");
 }
 
+bool CLIHandler::handleQueryStats(bool reset) {
+    std::vector<QueryMethodStats> stats;
+    std::vector<SlowQueryRecord> slowQueries;
+    if (!getQueryStatsForUI(stats, slowQueries)) {
+        printWarning("当前存储后端（" + dbManager->backendName() + "）不收集查询统计");
+        return false;
+    }
+
+    qDebug() << "\n=== 数据库查询统计 ===\n";
+    if (stats.empty()) {
+        printInfo("还没有数据库调用");
+    } else {
+        qDebug().noquote() << QString::fromUtf8(formatQueryStatsTable(stats));
+    }
+
+    auto* mysql = static_cast<DatabaseManager*>(dbManager.get());
+    QueryProfilingOptions options = mysql->getQueryProfiling();
+    qDebug().noquote() << QString::fromUtf8("最近的慢查询（阈值 " + std::to_string(options.slowQueryMs) + "ms，共 " +
+                                            std::to_string(slowQueries.size()) + " 条）:");
+    for (const auto& record : slowQueries) {
+        std::time_t time = std::chrono::system_clock::to_time_t(record.time);
+        std::ostringstream line;
+        line << "  [" << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S") << "] " << record.method << " "
+             << formatMicros(record.micros) << ", " << record.rows << " 行\n    " << record.statement;
+        if (!record.plan.empty()) {
+            line << "\n    EXPLAIN:\n  " << record.plan;
+        }
+        qDebug().noquote() << QString::fromUtf8(line.str());
+    }
+    qDebug() << "=========================\n";
+
+    if (reset) {
+        resetQueryStatsForUI();
+        printSuccess("查询统计已清零");
+    }
+    return true;
+}
+
+bool CLIHandler::handleBenchmark(const BenchmarkOptions& options, const std::string& outputFile,
+                                 const std::string& baselineFile) {
+    if (!dbManager || !dbManager->isConnectionValid()) {
+        printError("数据库未连接，无法运行基准测试");
+        return false;
+    }
+
+    std::vector<BenchmarkResult> baseline;
+    if (!baselineFile.empty()) {
+        auto baselineResult = StorageBenchmark::readJson(baselineFile);
+        if (!baselineResult.success || !baselineResult.data.has_value()) {
+            printError(baselineResult.message);
+            return false;
+        }
+        baseline = baselineResult.data.value();
+    }
+
+    qDebug().noquote() << QString::fromUtf8("\n=== 存储层基准测试（" + dbManager->backendName() + "，种子 " +
+                                            std::to_string(options.seed) + "）===\n");
+    StorageBenchmark benchmark(dbManager.get(), options);
+    auto result = benchmark.run([this](const std::string& text) {
+        printInfo(text);
+    });
+    if (!result.success || !result.data.has_value()) {
+        printError("基准测试失败: " + result.message);
+        return false;
+    }
+
+    const auto& results = result.data.value();
+    qDebug().noquote() << QString::fromUtf8(StorageBenchmark::formatTable(results, baseline));
+
+    uint64_t errors = 0;
+    for (const auto& item : results) {
+        errors += item.errors;
+    }
+    if (errors > 0) {
+        printWarning("压测期间共有 " + std::to_string(errors) + " 次调用失败，详见日志");
+    }
+
+    if (!outputFile.empty()) {
+        auto written = benchmark.writeJson(results, outputFile);
+        if (!written.success) {
+            printError(written.message);
+            return false;
+        }
+        printSuccess(written.message);
+    }
+    return true;
+}
+
+bool CLIHandler::handleRespBenchmark(const RespBenchmarkOptions& options) {
+    qDebug().noquote() << QString::fromUtf8("\n=== RESP 解析器基准测试（种子 " + std::to_string(options.seed) + "）===\n");
+    RespBenchmark benchmark(options);
+    auto result = benchmark.run([this](const std::string& text) {
+        printInfo(text);
+    });
+    if (!result.success || !result.data.has_value()) {
+        printError("RESP 解析器基准测试失败: " + result.message);
+        return false;
+    }
+
+    qDebug().noquote() << QString::fromUtf8(RespBenchmark::formatReport(result.data.value()));
+    return true;
+}
+
+bool CLIHandler::handleRowDecodeBenchmark(const RowDecodeBenchmarkOptions& options) {
+    qDebug().noquote() << QString::fromUtf8("\n=== 结果行解码基准测试（种子 " + std::to_string(options.seed) + "）===\n");
+    RowDecodeBenchmark benchmark(options);
+    auto result = benchmark.run([this](const std::string& text) {
+        printInfo(text);
+    });
+    if (!result.success || !result.data.has_value()) {
+        printError("结果行解码基准测试失败: " + result.message);
+        return false;
+    }
+
+    qDebug().noquote() << QString::fromUtf8(RowDecodeBenchmark::formatReport(result.data.value()));
+    return true;
+}
+
+bool CLIHandler::handleRedisStatus() {
+    qDebug() << "\n=== Redis 状态检查 ===\n";
+    
+    if (!redisManager) {
+        printError("Redis管理器未创建");
+        return false;
+    }
+    
+    RedisPoolStats stats = redisManager->getPoolStats();
+    qDebug() << "Redis连接状态: " << (redisManager->isConnected() ? "可用" : (stats.breakerOpen ? "已熔断" : "未连接"));
+    qDebug() << QString::fromUtf8("连接池: 共 " + std::to_string(stats.totalConnections) + " 条, 空闲 " +
+                                  std::to_string(stats.idleConnections) + " 条, 使用中 " +
+                                  std::to_string(stats.inUseConnections) + " 条");
+    qDebug() << QString::fromUtf8("借用 " + std::to_string(stats.checkouts) + " 次, 等待 " +
+                                  std::to_string(stats.waits) + " 次, 超时 " + std::to_string(stats.timeouts) + " 次");
+    qDebug() << QString::fromUtf8("重连 " + std::to_string(stats.reconnects) + " 次, 健康检查失败 " +
+                                  std::to_string(stats.healthCheckFailures) + " 次");
+    qDebug() << QString::fromUtf8("熔断 " + std::to_string(stats.breakerTrips) + " 次, 熔断期间拒绝 " +
+                                  std::to_string(stats.rejected) + " 次, 失败命令 " +
+                                  std::to_string(stats.failedCommands) + " 条");
+    
+    if (redisManager->isAsyncEnabled()) {
+        RedisAsyncStats asyncStats = redisManager->getAsyncStats();
+        qDebug() << QString::fromUtf8("异步客户端: " + std::string(asyncStats.connected ? "已连接" : "断线重连中") +
+                                      ", 未完成 " + std::to_string(asyncStats.inFlight) + " 个, 已提交 " +
+                                      std::to_string(asyncStats.submitted) + " 个, 完成 " +
+                                      std::to_string(asyncStats.completed) + " 个, 失败 " +
+                                      std::to_string(asyncStats.failed) + " 个, 重连 " +
+                                      std::to_string(asyncStats.reconnects) + " 次");
+    } else {
+        qDebug() << "异步客户端: 未启用";
+    }
+    
+    if (!redisManager->isConnected()) {
+        return false;
+    }
+    if (redisManager->ping()) {
+        printSuccess("Redis服务正常");
+        return true;
+    }
+    printError("Redis ping失败");
+    return false;
+}
+
 bool CLIHandler::handleMinioStatus() {
     qDebug() << "\n=== MinIO 状态检查 ===\n";
     
@@ -722,6 +1086,15 @@ bool CLIHandler::handleMinioStatus() {
     }
     
     qDebug() << "MinIO客户端初始化状态: " << (minioClient->isInitialized() ? "已初始化" : "未初始化");
+
+    // 数据库侧的文档数与总字节数来自 usage_stats 汇总表，可与下方的对象列表对照
+    auto usage = dbManager->getUsageStats(0);
+    if (usage.success) {
+        qDebug() << QString::fromUtf8("数据库记录: " + std::to_string(usage.data->documentCount) + " 个文档, 共 " +
+                                      std::to_string(usage.data->totalBytes) + " bytes");
+    } else {
+        printWarning("获取用量统计失败: " + usage.message);
+    }
     
     if (!minioClient->isInitialized()) {
         printError("MinIO客户端未初始化，无法检查状态");
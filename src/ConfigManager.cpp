@@ -50,6 +50,30 @@ std::string ConfigManager::getSqliteFilename() const {
             .value("filename", "data/management.db");
 }
 
+long long ConfigManager::getSqliteMmapSize() const {
+    return config.value("database", json::object())
+            .value("sqlite", json::object())
+            .value("mmap_size", 268435456LL);
+}
+
+int ConfigManager::getSqliteBusyTimeout() const {
+    return config.value("database", json::object())
+            .value("sqlite", json::object())
+            .value("busy_timeout", 5000);
+}
+
+int ConfigManager::getSqliteReadConnections() const {
+    return config.value("database", json::object())
+            .value("sqlite", json::object())
+            .value("read_connections", 4);
+}
+
+int ConfigManager::getSqliteStatementCacheSize() const {
+    return config.value("database", json::object())
+            .value("sqlite", json::object())
+            .value("statement_cache_size", 64);
+}
+
 std::string ConfigManager::getMysqlHost() const {
     return config.value("database", json::object())
             .value("mysql", json::object())
@@ -80,6 +104,176 @@ std::string ConfigManager::getMysqlDatabase() const {
             .value("database", "management_system");
 }
 
+int ConfigManager::getMysqlPoolMinSize() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("pool", json::object())
+            .value("min_size", 2);
+}
+
+int ConfigManager::getMysqlPoolMaxSize() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("pool", json::object())
+            .value("max_size", 10);
+}
+
+int ConfigManager::getMysqlPoolIdleTimeout() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("pool", json::object())
+            .value("idle_timeout", 300);
+}
+
+int ConfigManager::getMysqlPoolCheckoutTimeout() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("pool", json::object())
+            .value("checkout_timeout", 5000);
+}
+
+int ConfigManager::getMysqlPoolHealthCheckInterval() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("pool", json::object())
+            .value("health_check_interval", 30);
+}
+
+int ConfigManager::getMysqlStatementCacheSize() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("pool", json::object())
+            .value("statement_cache_size", 64);
+}
+
+int ConfigManager::getMysqlBatchInsertSize() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("batch_insert_size", 500);
+}
+
+int ConfigManager::getMysqlAsyncWorkers() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("async_workers", 4);
+}
+
+int ConfigManager::getMysqlStatsReconcileInterval() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("stats_reconcile_interval", 3600);
+}
+
+json ConfigManager::getMysqlReplicas() const {
+    json replicas = config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("replication", json::object())
+            .value("replicas", json::array());
+    return replicas.is_array() ? replicas : json::array();
+}
+
+int ConfigManager::getMysqlReplicaHealthCheckInterval() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("replication", json::object())
+            .value("health_check_interval", 5);
+}
+
+int ConfigManager::getMysqlReplicaMaxLag() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("replication", json::object())
+            .value("max_lag_seconds", 30);
+}
+
+int ConfigManager::getMysqlReadYourWritesWindow() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("replication", json::object())
+            .value("read_your_writes_window", 2000);
+}
+
+int ConfigManager::getMysqlSlowQueryThreshold() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("profiling", json::object())
+            .value("slow_query_ms", 200);
+}
+
+bool ConfigManager::getMysqlExplainSlowQueries() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("profiling", json::object())
+            .value("explain_slow_queries", true);
+}
+
+int ConfigManager::getMysqlSlowQueryLogSize() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("profiling", json::object())
+            .value("slow_log_size", 50);
+}
+
+// 默认关闭：图形界面只读在线表，归档后的文档在界面上不可见，需在配置中显式开启
+int ConfigManager::getMysqlArchiveInterval() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("archive", json::object())
+            .value("interval", 0);
+}
+
+int ConfigManager::getMysqlArchiveHotDays() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("archive", json::object())
+            .value("hot_days", 365);
+}
+
+int ConfigManager::getMysqlArchiveBatchSize() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("archive", json::object())
+            .value("batch_size", 500);
+}
+
+int ConfigManager::getMysqlArchivePause() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("archive", json::object())
+            .value("pause_ms", 200);
+}
+
+int ConfigManager::getMysqlArchiveMaxBatches() const {
+    return config.value("database", json::object())
+            .value("mysql", json::object())
+            .value("archive", json::object())
+            .value("max_batches", 200);
+}
+
+int ConfigManager::getPurgeInterval() const {
+    return config.value("database", json::object())
+            .value("purge", json::object())
+            .value("interval", 300);
+}
+
+int ConfigManager::getPurgeBatchSize() const {
+    return config.value("database", json::object())
+            .value("purge", json::object())
+            .value("batch_size", 200);
+}
+
+int ConfigManager::getPurgePause() const {
+    return config.value("database", json::object())
+            .value("purge", json::object())
+            .value("pause_ms", 500);
+}
+
+int ConfigManager::getPurgeMaxBatches() const {
+    return config.value("database", json::object())
+            .value("purge", json::object())
+            .value("max_batches", 100);
+}
+
 // Redis配置
 std::string ConfigManager::getRedisHost() const {
     return config.value("redis", json::object()).value("host", "127.0.0.1");
@@ -101,6 +295,60 @@ int ConfigManager::getRedisTimeout() const {
     return config.value("redis", json::object()).value("timeout", 5000);
 }
 
+int ConfigManager::getRedisPoolMinSize() const {
+    return config.value("redis", json::object())
+            .value("pool", json::object())
+            .value("min_size", 1);
+}
+
+int ConfigManager::getRedisPoolMaxSize() const {
+    return config.value("redis", json::object())
+            .value("pool", json::object())
+            .value("max_size", 8);
+}
+
+int ConfigManager::getRedisPoolCheckoutTimeout() const {
+    return config.value("redis", json::object())
+            .value("pool", json::object())
+            .value("checkout_timeout", 2000);
+}
+
+int ConfigManager::getRedisPoolHealthCheckInterval() const {
+    return config.value("redis", json::object())
+            .value("pool", json::object())
+            .value("health_check_interval", 30);
+}
+
+int ConfigManager::getRedisBreakerThreshold() const {
+    return config.value("redis", json::object())
+            .value("reconnect", json::object())
+            .value("breaker_threshold", 3);
+}
+
+int ConfigManager::getRedisBackoffInitial() const {
+    return config.value("redis", json::object())
+            .value("reconnect", json::object())
+            .value("backoff_initial_ms", 100);
+}
+
+int ConfigManager::getRedisBackoffMax() const {
+    return config.value("redis", json::object())
+            .value("reconnect", json::object())
+            .value("backoff_max_ms", 10000);
+}
+
+bool ConfigManager::getRedisAsyncEnabled() const {
+    return config.value("redis", json::object())
+            .value("async", json::object())
+            .value("enabled", true);
+}
+
+int ConfigManager::getRedisAsyncMaxPending() const {
+    return config.value("redis", json::object())
+            .value("async", json::object())
+            .value("max_pending", 65536);
+}
+
 // MinIO配置
 std::string ConfigManager::getMinioEndpoint() const {
     return config.value("minio", json::object()).value("endpoint", "127.0.0.1:9000");
@@ -1,12 +1,208 @@
 #include "DatabaseManager.h"
 #include "Common.h"
 #include "Logger.h"
+#include "TransactionScope.h"
 #include <QFileInfo>
 #include <QDir>
 #include <mutex>
+#include <set>
 #include <sstream>
-DatabaseManager::DatabaseManager() : db(nullptr), isConnected(false) {
+#include <cstring>
+#include <cctype>
+
+namespace {
+    // 软删除：删除用户或单个文档只写 deleted_at。被删除用户的文档不逐行标记，读取时按所有者过滤
+    // （待清理的用户很少，子查询经 deleted_at 索引物化为一个小集合），由清理线程分批物理删除
+    const std::string DELETED_USER_IDS = "(SELECT id FROM users WHERE deleted_at IS NOT NULL)";
+
+    // 文档可见条件，alias 为表别名前缀（如 "d."）；不含参数，可以直接拼进预处理语句
+    std::string liveDocument(const std::string& alias = "") {
+        return alias + "deleted_at IS NULL AND " + alias + "owner_id NOT IN " + DELETED_USER_IDS;
+    }
+
+    // 删除用户或文档时分享记录不随之删除，读取时隐藏分享人、接收人、原文档或副本文档已删除的分享，
+    // 由 purgeDeleted 分批物理删除。收件箱行只带副本文档ID，原文档经 document_shares 主键查到
+    const std::string LIVE_SHARE_INBOX =
+            "share_inbox.shared_by_user_id NOT IN " + DELETED_USER_IDS +
+            " AND NOT EXISTS (SELECT 1 FROM document_shares ds INNER JOIN documents d"
+            " ON d.id = ds.document_id OR d.id = ds.shared_document_id"
+            " WHERE ds.id = share_inbox.id AND d.deleted_at IS NOT NULL)";
+    const std::string LIVE_SHARE =
+            "shared_by_user_id NOT IN " + DELETED_USER_IDS + " AND shared_to_user_id NOT IN " + DELETED_USER_IDS +
+            " AND NOT EXISTS (SELECT 1 FROM documents d WHERE d.id IN (document_shares.document_id, "
+            "document_shares.shared_document_id) AND d.deleted_at IS NOT NULL)";
+    // 归档分享引用的文档可能仍在在线表中；owner_id 为副本文档的所有者，即接收人
+    const std::string LIVE_ARCHIVED_SHARE =
+            "owner_id NOT IN " + DELETED_USER_IDS + " AND shared_by_user_id NOT IN " + DELETED_USER_IDS +
+            " AND NOT EXISTS (SELECT 1 FROM documents d WHERE d.id IN (document_shares_archive.source_document_id, "
+            "document_shares_archive.document_id) AND d.deleted_at IS NOT NULL)";
+
+    // 热点查询走预处理语句缓存，SQL文本即缓存键
+    const std::string SQL_USER_BY_ID =
+            "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+            "WHERE id = ? AND deleted_at IS NULL";
+    const std::string SQL_USER_BY_USERNAME =
+            "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+            "WHERE username = ? AND deleted_at IS NULL";
+    const std::string SQL_DOCUMENT_BY_ID =
+            "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type "
+            "FROM documents WHERE id = ? AND " + liveDocument();
+    const std::string SQL_DOCUMENTS_BY_OWNER =
+            "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type "
+            "FROM documents WHERE owner_id = ? AND " + liveDocument() + " LIMIT ? OFFSET ?";
+    const std::string SQL_INSERT_DOCUMENT =
+            "INSERT INTO documents (title, description, file_path, minio_key, owner_id, file_size, content_type) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?)";
+    const std::string SQL_DOCUMENT_SHARE_EXISTS =
+            "SELECT COUNT(*) FROM document_shares WHERE document_id = ? AND shared_by_user_id = ? AND shared_to_user_id = ? AND " +
+            LIVE_SHARE;
+    // share_inbox 中与 documents 同序的列表字段，可直接交给 decodeDocument / readDocumentRow
+    const std::string SHARE_INBOX_DOCUMENT_COLUMNS =
+            "document_id, title, description, file_path, minio_key, owner_id, document_created_at, "
+            "document_updated_at, file_size, content_type";
+    // 从分享记录及其副本文档生成收件箱行，调用方追加 WHERE 条件
+    const std::string SQL_FILL_SHARE_INBOX =
+            "INSERT IGNORE INTO share_inbox (shared_to_user_id, created_at, id, shared_by_user_id, " +
+            SHARE_INBOX_DOCUMENT_COLUMNS + ") "
+            "SELECT ds.shared_to_user_id, ds.created_at, ds.id, ds.shared_by_user_id, d.id, d.title, d.description, "
+            "d.file_path, ds.shared_minio_key, d.owner_id, d.created_at, d.updated_at, d.file_size, d.content_type "
+            "FROM document_shares ds INNER JOIN documents d ON d.id = ds.shared_document_id";
+    // 分享副本被修改后同步收件箱；minio_key 保持分享时复制出的键
+    const std::string SQL_SYNC_SHARE_INBOX =
+            "UPDATE share_inbox si INNER JOIN documents d ON d.id = si.document_id "
+            "SET si.title = d.title, si.description = d.description, si.file_path = d.file_path, "
+            "si.owner_id = d.owner_id, si.document_updated_at = d.updated_at, si.file_size = d.file_size, "
+            "si.content_type = d.content_type WHERE si.document_id = ";
+    const std::string SQL_USAGE_STATS =
+            "SELECT user_count, document_count, total_bytes, shares_given, shares_received FROM usage_stats WHERE owner_id = ?";
+
+    // 列顺序与上面的 SELECT 一致
+    User readUserRow(const BoundStatement& stmt) {
+        User user;
+        user.id = stmt.getInt(0);
+        user.username = stmt.getString(1);
+        user.password_hash = stmt.getString(2);
+        user.email = stmt.getString(3);
+        user.created_at = stmt.getTimestamp(4);
+        user.last_login = stmt.isNull(5) ? std::chrono::system_clock::now() : stmt.getTimestamp(5);
+        user.is_active = stmt.getInt(6) != 0;
+        return user;
+    }
+
+    Document readDocumentRow(const BoundStatement& stmt) {
+        Document doc;
+        doc.id = stmt.getInt(0);
+        doc.title = stmt.getString(1);
+        doc.description = stmt.getString(2);
+        doc.file_path = stmt.getString(3);
+        doc.minio_key = stmt.getString(4);
+        doc.owner_id = stmt.getInt(5);
+        doc.created_at = stmt.getTimestamp(6);
+        doc.updated_at = stmt.getTimestamp(7);
+        doc.file_size = static_cast<size_t>(stmt.getInt64(8));
+        doc.content_type = stmt.getString(9);
+        return doc;
+    }
+
+    const int MAX_PAGE_SIZE = 1000;
+
+    std::string escapeString(MYSQL* db, const std::string& value) {
+        std::string escaped(value.size() * 2 + 1, '\0');
+        unsigned long length = mysql_real_escape_string(db, &escaped[0], value.c_str(),
+                                                        static_cast<unsigned long>(value.size()));
+        escaped.resize(length);
+        return escaped;
+    }
+
+    // 按 UTF-8 字符（而非字节）计数
+    size_t utf8Length(const std::string& text) {
+        size_t count = 0;
+        for (unsigned char c : text) {
+            if ((c & 0xC0) != 0x80) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // 客户端错误（2000+）、语句句柄失效（1243）或需要重新预处理（1615）时丢弃缓存的语句
+    bool shouldInvalidateStatement(unsigned int errorCode) {
+        return errorCode >= 2000 || errorCode == 1243 || errorCode == 1615;
+    }
+
+    // 当前线程最近一次失败的 MySQL 错误码，开启事务时清零
+    thread_local unsigned int lastErrorCode = 0;
+
+    void recordError(unsigned int errorCode) {
+        if (errorCode != 0) {
+            lastErrorCode = errorCode;
+        }
+    }
+
+    // 执行文本协议语句，并把语句文本、失败次数与影响行数记到当前方法的计时器上
+    int runQuery(MYSQL* db, const std::string& sql) {
+        QueryTimer* timer = QueryTimer::current();
+        if (timer) {
+            timer->noteStatement(sql);
+        }
+        int rc = mysql_query(db, sql.c_str());
+        if (timer) {
+            if (rc != 0) {
+                timer->markFailed();
+            } else if (mysql_field_count(db) == 0) {
+                timer->addAffected(mysql_affected_rows(db));
+            }
+        }
+        return rc;
+    }
 
+    // 会话级命名锁（GET_LOCK），名字前加库名，各库互不影响；让多个客户端中只有一个执行迁移或后台任务。
+    // timeoutSeconds 为 0 时不等待。连接断开时服务端自动释放
+    bool acquireNamedLock(MYSQL* db, const std::string& name, int timeoutSeconds) {
+        std::string sql = "SELECT GET_LOCK(CONCAT(DATABASE(), '." + name + "'), " + std::to_string(timeoutSeconds) + ");";
+        if (mysql_query(db, sql.c_str()) != 0) {
+            return false;
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+        return row && row[0] && std::string(row[0]) == "1";
+    }
+
+    void releaseNamedLock(MYSQL* db, const std::string& name) {
+        std::string sql = "SELECT RELEASE_LOCK(CONCAT(DATABASE(), '." + name + "'));";
+        if (mysql_query(db, sql.c_str()) == 0) {
+            mysql_free_result(mysql_store_result(db));
+        }
+    }
+
+    // 在作用域结束时释放命名锁，须声明在持锁连接之后，使锁先于连接归还而释放
+    struct NamedLockGuard {
+        MYSQL* db;
+        std::string name;
+        ~NamedLockGuard() { releaseNamedLock(db, name); }
+    };
+
+    // 能做 EXPLAIN 的语句类型
+    bool isExplainable(const std::string& sql) {
+        size_t start = sql.find_first_not_of(" \t\r\n(");
+        if (start == std::string::npos) {
+            return false;
+        }
+        std::string keyword;
+        for (size_t i = start; i < sql.size() && std::isalpha(static_cast<unsigned char>(sql[i])); ++i) {
+            keyword += static_cast<char>(std::toupper(static_cast<unsigned char>(sql[i])));
+        }
+        return keyword == "SELECT" || keyword == "INSERT" || keyword == "UPDATE" || keyword == "DELETE" ||
+               keyword == "REPLACE";
+    }
+}
+
+DatabaseManager::DatabaseManager()
+        : isConnected(false), fulltextSearchEnabled(false), nextReplica(0), replicaReadCount(0), primaryReadCount(0),
+          lastWriteAt(0), replicaMonitorStopping(false) {
+    queryStats.setExplainer([this](const std::string& sql, const std::vector<QueryParameter>& params) {
+        return explainStatement(sql, params);
+    });
 }
 
 DatabaseManager::~DatabaseManager() {
@@ -14,44 +210,70 @@ DatabaseManager::~DatabaseManager() {
 }
 
 bool DatabaseManager::connect(const std::string& host, int port, const std::string& username, 
-                             const std::string& password, const std::string& database) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
+                             const std::string& password, const std::string& database,
+                             const MySqlPoolOptions& poolOptions,
+                             const MySqlReplicationOptions& replicationOptions) {
+    if (pool) {
+        disconnect();
+    }
 
     try {
-        // 初始化MySQL连接
-        db = mysql_init(nullptr);
-        if (!db) {
-            LOG_ERROR("无法初始化MySQL连接");
-            return false;
-        }
-
-        // 设置连接选项
-        mysql_options(db, MYSQL_OPT_RECONNECT, "1");
-        mysql_options(db, MYSQL_SET_CHARSET_NAME, "utf8mb4");
-        mysql_options(db, MYSQL_DEFAULT_AUTH, "mysql_native_password");
-
         //打印连接信息
         LOG_INFO("尝试连接到MySQL数据库: " + host + ":" + std::to_string(port) + "/" + database+
                  " 用户: " + username+" 密码: " + (password.empty() ? "未设置" : "已设置"));
 
-        // 连接到MySQL服务器
-        if (!mysql_real_connect(db, host.c_str(), username.c_str(), password.c_str(), 
-                               database.c_str(), port, nullptr, 0)) {
-            LOG_ERROR("无法连接到MySQL数据库: " + std::string(mysql_error(db)));
-            mysql_close(db);
-            db = nullptr;
+        // 建立连接池（预建 minSize 条连接）
+        pool = std::make_unique<MySqlConnectionPool>(host, port, username, password, database, poolOptions);
+        if (!pool->initialize()) {
+            LOG_ERROR("无法连接到MySQL数据库: " + pool->getLastError());
+            pool.reset();
             return false;
         }
 
         isConnected = true;
         LOG_INFO("MySQL数据库连接成功: " + host + ":" + std::to_string(port) + "/" + database);
 
-        // 创建表
-        if (!createTables()) {
-            LOG_ERROR("创建数据库表失败");
+        // 结构版本落后时才执行迁移
+        PooledConnection conn = pool->acquire();
+        if (!conn || !migrateSchema(conn.get())) {
+            LOG_ERROR("初始化数据库结构失败");
+            conn.release();
             disconnect();
             return false;
         }
+        conn.release();
+
+        // 首次启用统计表时还没有全局行，按明细表初始化一次
+        auto statsResult = getUsageStats(0);
+        if (!statsResult.success) {
+            auto reconcileResult = reconcileUsageStats();
+            if (!reconcileResult.success) {
+                LOG_WARNING("初始化用量统计失败: " + reconcileResult.message);
+            }
+        }
+
+        // 启动时流式扫描构建内存搜索索引，失败不影响连接
+        auto indexResult = rebuildSearchIndex();
+        if (!indexResult.success) {
+            LOG_WARNING("构建文档搜索索引失败: " + indexResult.message);
+        }
+
+        // 主库就绪后再接入只读副本：同步检查一轮，之后由后台线程定期检查
+        replication = replicationOptions;
+        replicaPoolOptions = poolOptions;
+        if (!replication.replicas.empty()) {
+            for (const auto& endpoint : replication.replicas) {
+                auto replica = std::make_unique<Replica>();
+                replica->endpoint = endpoint;
+                checkReplica(*replica);
+                replicas.push_back(std::move(replica));
+            }
+            replicaMonitorStopping = false;
+            replicaMonitor = std::thread(&DatabaseManager::replicaMonitorLoop, this);
+            MySqlReplicationStats replicationStats = getReplicationStats();
+            LOG_INFO("读写分离已启用: 副本 " + std::to_string(replicationStats.replicas) + " 个，可用 " +
+                     std::to_string(replicationStats.healthyReplicas) + " 个");
+        }
 
         return true;
 
@@ -62,21 +284,353 @@ bool DatabaseManager::connect(const std::string& host, int port, const std::stri
 }
 
 void DatabaseManager::disconnect() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-
-    if (db) {
-        mysql_close(db);
-        db = nullptr;
-        isConnected = false;
+    isConnected = false;
+    stopReplicas();
+
+    {
+        // 归还尚未结束的事务连接
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        transactionConnections.clear();
+        pendingIndexChanges.clear();
+    }
+    searchIndex.clear();
+
+    if (pool) {
+        StatementCacheStats stmtStats = pool->getStatementCacheStats();
+        LOG_INFO("预处理语句缓存: 命中 " + std::to_string(stmtStats.hits) +
+                 " 次, 未命中 " + std::to_string(stmtStats.misses) + " 次");
+        pool->shutdown();
+        pool.reset();
         LOG_INFO("MySQL数据库连接已关闭");
     }
 }
 
 bool DatabaseManager::isConnectionValid() const {
-    return isConnected && db != nullptr;
+    return isConnected && pool != nullptr;
+}
+
+MySqlPoolStats DatabaseManager::getPoolStats() const {
+    return pool ? pool->getStats() : MySqlPoolStats();
+}
+
+StatementCacheStats DatabaseManager::getStatementCacheStats() const {
+    return pool ? pool->getStatementCacheStats() : StatementCacheStats();
+}
+
+MySqlReplicationStats DatabaseManager::getReplicationStats() const {
+    MySqlReplicationStats stats;
+    stats.replicas = static_cast<int>(replicas.size());
+    for (const auto& replica : replicas) {
+        if (replica->healthy) {
+            stats.healthyReplicas++;
+        }
+    }
+    stats.replicaReads = replicaReadCount;
+    stats.primaryReads = primaryReadCount;
+    return stats;
+}
+
+MYSQL_STMT* DatabaseManager::acquireStatement(PooledConnection& conn, const std::string& sql) {
+    if (QueryTimer* timer = QueryTimer::current()) {
+        timer->noteStatement(sql);
+    }
+    PreparedStatementCache* statements = conn.statements();
+    return statements ? statements->acquire(sql) : nullptr;
+}
+
+void DatabaseManager::handleStatementError(PooledConnection& conn, const std::string& sql, const BoundStatement& stmt) {
+    recordError(stmt.errorCode());
+    if (QueryTimer* timer = QueryTimer::current()) {
+        timer->markFailed();
+    }
+    PreparedStatementCache* statements = conn.statements();
+    if (statements && shouldInvalidateStatement(stmt.errorCode())) {
+        statements->invalidate(sql);
+    }
+}
+
+std::string DatabaseManager::explainStatement(const std::string& sql, const std::vector<QueryParameter>& params) {
+    if (!isExplainable(sql)) {
+        return std::string();
+    }
+    auto conn = acquireConnection();
+    if (!conn) {
+        return std::string();
+    }
+    MYSQL* db = conn.get();
+
+    // 预处理语句的 ? 按顺序代入最后一次执行的参数，计划才与实际执行一致
+    std::string text;
+    if (params.empty()) {
+        text = sql;
+    } else {
+        text.reserve(sql.size() + 64);
+        size_t next = 0;
+        for (char c : sql) {
+            if (c != '?' || next >= params.size()) {
+                text += c;
+                continue;
+            }
+            const QueryParameter& param = params[next++];
+            if (param.kind == QueryParameter::Kind::Null) {
+                text += "NULL";
+            } else if (param.kind == QueryParameter::Kind::Integer) {
+                text += std::to_string(param.intValue);
+            } else {
+                std::vector<char> escaped(param.text.size() * 2 + 1);
+                unsigned long length = mysql_real_escape_string(db, escaped.data(), param.text.data(),
+                                                                static_cast<unsigned long>(param.text.size()));
+                text += "'";
+                text.append(escaped.data(), length);
+                text += "'";
+            }
+        }
+    }
+
+    if (mysql_query(db, ("EXPLAIN " + text).c_str()) != 0) {
+        return "EXPLAIN 失败: " + std::string(mysql_error(db));
+    }
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+    if (!result) {
+        return std::string();
+    }
+
+    // 每个访问的表一行：列名=值，跳过 NULL 列
+    unsigned int fieldCount = mysql_num_fields(result.get());
+    MYSQL_FIELD* fields = mysql_fetch_fields(result.get());
+    std::string plan;
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        plan += plan.empty() ? "  " : "\n  ";
+        bool first = true;
+        for (unsigned int i = 0; i < fieldCount; ++i) {
+            if (!row[i]) {
+                continue;
+            }
+            plan += (first ? "" : ", ") + std::string(fields[i].name) + "=" + row[i];
+            first = false;
+        }
+    }
+    return plan;
+}
+
+PooledConnection DatabaseManager::acquireConnection() {
+    if (!isConnected || !pool) {
+        return PooledConnection();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto it = transactionConnections.find(std::this_thread::get_id());
+        if (it != transactionConnections.end()) {
+            PooledConnection conn = it->second.borrow();
+            applyCallDeadline(conn);
+            return conn;
+        }
+    }
+
+    PooledConnection conn = pool->acquire();
+    if (!conn) {
+        LOG_WARNING("获取数据库连接失败: " + pool->getLastError());
+        return conn;
+    }
+    applyCallDeadline(conn);
+    return conn;
+}
+
+void DatabaseManager::applyCallDeadline(PooledConnection& conn) {
+    long long remaining = CallDeadline::remainingMs();
+    if (remaining < 0) {
+        return;
+    }
+    // 设置失败不影响本次调用，只是语句不再受服务端时限约束，由异步门面在截止时完成调用
+    conn.setStatementTimeout(std::max(1LL, remaining));
+}
+
+PooledConnection DatabaseManager::acquireReplicaConnection() {
+    if (replicas.empty() || !isConnected || inTransaction() || withinReadYourWritesWindow()) {
+        return PooledConnection();
+    }
+
+    // 从轮询位置开始找第一个健康副本
+    size_t count = replicas.size();
+    size_t start = nextReplica.fetch_add(1, std::memory_order_relaxed);
+    auto checkoutTimeout = std::chrono::milliseconds(std::min(replicaPoolOptions.checkoutTimeoutMs, 1000));
+    for (size_t i = 0; i < count; ++i) {
+        Replica& replica = *replicas[(start + i) % count];
+        if (!replica.healthy.load(std::memory_order_acquire)) {
+            continue;
+        }
+        PooledConnection conn = replica.pool->acquire(checkoutTimeout);
+        if (conn) {
+            replicaReadCount++;
+            applyCallDeadline(conn);
+            return conn;
+        }
+        // 借不到连接（宕机或连接耗尽）时先摘除，等健康检查恢复；本次改读其他副本或主库
+        if (replica.healthy.exchange(false)) {
+            LOG_WARNING("只读副本 " + replica.label() + " 暂停读流量: " + replica.pool->getLastError());
+        }
+    }
+    return PooledConnection();
+}
+
+PooledConnection DatabaseManager::acquireReadConnection() {
+    PooledConnection conn = acquireReplicaConnection();
+    if (conn) {
+        return conn;
+    }
+    if (!replicas.empty()) {
+        primaryReadCount++;
+    }
+    return acquireConnection();
+}
+
+void DatabaseManager::noteWrite() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    lastWriteAt.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), std::memory_order_release);
+}
+
+bool DatabaseManager::withinReadYourWritesWindow() const {
+    long long last = lastWriteAt.load(std::memory_order_acquire);
+    if (last == 0 || replication.readYourWritesMs <= 0) {
+        return false;
+    }
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    return now - last < static_cast<long long>(replication.readYourWritesMs) * 1000000LL;
+}
+
+void DatabaseManager::replicaMonitorLoop() {
+    std::unique_lock<std::mutex> lock(replicaMonitorMutex);
+    auto interval = std::chrono::seconds(std::max(1, replication.healthCheckSeconds));
+    while (!replicaMonitorWakeup.wait_for(lock, interval, [this]() { return replicaMonitorStopping; })) {
+        lock.unlock();
+        for (auto& replica : replicas) {
+            checkReplica(*replica);
+        }
+        lock.lock();
+    }
+}
+
+void DatabaseManager::checkReplica(Replica& replica) {
+    // 启动时连不上的副本在这里重试建池；池建好后不再替换，读路径可以无锁使用
+    if (!replica.pool) {
+        const MySqlReplicaEndpoint& endpoint = replica.endpoint;
+        auto replicaPool = std::make_unique<MySqlConnectionPool>(endpoint.host, endpoint.port, endpoint.username,
+                                                                 endpoint.password, endpoint.database, replicaPoolOptions);
+        if (!replicaPool->initialize()) {
+            setReplicaHealth(replica, false, "无法连接: " + replicaPool->getLastError());
+            return;
+        }
+        replica.pool = std::move(replicaPool);
+    }
+
+    PooledConnection conn = replica.pool->acquire(std::chrono::milliseconds(1000));
+    if (!conn) {
+        setReplicaHealth(replica, false, "获取连接失败: " + replica.pool->getLastError());
+        return;
+    }
+    MYSQL* db = conn.get();
+    if (mysql_ping(db) != 0) {
+        std::string error = mysql_error(db);
+        conn.markBroken();
+        setReplicaHealth(replica, false, "ping 失败: " + error);
+        return;
+    }
+
+    if (replication.maxLagSeconds > 0) {
+        // SHOW SLAVE STATUS 在 MySQL 8 与 MariaDB 上都可用；MySQL 8.0.22 起列名为 Seconds_Behind_Source
+        if (mysql_query(db, "SHOW SLAVE STATUS") != 0) {
+            if (!replica.lagUnknownReported) {
+                LOG_WARNING("无法读取只读副本 " + replica.label() + " 的复制状态，不检查复制延迟: " +
+                            std::string(mysql_error(db)));
+                replica.lagUnknownReported = true;
+            }
+        } else {
+            std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> status(mysql_store_result(db), &mysql_free_result);
+            MYSQL_ROW row = status ? mysql_fetch_row(status.get()) : nullptr;
+            if (row) {
+                unsigned int fieldCount = mysql_num_fields(status.get());
+                MYSQL_FIELD* fields = mysql_fetch_fields(status.get());
+                for (unsigned int i = 0; i < fieldCount; ++i) {
+                    std::string name = fields[i].name;
+                    if (name != "Seconds_Behind_Master" && name != "Seconds_Behind_Source") {
+                        continue;
+                    }
+                    // NULL 表示复制线程没有运行，数据可能停留在任意旧的时间点
+                    if (!row[i]) {
+                        setReplicaHealth(replica, false, "复制线程未运行");
+                        return;
+                    }
+                    long long lag = std::strtoll(row[i], nullptr, 10);
+                    if (lag > replication.maxLagSeconds) {
+                        setReplicaHealth(replica, false, "复制延迟 " + std::to_string(lag) + " 秒");
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    setReplicaHealth(replica, true, "");
+}
+
+void DatabaseManager::setReplicaHealth(Replica& replica, bool healthy, const std::string& reason) {
+    bool wasHealthy = replica.healthy.exchange(healthy);
+    if (healthy) {
+        if (!wasHealthy) {
+            LOG_INFO("只读副本 " + replica.label() + " 已接入读流量");
+        }
+        replica.failureReported = false;
+        return;
+    }
+    if (wasHealthy || !replica.failureReported) {
+        LOG_WARNING("只读副本 " + replica.label() + " 暂停读流量: " + reason);
+    }
+    replica.failureReported = true;
+}
+
+void DatabaseManager::stopReplicas() {
+    {
+        std::lock_guard<std::mutex> lock(replicaMonitorMutex);
+        replicaMonitorStopping = true;
+    }
+    replicaMonitorWakeup.notify_all();
+    if (replicaMonitor.joinable()) {
+        replicaMonitor.join();
+    }
+
+    for (auto& replica : replicas) {
+        replica->healthy = false;
+        if (replica->pool) {
+            replica->pool->shutdown();
+        }
+    }
+    replicas.clear();
+}
+
+template<typename T>
+Result<T> DatabaseManager::runInTransaction(const std::function<Result<T>(PooledConnection&)>& body) {
+    auto run = [&]() {
+        // 借用的事务连接须在提交/回滚之前归还
+        auto conn = acquireConnection();
+        if (!conn) {
+            return Result<T>::Error("数据库未连接");
+        }
+        Result<T> result = body(conn);
+        if (!result.success) {
+            recordError(mysql_errno(conn.get()));
+        }
+        return result;
+    };
+
+    if (inTransaction()) {
+        return run();
+    }
+    return runTransaction<T>(this, "mysql", run);
 }
 
-bool DatabaseManager::createTables() {
+bool DatabaseManager::createTables(MYSQL* db) {
     std::string createUsersTable = R"(
         CREATE TABLE IF NOT EXISTS users (
             id INT AUTO_INCREMENT PRIMARY KEY,
@@ -206,17 +760,6 @@ bool DatabaseManager::createTables() {
         ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
     )";
 
-    std::string createIndexes = R"(
-        CREATE INDEX IF NOT EXISTS idx_users_username ON users(username);
-        CREATE INDEX IF NOT EXISTS idx_users_email ON users(email);
-        CREATE INDEX IF NOT EXISTS idx_documents_owner ON documents(owner_id);
-        CREATE INDEX IF NOT EXISTS idx_documents_title ON documents(title);
-        CREATE INDEX IF NOT EXISTS idx_documents_created ON documents(created_at);
-        CREATE INDEX IF NOT EXISTS idx_document_shares_shared_to ON document_shares(shared_to_user_id);
-        CREATE INDEX IF NOT EXISTS idx_document_shares_shared_by ON document_shares(shared_by_user_id);
-        CREATE INDEX IF NOT EXISTS idx_document_shares_document ON document_shares(document_id);
-    )";
-
     // 创建users表
     if (mysql_query(db, createUsersTable.c_str()) != 0) {
         LOG_ERROR("创建users表失败: " + std::string(mysql_error(db)));
@@ -235,6 +778,24 @@ bool DatabaseManager::createTables() {
         return false;
     }
 
+    // 用量统计汇总表：owner_id = 0 为全局行；随写入在同一事务内增量更新，不设外键以便保留全局行
+    std::string createUsageStatsTable = R"(
+        CREATE TABLE IF NOT EXISTS usage_stats (
+            owner_id INT PRIMARY KEY,
+            user_count BIGINT NOT NULL DEFAULT 0,
+            document_count BIGINT NOT NULL DEFAULT 0,
+            total_bytes BIGINT NOT NULL DEFAULT 0,
+            shares_given BIGINT NOT NULL DEFAULT 0,
+            shares_received BIGINT NOT NULL DEFAULT 0,
+            updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP
+        ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
+    )";
+
+    if (mysql_query(db, createUsageStatsTable.c_str()) != 0) {
+        LOG_ERROR("创建usage_stats表失败: " + std::string(mysql_error(db)));
+        return false;
+    }
+
     // 创建权限管理相关表
     if (mysql_query(db, createRolesTable.c_str()) != 0) {
         LOG_ERROR("创建roles表失败: " + std::string(mysql_error(db)));
@@ -256,7 +817,115 @@ bool DatabaseManager::createTables() {
         return false;
     }
 
-    // 创建用户权限视图
+    return true;
+}
+
+bool DatabaseManager::createShareInbox(MYSQL* db) {
+    // 主键即列表顺序：一个接收人的分享在聚簇索引上连续存放，翻页只做一次主键范围扫描，不回表、不连接 documents。
+    // id 与 document_shares.id 相同，删除分享（含随用户、文档级联删除）时经外键一并删除
+    std::string createShareInboxTable = R"(
+        CREATE TABLE IF NOT EXISTS share_inbox (
+            shared_to_user_id INT NOT NULL,
+            created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            id INT NOT NULL,
+            shared_by_user_id INT NOT NULL,
+            document_id INT NOT NULL,
+            title VARCHAR(255) NOT NULL,
+            description TEXT,
+            file_path VARCHAR(500),
+            minio_key VARCHAR(500),
+            owner_id INT NOT NULL,
+            document_created_at TIMESTAMP NULL,
+            document_updated_at TIMESTAMP NULL,
+            file_size BIGINT DEFAULT 0,
+            content_type VARCHAR(100) DEFAULT '',
+            PRIMARY KEY (shared_to_user_id, created_at, id),
+            UNIQUE KEY uk_share_inbox_id (id),
+            INDEX idx_share_inbox_document (document_id),
+            FOREIGN KEY (id) REFERENCES document_shares(id) ON DELETE CASCADE
+        ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
+    )";
+
+    if (mysql_query(db, createShareInboxTable.c_str()) != 0) {
+        LOG_ERROR("创建share_inbox表失败: " + std::string(mysql_error(db)));
+        return false;
+    }
+
+    // INSERT IGNORE 跳过已回填的行，中途失败后重跑是安全的
+    if (mysql_query(db, SQL_FILL_SHARE_INBOX.c_str()) != 0) {
+        LOG_ERROR("回填share_inbox失败: " + std::string(mysql_error(db)));
+        return false;
+    }
+    LOG_INFO("share_inbox 回填 " + std::to_string(mysql_affected_rows(db)) + " 条分享");
+    return true;
+}
+
+bool DatabaseManager::createArchiveTables(MYSQL* db) {
+    // 在线表有外键，InnoDB 不允许分区；冷数据移到没有外键的归档表里按月分区，
+    // 整月的归档数据可以直接 DROP PARTITION。分区表的唯一键必须包含分区列，主键都带上 created_at
+    std::string createDocumentsArchive = R"(
+        CREATE TABLE IF NOT EXISTS documents_archive (
+            id INT NOT NULL,
+            title VARCHAR(255) NOT NULL,
+            description TEXT,
+            file_path VARCHAR(500),
+            minio_key VARCHAR(500),
+            owner_id INT NOT NULL,
+            created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            updated_at TIMESTAMP NULL,
+            file_size BIGINT DEFAULT 0,
+            content_type VARCHAR(100) DEFAULT '',
+            archived_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY (id, created_at),
+            INDEX idx_documents_archive_created_id (created_at, id),
+            INDEX idx_documents_archive_owner_created_id (owner_id, created_at, id)
+        ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci
+    )";
+
+    // 列表字段与 share_inbox 同名同序，分享列表可以直接 UNION；source_document_id 为被分享的原文档
+    std::string createSharesArchive = R"(
+        CREATE TABLE IF NOT EXISTS document_shares_archive (
+            shared_to_user_id INT NOT NULL,
+            created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            id INT NOT NULL,
+            shared_by_user_id INT NOT NULL,
+            source_document_id INT NOT NULL,
+            document_id INT NOT NULL,
+            title VARCHAR(255) NOT NULL,
+            description TEXT,
+            file_path VARCHAR(500),
+            minio_key VARCHAR(500),
+            owner_id INT NOT NULL,
+            document_created_at TIMESTAMP NULL,
+            document_updated_at TIMESTAMP NULL,
+            file_size BIGINT DEFAULT 0,
+            content_type VARCHAR(100) DEFAULT '',
+            archived_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY (shared_to_user_id, created_at, id),
+            INDEX idx_shares_archive_by (shared_by_user_id),
+            INDEX idx_shares_archive_source (source_document_id),
+            INDEX idx_shares_archive_document (document_id)
+        ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci
+    )";
+
+    const std::string partitioning =
+            " PARTITION BY RANGE (UNIX_TIMESTAMP(created_at)) (PARTITION p_max VALUES LESS THAN MAXVALUE);";
+    for (const auto& item : {std::make_pair(std::string("documents_archive"), createDocumentsArchive),
+                             std::make_pair(std::string("document_shares_archive"), createSharesArchive)}) {
+        if (mysql_query(db, (item.second + partitioning).c_str()) == 0) {
+            continue;
+        }
+        // 服务端未启用分区时退回普通表，归档照常进行，只是不能按月整块删除
+        LOG_WARNING("创建分区表" + item.first + "失败，改为不分区: " + std::string(mysql_error(db)));
+        if (mysql_query(db, (item.second + ";").c_str()) != 0) {
+            LOG_ERROR("创建" + item.first + "表失败: " + std::string(mysql_error(db)));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::createUserPermissionsView(MYSQL* db, bool excludeDeletedUsers) {
     std::string createUserPermissionsView = R"(
         CREATE OR REPLACE VIEW user_permissions AS
         SELECT
@@ -284,123 +953,299 @@ bool DatabaseManager::createTables() {
             AND ur.is_active = TRUE
             AND m.is_active = TRUE
             AND rm.is_granted = TRUE
-            AND (ur.expires_at IS NULL OR ur.expires_at > NOW());
+            AND (ur.expires_at IS NULL OR ur.expires_at > NOW())
     )";
+    if (excludeDeletedUsers) {
+        createUserPermissionsView += "            AND u.deleted_at IS NULL";
+    }
+    createUserPermissionsView += ";";
 
     if (mysql_query(db, createUserPermissionsView.c_str()) != 0) {
         LOG_ERROR("创建user_permissions视图失败: " + std::string(mysql_error(db)));
         return false;
     }
+    return true;
+}
+
+std::vector<DatabaseManager::SchemaMigration> DatabaseManager::schemaMigrations() {
+    // 只能在末尾追加新版本，已发布的迁移不要修改
+    return {
+        {1, "创建基础表", [this](MYSQL* db) { return createTables(db); }},
+        {2, "创建 user_permissions 视图", [this](MYSQL* db) { return createUserPermissionsView(db, false); }},
+        {3, "键集分页复合索引", [this](MYSQL* db) {
+            // 键集分页所需的 (过滤列, created_at, id) 复合索引
+            return ensureIndex(db, "users", "idx_users_created_id", "created_at, id") &&
+                   ensureIndex(db, "documents", "idx_documents_created_id", "created_at, id") &&
+                   ensureIndex(db, "documents", "idx_documents_owner_created_id", "owner_id, created_at, id") &&
+                   ensureIndex(db, "document_shares", "idx_shares_to_created_id", "shared_to_user_id, created_at, id");
+        }},
+        {4, "文档标题与描述的 ngram 全文索引", [this](MYSQL* db) {
+            // 标题以中文为主，全文索引使用 ngram 分词；服务端不支持时（如 MariaDB）记为已执行，搜索退回 LIKE。
+            // 升级服务端后如需重试，删除 schema_migrations 中的版本 4 再重启
+            if (!ensureIndex(db, "documents", "ft_documents_title_description", "title, description",
+                             "FULLTEXT INDEX", "WITH PARSER ngram")) {
+                LOG_WARNING("服务端不支持 ngram 全文索引，跳过");
+            }
+            return true;
+        }},
+        {5, "分享记录的分享人与副本文档索引", [this](MYSQL* db) {
+            // 删除用户/文档时按这两列统计并级联删除分享记录。InnoDB 原本为外键自动建的匿名索引
+            // 会被这里的显式索引取代；username/email 已有唯一索引，owner_id、created_at、
+            // shared_to_user_id、document_id 已被复合索引或唯一键的前缀覆盖，不再重复建
+            return ensureIndex(db, "document_shares", "idx_document_shares_shared_by", "shared_by_user_id") &&
+                   ensureIndex(db, "document_shares", "idx_document_shares_shared_document", "shared_document_id");
+        }},
+        {6, "分享收件箱表", [this](MYSQL* db) { return createShareInbox(db); }},
+        {7, "按月 RANGE 分区的归档表", [this](MYSQL* db) { return createArchiveTables(db); }},
+        {8, "用户与文档的软删除标记", [this](MYSQL* db) {
+            // 删除只写 deleted_at，purgeDeleted 按这两个索引找到待清理的行；在线查询的
+            // deleted_at IS NULL 条件接在现有索引之后回表判断，不需要改动分页索引
+            return ensureColumn(db, "users", "deleted_at", "TIMESTAMP NULL DEFAULT NULL") &&
+                   ensureColumn(db, "documents", "deleted_at", "TIMESTAMP NULL DEFAULT NULL") &&
+                   ensureIndex(db, "users", "idx_users_deleted_at", "deleted_at") &&
+                   ensureIndex(db, "documents", "idx_documents_deleted_at", "deleted_at");
+        }},
+        {9, "user_permissions 视图排除软删除的用户", [this](MYSQL* db) {
+            // 用户软删除后到清理线程删行之前，hasPermission 不应再按其角色授权
+            return createUserPermissionsView(db, true);
+        }},
+    };
+}
+
+bool DatabaseManager::readSchemaVersion(MYSQL* db, int& version) {
+    // 版本与全文索引是否存在一次读出，结构已是最新时连接只需这一条查询
+    const char* sql = "SELECT COALESCE(MAX(version), 0), "
+                      "(SELECT COUNT(*) FROM information_schema.statistics WHERE table_schema = DATABASE() "
+                      "AND table_name = 'documents' AND index_name = 'ft_documents_title_description') "
+                      "FROM schema_migrations;";
+    if (mysql_query(db, sql) != 0) {
+        // 1146 ER_NO_SUCH_TABLE：全新的库或升级前的库，从版本 0 开始（各迁移可重复执行）
+        if (mysql_errno(db) == 1146) {
+            version = 0;
+            fulltextSearchEnabled = false;
+            return true;
+        }
+        LOG_ERROR("读取数据库结构版本失败: " + std::string(mysql_error(db)));
+        return false;
+    }
 
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+    MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+    if (!row) {
+        LOG_ERROR("读取数据库结构版本失败: " + std::string(mysql_error(db)));
+        return false;
+    }
+    RowDecoder decoder(result.get(), row);
+    version = decoder.getInt(0);
+    fulltextSearchEnabled = decoder.getInt64(1) > 0;
     return true;
 }
 
-Result<User> DatabaseManager::createUser(const std::string& username, const std::string& passwordHash, const std::string& email) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<User>::Error("数据库未连接");
+bool DatabaseManager::migrateSchema(MYSQL* db) {
+    std::vector<SchemaMigration> migrations = schemaMigrations();
+    int targetVersion = migrations.back().version;
+
+    int currentVersion = 0;
+    if (!readSchemaVersion(db, currentVersion)) {
+        return false;
     }
-    
-    // 构建插入SQL语句
-    std::string sql = "INSERT INTO users (username, password_hash, email) VALUES ('" + 
-                      username + "', '" + passwordHash + "', '" + email + "');";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<User>::Error("插入用户失败: " + std::string(mysql_error(db)));
+
+    if (currentVersion < targetVersion) {
+        // 多个客户端同时启动时只让一个执行迁移；其余等锁释放后重新读取版本，通常已无事可做
+        if (!acquireNamedLock(db, "schema_migrations", 60)) {
+            LOG_ERROR("等待数据库迁移锁超时: " + std::string(mysql_error(db)));
+            return false;
+        }
+        auto releaseLock = [db]() { releaseNamedLock(db, "schema_migrations"); };
+
+        std::string createMigrationsTable = R"(
+            CREATE TABLE IF NOT EXISTS schema_migrations (
+                version INT PRIMARY KEY,
+                description VARCHAR(255) NOT NULL,
+                applied_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
+        )";
+        if (!readSchemaVersion(db, currentVersion) || mysql_query(db, createMigrationsTable.c_str()) != 0) {
+            LOG_ERROR("创建schema_migrations表失败: " + std::string(mysql_error(db)));
+            releaseLock();
+            return false;
+        }
+
+        for (const auto& migration : migrations) {
+            if (migration.version <= currentVersion) {
+                continue;
+            }
+            LOG_INFO("执行数据库迁移 " + std::to_string(migration.version) + ": " + migration.description);
+            if (!migration.apply(db)) {
+                LOG_ERROR("数据库迁移 " + std::to_string(migration.version) + " 失败");
+                releaseLock();
+                return false;
+            }
+            std::string recordSql = "INSERT INTO schema_migrations (version, description) VALUES (" +
+                                    std::to_string(migration.version) + ", '" + migration.description + "');";
+            if (mysql_query(db, recordSql.c_str()) != 0) {
+                LOG_ERROR("记录数据库迁移 " + std::to_string(migration.version) + " 失败: " + std::string(mysql_error(db)));
+                releaseLock();
+                return false;
+            }
+        }
+        releaseLock();
+
+        if (!readSchemaVersion(db, currentVersion)) {
+            return false;
+        }
     }
-    
-    // 获取新插入的用户id
-    int userId = (int)mysql_insert_id(db);
 
-    Result<User> result= getUserById(userId);  // 调用查询函数获取新用户信息
-    // 查询新用户信息
-    return result;
+    LOG_INFO("数据库结构版本: " + std::to_string(currentVersion));
+    if (!fulltextSearchEnabled) {
+        LOG_WARNING("文档全文索引不可用，搜索将使用 LIKE 匹配");
+    }
+    return true;
 }
 
-Result<User> DatabaseManager::getUserByUsername(const std::string& username) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<User>::Error("数据库未连接");
-    }
-    
-    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users WHERE username = '" + username + "';";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<User>::Error("查询用户失败: " + std::string(mysql_error(db)));
+bool DatabaseManager::ensureIndex(MYSQL* db, const std::string& table, const std::string& indexName, const std::string& columns,
+                                  const std::string& indexKind, const std::string& indexOptions) {
+    // MySQL 不支持 CREATE INDEX IF NOT EXISTS，先查 information_schema
+    std::string checkSql = "SELECT COUNT(*) FROM information_schema.statistics WHERE table_schema = DATABASE() "
+                           "AND table_name = '" + table + "' AND index_name = '" + indexName + "';";
+    if (mysql_query(db, checkSql.c_str()) != 0) {
+        LOG_ERROR("查询索引失败: " + std::string(mysql_error(db)));
+        return false;
     }
-    
+
     MYSQL_RES* result = mysql_store_result(db);
     if (!result) {
-        return Result<User>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        LOG_ERROR("获取查询结果失败: " + std::string(mysql_error(db)));
+        return false;
     }
-    
     MYSQL_ROW row = mysql_fetch_row(result);
-    if (row) {
-        User user;
-        user.id = std::stoi(row[0]);
-        user.username = row[1];
-        user.password_hash = row[2];
-        user.email = row[3];
-        // created_at 和 last_login 暂时使用当前时间，后续可以解析时间字符串
-        user.created_at = std::chrono::system_clock::now();
-        user.last_login = std::chrono::system_clock::now();
-        user.is_active = std::stoi(row[6]) != 0;
-        
-        mysql_free_result(result);
-        return Result<User>::Success(user);
-    } else {
-        mysql_free_result(result);
-        return Result<User>::Error("未找到该用户");
+    bool exists = row && RowDecoder(result, row).getInt64(0) > 0;
+    mysql_free_result(result);
+
+    if (exists) {
+        return true;
+    }
+
+    std::string createSql = "ALTER TABLE " + table + " ADD " + indexKind + " " + indexName + " (" + columns + ")" +
+                            (indexOptions.empty() ? "" : " " + indexOptions) + ";";
+    if (mysql_query(db, createSql.c_str()) != 0) {
+        LOG_ERROR("创建索引" + indexName + "失败: " + std::string(mysql_error(db)));
+        return false;
     }
+    LOG_INFO("已创建索引: " + indexName);
+    return true;
 }
 
-Result<User> DatabaseManager::getUserById(int userId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<User>::Error("数据库未连接");
+bool DatabaseManager::ensureColumn(MYSQL* db, const std::string& table, const std::string& column, const std::string& definition) {
+    // 与 ensureIndex 相同：MySQL 不支持 ADD COLUMN IF NOT EXISTS，先查 information_schema
+    std::string checkSql = "SELECT COUNT(*) FROM information_schema.columns WHERE table_schema = DATABASE() "
+                           "AND table_name = '" + table + "' AND column_name = '" + column + "';";
+    if (mysql_query(db, checkSql.c_str()) != 0) {
+        LOG_ERROR("查询列失败: " + std::string(mysql_error(db)));
+        return false;
     }
-    
-    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users WHERE id = " + std::to_string(userId) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<User>::Error("查询用户失败: " + std::string(mysql_error(db)));
+
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+    MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+    if (!row) {
+        LOG_ERROR("获取查询结果失败: " + std::string(mysql_error(db)));
+        return false;
     }
-    
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<User>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+    if (RowDecoder(result.get(), row).getInt64(0) > 0) {
+        return true;
     }
-    
-    MYSQL_ROW row = mysql_fetch_row(result);
-    if (row) {
-        User user;
-        user.id = std::stoi(row[0]);
-        user.username = row[1];
-        user.password_hash = row[2];
-        user.email = row[3];
-        // created_at 和 last_login 暂时使用当前时间，后续可以解析时间字符串
-        user.created_at = std::chrono::system_clock::now();
-        user.last_login = std::chrono::system_clock::now();
-        user.is_active = std::stoi(row[6]) != 0;
-        
-        mysql_free_result(result);
-        return Result<User>::Success(user);
-    } else {
-        mysql_free_result(result);
+
+    std::string alterSql = "ALTER TABLE " + table + " ADD COLUMN " + column + " " + definition + ";";
+    if (mysql_query(db, alterSql.c_str()) != 0) {
+        LOG_ERROR("添加列" + table + "." + column + "失败: " + std::string(mysql_error(db)));
+        return false;
+    }
+    LOG_INFO("已添加列: " + table + "." + column);
+    return true;
+}
+
+Result<User> DatabaseManager::createUser(const std::string& username, const std::string& passwordHash, const std::string& email) {
+    QueryTimer timer(queryStats, "createUser");
+    return runInTransaction<User>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+
+        // 构建插入SQL语句
+        std::string sql = "INSERT INTO users (username, password_hash, email) VALUES ('" +
+                          username + "', '" + passwordHash + "', '" + email + "');";
+
+        if (runQuery(db, sql) != 0) {
+            return Result<User>::Error("插入用户失败: " + std::string(mysql_error(db)));
+        }
+
+        // 获取新插入的用户id
+        int userId = (int)mysql_insert_id(db);
+
+        std::map<int, UsageStats> deltas;
+        deltas[0].userCount = 1;
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<User>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
+
+        // 在同一连接上查询新用户信息
+        return fetchUserById(conn, userId);
+    });
+}
+
+Result<User> DatabaseManager::getUserByUsername(const std::string& username) {
+    QueryTimer timer(queryStats, "getUserByUsername");
+    auto conn = acquireReadConnection();
+    if (!conn) {
+        return Result<User>::Error("数据库未连接");
+    }
+
+    BoundStatement stmt(acquireStatement(conn, SQL_USER_BY_USERNAME));
+    stmt.bind(username);
+    if (!stmt.execute()) {
+        handleStatementError(conn, SQL_USER_BY_USERNAME, stmt);
+        return Result<User>::Error("查询用户失败: " + stmt.error());
+    }
+
+    if (!stmt.fetch()) {
+        return Result<User>::Error("未找到该用户");
+    }
+    return Result<User>::Success(readUserRow(stmt));
+}
+
+Result<User> DatabaseManager::getUserById(int userId) {
+    QueryTimer timer(queryStats, "getUserById");
+    auto conn = acquireReadConnection();
+    if (!conn) {
+        return Result<User>::Error("数据库未连接");
+    }
+    return fetchUserById(conn, userId);
+}
+
+Result<User> DatabaseManager::fetchUserById(PooledConnection& conn, int userId) {
+    BoundStatement stmt(acquireStatement(conn, SQL_USER_BY_ID));
+    stmt.bind(userId);
+    if (!stmt.execute()) {
+        handleStatementError(conn, SQL_USER_BY_ID, stmt);
+        return Result<User>::Error("查询用户失败: " + stmt.error());
+    }
+
+    if (!stmt.fetch()) {
         return Result<User>::Error("未找到该用户");
     }
+    return Result<User>::Success(readUserRow(stmt));
 }
 
 Result<std::vector<User>> DatabaseManager::getAllUsers(int limit, int offset) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "getAllUsers");
+    auto conn = acquireReadConnection();
+    if (!conn) {
         return Result<std::vector<User>>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
     
-    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users LIMIT " + 
-                      std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
+    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+                      "WHERE deleted_at IS NULL LIMIT " + std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
     
-    if (mysql_query(db, sql.c_str()) != 0) {
+    if (runQuery(db, sql) != 0) {
         return Result<std::vector<User>>::Error("查询用户失败: " + std::string(mysql_error(db)));
     }
     
@@ -410,17 +1255,11 @@ Result<std::vector<User>> DatabaseManager::getAllUsers(int limit, int offset) {
     }
     
     std::vector<User> users;
+    users.reserve(mysql_num_rows(result));
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        User user;
-        user.id = std::stoi(row[0]);
-        user.username = row[1];
-        user.password_hash = row[2];
-        user.email = row[3];
-        user.created_at = std::chrono::system_clock::now();
-        user.last_login = std::chrono::system_clock::now();
-        user.is_active = std::stoi(row[6]) != 0;
-        users.push_back(user);
+        users.emplace_back();
+        decodeUser(RowDecoder(result, row), users.back());
     }
     
     mysql_free_result(result);
@@ -428,20 +1267,23 @@ Result<std::vector<User>> DatabaseManager::getAllUsers(int limit, int offset) {
 }
 
 Result<bool> DatabaseManager::updateUser(const User& user) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "updateUser");
+    auto conn = acquireConnection();
+    if (!conn) {
         return Result<bool>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
     
     std::string sql = "UPDATE users SET username = '" + user.username + 
                       "', password_hash = '" + user.password_hash + 
                       "', email = '" + user.email + 
                       "', is_active = " + (user.is_active ? "1" : "0") + 
-                      " WHERE id = " + std::to_string(user.id) + ";";
+                      " WHERE id = " + std::to_string(user.id) + " AND deleted_at IS NULL;";
     
-    if (mysql_query(db, sql.c_str()) != 0) {
+    if (runQuery(db, sql) != 0) {
         return Result<bool>::Error("更新用户失败: " + std::string(mysql_error(db)));
     }
+    noteWrite();
     
     //if (mysql_affected_rows(db) == 0) {
     //    return Result<bool>::Error("用户不存在或未发生更改");
@@ -451,35 +1293,67 @@ Result<bool> DatabaseManager::updateUser(const User& user) {
 }
 
 Result<bool> DatabaseManager::deleteUser(int userId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<bool>::Error("数据库未连接");
-    }
-    
-    std::string sql = "DELETE FROM users WHERE id = " + std::to_string(userId) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<bool>::Error("删除用户失败: " + std::string(mysql_error(db)));
-    }
-    
-    if (mysql_affected_rows(db) == 0) {
-        return Result<bool>::Error("用户不存在");
+    QueryTimer timer(queryStats, "deleteUser");
+    auto result = runInTransaction<bool>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+        std::string id = std::to_string(userId);
+
+        // 软删除：只标记用户行（同时锁住它，外键检查使该用户不能再新建文档）；文档、分享、归档数据和
+        // 对象存储中的文件由 purgeDeleted 分批物理删除。用户名与邮箱改写为按 id 生成的占位值，
+        // 释放唯一键，不必等清理就能用原名重新注册
+        std::string sql = "UPDATE users SET deleted_at = CURRENT_TIMESTAMP, username = CONCAT('" + DELETED_USER_PREFIX +
+                          "', id), email = CONCAT('" + DELETED_USER_PREFIX + "', id) WHERE id = " + id +
+                          " AND deleted_at IS NULL;";
+        if (runQuery(db, sql) != 0) {
+            return Result<bool>::Error("删除用户失败: " + std::string(mysql_error(db)));
+        }
+        if (mysql_affected_rows(db) == 0) {
+            return Result<bool>::Error("用户不存在");
+        }
+
+        // 该用户的统计行即其仍可见的文档与分享计数（单独删除过的文档早已扣除），整行从全局中扣除后删除；
+        // 只锁这一行，不再逐个统计文档。涉及的分享记录只在读取时隐藏，由 purgeDeleted 分批删除，
+        // 届时只扣除仍在线的另一方（见 collectShareDeltas）
+        auto owned = lockUsageStats(db, userId);
+        if (!owned.success) {
+            return Result<bool>::Error(owned.message);
+        }
+        std::map<int, UsageStats> deltas;
+        UsageStats& global = deltas[0];
+        global.userCount -= 1;
+        global.documentCount -= owned.data->documentCount;
+        global.totalBytes -= owned.data->totalBytes;
+        global.sharesGiven -= owned.data->sharesGiven;
+        global.sharesReceived -= owned.data->sharesReceived;
+        std::string deleteStats = "DELETE FROM usage_stats WHERE owner_id = " + id + ";";
+        if (runQuery(db, deleteStats) != 0 || !applyStatsDeltas(db, deltas)) {
+            return Result<bool>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
+        return Result<bool>::Success(true);
+    });
+
+    if (result.success) {
+        // 该用户的文档已不可见，同步移除其索引条目
+        applyIndexChange([this, userId]() { searchIndex.removeOwner(userId); });
     }
-    
-    return Result<bool>::Success(true);
+    return result;
 }
 
 Result<bool> DatabaseManager::updateUserLastLogin(int userId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "updateUserLastLogin");
+    auto conn = acquireConnection();
+    if (!conn) {
         return Result<bool>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
     
-    std::string sql = "UPDATE users SET last_login = CURRENT_TIMESTAMP WHERE id = " + std::to_string(userId) + ";";
+    std::string sql = "UPDATE users SET last_login = CURRENT_TIMESTAMP WHERE id = " + std::to_string(userId) +
+                      " AND deleted_at IS NULL;";
     
-    if (mysql_query(db, sql.c_str()) != 0) {
+    if (runQuery(db, sql) != 0) {
         return Result<bool>::Error("更新最后登录时间失败: " + std::string(mysql_error(db)));
     }
+    noteWrite();
     
     return Result<bool>::Success(true);
 }
@@ -487,111 +1361,90 @@ Result<bool> DatabaseManager::updateUserLastLogin(int userId) {
 Result<Document> DatabaseManager::createDocument(const std::string& title, const std::string& description,
                                                 const std::string& filePath, const std::string& minioKey,
                                                 int ownerId, size_t fileSize, const std::string& contentType) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<Document>::Error("数据库未连接");
-    }
-    
-    std::string sql = "INSERT INTO documents (title, description, file_path, minio_key, owner_id, file_size, content_type) VALUES ('" +
-                      title + "', '" + description + "', '" + filePath + "', '" + minioKey + "', " +
-                      std::to_string(ownerId) + ", " + std::to_string(fileSize) + ", '" + contentType + "');";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<Document>::Error("插入文档失败: " + std::string(mysql_error(db)));
+    QueryTimer timer(queryStats, "createDocument");
+    auto result = runInTransaction<Document>([&](PooledConnection& conn) {
+        BoundStatement stmt(acquireStatement(conn, SQL_INSERT_DOCUMENT));
+        stmt.bind(title).bind(description).bind(filePath).bind(minioKey)
+            .bind(ownerId).bind(fileSize).bind(contentType);
+        if (!stmt.execute()) {
+            handleStatementError(conn, SQL_INSERT_DOCUMENT, stmt);
+            return Result<Document>::Error("插入文档失败: " + stmt.error());
+        }
+        int docId = static_cast<int>(stmt.insertId());
+
+        std::map<int, UsageStats> deltas;
+        for (int key : {0, ownerId}) {
+            deltas[key].documentCount += 1;
+            deltas[key].totalBytes += static_cast<long long>(fileSize);
+        }
+        if (!applyStatsDeltas(conn.get(), deltas)) {
+            return Result<Document>::Error("更新用量统计失败: " + std::string(mysql_error(conn.get())));
+        }
+        return fetchDocumentById(conn, docId);
+    });
+    if (result.success) {
+        Document doc = result.data.value();
+        applyIndexChange([this, doc]() { searchIndex.addOrUpdate(doc); });
     }
-    
-    int docId = (int)mysql_insert_id(db);
-    return getDocumentById(docId);
+    return result;
 }
 
 Result<Document> DatabaseManager::getDocumentById(int docId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "getDocumentById");
+    auto conn = acquireReadConnection();
+    if (!conn) {
         return Result<Document>::Error("数据库未连接");
     }
-    
-    std::string sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM documents WHERE id = " + std::to_string(docId) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<Document>::Error("查询文档失败: " + std::string(mysql_error(db)));
-    }
-    
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<Document>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+    return fetchDocumentById(conn, docId);
+}
+
+Result<Document> DatabaseManager::fetchDocumentById(PooledConnection& conn, int docId) {
+    BoundStatement stmt(acquireStatement(conn, SQL_DOCUMENT_BY_ID));
+    stmt.bind(docId);
+    if (!stmt.execute()) {
+        handleStatementError(conn, SQL_DOCUMENT_BY_ID, stmt);
+        return Result<Document>::Error("查询文档失败: " + stmt.error());
     }
-    
-    MYSQL_ROW row = mysql_fetch_row(result);
-    if (row) {
-        Document doc;
-        doc.id = std::stoi(row[0]);
-        doc.title = row[1];
-        doc.description = row[2] ? row[2] : "";
-        doc.file_path = row[3] ? row[3] : "";
-        doc.minio_key = row[4] ? row[4] : "";
-        doc.owner_id = std::stoi(row[5]);
-        doc.created_at = std::chrono::system_clock::now();
-        doc.updated_at = std::chrono::system_clock::now();
-        doc.file_size = std::stoull(row[8] ? row[8] : "0");
-        doc.content_type = row[9] ? row[9] : "";
-        
-        mysql_free_result(result);
-        return Result<Document>::Success(doc);
-    } else {
-        mysql_free_result(result);
+
+    if (!stmt.fetch()) {
         return Result<Document>::Error("未找到该文档");
     }
+    return Result<Document>::Success(readDocumentRow(stmt));
 }
 
 Result<std::vector<Document>> DatabaseManager::getDocumentsByOwner(int ownerId, int limit, int offset) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "getDocumentsByOwner");
+    auto conn = acquireReadConnection();
+    if (!conn) {
         return Result<std::vector<Document>>::Error("数据库未连接");
     }
-    
-    std::string sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM documents WHERE owner_id = " + 
-                      std::to_string(ownerId) + " LIMIT " + std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<std::vector<Document>>::Error("查询文档失败: " + std::string(mysql_error(db)));
-    }
-    
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<std::vector<Document>>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+
+    BoundStatement stmt(acquireStatement(conn, SQL_DOCUMENTS_BY_OWNER));
+    stmt.bind(ownerId).bind(limit).bind(offset);
+    if (!stmt.execute()) {
+        handleStatementError(conn, SQL_DOCUMENTS_BY_OWNER, stmt);
+        return Result<std::vector<Document>>::Error("查询文档失败: " + stmt.error());
     }
-    
+
     std::vector<Document> documents;
-    MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Document doc;
-        doc.id = std::stoi(row[0]);
-        doc.title = row[1];
-        doc.description = row[2] ? row[2] : "";
-        doc.file_path = row[3] ? row[3] : "";
-        doc.minio_key = row[4] ? row[4] : "";
-        doc.owner_id = std::stoi(row[5]);
-        doc.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
-        doc.updated_at = Utils::parseTimestamp(row[7] ? row[7] : "");
-        doc.file_size = std::stoull(row[8] ? row[8] : "0");
-        doc.content_type = row[9] ? row[9] : "";
-        documents.push_back(doc);
+    while (stmt.fetch()) {
+        documents.push_back(readDocumentRow(stmt));
     }
-    
-    mysql_free_result(result);
     return Result<std::vector<Document>>::Success(documents);
 }
 
 Result<std::vector<Document>> DatabaseManager::getAllDocuments(int limit, int offset) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "getAllDocuments");
+    auto conn = acquireReadConnection();
+    if (!conn) {
         return Result<std::vector<Document>>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
     
-    std::string sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM documents LIMIT " + 
-                      std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
+    std::string sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM documents "
+                      "WHERE " + liveDocument() + " LIMIT " + std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
     
-    if (mysql_query(db, sql.c_str()) != 0) {
+    if (runQuery(db, sql) != 0) {
         return Result<std::vector<Document>>::Error("查询文档失败: " + std::string(mysql_error(db)));
     }
     
@@ -601,20 +1454,11 @@ Result<std::vector<Document>> DatabaseManager::getAllDocuments(int limit, int of
     }
     
     std::vector<Document> documents;
+    documents.reserve(mysql_num_rows(result));
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        Document doc;
-        doc.id = std::stoi(row[0]);
-        doc.title = row[1];
-        doc.description = row[2] ? row[2] : "";
-        doc.file_path = row[3] ? row[3] : "";
-        doc.minio_key = row[4] ? row[4] : "";
-        doc.owner_id = std::stoi(row[5]);
-        doc.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
-        doc.updated_at = Utils::parseTimestamp(row[7] ? row[7] : "");
-        doc.file_size = std::stoull(row[8] ? row[8] : "0");
-        doc.content_type = row[9] ? row[9] : "application/octet-stream";
-        documents.push_back(doc);
+        documents.emplace_back();
+        decodeDocument(RowDecoder(result, row), documents.back());
     }
     
     mysql_free_result(result);
@@ -622,114 +1466,204 @@ Result<std::vector<Document>> DatabaseManager::getAllDocuments(int limit, int of
 }
 
 Result<bool> DatabaseManager::updateDocument(const Document& doc) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<bool>::Error("数据库未连接");
-    }
-    
-    std::string sql = "UPDATE documents SET title = '" + doc.title +
-                      "', description = '" + doc.description +
-                      "', file_path = '" + doc.file_path +
-                      "', minio_key = '" + doc.minio_key +
-                      "', file_size = " + std::to_string(doc.file_size) +
-                      ", content_type = '" + doc.content_type +
-                      "' WHERE id = " + std::to_string(doc.id) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<bool>::Error("更新文档失败: " + std::string(mysql_error(db)));
-    }
-    
-    if (mysql_affected_rows(db) == 0) {
-        return Result<bool>::Error("文档不存在或未发生更改");
+    QueryTimer timer(queryStats, "updateDocument");
+    Document indexed;
+    auto result = runInTransaction<bool>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+
+        // 锁定原行，取旧的 owner_id/file_size 计算字节数增量
+        std::string lockSql = "SELECT owner_id, file_size FROM documents WHERE id = " + std::to_string(doc.id) +
+                              " AND " + liveDocument() + " FOR UPDATE;";
+        if (runQuery(db, lockSql) != 0) {
+            return Result<bool>::Error("更新文档失败: " + std::string(mysql_error(db)));
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> locked(mysql_store_result(db), &mysql_free_result);
+        MYSQL_ROW lockedRow = locked ? mysql_fetch_row(locked.get()) : nullptr;
+        if (!lockedRow) {
+            return Result<bool>::Error("文档不存在或未发生更改");
+        }
+        RowDecoder previous(locked.get(), lockedRow);
+        int ownerId = previous.getInt(0);
+        long long sizeDelta = static_cast<long long>(doc.file_size) - previous.getInt64(1);
+
+        std::string sql = "UPDATE documents SET title = '" + doc.title +
+                          "', description = '" + doc.description +
+                          "', file_path = '" + doc.file_path +
+                          "', minio_key = '" + doc.minio_key +
+                          "', file_size = " + std::to_string(doc.file_size) +
+                          ", content_type = '" + doc.content_type +
+                          "' WHERE id = " + std::to_string(doc.id) + ";";
+
+        if (runQuery(db, sql) != 0) {
+            return Result<bool>::Error("更新文档失败: " + std::string(mysql_error(db)));
+        }
+
+        if (mysql_affected_rows(db) == 0) {
+            return Result<bool>::Error("文档不存在或未发生更改");
+        }
+
+        // 该文档若是分享副本，接收人的收件箱显示的是它的标题等字段
+        if (runQuery(db, SQL_SYNC_SHARE_INBOX + std::to_string(doc.id) + ";") != 0) {
+            return Result<bool>::Error("同步分享收件箱失败: " + std::string(mysql_error(db)));
+        }
+
+        if (sizeDelta != 0) {
+            std::map<int, UsageStats> deltas;
+            deltas[0].totalBytes = sizeDelta;
+            deltas[ownerId].totalBytes = sizeDelta;
+            if (!applyStatsDeltas(db, deltas)) {
+                return Result<bool>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+            }
+        }
+
+        // 重新读取整行（含 owner_id、updated_at）更新内存索引
+        auto updated = fetchDocumentById(conn, doc.id);
+        if (updated.success) {
+            indexed = updated.data.value();
+        }
+        return Result<bool>::Success(true);
+    });
+
+    if (result.success && indexed.id == doc.id) {
+        applyIndexChange([this, indexed]() { searchIndex.addOrUpdate(indexed); });
     }
-    
-    return Result<bool>::Success(true);
+    return result;
 }
 
 Result<bool> DatabaseManager::deleteDocument(int docId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<bool>::Error("数据库未连接");
-    }
-    
-    std::string sql = "DELETE FROM documents WHERE id = " + std::to_string(docId) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<bool>::Error("删除文档失败: " + std::string(mysql_error(db)));
-    }
-    
-    if (mysql_affected_rows(db) == 0) {
-        return Result<bool>::Error("文档不存在");
+    QueryTimer timer(queryStats, "deleteDocument");
+    auto result = runInTransaction<bool>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+        std::string id = std::to_string(docId);
+
+        std::string lockSql = "SELECT owner_id, file_size FROM documents WHERE id = " + id +
+                              " AND " + liveDocument() + " FOR UPDATE;";
+        if (runQuery(db, lockSql) != 0) {
+            return Result<bool>::Error("删除文档失败: " + std::string(mysql_error(db)));
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> locked(mysql_store_result(db), &mysql_free_result);
+        MYSQL_ROW lockedRow = locked ? mysql_fetch_row(locked.get()) : nullptr;
+        if (!lockedRow) {
+            return Result<bool>::Error("文档不存在");
+        }
+        RowDecoder previous(locked.get(), lockedRow);
+        int ownerId = previous.getInt(0);
+        long long fileSize = previous.getInt64(1);
+
+        // 文档行只做标记：引用它（原件或分享副本）的分享与归档分享在读取时隐藏，
+        // 连同文档行与对象存储中的文件由 purgeDeleted 在后台分批删除
+        std::string sql = "UPDATE documents SET deleted_at = CURRENT_TIMESTAMP WHERE id = " + id + ";";
+        if (runQuery(db, sql) != 0) {
+            return Result<bool>::Error("删除文档失败: " + std::string(mysql_error(db)));
+        }
+
+        std::map<int, UsageStats> deltas;
+        for (int key : {0, ownerId}) {
+            deltas[key].documentCount -= 1;
+            deltas[key].totalBytes -= fileSize;
+        }
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<bool>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
+        return Result<bool>::Success(true);
+    });
+
+    if (result.success) {
+        applyIndexChange([this, docId]() { searchIndex.remove(docId); });
     }
-    
-    return Result<bool>::Success(true);
+    return result;
 }
 
 // Document sharing operations
 Result<DocumentShare> DatabaseManager::createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
                                                           int sharedDocumentId, const std::string& sharedMinioKey) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<DocumentShare>::Error("数据库未连接");
-    }
+    QueryTimer timer(queryStats, "createDocumentShare");
+    return runInTransaction<DocumentShare>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+
+        // 同一 (原文档, 分享人, 接收人) 上已失效、尚未清理的旧分享（副本或原文档已删除）会占住唯一键：
+        // 先扣除其计数再物理删除，收件箱中的对应行经外键级联删除
+        std::string deadShare = "document_id = " + std::to_string(documentId) + " AND shared_by_user_id = " +
+                                std::to_string(sharedByUserId) + " AND shared_to_user_id = " +
+                                std::to_string(sharedToUserId) + " AND NOT (" + LIVE_SHARE + ")";
+        std::map<int, UsageStats> deltas;
+        if (!collectShareDeltas(db, deadShare, deltas)) {
+            return Result<DocumentShare>::Error("统计失效分享失败: " + std::string(mysql_error(db)));
+        }
+        if (runQuery(db, "DELETE FROM document_shares WHERE " + deadShare + ";") != 0) {
+            return Result<DocumentShare>::Error("清理失效分享失败: " + std::string(mysql_error(db)));
+        }
 
-    std::string sql = "INSERT INTO document_shares (document_id, shared_by_user_id, shared_to_user_id, shared_document_id, shared_minio_key) VALUES (" +
-                      std::to_string(documentId) + ", " + std::to_string(sharedByUserId) + ", " +
-                      std::to_string(sharedToUserId) + ", " + std::to_string(sharedDocumentId) + ", '" +
-                      sharedMinioKey + "');";
+        std::string sql = "INSERT INTO document_shares (document_id, shared_by_user_id, shared_to_user_id, shared_document_id, shared_minio_key) VALUES (" +
+                          std::to_string(documentId) + ", " + std::to_string(sharedByUserId) + ", " +
+                          std::to_string(sharedToUserId) + ", " + std::to_string(sharedDocumentId) + ", '" +
+                          sharedMinioKey + "');";
 
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<DocumentShare>::Error("创建分享记录失败: " + std::string(mysql_error(db)));
-    }
+        if (runQuery(db, sql) != 0) {
+            return Result<DocumentShare>::Error("创建分享记录失败: " + std::string(mysql_error(db)));
+        }
 
-    // 获取新插入的分享记录ID
-    int shareId = (int)mysql_insert_id(db);
+        // 获取新插入的分享记录ID
+        int shareId = (int)mysql_insert_id(db);
 
-    // 查询新创建的分享记录
-    std::string selectSql = "SELECT id, document_id, shared_by_user_id, shared_to_user_id, shared_document_id, shared_minio_key, created_at FROM document_shares WHERE id = " +
-                           std::to_string(shareId) + ";";
+        // 同一事务写入接收人的收件箱，列表页不再连接 documents
+        if (runQuery(db, SQL_FILL_SHARE_INBOX + " WHERE ds.id = " + std::to_string(shareId) + ";") != 0) {
+            return Result<DocumentShare>::Error("写入分享收件箱失败: " + std::string(mysql_error(db)));
+        }
+        if (mysql_affected_rows(db) != 1) {
+            return Result<DocumentShare>::Error("写入分享收件箱失败: 分享副本文档不存在");
+        }
 
-    if (mysql_query(db, selectSql.c_str()) != 0) {
-        return Result<DocumentShare>::Error("查询分享记录失败: " + std::string(mysql_error(db)));
-    }
+        deltas[0].sharesGiven += 1;
+        deltas[0].sharesReceived += 1;
+        deltas[sharedByUserId].sharesGiven += 1;
+        deltas[sharedToUserId].sharesReceived += 1;
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<DocumentShare>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
 
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<DocumentShare>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
-    }
+        // 查询新创建的分享记录
+        std::string selectSql = "SELECT id, document_id, shared_by_user_id, shared_to_user_id, shared_document_id, shared_minio_key, created_at FROM document_shares WHERE id = " +
+                               std::to_string(shareId) + ";";
 
-    MYSQL_ROW row = mysql_fetch_row(result);
-    if (!row) {
-        mysql_free_result(result);
-        return Result<DocumentShare>::Error("分享记录不存在");
-    }
+        if (runQuery(db, selectSql) != 0) {
+            return Result<DocumentShare>::Error("查询分享记录失败: " + std::string(mysql_error(db)));
+        }
 
-    DocumentShare share;
-    share.id = std::stoi(row[0]);
-    share.document_id = std::stoi(row[1]);
-    share.shared_by_user_id = std::stoi(row[2]);
-    share.shared_to_user_id = std::stoi(row[3]);
-    share.shared_document_id = std::stoi(row[4]);
-    share.shared_minio_key = row[5] ? row[5] : "";
-    share.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
+        MYSQL_RES* result = mysql_store_result(db);
+        if (!result) {
+            return Result<DocumentShare>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        }
 
-    mysql_free_result(result);
-    return Result<DocumentShare>::Success(share);
+        MYSQL_ROW row = mysql_fetch_row(result);
+        if (!row) {
+            mysql_free_result(result);
+            return Result<DocumentShare>::Error("分享记录不存在");
+        }
+
+        DocumentShare share;
+        decodeDocumentShare(RowDecoder(result, row), share);
+
+        mysql_free_result(result);
+        return Result<DocumentShare>::Success(share);
+    });
 }
 
 Result<std::vector<Document>> DatabaseManager::getSharedDocuments(int userId, int limit, int offset) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "getSharedDocuments");
+    auto conn = acquireReadConnection();
+    if (!conn) {
         return Result<std::vector<Document>>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
 
-    std::string sql = "SELECT d.id, d.title, d.description, d.file_path, ds.shared_minio_key, d.owner_id, d.created_at, d.updated_at, d.file_size, d.content_type "
-                      "FROM documents d "
-                      "INNER JOIN document_shares ds ON d.id = ds.shared_document_id "
-                      "WHERE ds.shared_to_user_id = " + std::to_string(userId) +
+    // 收件箱主键范围扫描，最新的分享在前
+    std::string sql = "SELECT " + SHARE_INBOX_DOCUMENT_COLUMNS + " FROM share_inbox "
+                      "WHERE shared_to_user_id = " + std::to_string(userId) + " AND " + LIVE_SHARE_INBOX +
+                      " ORDER BY created_at DESC, id DESC"
                       " LIMIT " + std::to_string(limit) + " OFFSET " + std::to_string(offset) + ";";
 
-    if (mysql_query(db, sql.c_str()) != 0) {
+    if (runQuery(db, sql) != 0) {
         return Result<std::vector<Document>>::Error("查询分享文档失败: " + std::string(mysql_error(db)));
     }
 
@@ -738,21 +1672,13 @@ Result<std::vector<Document>> DatabaseManager::getSharedDocuments(int userId, in
         return Result<std::vector<Document>>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
     }
 
+    // minio_key 列是分享复制出的键
     std::vector<Document> documents;
+    documents.reserve(mysql_num_rows(result));
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        Document doc;
-        doc.id = std::stoi(row[0]);
-        doc.title = row[1];
-        doc.description = row[2] ? row[2] : "";
-        doc.file_path = row[3] ? row[3] : "";
-        doc.minio_key = row[4] ? row[4] : "";  // 使用分享的minio_key
-        doc.owner_id = std::stoi(row[5]);
-        doc.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
-        doc.updated_at = Utils::parseTimestamp(row[7] ? row[7] : "");
-        doc.file_size = std::stoull(row[8] ? row[8] : "0");
-        doc.content_type = row[9] ? row[9] : "application/octet-stream";
-        documents.push_back(doc);
+        documents.emplace_back();
+        decodeDocument(RowDecoder(result, row), documents.back());
     }
 
     mysql_free_result(result);
@@ -760,15 +1686,17 @@ Result<std::vector<Document>> DatabaseManager::getSharedDocuments(int userId, in
 }
 
 Result<std::vector<DocumentShare>> DatabaseManager::getDocumentShares(int documentId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "getDocumentShares");
+    auto conn = acquireReadConnection();
+    if (!conn) {
         return Result<std::vector<DocumentShare>>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
 
     std::string sql = "SELECT id, document_id, shared_by_user_id, shared_to_user_id, shared_document_id, shared_minio_key, created_at FROM document_shares WHERE document_id = " +
-                      std::to_string(documentId) + ";";
+                      std::to_string(documentId) + " AND " + LIVE_SHARE + ";";
 
-    if (mysql_query(db, sql.c_str()) != 0) {
+    if (runQuery(db, sql) != 0) {
         return Result<std::vector<DocumentShare>>::Error("查询分享记录失败: " + std::string(mysql_error(db)));
     }
 
@@ -778,17 +1706,11 @@ Result<std::vector<DocumentShare>> DatabaseManager::getDocumentShares(int docume
     }
 
     std::vector<DocumentShare> shares;
+    shares.reserve(mysql_num_rows(result));
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        DocumentShare share;
-        share.id = std::stoi(row[0]);
-        share.document_id = std::stoi(row[1]);
-        share.shared_by_user_id = std::stoi(row[2]);
-        share.shared_to_user_id = std::stoi(row[3]);
-        share.shared_document_id = std::stoi(row[4]);
-        share.shared_minio_key = row[5] ? row[5] : "";
-        share.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
-        shares.push_back(share);
+        shares.emplace_back();
+        decodeDocumentShare(RowDecoder(result, row), shares.back());
     }
 
     mysql_free_result(result);
@@ -796,235 +1718,1667 @@ Result<std::vector<DocumentShare>> DatabaseManager::getDocumentShares(int docume
 }
 
 Result<bool> DatabaseManager::deleteDocumentShare(int shareId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "deleteDocumentShare");
+    return runInTransaction<bool>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+        std::string id = std::to_string(shareId);
+
+        std::map<int, UsageStats> deltas;
+        if (!collectShareDeltas(db, "id = " + id, deltas)) {
+            return Result<bool>::Error("删除分享记录失败: " + std::string(mysql_error(db)));
+        }
+
+        // 收件箱中的对应行经外键级联删除
+        std::string sql = "DELETE FROM document_shares WHERE id = " + id + ";";
+        if (runQuery(db, sql) != 0) {
+            return Result<bool>::Error("删除分享记录失败: " + std::string(mysql_error(db)));
+        }
+        if (mysql_affected_rows(db) == 0) {
+            return Result<bool>::Error("分享记录不存在");
+        }
+
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<bool>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
+        return Result<bool>::Success(true);
+    });
+}
+
+Result<bool> DatabaseManager::isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId) {
+    QueryTimer timer(queryStats, "isDocumentShared");
+    auto conn = acquireConnection();
+    if (!conn) {
         return Result<bool>::Error("数据库未连接");
     }
 
-    std::string sql = "DELETE FROM document_shares WHERE id = " + std::to_string(shareId) + ";";
+    BoundStatement stmt(acquireStatement(conn, SQL_DOCUMENT_SHARE_EXISTS));
+    stmt.bind(documentId).bind(sharedByUserId).bind(sharedToUserId);
+    if (!stmt.execute()) {
+        handleStatementError(conn, SQL_DOCUMENT_SHARE_EXISTS, stmt);
+        return Result<bool>::Error("查询分享记录失败: " + stmt.error());
+    }
+
+    bool exists = stmt.fetch() && stmt.getInt64(0) > 0;
+    return Result<bool>::Success(exists);
+}
 
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<bool>::Error("删除分享记录失败: " + std::string(mysql_error(db)));
+void DatabaseManager::applyIndexChange(std::function<void()> change) {
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto threadId = std::this_thread::get_id();
+        if (transactionConnections.count(threadId)) {
+            pendingIndexChanges[threadId].push_back(std::move(change));
+            return;
+        }
     }
+    change();
+}
 
-    if (mysql_affected_rows(db) == 0) {
-        return Result<bool>::Error("分享记录不存在");
+Result<size_t> DatabaseManager::rebuildSearchIndex() {
+    QueryTimer timer(queryStats, "rebuildSearchIndex");
+    auto startTime = std::chrono::steady_clock::now();
+    searchIndex.clear();
+
+    // 固定读主库：副本可能还没追上已经应用到索引的写入
+    auto result = streamDocuments(DocumentFilter(), [this](const Document& doc) {
+        searchIndex.addOrUpdate(doc);
+        return true;
+    }, false);
+    if (!result.success) {
+        return result;
     }
+    searchIndex.markReady();
 
-    return Result<bool>::Success(true);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    DocumentSearchIndexStats stats = searchIndex.getStats();
+    LOG_INFO("文档搜索索引已构建: " + std::to_string(stats.documents) + " 个文档, " +
+             std::to_string(stats.grams) + " 个bigram, 约 " + std::to_string(stats.memoryBytes / 1024) +
+             " KB, 耗时 " + std::to_string(elapsed.count()) + "ms");
+    return result;
 }
 
-Result<bool> DatabaseManager::isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<bool>::Error("数据库未连接");
+std::vector<Document> DatabaseManager::quickSearchDocuments(const std::string& query, int ownerId, size_t limit,
+                                                            IndexMatchMode mode) const {
+    return searchIndex.search(query, ownerId, limit, mode);
+}
+
+bool DatabaseManager::inTransaction() {
+    std::lock_guard<std::mutex> lock(transactionMutex);
+    return transactionConnections.count(std::this_thread::get_id()) > 0;
+}
+
+// 在调用方的事务连接上执行，事务的开启、提交、回滚与冲突重试都由 runInTransaction 负责
+Result<std::vector<int>> DatabaseManager::insertBatch(MYSQL* db, const std::string& insertPrefix, size_t rowCount, size_t chunkSize,
+                                                      const std::function<std::string(MYSQL*, size_t)>& rowValues) {
+    if (rowCount == 0) {
+        return Result<std::vector<int>>::Success(std::vector<int>());
+    }
+    chunkSize = std::max<size_t>(1, chunkSize);
+
+    // 多行 INSERT ... VALUES 一次性分配一段连续的自增值，步长取会话的 auto_increment_increment
+    long long increment = 1;
+    if (mysql_query(db, "SELECT @@auto_increment_increment;") == 0) {
+        MYSQL_RES* result = mysql_store_result(db);
+        if (result) {
+            MYSQL_ROW row = mysql_fetch_row(result);
+            if (row && row[0]) {
+                increment = std::max(1LL, RowDecoder(result, row).getInt64(0, 1));
+            }
+            mysql_free_result(result);
+        }
+    }
+
+    std::vector<int> ids;
+    ids.reserve(rowCount);
+    std::string sql;
+    for (size_t start = 0; start < rowCount; start += chunkSize) {
+        size_t end = std::min(rowCount, start + chunkSize);
+
+        sql.assign(insertPrefix);
+        for (size_t i = start; i < end; ++i) {
+            if (i > start) {
+                sql += ",";
+            }
+            sql += rowValues(db, i);
+        }
+        sql += ";";
+
+        if (runQuery(db, sql) != 0) {
+            recordError(mysql_errno(db));
+            return Result<std::vector<int>>::Error("批量插入失败（第" + std::to_string(start + 1) + "-" + std::to_string(end) +
+                                                   "行）: " + std::string(mysql_error(db)));
+        }
+
+        long long firstId = static_cast<long long>(mysql_insert_id(db));
+        size_t inserted = static_cast<size_t>(mysql_affected_rows(db));
+        for (size_t i = 0; i < inserted; ++i) {
+            ids.push_back(static_cast<int>(firstId + static_cast<long long>(i) * increment));
+        }
     }
 
-    std::string sql = "SELECT COUNT(*) FROM document_shares WHERE document_id = " + std::to_string(documentId) +
-                      " AND shared_by_user_id = " + std::to_string(sharedByUserId) +
-                      " AND shared_to_user_id = " + std::to_string(sharedToUserId) + ";";
+    return Result<std::vector<int>>::Success(ids);
+}
+
+Result<std::vector<int>> DatabaseManager::createUsersBatch(const std::vector<User>& users, size_t chunkSize) {
+    QueryTimer timer(queryStats, "createUsersBatch");
+    return runInTransaction<std::vector<int>>([&](PooledConnection& conn) {
+        auto result = insertBatch(conn.get(), "INSERT INTO users (username, password_hash, email) VALUES ",
+                                  users.size(), chunkSize,
+                                  [&users](MYSQL* db, size_t i) {
+                                      const User& user = users[i];
+                                      return "('" + escapeString(db, user.username) + "', '" +
+                                             escapeString(db, user.password_hash) + "', '" +
+                                             escapeString(db, user.email) + "')";
+                                  });
+        if (result.success && !result.data->empty()) {
+            std::map<int, UsageStats> deltas;
+            deltas[0].userCount = static_cast<long long>(result.data->size());
+            if (!applyStatsDeltas(conn.get(), deltas)) {
+                return Result<std::vector<int>>::Error("更新用量统计失败: " + std::string(mysql_error(conn.get())));
+            }
+        }
+        return result;
+    });
+}
 
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<bool>::Error("查询分享记录失败: " + std::string(mysql_error(db)));
+Result<std::vector<int>> DatabaseManager::createDocumentsBatch(const std::vector<Document>& documents, size_t chunkSize) {
+    QueryTimer timer(queryStats, "createDocumentsBatch");
+    auto result = runInTransaction<std::vector<int>>([&](PooledConnection& conn) {
+        auto inserted = insertBatch(conn.get(), "INSERT INTO documents (title, description, file_path, minio_key, owner_id, file_size, content_type) VALUES ",
+                                    documents.size(), chunkSize,
+                                    [&documents](MYSQL* db, size_t i) {
+                                        const Document& doc = documents[i];
+                                        return "('" + escapeString(db, doc.title) + "', '" +
+                                               escapeString(db, doc.description) + "', '" +
+                                               escapeString(db, doc.file_path) + "', '" +
+                                               escapeString(db, doc.minio_key) + "', " +
+                                               std::to_string(doc.owner_id) + ", " +
+                                               std::to_string(doc.file_size) + ", '" +
+                                               escapeString(db, doc.content_type) + "')";
+                                    });
+        if (inserted.success && !inserted.data->empty()) {
+            std::map<int, UsageStats> deltas;
+            for (size_t i = 0; i < inserted.data->size(); ++i) {
+                for (int key : {0, documents[i].owner_id}) {
+                    deltas[key].documentCount += 1;
+                    deltas[key].totalBytes += static_cast<long long>(documents[i].file_size);
+                }
+            }
+            if (!applyStatsDeltas(conn.get(), deltas)) {
+                return Result<std::vector<int>>::Error("更新用量统计失败: " + std::string(mysql_error(conn.get())));
+            }
+        }
+        return inserted;
+    });
+
+    if (result.success && result.data->size() == documents.size()) {
+        // 批量插入不回读，时间戳以本地当前时间近似
+        auto now = std::chrono::system_clock::now();
+        const std::vector<int>& ids = result.data.value();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            Document doc = documents[i];
+            doc.id = ids[i];
+            doc.created_at = now;
+            doc.updated_at = now;
+            applyIndexChange([this, doc]() { searchIndex.addOrUpdate(doc); });
+        }
     }
+    return result;
+}
 
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<bool>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+Result<std::string> DatabaseManager::fetchKeysetPage(const std::string& columns, const std::string& from,
+                                                     const std::string& fromCondition, const std::string& archiveFrom,
+                                                     const std::string& archiveCondition,
+                                                     const std::string& filter, int filterId, const std::string& keyPrefix,
+                                                     int pageSize, const std::string& pageToken,
+                                                     const std::function<void(const BoundStatement&)>& onRow) {
+    std::string cursorCreatedAt;
+    long long cursorId = 0;
+    bool hasCursor = !pageToken.empty();
+    if (hasCursor && !decodePageToken(pageToken, cursorCreatedAt, cursorId)) {
+        return Result<std::string>::Error("无效的分页令牌");
+    }
+    pageSize = std::max(1, std::min(pageSize, MAX_PAGE_SIZE));
+
+    auto conn = acquireReadConnection();
+    if (!conn) {
+        return Result<std::string>::Error("数据库未连接");
+    }
+
+    // 排序键追加在选择列之后；多取一行用来判断是否还有下一页
+    const std::string createdAtColumn = keyPrefix + "created_at";
+    const std::string idColumn = keyPrefix + "id";
+    std::string where = filter;
+    if (hasCursor) {
+        where += (where.empty() ? "" : " AND ");
+        where += "(" + createdAtColumn + " < ? OR (" + createdAtColumn + " = ? AND " + idColumn + " < ?))";
+    }
+    // 表自身的可见条件不含参数，放在最前面，绑定顺序不变
+    auto pageOf = [&](const std::string& table, const std::string& condition) {
+        std::string tableWhere = condition;
+        if (!where.empty()) {
+            tableWhere += (tableWhere.empty() ? "" : " AND ") + where;
+        }
+        return "SELECT " + columns + ", " + createdAtColumn + " AS page_created_at, " + idColumn + " AS page_id FROM " +
+               table + (tableWhere.empty() ? "" : " WHERE " + tableWhere) +
+               " ORDER BY " + createdAtColumn + " DESC, " + idColumn + " DESC LIMIT ?";
+    };
+    // 包含归档时两张表各自按索引取一页，合并后只需对至多 2*(pageSize+1) 行排序
+    std::string sql = archiveFrom.empty() ? pageOf(from, fromCondition)
+                    : "SELECT * FROM ((" + pageOf(from, fromCondition) + ") UNION ALL (" +
+                      pageOf(archiveFrom, archiveCondition) + ")) AS merged "
+                      "ORDER BY page_created_at DESC, page_id DESC LIMIT ?";
+
+    BoundStatement stmt(acquireStatement(conn, sql));
+    for (int part = archiveFrom.empty() ? 1 : 2; part > 0; --part) {
+        if (!filter.empty()) {
+            stmt.bind(filterId);
+        }
+        if (hasCursor) {
+            stmt.bind(cursorCreatedAt).bind(cursorCreatedAt).bind(cursorId);
+        }
+        stmt.bind(pageSize + 1);
+    }
+    if (!archiveFrom.empty()) {
+        stmt.bind(pageSize + 1);
     }
 
-    MYSQL_ROW row = mysql_fetch_row(result);
-    bool exists = false;
-    if (row && row[0]) {
-        int count = std::stoi(row[0]);
-        exists = (count > 0);
+    if (!stmt.execute()) {
+        handleStatementError(conn, sql, stmt);
+        return Result<std::string>::Error("分页查询失败: " + stmt.error());
     }
 
-    mysql_free_result(result);
-    return Result<bool>::Success(exists);
+    int rows = 0;
+    std::string lastCreatedAt;
+    long long lastId = 0;
+    while (stmt.fetch()) {
+        if (rows == pageSize) {
+            // 存在第 pageSize+1 行，说明还有下一页
+            return Result<std::string>::Success(encodePageToken(lastCreatedAt, lastId), "查询成功");
+        }
+        size_t keyColumn = stmt.columnCount() - 2;
+        lastCreatedAt = stmt.getString(keyColumn);
+        lastId = stmt.getInt64(keyColumn + 1);
+        onRow(stmt);
+        rows++;
+    }
+    return Result<std::string>::Success(std::string(), "查询成功");
 }
 
-Result<std::vector<User>> DatabaseManager::searchUsers(const std::string& query, int limit) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<std::vector<User>>::Error("数据库未连接");
+Result<Page<User>> DatabaseManager::getUsersPage(int pageSize, const std::string& pageToken) {
+    QueryTimer timer(queryStats, "getUsersPage");
+    Page<User> page;
+    auto result = fetchKeysetPage("id, username, password_hash, email, created_at, last_login, is_active",
+                                  "users", "deleted_at IS NULL", "", "", "", 0, "", pageSize, pageToken,
+                                  [&page](const BoundStatement& stmt) {
+                                      page.items.push_back(readUserRow(stmt));
+                                  });
+    if (!result.success) {
+        return Result<Page<User>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<User>>::Success(page);
+}
+
+Result<Page<Document>> DatabaseManager::getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken) {
+    return getDocumentsByOwnerPage(ownerId, pageSize, pageToken, false);
+}
+
+Result<Page<Document>> DatabaseManager::getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken,
+                                                                bool includeArchived) {
+    QueryTimer timer(queryStats, "getDocumentsByOwnerPage");
+    Page<Document> page;
+    auto result = fetchKeysetPage("id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type",
+                                  "documents", liveDocument(), includeArchived ? "documents_archive" : "",
+                                  "owner_id NOT IN " + DELETED_USER_IDS, "owner_id = ?", ownerId, "", pageSize, pageToken,
+                                  [&page](const BoundStatement& stmt) {
+                                      page.items.push_back(readDocumentRow(stmt));
+                                  });
+    if (!result.success) {
+        return Result<Page<Document>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<Document>>::Success(page);
+}
+
+Result<Page<Document>> DatabaseManager::getAllDocumentsPage(int pageSize, const std::string& pageToken) {
+    return getAllDocumentsPage(pageSize, pageToken, false);
+}
+
+Result<Page<Document>> DatabaseManager::getAllDocumentsPage(int pageSize, const std::string& pageToken, bool includeArchived) {
+    QueryTimer timer(queryStats, "getAllDocumentsPage");
+    Page<Document> page;
+    auto result = fetchKeysetPage("id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type",
+                                  "documents", liveDocument(), includeArchived ? "documents_archive" : "",
+                                  "owner_id NOT IN " + DELETED_USER_IDS, "", 0, "", pageSize, pageToken,
+                                  [&page](const BoundStatement& stmt) {
+                                      page.items.push_back(readDocumentRow(stmt));
+                                  });
+    if (!result.success) {
+        return Result<Page<Document>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<Document>>::Success(page);
+}
+
+Result<Page<Document>> DatabaseManager::getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken) {
+    return getSharedDocumentsPage(userId, pageSize, pageToken, false);
+}
+
+Result<Page<Document>> DatabaseManager::getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken,
+                                                               bool includeArchived) {
+    QueryTimer timer(queryStats, "getSharedDocumentsPage");
+    // 按分享时间翻页：share_inbox 的主键就是 (shared_to_user_id, created_at, id)，每页一次范围扫描；
+    // document_shares_archive 的主键与列表列相同。涉及已删除用户或文档的分享在清理前仍在表中，两张表都按可见条件过滤
+    Page<Document> page;
+    auto result = fetchKeysetPage(SHARE_INBOX_DOCUMENT_COLUMNS, "share_inbox", LIVE_SHARE_INBOX,
+                                  includeArchived ? "document_shares_archive" : "", LIVE_ARCHIVED_SHARE,
+                                  "shared_to_user_id = ?", userId, "", pageSize, pageToken,
+                                  [&page](const BoundStatement& stmt) {
+                                      page.items.push_back(readDocumentRow(stmt));
+                                  });
+    if (!result.success) {
+        return Result<Page<Document>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<Document>>::Success(page);
+}
+
+Result<size_t> DatabaseManager::streamQuery(const std::string& sql, const std::function<bool(const RowDecoder&)>& visitor,
+                                             bool allowReplica) {
+    // 不复用事务连接：未读完的结果集会占住连接，回调里再发语句会 "Commands out of sync"
+    if (!isConnected || !pool) {
+        return Result<size_t>::Error("数据库未连接");
     }
-    
-    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users WHERE username LIKE '%" + 
-                      query + "%' OR email LIKE '%" + query + "%' LIMIT " + std::to_string(limit) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<std::vector<User>>::Error("搜索用户失败: " + std::string(mysql_error(db)));
+    PooledConnection conn = allowReplica ? acquireReplicaConnection() : PooledConnection();
+    if (!conn) {
+        if (allowReplica && !replicas.empty()) {
+            primaryReadCount++;
+        }
+        conn = pool->acquire();
+        if (conn) {
+            applyCallDeadline(conn);
+        }
     }
-    
-    MYSQL_RES* result = mysql_store_result(db);
+    if (!conn) {
+        return Result<size_t>::Error("获取数据库连接失败: " + pool->getLastError());
+    }
+    MYSQL* db = conn.get();
+
+    if (runQuery(db, sql) != 0) {
+        return Result<size_t>::Error("查询失败: " + std::string(mysql_error(db)));
+    }
+
+    // 提前结束或回调抛异常时，mysql_free_result 会读掉剩余的行，连接可以安全归还
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_use_result(db), &mysql_free_result);
     if (!result) {
-        return Result<std::vector<User>>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        return Result<size_t>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
     }
-    
-    std::vector<User> users;
+
+    size_t visited = 0;
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        User user;
-        user.id = std::stoi(row[0]);
-        user.username = row[1];
-        user.password_hash = row[2];
-        user.email = row[3];
-        user.created_at = std::chrono::system_clock::now();
-        user.last_login = std::chrono::system_clock::now();
-        user.is_active = std::stoi(row[6]) != 0;
-        users.push_back(user);
+    while ((row = mysql_fetch_row(result.get()))) {
+        visited++;
+        if (!visitor(RowDecoder(result.get(), row))) {
+            return Result<size_t>::Success(visited);
+        }
     }
-    
-    mysql_free_result(result);
-    return Result<std::vector<User>>::Success(users);
-}
 
-Result<std::vector<Document>> DatabaseManager::searchDocuments(const std::string& query, int limit) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<std::vector<Document>>::Error("数据库未连接");
+    // mysql_fetch_row 返回 NULL 也可能是读取中途出错
+    if (mysql_errno(db) != 0) {
+        return Result<size_t>::Error("读取查询结果失败: " + std::string(mysql_error(db)));
     }
+    return Result<size_t>::Success(visited);
+}
+
+Result<size_t> DatabaseManager::forEachUser(const UserVisitor& visitor) {
+    QueryTimer timer(queryStats, "forEachUser");
+    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+                      "WHERE deleted_at IS NULL ORDER BY id;";
+    User user;
+    return streamQuery(sql, [&visitor, &user](const RowDecoder& row) {
+        decodeUser(row, user);
+        return visitor(user);
+    });
+}
+
+Result<size_t> DatabaseManager::forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor) {
+    return forEachDocument(filter, visitor, false);
+}
+
+Result<size_t> DatabaseManager::forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor,
+                                                bool includeArchived) {
+    QueryTimer timer(queryStats, "forEachDocument");
+    return streamDocuments(filter, visitor, true, includeArchived);
+}
+
+Result<size_t> DatabaseManager::streamDocuments(const DocumentFilter& filter, const DocumentVisitor& visitor, bool allowReplica,
+                                                bool includeArchived) {
+    // 分享列表读收件箱（归档的分享在 document_shares_archive，列名相同），文档读 documents（归档在 documents_archive）
+    // 可见条件与分页一致：在线文档按 liveDocument，归档文档按所有者过滤，两张分享表按各自的分享可见条件过滤
+    auto buildSql = [&filter](const std::string& documentsTable, const std::string& documentCondition,
+                              const std::string& sharesTable, const std::string& shareCondition) {
+        std::string sql;
+        if (filter.sharedToUserId > 0) {
+            sql = "SELECT " + SHARE_INBOX_DOCUMENT_COLUMNS + " FROM " + sharesTable +
+                  " WHERE shared_to_user_id = " + std::to_string(filter.sharedToUserId) + " AND " + shareCondition;
+            if (filter.ownerId > 0) {
+                sql += " AND owner_id = " + std::to_string(filter.ownerId);
+            }
+            sql += " ORDER BY created_at, id;";
+        } else {
+            sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM " +
+                  documentsTable + " WHERE " + documentCondition;
+            if (filter.ownerId > 0) {
+                sql += " AND owner_id = " + std::to_string(filter.ownerId);
+            }
+            sql += " ORDER BY id;";
+        }
+        return sql;
+    };
+
+    Document doc;
+    bool stopped = false;
+    auto visit = [&visitor, &doc, &stopped](const RowDecoder& row) {
+        decodeDocument(row, doc);
+        stopped = !visitor(doc);
+        return !stopped;
+    };
+
+    size_t visited = 0;
+    if (includeArchived) {
+        auto archived = streamQuery(buildSql("documents_archive", "owner_id NOT IN " + DELETED_USER_IDS,
+                                             "document_shares_archive", LIVE_ARCHIVED_SHARE),
+                                    visit, allowReplica);
+        if (!archived.success || stopped) {
+            return archived;
+        }
+        visited = archived.data.value();
+    }
+    auto result = streamQuery(buildSql("documents", liveDocument(), "share_inbox", LIVE_SHARE_INBOX), visit, allowReplica);
+    if (!result.success) {
+        return result;
+    }
+    return Result<size_t>::Success(visited + result.data.value());
+}
+
+Result<std::vector<User>> DatabaseManager::searchUsers(const std::string& query, int limit) {
+    QueryTimer timer(queryStats, "searchUsers");
+    auto conn = acquireReadConnection();
+    if (!conn) {
+        return Result<std::vector<User>>::Error("数据库未连接");
+    }
+    MYSQL* db = conn.get();
+    
+    std::string sql = "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users WHERE deleted_at IS NULL AND (username LIKE '%" + 
+                      query + "%' OR email LIKE '%" + query + "%') LIMIT " + std::to_string(limit) + ";";
     
-    std::string sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM documents WHERE title LIKE '%" + 
-                      query + "%' OR description LIKE '%" + query + "%' LIMIT " + std::to_string(limit) + ";";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<std::vector<Document>>::Error("搜索文档失败: " + std::string(mysql_error(db)));
+    if (runQuery(db, sql) != 0) {
+        return Result<std::vector<User>>::Error("搜索用户失败: " + std::string(mysql_error(db)));
     }
     
     MYSQL_RES* result = mysql_store_result(db);
     if (!result) {
-        return Result<std::vector<Document>>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        return Result<std::vector<User>>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
     }
     
-    std::vector<Document> documents;
+    std::vector<User> users;
+    users.reserve(mysql_num_rows(result));
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        Document doc;
-        doc.id = std::stoi(row[0]);
-        doc.title = row[1];
-        doc.description = row[2] ? row[2] : "";
-        doc.file_path = row[3] ? row[3] : "";
-        doc.minio_key = row[4] ? row[4] : "";
-        doc.owner_id = std::stoi(row[5]);
-        doc.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
-        doc.updated_at = Utils::parseTimestamp(row[7] ? row[7] : "");
-        doc.file_size = std::stoull(row[8] ? row[8] : "0");
-        doc.content_type = row[9] ? row[9] : "application/octet-stream";
-        documents.push_back(doc);
+        users.emplace_back();
+        decodeUser(RowDecoder(result, row), users.back());
     }
     
     mysql_free_result(result);
+    return Result<std::vector<User>>::Success(users);
+}
+
+Result<std::vector<Document>> DatabaseManager::searchDocuments(const std::string& query, const DocumentSearchOptions& options) {
+    QueryTimer timer(queryStats, "searchDocuments");
+    bool useFulltext = false;
+    switch (options.mode) {
+        case DocumentSearchMode::FullText:
+            if (!fulltextSearchEnabled) {
+                return Result<std::vector<Document>>::Error("全文索引不可用");
+            }
+            useFulltext = true;
+            break;
+        case DocumentSearchMode::Auto:
+            // ngram 默认按2个字符切分，单字关键词在全文索引中查不到
+            useFulltext = fulltextSearchEnabled && utf8Length(query) >= 2;
+            break;
+        case DocumentSearchMode::Like:
+            break;
+    }
+
+    auto conn = acquireReadConnection();
+    if (!conn) {
+        return Result<std::vector<Document>>::Error("数据库未连接");
+    }
+
+    std::string sql = "SELECT d.id, d.title, d.description, d.file_path, d.minio_key, d.owner_id, d.created_at, d.updated_at, d.file_size, d.content_type";
+    if (useFulltext) {
+        sql += ", MATCH(d.title, d.description) AGAINST(? IN NATURAL LANGUAGE MODE) AS score"
+               " FROM documents d WHERE MATCH(d.title, d.description) AGAINST(? IN NATURAL LANGUAGE MODE)";
+    } else {
+        sql += " FROM documents d WHERE (d.title LIKE ? OR d.description LIKE ?)";
+    }
+    sql += " AND " + liveDocument("d.");
+    if (options.ownerId > 0) {
+        sql += " AND d.owner_id = ?";
+    }
+    if (options.visibleToUserId > 0) {
+        sql += " AND (d.owner_id = ? OR EXISTS (SELECT 1 FROM document_shares ds"
+               " WHERE ds.shared_document_id = d.id AND ds.shared_to_user_id = ?))";
+    }
+    sql += useFulltext ? " ORDER BY score DESC, d.id DESC" : " ORDER BY d.id DESC";
+    sql += " LIMIT ? OFFSET ?";
+
+    BoundStatement stmt(acquireStatement(conn, sql));
+    std::string pattern = useFulltext ? query : "%" + escapeLikePattern(query) + "%";
+    stmt.bind(pattern).bind(pattern);
+    if (options.ownerId > 0) {
+        stmt.bind(options.ownerId);
+    }
+    if (options.visibleToUserId > 0) {
+        stmt.bind(options.visibleToUserId).bind(options.visibleToUserId);
+    }
+    stmt.bind(std::max(1, std::min(options.limit, MAX_PAGE_SIZE))).bind(std::max(0, options.offset));
+
+    if (!stmt.execute()) {
+        handleStatementError(conn, sql, stmt);
+        return Result<std::vector<Document>>::Error("搜索文档失败: " + stmt.error());
+    }
+
+    std::vector<Document> documents;
+    while (stmt.fetch()) {
+        documents.push_back(readDocumentRow(stmt));
+    }
     return Result<std::vector<Document>>::Success(documents);
 }
 
 Result<int> DatabaseManager::getUserCount() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<int>::Error("数据库未连接");
+    QueryTimer timer(queryStats, "getUserCount");
+    auto result = getUsageStats(0);
+    if (!result.success) {
+        return Result<int>::Error("获取用户数量失败: " + result.message);
     }
-    
-    std::string sql = "SELECT COUNT(*) FROM users;";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<int>::Error("获取用户数量失败: " + std::string(mysql_error(db)));
+    return Result<int>::Success(static_cast<int>(result.data->userCount));
+}
+
+Result<int> DatabaseManager::getDocumentCount() {
+    QueryTimer timer(queryStats, "getDocumentCount");
+    auto result = getUsageStats(0);
+    if (!result.success) {
+        return Result<int>::Error("获取文档数量失败: " + result.message);
     }
-    
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<int>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+    return Result<int>::Success(static_cast<int>(result.data->documentCount));
+}
+
+Result<size_t> DatabaseManager::getTotalFileSize() {
+    QueryTimer timer(queryStats, "getTotalFileSize");
+    auto result = getUsageStats(0);
+    if (!result.success) {
+        return Result<size_t>::Error("获取总文件大小失败: " + result.message);
     }
-    
-    MYSQL_ROW row = mysql_fetch_row(result);
-    int count = 0;
-    if (row) {
-        count = std::stoi(row[0]);
+    return Result<size_t>::Success(static_cast<size_t>(std::max(0LL, result.data->totalBytes)));
+}
+
+Result<UsageStats> DatabaseManager::getUsageStats(int ownerId) {
+    QueryTimer timer(queryStats, "getUsageStats");
+    auto conn = acquireReadConnection();
+    if (!conn) {
+        return Result<UsageStats>::Error("数据库未连接");
     }
-    
-    mysql_free_result(result);
-    return Result<int>::Success(count);
+
+    BoundStatement stmt(acquireStatement(conn, SQL_USAGE_STATS));
+    stmt.bind(ownerId);
+    if (!stmt.execute()) {
+        handleStatementError(conn, SQL_USAGE_STATS, stmt);
+        return Result<UsageStats>::Error("查询用量统计失败: " + stmt.error());
+    }
+
+    UsageStats stats;
+    if (!stmt.fetch()) {
+        // 用户还没有任何文档或分享时不存在统计行，计数均为0；全局行缺失说明尚未初始化
+        if (ownerId == 0) {
+            return Result<UsageStats>::Error("用量统计尚未初始化");
+        }
+        return Result<UsageStats>::Success(stats);
+    }
+    stats.userCount = stmt.getInt64(0);
+    stats.documentCount = stmt.getInt64(1);
+    stats.totalBytes = stmt.getInt64(2);
+    stats.sharesGiven = stmt.getInt64(3);
+    stats.sharesReceived = stmt.getInt64(4);
+    return Result<UsageStats>::Success(stats);
 }
 
-Result<int> DatabaseManager::getDocumentCount() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<int>::Error("数据库未连接");
+bool DatabaseManager::applyStatsDeltas(MYSQL* db, const std::map<int, UsageStats>& deltas) {
+    std::string sql = "INSERT INTO usage_stats (owner_id, user_count, document_count, total_bytes, shares_given, shares_received) VALUES ";
+    bool first = true;
+    for (const auto& item : deltas) {
+        const UsageStats& d = item.second;
+        if (d.userCount == 0 && d.documentCount == 0 && d.totalBytes == 0 && d.sharesGiven == 0 && d.sharesReceived == 0) {
+            continue;
+        }
+        sql += (first ? "(" : ", (") + std::to_string(item.first) + ", " + std::to_string(d.userCount) + ", " +
+               std::to_string(d.documentCount) + ", " + std::to_string(d.totalBytes) + ", " +
+               std::to_string(d.sharesGiven) + ", " + std::to_string(d.sharesReceived) + ")";
+        first = false;
     }
-    
-    std::string sql = "SELECT COUNT(*) FROM documents;";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<int>::Error("获取文档数量失败: " + std::string(mysql_error(db)));
+    if (first) {
+        return true;
     }
-    
-    MYSQL_RES* result = mysql_store_result(db);
+    sql += " ON DUPLICATE KEY UPDATE user_count = user_count + VALUES(user_count), "
+           "document_count = document_count + VALUES(document_count), "
+           "total_bytes = total_bytes + VALUES(total_bytes), "
+           "shares_given = shares_given + VALUES(shares_given), "
+           "shares_received = shares_received + VALUES(shares_received);";
+    return runQuery(db, sql) == 0;
+}
+
+bool DatabaseManager::collectShareDeltas(MYSQL* db, const std::string& where, std::map<int, UsageStats>& deltas) {
+    std::string sql = "SELECT shared_by_user_id, shared_to_user_id, COUNT(*) FROM document_shares WHERE " + where +
+                      " GROUP BY shared_by_user_id, shared_to_user_id FOR UPDATE;";
+    if (runQuery(db, sql) != 0) {
+        return false;
+    }
+    std::map<int, UsageStats> shares;
+    {
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        if (!result) {
+            return false;
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            RowDecoder decoder(result.get(), row);
+            long long count = decoder.getInt64(2);
+            shares[decoder.getInt(0)].sharesGiven -= count;
+            shares[decoder.getInt(1)].sharesReceived -= count;
+            shares[0].sharesGiven -= count;
+            shares[0].sharesReceived -= count;
+        }
+    }
+
+    // 已删除用户的统计行在删除时已整行从全局扣除，这里只扣在线的一方；共享锁与 deleteUser 对用户行的更新互斥
+    std::string userIds;
+    for (const auto& item : shares) {
+        if (item.first != 0) {
+            userIds += (userIds.empty() ? "" : ",") + std::to_string(item.first);
+        }
+    }
+    if (!userIds.empty()) {
+        std::string deletedSql = "SELECT id FROM users WHERE id IN (" + userIds + ") AND deleted_at IS NOT NULL LOCK IN SHARE MODE;";
+        if (runQuery(db, deletedSql) != 0) {
+            return false;
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        if (!result) {
+            return false;
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            auto deleted = shares.find(RowDecoder(result.get(), row).getInt(0));
+            shares[0].sharesGiven -= deleted->second.sharesGiven;
+            shares[0].sharesReceived -= deleted->second.sharesReceived;
+            shares.erase(deleted);
+        }
+    }
+
+    for (const auto& item : shares) {
+        deltas[item.first].sharesGiven += item.second.sharesGiven;
+        deltas[item.first].sharesReceived += item.second.sharesReceived;
+    }
+    return true;
+}
+
+Result<UsageStats> DatabaseManager::lockUsageStats(MYSQL* db, int ownerId) {
+    std::string sql = "SELECT user_count, document_count, total_bytes, shares_given, shares_received FROM usage_stats "
+                      "WHERE owner_id = " + std::to_string(ownerId) + " FOR UPDATE;";
+    if (runQuery(db, sql) != 0) {
+        return Result<UsageStats>::Error("读取用量统计失败: " + std::string(mysql_error(db)));
+    }
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
     if (!result) {
-        return Result<int>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        return Result<UsageStats>::Error("读取用量统计失败: " + std::string(mysql_error(db)));
     }
-    
-    MYSQL_ROW row = mysql_fetch_row(result);
-    int count = 0;
+
+    // 还没有任何文档或分享的用户没有统计行，计数均为0
+    UsageStats stats;
+    MYSQL_ROW row = mysql_fetch_row(result.get());
     if (row) {
-        count = std::stoi(row[0]);
+        RowDecoder decoder(result.get(), row);
+        stats.userCount = decoder.getInt64(0);
+        stats.documentCount = decoder.getInt64(1);
+        stats.totalBytes = decoder.getInt64(2);
+        stats.sharesGiven = decoder.getInt64(3);
+        stats.sharesReceived = decoder.getInt64(4);
+    }
+    return Result<UsageStats>::Success(stats);
+}
+
+bool DatabaseManager::collectStatsDrift(MYSQL* db, long long low, long long high, std::map<int, UsageStats>& deltas) {
+    // 列顺序：owner_id, user_count, document_count, total_bytes, shares_given, shares_received。
+    // 已软删除的用户和文档不计入；尚未清理的分享与增量维护时一致，只计入在线的一方
+    const std::string live = liveDocument();
+    const std::string liveGiver = "shared_by_user_id NOT IN " + DELETED_USER_IDS;
+    const std::string liveReceiver = "shared_to_user_id NOT IN " + DELETED_USER_IDS;
+    const std::string storedColumns =
+            "SELECT owner_id, user_count, document_count, total_bytes, shares_given, shares_received FROM usage_stats WHERE owner_id";
+    std::vector<std::string> expected;
+    std::string stored;
+    if (high == 0) {
+        expected.push_back("SELECT 0, (SELECT COUNT(*) FROM users WHERE deleted_at IS NULL), "
+                           "(SELECT COUNT(*) FROM documents WHERE " + live + "), "
+                           "(SELECT COALESCE(SUM(file_size), 0) FROM documents WHERE " + live + "), "
+                           "(SELECT COUNT(*) FROM document_shares WHERE " + liveGiver + "), "
+                           "(SELECT COUNT(*) FROM document_shares WHERE " + liveReceiver + ");");
+        stored = storedColumns + " = 0;";
+    } else {
+        const std::string range = " BETWEEN " + std::to_string(low) + " AND " + std::to_string(high);
+        expected.push_back("SELECT owner_id, 0, COUNT(*), COALESCE(SUM(file_size), 0), 0, 0 FROM documents "
+                           "WHERE owner_id" + range + " AND " + live + " GROUP BY owner_id;");
+        expected.push_back("SELECT shared_by_user_id, 0, 0, 0, COUNT(*), 0 FROM document_shares "
+                           "WHERE shared_by_user_id" + range + " AND " + liveGiver + " GROUP BY shared_by_user_id;");
+        expected.push_back("SELECT shared_to_user_id, 0, 0, 0, 0, COUNT(*) FROM document_shares "
+                           "WHERE shared_to_user_id" + range + " AND " + liveReceiver + " GROUP BY shared_to_user_id;");
+        stored = storedColumns + range + ";";
+    }
+
+    std::map<int, UsageStats> drift;
+    auto accumulate = [&](const std::string& sql, long long sign) {
+        if (runQuery(db, sql) != 0) {
+            return false;
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        if (!result) {
+            return false;
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            RowDecoder decoder(result.get(), row);
+            UsageStats& d = drift[decoder.getInt(0)];
+            d.userCount += sign * decoder.getInt64(1);
+            d.documentCount += sign * decoder.getInt64(2);
+            d.totalBytes += sign * decoder.getInt64(3);
+            d.sharesGiven += sign * decoder.getInt64(4);
+            d.sharesReceived += sign * decoder.getInt64(5);
+        }
+        return true;
+    };
+    for (const std::string& sql : expected) {
+        if (!accumulate(sql, 1)) {
+            return false;
+        }
     }
-    
-    mysql_free_result(result);
-    return Result<int>::Success(count);
+    if (!accumulate(stored, -1)) {
+        return false;
+    }
+
+    for (const auto& item : drift) {
+        const UsageStats& d = item.second;
+        if (d.userCount != 0 || d.documentCount != 0 || d.totalBytes != 0 || d.sharesGiven != 0 || d.sharesReceived != 0) {
+            deltas[item.first] = d;
+        }
+    }
+    return true;
 }
 
-Result<size_t> DatabaseManager::getTotalFileSize() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+Result<size_t> DatabaseManager::reconcileUsageStats() {
+    QueryTimer timer(queryStats, "reconcileUsageStats");
+    if (inTransaction()) {
+        return Result<size_t>::Error("不能在事务中重算用量统计");
+    }
+
+    // 多个客户端都会定时重算，只让拿到锁的一个执行；锁连接同时用来做只读的快照查询
+    auto lockConn = acquireConnection();
+    if (!lockConn) {
         return Result<size_t>::Error("数据库未连接");
     }
-    
-    std::string sql = "SELECT SUM(file_size) FROM documents;";
-    
-    if (mysql_query(db, sql.c_str()) != 0) {
-        return Result<size_t>::Error("获取总文件大小失败: " + std::string(mysql_error(db)));
+    MYSQL* db = lockConn.get();
+    if (!acquireNamedLock(db, "usage_stats_reconcile", 0)) {
+        LOG_INFO("其他客户端正在重算用量统计，本轮跳过");
+        return Result<size_t>::Success(0, "其他客户端正在重算用量统计");
+    }
+    NamedLockGuard lockGuard{db, "usage_stats_reconcile"};
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 统计行可能残留在已清理的用户上，上界取两张表中较大的 id
+    long long maxId = 0;
+    if (runQuery(db, "SELECT GREATEST(COALESCE((SELECT MAX(id) FROM users), 0), "
+                     "COALESCE((SELECT MAX(owner_id) FROM usage_stats), 0));") != 0) {
+        return Result<size_t>::Error("重算用量统计失败: " + std::string(mysql_error(db)));
+    }
+    {
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+        if (row) {
+            maxId = RowDecoder(result.get(), row).getInt64(0);
+        }
     }
-    
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        return Result<size_t>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+
+    // 先全局行，再按 owner_id 分段。每段在一个只读一致性快照中读出明细聚合与统计行（不加锁，不阻塞在线写入），
+    // 差值作为增量写回：快照之后提交的写入各自带着增量，叠加后仍然正确。只有存在偏差的统计行会被短暂锁住
+    const long long rangeSize = 1000;
+    size_t corrected = 0;
+    std::map<int, UsageStats> globalDrift;
+    for (long long low = 0; low <= maxId;) {
+        long long high = low == 0 ? 0 : low + rangeSize - 1;
+        std::map<int, UsageStats> deltas;
+        if (runQuery(db, "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ;") != 0 ||
+            runQuery(db, "START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY;") != 0) {
+            return Result<size_t>::Error("重算用量统计失败: " + std::string(mysql_error(db)));
+        }
+        bool read = collectStatsDrift(db, low, high, deltas);
+        std::string readError = mysql_error(db);
+        runQuery(db, "COMMIT;");
+        if (!read) {
+            return Result<size_t>::Error("重算用量统计失败: " + readError);
+        }
+
+        if (!deltas.empty()) {
+            auto applied = runInTransaction<bool>([&](PooledConnection& conn) {
+                if (!applyStatsDeltas(conn.get(), deltas)) {
+                    return Result<bool>::Error("更新用量统计失败: " + std::string(mysql_error(conn.get())));
+                }
+                return Result<bool>::Success(true);
+            });
+            if (!applied.success) {
+                return Result<size_t>::Error(applied.message);
+            }
+            corrected += deltas.size();
+            if (low == 0) {
+                globalDrift = deltas;
+            }
+        }
+        low = high + 1;
     }
-    
-    MYSQL_ROW row = mysql_fetch_row(result);
-    size_t totalSize = 0;
-    if (row && row[0]) {
-        totalSize = std::stoull(row[0]);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    if (!globalDrift.empty()) {
+        const UsageStats& d = globalDrift.begin()->second;
+        LOG_WARNING("用量统计存在偏差已修复: 用户 " + std::to_string(d.userCount) + ", 文档 " +
+                    std::to_string(d.documentCount) + ", 字节 " + std::to_string(d.totalBytes) + ", 分享 " +
+                    std::to_string(d.sharesGiven) + "/" + std::to_string(d.sharesReceived));
     }
-    
-    mysql_free_result(result);
-    return Result<size_t>::Success(totalSize);
+    LOG_INFO("用量统计重算完成，修正 " + std::to_string(corrected) + " 行，耗时 " + std::to_string(elapsed.count()) + "ms");
+    return Result<size_t>::Success(corrected, "用量统计已重算");
+}
+
+bool DatabaseManager::ensureArchivePartitions(MYSQL* db, const std::string& table, const std::string& cutoff) {
+    // 读出最后一个有界分区的上界（即下一个待建月份的第一天）；没有 p_max 说明表未分区
+    std::string sql = "SELECT SUM(partition_name = 'p_max'), "
+                      "DATE_FORMAT(FROM_UNIXTIME(MAX(CASE WHEN partition_description <> 'MAXVALUE' "
+                      "THEN CAST(partition_description AS UNSIGNED) END)), '%Y%m') "
+                      "FROM information_schema.partitions WHERE table_schema = DATABASE() AND table_name = '" + table + "';";
+    if (runQuery(db, sql) != 0) {
+        return false;
+    }
+    std::string nextMonth;
+    {
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+        if (!row) {
+            return false;
+        }
+        RowDecoder decoder(result.get(), row);
+        if (decoder.getInt(0) == 0) {
+            return true;
+        }
+        nextMonth = decoder.getString(1);
+    }
+
+    // 还没有月份分区时从最早的冷文档所在月份开始，更早的数据都落在第一个分区里
+    if (nextMonth.empty()) {
+        std::string minSql = "SELECT DATE_FORMAT(MIN(created_at), '%Y%m') FROM documents WHERE created_at < '" + cutoff + "';";
+        if (runQuery(db, minSql) != 0) {
+            return false;
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+        MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+        if (!row) {
+            return false;
+        }
+        nextMonth = RowDecoder(result.get(), row).getString(0);
+        if (nextMonth.empty()) {
+            return true;
+        }
+    }
+
+    // 建到截止时间所在月份为止：归档的行都早于截止时间，不会落进 p_max，拆分 p_max 只改元数据
+    int year = std::stoi(nextMonth.substr(0, 4));
+    int month = std::stoi(nextMonth.substr(4, 2));
+    const int lastYear = std::stoi(cutoff.substr(0, 4));
+    const int lastMonth = std::stoi(cutoff.substr(5, 2));
+    std::string partitions;
+    while (year < lastYear || (year == lastYear && month <= lastMonth)) {
+        char name[16];
+        char bound[32];
+        int boundYear = month == 12 ? year + 1 : year;
+        int boundMonth = month == 12 ? 1 : month + 1;
+        std::snprintf(name, sizeof(name), "p%04d%02d", year, month);
+        std::snprintf(bound, sizeof(bound), "%04d-%02d-01 00:00:00", boundYear, boundMonth);
+        partitions += "PARTITION " + std::string(name) + " VALUES LESS THAN (UNIX_TIMESTAMP('" + bound + "')), ";
+        year = boundYear;
+        month = boundMonth;
+    }
+    if (partitions.empty()) {
+        return true;
+    }
+
+    std::string reorganize = "ALTER TABLE " + table + " REORGANIZE PARTITION p_max INTO (" + partitions +
+                             "PARTITION p_max VALUES LESS THAN MAXVALUE);";
+    if (runQuery(db, reorganize) != 0) {
+        return false;
+    }
+    LOG_INFO(table + " 新建月份分区 " + nextMonth + " 至 " + cutoff.substr(0, 7));
+    return true;
+}
+
+Result<MySqlArchiveStats> DatabaseManager::archiveBatch(const std::string& cutoff, int batchSize,
+                                                        std::string& cursorCreatedAt, long long& cursorId) {
+    QueryTimer timer(queryStats, "archiveBatch");
+    std::vector<int> archivedIds;
+    std::string lastCreatedAt;
+    long long lastId = 0;
+
+    auto result = runInTransaction<MySqlArchiveStats>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+        archivedIds.clear();
+
+        // 按 (created_at, id) 从旧到新取一批；仍有新分享引用的文档留在在线表，游标越过它们不再重复扫描。
+        // 已软删除的文档等待清理，不再归档
+        std::string sql = "SELECT d.id, d.owner_id, d.file_size, d.created_at FROM documents d "
+                          "WHERE d.created_at < '" + cutoff + "' AND " + liveDocument("d.");
+        if (!cursorCreatedAt.empty()) {
+            sql += " AND (d.created_at > '" + cursorCreatedAt + "' OR (d.created_at = '" + cursorCreatedAt +
+                   "' AND d.id > " + std::to_string(cursorId) + "))";
+        }
+        sql += " AND NOT EXISTS (SELECT 1 FROM document_shares ds WHERE ds.document_id = d.id AND ds.created_at >= '" + cutoff + "')"
+               " AND NOT EXISTS (SELECT 1 FROM document_shares ds WHERE ds.shared_document_id = d.id AND ds.created_at >= '" + cutoff + "')"
+               " ORDER BY d.created_at, d.id LIMIT " + std::to_string(batchSize) + " FOR UPDATE;";
+        if (runQuery(db, sql) != 0) {
+            return Result<MySqlArchiveStats>::Error("查询待归档文档失败: " + std::string(mysql_error(db)));
+        }
+
+        std::map<int, UsageStats> deltas;
+        std::string ids;
+        {
+            std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> rows(mysql_store_result(db), &mysql_free_result);
+            if (!rows) {
+                return Result<MySqlArchiveStats>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+            }
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(rows.get()))) {
+                RowDecoder decoder(rows.get(), row);
+                int id = decoder.getInt(0);
+                long long fileSize = decoder.getInt64(2);
+                for (int key : {0, decoder.getInt(1)}) {
+                    deltas[key].documentCount -= 1;
+                    deltas[key].totalBytes -= fileSize;
+                }
+                ids += (ids.empty() ? "" : ",") + std::to_string(id);
+                archivedIds.push_back(id);
+                lastCreatedAt = decoder.getString(3);
+                lastId = id;
+            }
+        }
+
+        MySqlArchiveStats stats;
+        if (archivedIds.empty()) {
+            return Result<MySqlArchiveStats>::Success(stats);
+        }
+
+        // 引用这些文档（原件或分享副本）的分享随文档一起移走，列表字段取归档时的副本
+        std::string shareWhere = "document_id IN (" + ids + ") OR shared_document_id IN (" + ids + ")";
+        if (!collectShareDeltas(db, shareWhere, deltas)) {
+            return Result<MySqlArchiveStats>::Error("统计待归档分享失败: " + std::string(mysql_error(db)));
+        }
+        std::string archiveShares =
+                "INSERT INTO document_shares_archive (shared_to_user_id, created_at, id, shared_by_user_id, source_document_id, " +
+                SHARE_INBOX_DOCUMENT_COLUMNS + ") "
+                "SELECT ds.shared_to_user_id, ds.created_at, ds.id, ds.shared_by_user_id, ds.document_id, d.id, d.title, "
+                "d.description, d.file_path, ds.shared_minio_key, d.owner_id, d.created_at, d.updated_at, d.file_size, "
+                "d.content_type FROM document_shares ds INNER JOIN documents d ON d.id = ds.shared_document_id "
+                "WHERE ds.document_id IN (" + ids + ") OR ds.shared_document_id IN (" + ids + ");";
+        if (runQuery(db, archiveShares) != 0) {
+            return Result<MySqlArchiveStats>::Error("归档分享失败: " + std::string(mysql_error(db)));
+        }
+        stats.shares = static_cast<size_t>(mysql_affected_rows(db));
+
+        std::string archiveDocuments =
+                "INSERT INTO documents_archive (id, title, description, file_path, minio_key, owner_id, created_at, "
+                "updated_at, file_size, content_type) "
+                "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type "
+                "FROM documents WHERE id IN (" + ids + ");";
+        if (runQuery(db, archiveDocuments) != 0) {
+            return Result<MySqlArchiveStats>::Error("归档文档失败: " + std::string(mysql_error(db)));
+        }
+        stats.documents = static_cast<size_t>(mysql_affected_rows(db));
+
+        // 分享与收件箱经外键级联删除
+        if (runQuery(db, "DELETE FROM documents WHERE id IN (" + ids + ");") != 0) {
+            return Result<MySqlArchiveStats>::Error("删除已归档文档失败: " + std::string(mysql_error(db)));
+        }
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<MySqlArchiveStats>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
+        return Result<MySqlArchiveStats>::Success(stats);
+    });
+
+    if (result.success && !archivedIds.empty()) {
+        cursorCreatedAt = lastCreatedAt;
+        cursorId = lastId;
+        applyIndexChange([this, archivedIds]() {
+            for (int id : archivedIds) {
+                searchIndex.remove(id);
+            }
+        });
+    }
+    return result;
+}
+
+Result<MySqlArchiveStats> DatabaseManager::archiveColdDocuments(const MySqlArchiveOptions& options,
+                                                                const std::function<bool()>& shouldContinue) {
+    if (options.hotDays <= 0 || options.batchSize <= 0) {
+        return Result<MySqlArchiveStats>::Error("归档参数无效");
+    }
+    // 补建分区是 DDL，会隐式提交调用方的事务
+    if (inTransaction()) {
+        return Result<MySqlArchiveStats>::Error("不能在事务中执行归档");
+    }
+
+    // 多个客户端都会定时归档，只让拿到锁的一个执行，避免各自的批次扫描争抢同一批行锁
+    auto lockConn = acquireConnection();
+    if (!lockConn) {
+        return Result<MySqlArchiveStats>::Error("数据库未连接");
+    }
+    if (!acquireNamedLock(lockConn.get(), "archive_cold_documents", 0)) {
+        LOG_INFO("其他客户端正在归档，本轮跳过");
+        return Result<MySqlArchiveStats>::Success(MySqlArchiveStats(), "其他客户端正在归档");
+    }
+    NamedLockGuard lockGuard{lockConn.get(), "archive_cold_documents"};
+
+    // 截止时间在本次运行开始时固定，各批次使用同一个值
+    std::string cutoff;
+    {
+        MYSQL* db = lockConn.get();
+        std::string sql = "SELECT DATE_FORMAT(NOW() - INTERVAL " + std::to_string(options.hotDays) +
+                          " DAY, '%Y-%m-%d %H:%i:%s');";
+        if (runQuery(db, sql) != 0) {
+            return Result<MySqlArchiveStats>::Error("计算归档截止时间失败: " + std::string(mysql_error(db)));
+        }
+        {
+            std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+            MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+            if (row) {
+                cutoff = RowDecoder(result.get(), row).getString(0);
+            }
+        }
+        if (cutoff.size() < 7) {
+            return Result<MySqlArchiveStats>::Error("计算归档截止时间失败");
+        }
+        for (const char* table : {"documents_archive", "document_shares_archive"}) {
+            if (!ensureArchivePartitions(db, table, cutoff)) {
+                return Result<MySqlArchiveStats>::Error("创建归档分区失败: " + std::string(mysql_error(db)));
+            }
+        }
+    }
+
+    MySqlArchiveStats total;
+    std::string cursorCreatedAt;
+    long long cursorId = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    while (isConnected && (options.maxBatches <= 0 || total.batches < static_cast<size_t>(options.maxBatches))) {
+        if (shouldContinue && !shouldContinue()) {
+            break;
+        }
+        auto batch = archiveBatch(cutoff, options.batchSize, cursorCreatedAt, cursorId);
+        if (!batch.success) {
+            LOG_WARNING("归档中断，已移动文档 " + std::to_string(total.documents) + " 个: " + batch.message);
+            return Result<MySqlArchiveStats>::Error(batch.message);
+        }
+        if (batch.data->documents > 0) {
+            total.batches++;
+        }
+        total.documents += batch.data->documents;
+        total.shares += batch.data->shares;
+        if (batch.data->documents < static_cast<size_t>(options.batchSize)) {
+            total.completed = true;
+            break;
+        }
+        // 批间停顿：让在线事务拿到刚释放的行锁，也限制对复制与 IO 的冲击
+        if (options.pauseMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.pauseMs));
+        }
+    }
+
+    if (total.documents > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        LOG_INFO("归档早于 " + cutoff + " 的文档 " + std::to_string(total.documents) + " 个、分享 " +
+                 std::to_string(total.shares) + " 条，耗时 " + std::to_string(elapsed.count()) + "ms" +
+                 (total.completed ? "" : "，尚未完成"));
+    }
+    return Result<MySqlArchiveStats>::Success(total);
+}
+
+Result<size_t> DatabaseManager::purgeShares(int batchSize) {
+    std::string limit = std::to_string(batchSize);
+    std::string ids;
+    {
+        auto conn = acquireConnection();
+        if (!conn) {
+            return Result<size_t>::Error("数据库未连接");
+        }
+        MYSQL* db = conn.get();
+
+        // 与 LIVE_SHARE 相反的四种情况各走一个索引；被删除用户的文档没有逐行标记，
+        // 但引用它们的分享必然以该用户为分享人（原件）或接收人（副本）
+        std::string sql =
+                "(SELECT ds.id FROM document_shares ds INNER JOIN documents d ON d.id = ds.document_id"
+                " WHERE d.deleted_at IS NOT NULL LIMIT " + limit + ")"
+                " UNION (SELECT ds.id FROM document_shares ds INNER JOIN documents d ON d.id = ds.shared_document_id"
+                " WHERE d.deleted_at IS NOT NULL LIMIT " + limit + ")"
+                " UNION (SELECT id FROM document_shares WHERE shared_by_user_id IN " + DELETED_USER_IDS + " LIMIT " + limit + ")"
+                " UNION (SELECT id FROM document_shares WHERE shared_to_user_id IN " + DELETED_USER_IDS + " LIMIT " + limit + ")"
+                " LIMIT " + limit + ";";
+        if (runQuery(db, sql) != 0) {
+            return Result<size_t>::Error("查询待清理分享失败: " + std::string(mysql_error(db)));
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> rows(mysql_store_result(db), &mysql_free_result);
+        if (!rows) {
+            return Result<size_t>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(rows.get()))) {
+            ids += (ids.empty() ? "" : ",") + RowDecoder(rows.get(), row).getString(0);
+        }
+    }
+    if (ids.empty()) {
+        return Result<size_t>::Success(0);
+    }
+
+    // 收件箱中的对应行经外键级联删除
+    return runInTransaction<size_t>([&](PooledConnection& conn) {
+        MYSQL* db = conn.get();
+        std::map<int, UsageStats> deltas;
+        if (!collectShareDeltas(db, "id IN (" + ids + ")", deltas)) {
+            return Result<size_t>::Error("统计待清理分享失败: " + std::string(mysql_error(db)));
+        }
+        if (runQuery(db, "DELETE FROM document_shares WHERE id IN (" + ids + ");") != 0) {
+            return Result<size_t>::Error("清理分享失败: " + std::string(mysql_error(db)));
+        }
+        size_t deleted = static_cast<size_t>(mysql_affected_rows(db));
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<size_t>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+        }
+        return Result<size_t>::Success(deleted);
+    });
+}
+
+Result<size_t> DatabaseManager::purgeArchivedShares(int batchSize) {
+    auto conn = acquireConnection();
+    if (!conn) {
+        return Result<size_t>::Error("数据库未连接");
+    }
+    MYSQL* db = conn.get();
+    std::string limit = std::to_string(batchSize);
+
+    // 与 LIVE_ARCHIVED_SHARE 相反的情况各走一个索引；按主键删除，不用 DELETE ... LIMIT（基于语句的复制下不确定）
+    std::string deletedDocuments = "(SELECT id FROM documents WHERE deleted_at IS NOT NULL)";
+    std::string columns = "SELECT shared_to_user_id, created_at, id FROM document_shares_archive WHERE ";
+    std::string sql =
+            "(" + columns + "source_document_id IN " + deletedDocuments + " LIMIT " + limit + ")"
+            " UNION (" + columns + "document_id IN " + deletedDocuments + " LIMIT " + limit + ")"
+            " UNION (" + columns + "shared_by_user_id IN " + DELETED_USER_IDS + " LIMIT " + limit + ")"
+            " UNION (" + columns + "shared_to_user_id IN " + DELETED_USER_IDS + " LIMIT " + limit + ")"
+            " LIMIT " + limit + ";";
+    if (runQuery(db, sql) != 0) {
+        return Result<size_t>::Error("查询待清理归档分享失败: " + std::string(mysql_error(db)));
+    }
+    std::string keys;
+    {
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> rows(mysql_store_result(db), &mysql_free_result);
+        if (!rows) {
+            return Result<size_t>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(rows.get()))) {
+            RowDecoder decoder(rows.get(), row);
+            keys += (keys.empty() ? "(" : ",(") + decoder.getString(0) + ",'" + decoder.getString(1) + "'," +
+                    decoder.getString(2) + ")";
+        }
+    }
+    if (keys.empty()) {
+        return Result<size_t>::Success(0);
+    }
+
+    // 归档分享不计入用量统计，单条语句即可
+    std::string deleteSql = "DELETE FROM document_shares_archive WHERE (shared_to_user_id, created_at, id) IN (" + keys + ");";
+    if (runQuery(db, deleteSql) != 0) {
+        return Result<size_t>::Error("清理归档分享失败: " + std::string(mysql_error(db)));
+    }
+    return Result<size_t>::Success(static_cast<size_t>(mysql_affected_rows(db)));
+}
+
+Result<PurgeStats> DatabaseManager::purgeBatch(int batchSize, const ObjectRemover& removeObject) {
+    QueryTimer timer(queryStats, "purgeBatch");
+    PurgeStats stats;
+
+    // 先删分享，再删文档与用户：文档行删除时经外键级联的分享会绕过用量统计，归档分享则没有外键。
+    // 每一步都限制在一批以内，前一步还有积压时本批到此为止，由 purgeDeleted 在批间停顿后继续
+    auto shares = purgeShares(batchSize);
+    if (!shares.success) {
+        return Result<PurgeStats>::Error(shares.message);
+    }
+    stats.shares = shares.data.value();
+    if (stats.shares >= static_cast<size_t>(batchSize)) {
+        return Result<PurgeStats>::Success(stats);
+    }
+    auto archivedShares = purgeArchivedShares(batchSize);
+    if (!archivedShares.success) {
+        return Result<PurgeStats>::Error(archivedShares.message);
+    }
+    stats.shares += archivedShares.data.value();
+    if (archivedShares.data.value() >= static_cast<size_t>(batchSize)) {
+        return Result<PurgeStats>::Success(stats);
+    }
+
+    struct Candidate {
+        int id;
+        std::string minioKey;
+        bool archived;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<int> userIds;
+    std::string limit = std::to_string(batchSize);
+    // 没有对象存储时只取没有文件的文档
+    std::string fileFilter = removeObject ? "" : " AND COALESCE(minio_key, '') = ''";
+
+    // 候选读主库、不加锁：软删除是终态，这些行不会再被在线请求修改
+    {
+        auto conn = acquireConnection();
+        if (!conn) {
+            return Result<PurgeStats>::Error("数据库未连接");
+        }
+        MYSQL* db = conn.get();
+
+        // 单独删除的文档、被删除用户的在线文档与归档文档；同一文档可能同时满足前两项，下面去重
+        std::string sql =
+                "(SELECT id, minio_key, 0 FROM documents WHERE deleted_at IS NOT NULL" + fileFilter + " LIMIT " + limit + ")"
+                " UNION ALL (SELECT id, minio_key, 0 FROM documents WHERE owner_id IN " + DELETED_USER_IDS + fileFilter +
+                " LIMIT " + limit + ")"
+                " UNION ALL (SELECT id, minio_key, 1 FROM documents_archive WHERE owner_id IN " + DELETED_USER_IDS + fileFilter +
+                " LIMIT " + limit + ") LIMIT " + limit + ";";
+        if (runQuery(db, sql) != 0) {
+            return Result<PurgeStats>::Error("查询待清理文档失败: " + std::string(mysql_error(db)));
+        }
+        std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> rows(mysql_store_result(db), &mysql_free_result);
+        if (!rows) {
+            return Result<PurgeStats>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+        }
+        std::set<std::pair<int, bool>> seen;
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(rows.get()))) {
+            RowDecoder decoder(rows.get(), row);
+            Candidate candidate{decoder.getInt(0), decoder.getString(1), decoder.getInt(2) != 0};
+            if (seen.insert({candidate.id, candidate.archived}).second) {
+                candidates.push_back(candidate);
+            }
+        }
+    }
+
+    // 文件在事务之外逐个删除，失败的文档保留行等下次重试；删除不存在的对象视为成功，
+    // 所以文件已删、行删除失败的文档下次可以安全重来
+    std::string ids;
+    std::string archivedIds;
+    for (const auto& candidate : candidates) {
+        if (!candidate.minioKey.empty()) {
+            if (!removeObject(candidate.minioKey)) {
+                stats.objectFailures++;
+                continue;
+            }
+            stats.objects++;
+        }
+        std::string& target = candidate.archived ? archivedIds : ids;
+        target += (target.empty() ? "" : ",") + std::to_string(candidate.id);
+    }
+
+    if (!ids.empty() || !archivedIds.empty()) {
+        auto deleted = runInTransaction<size_t>([&](PooledConnection& conn) {
+            MYSQL* db = conn.get();
+            // 引用这些文档的分享通常已在前两步清完，这里兜住两步之间新删除的用户或文档：
+            // 在线分享经外键级联删除，先扣统计；在线与归档文档的 id 同属一个序列，归档分享的两列都可能引用其中任何一个
+            std::map<int, UsageStats> deltas;
+            if (!ids.empty() &&
+                !collectShareDeltas(db, "document_id IN (" + ids + ") OR shared_document_id IN (" + ids + ")", deltas)) {
+                return Result<size_t>::Error("统计待清理分享失败: " + std::string(mysql_error(db)));
+            }
+            std::string allIds = ids + (!ids.empty() && !archivedIds.empty() ? "," : "") + archivedIds;
+            std::string deleteShares = "DELETE FROM document_shares_archive WHERE source_document_id IN (" + allIds +
+                                       ") OR document_id IN (" + allIds + ");";
+            if (runQuery(db, deleteShares) != 0) {
+                return Result<size_t>::Error("清理归档分享失败: " + std::string(mysql_error(db)));
+            }
+            size_t documents = 0;
+            for (const auto& item : {std::make_pair("documents", ids), std::make_pair("documents_archive", archivedIds)}) {
+                if (item.second.empty()) {
+                    continue;
+                }
+                std::string sql = "DELETE FROM " + std::string(item.first) + " WHERE id IN (" + item.second + ");";
+                if (runQuery(db, sql) != 0) {
+                    return Result<size_t>::Error("清理文档失败: " + std::string(mysql_error(db)));
+                }
+                documents += static_cast<size_t>(mysql_affected_rows(db));
+            }
+            if (!applyStatsDeltas(db, deltas)) {
+                return Result<size_t>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+            }
+            return Result<size_t>::Success(documents);
+        });
+        if (!deleted.success) {
+            return Result<PurgeStats>::Error(deleted.message);
+        }
+        stats.documents = deleted.data.value();
+    }
+
+    // 文档不足一批时说明积压已清完，接着删除已没有任何文档的用户
+    bool documentsDrained = candidates.size() < static_cast<size_t>(batchSize);
+    if (documentsDrained) {
+        auto users = runInTransaction<size_t>([&](PooledConnection& conn) {
+            MYSQL* db = conn.get();
+            std::string sql = "SELECT u.id FROM users u WHERE u.deleted_at IS NOT NULL"
+                              " AND NOT EXISTS (SELECT 1 FROM documents d WHERE d.owner_id = u.id)"
+                              " AND NOT EXISTS (SELECT 1 FROM documents_archive a WHERE a.owner_id = u.id)"
+                              " LIMIT " + limit + " FOR UPDATE;";
+            if (runQuery(db, sql) != 0) {
+                return Result<size_t>::Error("查询待清理用户失败: " + std::string(mysql_error(db)));
+            }
+            userIds.clear();
+            std::string userList;
+            {
+                std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> rows(mysql_store_result(db), &mysql_free_result);
+                if (!rows) {
+                    return Result<size_t>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
+                }
+                MYSQL_ROW row;
+                while ((row = mysql_fetch_row(rows.get()))) {
+                    int id = RowDecoder(rows.get(), row).getInt(0);
+                    userIds.push_back(id);
+                    userList += (userList.empty() ? "" : ",") + std::to_string(id);
+                }
+            }
+            if (userIds.empty()) {
+                return Result<size_t>::Success(0);
+            }
+
+            // 与文档一样兜住前两步之后新出现的分享：在线分享随用户经外键级联删除，先扣统计；
+            // 归档表没有外键，按用户手动清理。reconcileUsageStats 之后这些用户可能又有了统计行，一并删除
+            std::map<int, UsageStats> deltas;
+            if (!collectShareDeltas(db, "shared_by_user_id IN (" + userList + ") OR shared_to_user_id IN (" + userList + ")",
+                                    deltas)) {
+                return Result<size_t>::Error("统计待清理分享失败: " + std::string(mysql_error(db)));
+            }
+            std::string deleteShares = "DELETE FROM document_shares_archive WHERE shared_by_user_id IN (" + userList +
+                                       ") OR shared_to_user_id IN (" + userList + ");";
+            std::string deleteStats = "DELETE FROM usage_stats WHERE owner_id IN (" + userList + ");";
+            if (runQuery(db, deleteShares) != 0 || runQuery(db, deleteStats) != 0) {
+                return Result<size_t>::Error("清理用户失败: " + std::string(mysql_error(db)));
+            }
+            std::string deleteUsers = "DELETE FROM users WHERE id IN (" + userList + ");";
+            if (runQuery(db, deleteUsers) != 0) {
+                return Result<size_t>::Error("清理用户失败: " + std::string(mysql_error(db)));
+            }
+            size_t users = static_cast<size_t>(mysql_affected_rows(db));
+            if (!applyStatsDeltas(db, deltas)) {
+                return Result<size_t>::Error("更新用量统计失败: " + std::string(mysql_error(db)));
+            }
+            return Result<size_t>::Success(users);
+        });
+        if (!users.success) {
+            return Result<PurgeStats>::Error(users.message);
+        }
+        stats.users = users.data.value();
+    }
+
+    stats.completed = documentsDrained && stats.objectFailures == 0 && userIds.size() < static_cast<size_t>(batchSize);
+    return Result<PurgeStats>::Success(stats);
+}
+
+Result<PurgeStats> DatabaseManager::purgeDeleted(const PurgeOptions& options, const ObjectRemover& removeObject,
+                                                 const std::function<bool()>& shouldContinue) {
+    QueryTimer timer(queryStats, "purgeDeleted");
+    if (options.batchSize <= 0) {
+        return Result<PurgeStats>::Error("清理参数无效");
+    }
+    // 每批自行开启短事务，且删除文件期间不能占着调用方的事务
+    if (inTransaction()) {
+        return Result<PurgeStats>::Error("不能在事务中执行清理");
+    }
+
+    // 多个客户端都会定时清理，只让拿到锁的一个执行，避免取到同一批候选、重复删除文件
+    auto lockConn = acquireConnection();
+    if (!lockConn) {
+        return Result<PurgeStats>::Error("数据库未连接");
+    }
+    if (!acquireNamedLock(lockConn.get(), "purge_deleted", 0)) {
+        LOG_INFO("其他客户端正在清理已删除数据，本轮跳过");
+        return Result<PurgeStats>::Success(PurgeStats(), "其他客户端正在清理已删除数据");
+    }
+    NamedLockGuard lockGuard{lockConn.get(), "purge_deleted"};
+
+    PurgeStats total;
+    auto startTime = std::chrono::steady_clock::now();
+    while (isConnected && (options.maxBatches <= 0 || total.batches < static_cast<size_t>(options.maxBatches))) {
+        if (shouldContinue && !shouldContinue()) {
+            break;
+        }
+        auto batch = purgeBatch(options.batchSize, removeObject);
+        if (!batch.success) {
+            LOG_WARNING("清理中断，已删除文档 " + std::to_string(total.documents) + " 个: " + batch.message);
+            return Result<PurgeStats>::Error(batch.message);
+        }
+        const PurgeStats& done = batch.data.value();
+        total.shares += done.shares;
+        total.documents += done.documents;
+        total.objects += done.objects;
+        total.objectFailures += done.objectFailures;
+        total.users += done.users;
+        if (done.shares > 0 || done.documents > 0 || done.users > 0) {
+            total.batches++;
+        }
+        if (done.completed) {
+            total.completed = true;
+            break;
+        }
+        // 整批都是文件删除失败的文档，再试也一样，留到下次运行
+        if (done.shares == 0 && done.documents == 0 && done.users == 0) {
+            break;
+        }
+        // 批间停顿：把 IO 和对象存储请求摊开，也让在线事务拿到刚释放的锁
+        if (options.pauseMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.pauseMs));
+        }
+    }
+
+    if (total.shares > 0 || total.documents > 0 || total.users > 0 || total.objectFailures > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        LOG_INFO("清理已删除的分享 " + std::to_string(total.shares) + " 条、文档 " + std::to_string(total.documents) + " 个（文件 " + std::to_string(total.objects) +
+                 " 个，失败 " + std::to_string(total.objectFailures) + " 个）、用户 " + std::to_string(total.users) +
+                 " 个，耗时 " + std::to_string(elapsed.count()) + "ms" + (total.completed ? "" : "，尚未完成"));
+    }
+    return Result<PurgeStats>::Success(total);
 }
 
 bool DatabaseManager::beginTransaction() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    if (!isConnected || !pool) {
         return false;
     }
-    
-    return mysql_query(db, "START TRANSACTION;") == 0;
+
+    auto threadId = std::this_thread::get_id();
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        if (transactionConnections.count(threadId)) {
+            LOG_WARNING("当前线程已有未结束的事务");
+            return false;
+        }
+    }
+    lastErrorCode = 0;
+
+    // 事务连接单独借出并绑定到当前线程，直到提交或回滚
+    PooledConnection conn = pool->acquire();
+    if (!conn) {
+        LOG_WARNING("获取数据库连接失败: " + pool->getLastError());
+        return false;
+    }
+    applyCallDeadline(conn);
+    if (mysql_query(conn.get(), "START TRANSACTION;") != 0) {
+        recordError(mysql_errno(conn.get()));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(transactionMutex);
+    transactionConnections.emplace(threadId, std::move(conn));
+    return true;
 }
 
 bool DatabaseManager::commitTransaction() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    QueryTimer timer(queryStats, "commitTransaction");
+    PooledConnection conn;
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto it = transactionConnections.find(std::this_thread::get_id());
+        if (it == transactionConnections.end()) {
+            return false;
+        }
+        conn = std::move(it->second);
+        transactionConnections.erase(it);
+        savepointMarks.erase(std::this_thread::get_id());
+    }
+
+    std::vector<std::function<void()>> indexChanges;
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto it = pendingIndexChanges.find(std::this_thread::get_id());
+        if (it != pendingIndexChanges.end()) {
+            indexChanges.swap(it->second);
+            pendingIndexChanges.erase(it);
+        }
+    }
+
+    if (runQuery(conn.get(), "COMMIT;") != 0) {
+        recordError(mysql_errno(conn.get()));
+        // 提交失败时显式回滚，避免把未结束的事务归还到池中
+        mysql_query(conn.get(), "ROLLBACK;");
         return false;
     }
-    
-    return mysql_query(db, "COMMIT;") == 0;
+    noteWrite();
+
+    // 事务提交后才让索引看到这些变更
+    for (auto& change : indexChanges) {
+        change();
+    }
+    return true;
 }
 
 bool DatabaseManager::rollbackTransaction() {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
+    PooledConnection conn;
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto it = transactionConnections.find(std::this_thread::get_id());
+        if (it == transactionConnections.end()) {
+            return false;
+        }
+        conn = std::move(it->second);
+        transactionConnections.erase(it);
+        pendingIndexChanges.erase(std::this_thread::get_id());
+        savepointMarks.erase(std::this_thread::get_id());
+    }
+
+    return mysql_query(conn.get(), "ROLLBACK;") == 0;
+}
+
+bool DatabaseManager::createSavepoint(const std::string& name) {
+    if (!inTransaction()) {
         return false;
     }
-    
-    return mysql_query(db, "ROLLBACK;") == 0;
+    auto conn = acquireConnection();
+    if (!conn) {
+        return false;
+    }
+    if (mysql_query(conn.get(), ("SAVEPOINT " + name + ";").c_str()) != 0) {
+        LOG_WARNING("建立保存点失败: " + std::string(mysql_error(conn.get())));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(transactionMutex);
+    auto threadId = std::this_thread::get_id();
+    auto pending = pendingIndexChanges.find(threadId);
+    savepointMarks[threadId].emplace_back(name, pending != pendingIndexChanges.end() ? pending->second.size() : 0);
+    return true;
+}
+
+bool DatabaseManager::releaseSavepoint(const std::string& name) {
+    if (!inTransaction()) {
+        return false;
+    }
+    auto conn = acquireConnection();
+    if (!conn) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto& marks = savepointMarks[std::this_thread::get_id()];
+        auto mark = std::find_if(marks.begin(), marks.end(),
+                                 [&name](const std::pair<std::string, size_t>& item) { return item.first == name; });
+        if (mark == marks.end()) {
+            return false;
+        }
+        // 释放保存点后其中的修改并入外层事务，暂存的索引变更保持不动
+        marks.erase(mark, marks.end());
+    }
+    return mysql_query(conn.get(), ("RELEASE SAVEPOINT " + name + ";").c_str()) == 0;
+}
+
+bool DatabaseManager::rollbackToSavepoint(const std::string& name) {
+    if (!inTransaction()) {
+        return false;
+    }
+    auto conn = acquireConnection();
+    if (!conn) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(transactionMutex);
+        auto threadId = std::this_thread::get_id();
+        auto& marks = savepointMarks[threadId];
+        auto mark = std::find_if(marks.begin(), marks.end(),
+                                 [&name](const std::pair<std::string, size_t>& item) { return item.first == name; });
+        if (mark == marks.end()) {
+            return false;
+        }
+        auto pending = pendingIndexChanges.find(threadId);
+        if (pending != pendingIndexChanges.end()) {
+            pending->second.resize(std::min(pending->second.size(), mark->second));
+        }
+        marks.erase(mark, marks.end());
+    }
+
+    // 不记录这里的错误码：保存点内的锁冲突已由失败的语句记录，回滚本身失败不应改变重试判断
+    // ROLLBACK TO 之后保存点仍然存在，再释放掉
+    if (mysql_query(conn.get(), ("ROLLBACK TO SAVEPOINT " + name + ";").c_str()) != 0 ||
+        mysql_query(conn.get(), ("RELEASE SAVEPOINT " + name + ";").c_str()) != 0) {
+        LOG_WARNING("回滚到保存点失败: " + std::string(mysql_error(conn.get())));
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::lastErrorRetryable() const {
+    // 1213 死锁（InnoDB 已回滚整个事务），1205 锁等待超时
+    return lastErrorCode == 1213 || lastErrorCode == 1205;
 }
 
 Result<bool> DatabaseManager::vacuum() {
@@ -1032,50 +3386,35 @@ Result<bool> DatabaseManager::vacuum() {
     return Result<bool>::Success(true, "MySQL 不需要 VACUUM 操作");
 }
 
-Result<std::vector<std::map<std::string, std::string>>> DatabaseManager::executeQuery(const std::string& query) {
-    std::lock_guard<std::recursive_mutex> lock(dbMutex);
-    if (!isConnected || db == nullptr) {
-        return Result<std::vector<std::map<std::string, std::string>>>::Error("数据库未连接");
+Result<QueryResult> DatabaseManager::executeQuery(const std::string& query) {
+    QueryTimer timer(queryStats, "executeQuery");
+    auto conn = acquireConnection();
+    if (!conn) {
+        return Result<QueryResult>::Error("数据库未连接");
     }
+    MYSQL* db = conn.get();
     
-    if (mysql_query(db, query.c_str()) != 0) {
-        return Result<std::vector<std::map<std::string, std::string>>>::Error("执行查询失败: " + std::string(mysql_error(db)));
+    if (runQuery(db, query) != 0) {
+        recordError(mysql_errno(db));
+        return Result<QueryResult>::Error("执行查询失败: " + std::string(mysql_error(db)));
     }
     
-    MYSQL_RES* result = mysql_store_result(db);
-    if (!result) {
-        // 检查是否有错误
-        if (mysql_errno(db) != 0) {
-            return Result<std::vector<std::map<std::string, std::string>>>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
-        }
-        // 如果没有错误，说明这是一个不返回结果集的查询（如INSERT、UPDATE、DELETE）
-        // 获取受影响的行数
-        my_ulonglong affectedRows = mysql_affected_rows(db);
-        return Result<std::vector<std::map<std::string, std::string>>>::Success(std::vector<std::map<std::string, std::string>>());
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> result(mysql_store_result(db), &mysql_free_result);
+    if (!result && mysql_errno(db) != 0) {
+        return Result<QueryResult>::Error("获取查询结果失败: " + std::string(mysql_error(db)));
     }
-    
-    std::vector<std::map<std::string, std::string>> rows;
-    MYSQL_FIELD* fields = mysql_fetch_fields(result);
-    int numFields = mysql_num_fields(result);
-    
-    MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        std::map<std::string, std::string> rowData;
-        for (int i = 0; i < numFields; i++) {
-            std::string fieldName = fields[i].name;
-            std::string fieldValue = row[i] ? row[i] : "";
-            rowData[fieldName] = fieldValue;
-        }
-        rows.push_back(rowData);
+    // 没有结果集且无错误：INSERT/UPDATE/DELETE 等语句，QueryResult 只记录影响行数
+    if (!result) {
+        noteWrite();
     }
-    
-    mysql_free_result(result);
-    return Result<std::vector<std::map<std::string, std::string>>>::Success(rows);
+    QueryResult rows = readQueryResult(db, result.get());
+    timer.addRows(rows.rowCount(), rows.dataSize());
+    return Result<QueryResult>::Success(rows);
 }
 
 std::string DatabaseManager::getLastError() const {
-    if (db) {
-        return std::string(mysql_error(db));
+    if (pool) {
+        return pool->getLastError();
     }
     return "数据库未连接";
 }
@@ -232,7 +232,7 @@ void DocListDialog::onSearchDocClicked()
     if (keyword.isEmpty()) {
         docs = g_cliHandler->getUserDocsForUI(userId);
     } else {
-        docs = g_cliHandler->getSearchedDocsForUI(userId, keyword.toUtf8().constData());
+        docs = g_cliHandler->quickSearchDocsForUI(userId, keyword.toUtf8().constData());
     }
     refreshDocs(docs);
 }
@@ -0,0 +1,258 @@
+#include "DocumentSearchIndex.h"
+#include <iterator>
+
+namespace {
+    // 逐个解出 UTF-8 码点；非法字节按单字节映射到私有区间，保证任意输入都能切分
+    void decodeUtf8(const std::string& text, std::vector<uint32_t>& codepoints) {
+        codepoints.clear();
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            size_t length = c < 0x80 ? 1 : (c >> 5) == 0x06 ? 2 : (c >> 4) == 0x0E ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+
+            bool valid = length > 0 && i + length <= text.size();
+            for (size_t k = 1; valid && k < length; ++k) {
+                valid = (static_cast<unsigned char>(text[i + k]) & 0xC0) == 0x80;
+            }
+            if (!valid) {
+                codepoints.push_back(0xF0000u + c);
+                i++;
+                continue;
+            }
+
+            uint32_t cp = length == 1 ? c : length == 2 ? (c & 0x1F) : length == 3 ? (c & 0x0F) : (c & 0x07);
+            for (size_t k = 1; k < length; ++k) {
+                cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+            }
+            codepoints.push_back(cp);
+            i += length;
+        }
+    }
+
+    // 超出短字符串优化容量的部分才占用堆内存（按 libstdc++ 的15字节估算）
+    size_t heapBytes(const std::string& s) {
+        return s.capacity() > 15 ? s.capacity() + 1 : 0;
+    }
+
+    // 哈希表节点的额外开销：next 指针 + 缓存的哈希值
+    const size_t NODE_OVERHEAD = sizeof(void*) + sizeof(size_t);
+}
+
+DocumentSearchIndex::DocumentSearchIndex() : ready(false) {
+}
+
+std::string DocumentSearchIndex::normalize(const std::string& text) {
+    std::string normalized(text);
+    for (char& c : normalized) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return normalized;
+}
+
+void DocumentSearchIndex::collectGrams(const std::string& normalized, std::vector<uint64_t>& grams) {
+    std::vector<uint32_t> codepoints;
+    decodeUtf8(normalized, codepoints);
+    for (size_t i = 0; i + 1 < codepoints.size(); ++i) {
+        grams.push_back((static_cast<uint64_t>(codepoints[i]) << 32) | codepoints[i + 1]);
+    }
+}
+
+void DocumentSearchIndex::collectEntryGrams(const Entry& entry, std::vector<uint64_t>& grams) {
+    // 各字段分别切分，bigram 不跨字段
+    grams.clear();
+    collectGrams(entry.title, grams);
+    collectGrams(entry.description, grams);
+    collectGrams(entry.filePath, grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+bool DocumentSearchIndex::matches(const Entry& entry, const std::string& query, IndexMatchMode mode) {
+    if (mode == IndexMatchMode::Prefix) {
+        return entry.title.compare(0, query.size(), query) == 0 ||
+               entry.description.compare(0, query.size(), query) == 0 ||
+               entry.filePath.compare(0, query.size(), query) == 0;
+    }
+    return entry.title.find(query) != std::string::npos ||
+           entry.description.find(query) != std::string::npos ||
+           entry.filePath.find(query) != std::string::npos;
+}
+
+void DocumentSearchIndex::indexEntry(int docId, const Entry& entry) {
+    std::vector<uint64_t> grams;
+    collectEntryGrams(entry, grams);
+    for (uint64_t gram : grams) {
+        std::vector<int>& ids = postings[gram];
+        // 新文档ID通常最大，直接追加；否则按序插入
+        if (ids.empty() || ids.back() < docId) {
+            ids.push_back(docId);
+        } else {
+            auto it = std::lower_bound(ids.begin(), ids.end(), docId);
+            if (it == ids.end() || *it != docId) {
+                ids.insert(it, docId);
+            }
+        }
+    }
+}
+
+void DocumentSearchIndex::unindexEntry(int docId, const Entry& entry) {
+    std::vector<uint64_t> grams;
+    collectEntryGrams(entry, grams);
+    for (uint64_t gram : grams) {
+        auto postingIt = postings.find(gram);
+        if (postingIt == postings.end()) {
+            continue;
+        }
+        std::vector<int>& ids = postingIt->second;
+        auto it = std::lower_bound(ids.begin(), ids.end(), docId);
+        if (it != ids.end() && *it == docId) {
+            ids.erase(it);
+        }
+        if (ids.empty()) {
+            postings.erase(postingIt);
+        }
+    }
+}
+
+void DocumentSearchIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    documents.clear();
+    postings.clear();
+    ready = false;
+}
+
+void DocumentSearchIndex::addOrUpdate(const Document& doc) {
+    Entry entry;
+    entry.doc = doc;
+    entry.title = normalize(doc.title);
+    entry.description = normalize(doc.description);
+    entry.filePath = normalize(doc.file_path);
+
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    auto it = documents.find(doc.id);
+    if (it != documents.end()) {
+        unindexEntry(doc.id, it->second);
+        it->second = std::move(entry);
+        indexEntry(doc.id, it->second);
+    } else {
+        auto inserted = documents.emplace(doc.id, std::move(entry));
+        indexEntry(doc.id, inserted.first->second);
+    }
+}
+
+void DocumentSearchIndex::remove(int docId) {
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    auto it = documents.find(docId);
+    if (it == documents.end()) {
+        return;
+    }
+    unindexEntry(docId, it->second);
+    documents.erase(it);
+}
+
+void DocumentSearchIndex::removeOwner(int ownerId) {
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    for (auto it = documents.begin(); it != documents.end();) {
+        if (it->second.doc.owner_id == ownerId) {
+            unindexEntry(it->first, it->second);
+            it = documents.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DocumentSearchIndex::markReady() {
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    ready = true;
+}
+
+bool DocumentSearchIndex::isReady() const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    return ready;
+}
+
+std::vector<Document> DocumentSearchIndex::search(const std::string& query, int ownerId, size_t limit,
+                                                  IndexMatchMode mode) const {
+    std::vector<Document> results;
+    std::string normalized = normalize(Utils::trim(query));
+    if (normalized.empty() || limit == 0) {
+        return results;
+    }
+
+    std::vector<uint64_t> grams;
+    collectGrams(normalized, grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+
+    std::vector<int> candidates;
+    if (grams.empty()) {
+        // 单字符关键词：没有 bigram 可用，扫描全部文档
+        candidates.reserve(documents.size());
+        for (const auto& entry : documents) {
+            candidates.push_back(entry.first);
+        }
+        std::sort(candidates.begin(), candidates.end());
+    } else {
+        // 从最短的倒排表开始求交集
+        std::vector<const std::vector<int>*> lists;
+        for (uint64_t gram : grams) {
+            auto it = postings.find(gram);
+            if (it == postings.end()) {
+                return results;
+            }
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const std::vector<int>* a, const std::vector<int>* b) {
+            return a->size() < b->size();
+        });
+
+        candidates = *lists[0];
+        std::vector<int> intersected;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            intersected.clear();
+            std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                                  std::back_inserter(intersected));
+            candidates.swap(intersected);
+        }
+    }
+
+    // bigram 全部命中不代表连续出现，逐个校验子串/前缀
+    for (auto it = candidates.rbegin(); it != candidates.rend() && results.size() < limit; ++it) {
+        const Entry& entry = documents.at(*it);
+        if (ownerId > 0 && entry.doc.owner_id != ownerId) {
+            continue;
+        }
+        if (matches(entry, normalized, mode)) {
+            results.push_back(entry.doc);
+        }
+    }
+    return results;
+}
+
+DocumentSearchIndexStats DocumentSearchIndex::getStats() const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+
+    DocumentSearchIndexStats stats;
+    stats.documents = documents.size();
+    stats.grams = postings.size();
+
+    size_t bytes = (documents.bucket_count() + postings.bucket_count()) * sizeof(void*);
+    for (const auto& item : documents) {
+        const Entry& entry = item.second;
+        bytes += sizeof(item) + NODE_OVERHEAD;
+        bytes += heapBytes(entry.doc.title) + heapBytes(entry.doc.description) + heapBytes(entry.doc.file_path) +
+                 heapBytes(entry.doc.minio_key) + heapBytes(entry.doc.content_type);
+        bytes += heapBytes(entry.title) + heapBytes(entry.description) + heapBytes(entry.filePath);
+    }
+    for (const auto& item : postings) {
+        stats.postings += item.second.size();
+        bytes += sizeof(item) + NODE_OVERHEAD + item.second.capacity() * sizeof(int);
+    }
+    stats.memoryBytes = bytes;
+    return stats;
+}
@@ -11,16 +11,77 @@
 // CSV文件处理实现
 // 支持标准的逗号分隔值格式，兼容Excel导出的CSV文件
 
-ImportExportManager::ImportExportManager(DatabaseManager* db) 
+namespace {
+    // 每累计这么多行提交一次批量写入（一个事务），失败时只需逐行重试这一批
+    const size_t IMPORT_FLUSH_ROWS = 10000;
+}
+
+ImportExportManager::ImportExportManager(StorageBackend* db) 
     : dbManager(db), dateFormat("%Y-%m-%d %H:%M:%S"), encoding("UTF-8"), 
-      skipEmptyRows(true), trimWhitespace(true) {
+      skipEmptyRows(true), trimWhitespace(true), batchSize(500) {
     if (!dbManager) {
-        throw std::invalid_argument("DatabaseManager cannot be null");
+        throw std::invalid_argument("StorageBackend cannot be null");
     }
 }
 
 ImportExportManager::~ImportExportManager() = default;
 
+void ImportExportManager::flushUsers(std::vector<User>& users, std::vector<int>& lineNumbers, ImportResult& result) {
+    if (users.empty()) {
+        return;
+    }
+
+    auto batchResult = dbManager->createUsersBatch(users, batchSize);
+    if (batchResult.success) {
+        result.successfulImports += static_cast<int>(users.size());
+    } else {
+        // 整批回滚后逐行重试，定位具体失败的行
+        for (size_t i = 0; i < users.size(); ++i) {
+            auto dbResult = dbManager->createUser(users[i].username, users[i].password_hash, users[i].email);
+            if (dbResult.success) {
+                result.successfulImports++;
+            } else {
+                std::string err = "第" + std::to_string(lineNumbers[i]) + "行: " + dbResult.message;
+                addError(err);
+                result.errors.push_back(err);
+                result.failedImports++;
+            }
+        }
+    }
+
+    users.clear();
+    lineNumbers.clear();
+}
+
+void ImportExportManager::flushDocuments(std::vector<Document>& documents, std::vector<int>& lineNumbers, ImportResult& result) {
+    if (documents.empty()) {
+        return;
+    }
+
+    auto batchResult = dbManager->createDocumentsBatch(documents, batchSize);
+    if (batchResult.success) {
+        result.successfulImports += static_cast<int>(documents.size());
+    } else {
+        // 整批回滚后逐行重试，定位具体失败的行
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const Document& doc = documents[i];
+            auto dbResult = dbManager->createDocument(doc.title, doc.description, doc.file_path,
+                                                      doc.minio_key, doc.owner_id, doc.file_size, doc.content_type);
+            if (dbResult.success) {
+                result.successfulImports++;
+            } else {
+                std::string err = "第" + std::to_string(lineNumbers[i]) + "行: " + dbResult.message;
+                addError(err);
+                result.errors.push_back(err);
+                result.failedImports++;
+            }
+        }
+    }
+
+    documents.clear();
+    lineNumbers.clear();
+}
+
 // 用户数据导入导出
 Result<ImportResult> ImportExportManager::importUsersFromCSV(const std::string& filePath, bool skipHeader) {
     auto startTime = std::chrono::high_resolution_clock::now();
@@ -71,6 +132,9 @@ Result<ImportResult> ImportExportManager::importUsersFromCSV(const std::string&
             {"内容类型", "content_type"}
         };
         
+        std::vector<User> pendingUsers;
+        std::vector<int> pendingLines;
+        
         // 处理数据行
         while (std::getline(file, line)) {
             lineNumber++;
@@ -115,17 +179,11 @@ Result<ImportResult> ImportExportManager::importUsersFromCSV(const std::string&
                     continue;
                 }
 
-                // 转换为User对象并保存
-                User user = mapToUser(data);
-                auto dbResult = dbManager->createUser(user.username, user.password_hash, user.email);
-                
-                if (dbResult.success) {
-                    result.successfulImports++;
-                } else {
-                    std::string err = "第" + std::to_string(lineNumber) + "行: " + dbResult.message;
-                    addError(err);
-                    result.errors.push_back(err);
-                    result.failedImports++;
+                // 转换为User对象，攒够一批后批量写入
+                pendingUsers.push_back(mapToUser(data));
+                pendingLines.push_back(lineNumber);
+                if (pendingUsers.size() >= IMPORT_FLUSH_ROWS) {
+                    flushUsers(pendingUsers, pendingLines, result);
                 }
                 
                 // 更新进度
@@ -138,6 +196,7 @@ Result<ImportResult> ImportExportManager::importUsersFromCSV(const std::string&
                 result.failedImports++;
             }
         }
+        flushUsers(pendingUsers, pendingLines, result);
         
         auto endTime = std::chrono::high_resolution_clock::now();
         result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -154,12 +213,6 @@ Result<ExportResult> ImportExportManager::exportUsersToCSV(const std::string& fi
     ExportResult result;
     
     try {
-        // 获取所有用户
-        auto usersResult = dbManager->getAllUsers();
-        if (!usersResult.success) {
-            return Result<ExportResult>::Error("获取用户数据失败: " + usersResult.message);
-        }
-        
         std::ofstream file(filePath);
         if (!file.is_open()) {
             return Result<ExportResult>::Error("无法创建文件: " + filePath);
@@ -170,8 +223,8 @@ Result<ExportResult> ImportExportManager::exportUsersToCSV(const std::string& fi
             file << "ID,用户名,邮箱,创建时间,最后登录,是否激活\n";
         }
         
-        // 写入数据行
-        for (const auto& user : usersResult.data.value()) {
+        // 流式写入数据行，不一次性加载全部用户
+        auto usersResult = dbManager->forEachUser([&](const User& user) {
             auto userMap = userToMap(user);
             file << userMap["id"] << ","
                  << userMap["username"] << ","
@@ -181,10 +234,15 @@ Result<ExportResult> ImportExportManager::exportUsersToCSV(const std::string& fi
                  << userMap["is_active"] << "\n";
             
             result.totalRecords++;
-        }
+            return true;
+        });
         
         file.close();
         
+        if (!usersResult.success) {
+            return Result<ExportResult>::Error("获取用户数据失败: " + usersResult.message);
+        }
+        
         // 获取文件大小
         QFileInfo fileInfo(QString::fromUtf8(filePath));
         result.fileSize = fileInfo.size();
@@ -230,6 +288,9 @@ Result<ImportResult> ImportExportManager::importDocumentsFromCSV(const std::stri
             lineNumber++;
         }
         
+        std::vector<Document> pendingDocs;
+        std::vector<int> pendingLines;
+        
         // 处理数据行
         while (std::getline(file, line)) {
             lineNumber++;
@@ -269,18 +330,11 @@ Result<ImportResult> ImportExportManager::importDocumentsFromCSV(const std::stri
                     continue;
                 }
                 
-                // 转换为Document对象并保存
-                Document doc = mapToDocument(data);
-                auto dbResult = dbManager->createDocument(doc.title, doc.description, doc.file_path, 
-                                                        doc.minio_key, doc.owner_id, doc.file_size, doc.content_type);
-                
-                if (dbResult.success) {
-                    result.successfulImports++;
-                } else {
-                    std::string err = "第" + std::to_string(lineNumber) + "行: " + dbResult.message;
-                    addError(err);
-                    result.errors.push_back(err);
-                    result.failedImports++;
+                // 转换为Document对象，攒够一批后批量写入
+                pendingDocs.push_back(mapToDocument(data));
+                pendingLines.push_back(lineNumber);
+                if (pendingDocs.size() >= IMPORT_FLUSH_ROWS) {
+                    flushDocuments(pendingDocs, pendingLines, result);
                 }
                 
                 updateProgress(result.totalRecords, result.totalRecords, "正在导入文档数据...");
@@ -292,6 +346,7 @@ Result<ImportResult> ImportExportManager::importDocumentsFromCSV(const std::stri
                 result.failedImports++;
             }
         }
+        flushDocuments(pendingDocs, pendingLines, result);
         
         auto endTime = std::chrono::high_resolution_clock::now();
         result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -308,12 +363,6 @@ Result<ExportResult> ImportExportManager::exportDocumentsToCSV(const std::string
     ExportResult result;
     
     try {
-        // 获取所有文档
-        auto docsResult = dbManager->getAllDocuments();
-        if (!docsResult.success) {
-            return Result<ExportResult>::Error("获取文档数据失败: " + docsResult.message);
-        }
-        
         std::ofstream file(filePath);
         if (!file.is_open()) {
             return Result<ExportResult>::Error("无法创建文件: " + filePath);
@@ -324,8 +373,8 @@ Result<ExportResult> ImportExportManager::exportDocumentsToCSV(const std::string
             file << "ID,标题,描述,文件名,Minio键,所有者ID,创建时间,更新时间,文件大小,文件后缀\n";
         }
         
-        // 写入数据行
-        for (const auto& doc : docsResult.data.value()) {
+        // 流式写入数据行，不一次性加载全部文档
+        auto docsResult = dbManager->forEachDocument(DocumentFilter(), [&](const Document& doc) {
             auto docMap = documentToMap(doc);
             file << docMap["id"] << ","
                  << docMap["title"] << ","
@@ -339,10 +388,15 @@ Result<ExportResult> ImportExportManager::exportDocumentsToCSV(const std::string
                  << docMap["content_type"] << "\n";
             
             result.totalRecords++;
-        }
+            return true;
+        });
         
         file.close();
         
+        if (!docsResult.success) {
+            return Result<ExportResult>::Error("获取文档数据失败: " + docsResult.message);
+        }
+        
         QFileInfo fileInfo(QString::fromUtf8(filePath));
         result.fileSize = fileInfo.size();
         result.filePath = filePath;
@@ -494,6 +548,10 @@ void ImportExportManager::setTrimWhitespace(bool trim) {
     trimWhitespace = trim;
 }
 
+void ImportExportManager::setBatchSize(size_t size) {
+    batchSize = std::max<size_t>(1, size);
+}
+
 // 进度回调设置
 void ImportExportManager::setProgressCallback(ProgressCallback callback) {
     progressCallback = callback;
@@ -0,0 +1,379 @@
+#include "MySqlConnectionPool.h"
+#include "Logger.h"
+#include <cstring>
+
+namespace {
+    std::once_flag mysqlLibraryInitFlag;
+}
+
+// ================== PooledConnection ==================
+
+PooledConnection::PooledConnection()
+        : pool(nullptr), conn(nullptr), owned(false), broken(false) {
+}
+
+PooledConnection::PooledConnection(MySqlConnectionPool* pool, MySqlConnection* conn, bool owned)
+        : pool(pool), conn(conn), owned(owned), broken(false) {
+}
+
+PooledConnection::~PooledConnection() {
+    release();
+}
+
+PooledConnection::PooledConnection(PooledConnection&& other) noexcept
+        : pool(other.pool), conn(other.conn), owned(other.owned), broken(other.broken) {
+    other.pool = nullptr;
+    other.conn = nullptr;
+    other.owned = false;
+    other.broken = false;
+}
+
+PooledConnection& PooledConnection::operator=(PooledConnection&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        conn = other.conn;
+        owned = other.owned;
+        broken = other.broken;
+        other.pool = nullptr;
+        other.conn = nullptr;
+        other.owned = false;
+        other.broken = false;
+    }
+    return *this;
+}
+
+PooledConnection PooledConnection::borrow() const {
+    return PooledConnection(pool, conn, false);
+}
+
+bool PooledConnection::setStatementTimeout(long long timeoutMs) {
+    return conn && MySqlConnectionPool::applyStatementTimeout(conn, timeoutMs);
+}
+
+void PooledConnection::release() {
+    if (conn && owned && pool) {
+        pool->release(conn, broken);
+    }
+    pool = nullptr;
+    conn = nullptr;
+    owned = false;
+    broken = false;
+}
+
+// ================== MySqlConnectionPool ==================
+
+MySqlConnectionPool::MySqlConnectionPool(const std::string& host, int port, const std::string& username,
+                                         const std::string& password, const std::string& database,
+                                         const MySqlPoolOptions& options)
+        : host(host), port(port), username(username), password(password), database(database),
+          options(options), totalConnections(0), shuttingDown(false),
+          checkoutCount(0), waitCount(0), timeoutCount(0), reapedCount(0), brokenCount(0) {
+    if (this->options.minSize < 0) this->options.minSize = 0;
+    if (this->options.maxSize < 1) this->options.maxSize = 1;
+    if (this->options.minSize > this->options.maxSize) this->options.minSize = this->options.maxSize;
+
+    // 多线程使用客户端库前必须先初始化一次
+    std::call_once(mysqlLibraryInitFlag, []() {
+        mysql_library_init(0, nullptr, nullptr);
+    });
+}
+
+MySqlConnectionPool::~MySqlConnectionPool() {
+    shutdown();
+}
+
+bool MySqlConnectionPool::initialize() {
+    int initialSize = std::max(1, options.minSize);
+    for (int i = 0; i < initialSize; ++i) {
+        MySqlConnection* conn = openConnection();
+        if (!conn) {
+            if (i == 0) {
+                return false;
+            }
+            LOG_WARNING("连接池预建连接不足: " + std::to_string(i) + "/" + std::to_string(initialSize));
+            break;
+        }
+        std::lock_guard<std::mutex> lock(poolMutex);
+        idleConnections.push_back(conn);
+        totalConnections++;
+    }
+
+    reaperThread = std::thread(&MySqlConnectionPool::reaperLoop, this);
+
+    LOG_INFO("MySQL连接池已启动: min=" + std::to_string(options.minSize) +
+             " max=" + std::to_string(options.maxSize));
+    return true;
+}
+
+void MySqlConnectionPool::shutdown() {
+    std::deque<MySqlConnection*> toClose;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (shuttingDown) {
+            return;
+        }
+        shuttingDown = true;
+        toClose.swap(idleConnections);
+        totalConnections -= static_cast<int>(toClose.size());
+    }
+    connectionAvailable.notify_all();
+    reaperWakeup.notify_all();
+
+    if (reaperThread.joinable()) {
+        reaperThread.join();
+    }
+
+    for (MySqlConnection* conn : toClose) {
+        closeConnection(conn);
+    }
+}
+
+MySqlConnection* MySqlConnectionPool::openConnection() {
+    MYSQL* handle = mysql_init(nullptr);
+    if (!handle) {
+        setLastError("无法初始化MySQL连接");
+        LOG_ERROR("无法初始化MySQL连接");
+        return nullptr;
+    }
+
+    // 断线由连接池的健康检查负责替换，不使用客户端自动重连（会静默丢失会话状态）
+    unsigned int connectTimeout = static_cast<unsigned int>(options.connectTimeoutSeconds);
+    mysql_options(handle, MYSQL_OPT_CONNECT_TIMEOUT, &connectTimeout);
+    mysql_options(handle, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+    mysql_options(handle, MYSQL_DEFAULT_AUTH, "mysql_native_password");
+
+    if (!mysql_real_connect(handle, host.c_str(), username.c_str(), password.c_str(),
+                            database.c_str(), port, nullptr, 0)) {
+        std::string error = mysql_error(handle);
+        setLastError(error);
+        LOG_ERROR("无法连接到MySQL数据库: " + error);
+        mysql_close(handle);
+        return nullptr;
+    }
+
+    auto* conn = new MySqlConnection();
+    conn->handle = handle;
+    const char* serverInfo = mysql_get_server_info(handle);
+    conn->mariaDb = serverInfo && std::strstr(serverInfo, "MariaDB") != nullptr;
+    conn->createdAt = std::chrono::steady_clock::now();
+    conn->lastUsed = conn->createdAt;
+    conn->statements = std::make_unique<PreparedStatementCache>(
+            handle, &statementCounters, static_cast<size_t>(std::max(1, options.statementCacheSize)));
+    return conn;
+}
+
+bool MySqlConnectionPool::applyStatementTimeout(MySqlConnection* conn, long long timeoutMs) {
+    if (conn->statementTimeoutMs == timeoutMs) {
+        return true;
+    }
+    std::string sql = conn->mariaDb
+                      ? "SET SESSION max_statement_time = " + std::to_string(timeoutMs / 1000.0) + ";"
+                      : "SET SESSION max_execution_time = " + std::to_string(timeoutMs) + ";";
+    if (mysql_query(conn->handle, sql.c_str()) != 0) {
+        LOG_WARNING("设置语句执行时限失败: " + std::string(mysql_error(conn->handle)));
+        return false;
+    }
+    conn->statementTimeoutMs = timeoutMs;
+    return true;
+}
+
+void MySqlConnectionPool::closeConnection(MySqlConnection* conn) {
+    if (!conn) {
+        return;
+    }
+    conn->statements.reset();
+    if (conn->handle) {
+        mysql_close(conn->handle);
+        conn->handle = nullptr;
+    }
+    delete conn;
+}
+
+PooledConnection MySqlConnectionPool::acquire() {
+    return acquire(std::chrono::milliseconds(options.checkoutTimeoutMs));
+}
+
+PooledConnection MySqlConnectionPool::acquire(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto healthCheckAge = std::chrono::seconds(options.healthCheckSeconds);
+    bool waited = false;
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (true) {
+        if (shuttingDown) {
+            return PooledConnection();
+        }
+
+        // 1. 优先复用最近归还的空闲连接
+        if (!idleConnections.empty()) {
+            MySqlConnection* conn = idleConnections.back();
+            idleConnections.pop_back();
+
+            if (std::chrono::steady_clock::now() - conn->lastUsed >= healthCheckAge) {
+                lock.unlock();
+                bool alive = mysql_ping(conn->handle) == 0;
+                if (!alive) {
+                    LOG_WARNING("连接池健康检查失败，丢弃连接: " + std::string(mysql_error(conn->handle)));
+                    closeConnection(conn);
+                    brokenCount++;
+                }
+                lock.lock();
+                if (!alive) {
+                    totalConnections--;
+                    continue;
+                }
+            }
+
+            checkoutCount++;
+            return PooledConnection(this, conn, true);
+        }
+
+        // 2. 未达到上限则新建连接（先占位，建连过程不持锁）
+        if (totalConnections < options.maxSize) {
+            totalConnections++;
+            lock.unlock();
+            MySqlConnection* conn = openConnection();
+            if (!conn) {
+                lock.lock();
+                totalConnections--;
+                connectionAvailable.notify_one();
+                return PooledConnection();
+            }
+            checkoutCount++;
+            return PooledConnection(this, conn, true);
+        }
+
+        // 3. 连接耗尽，等待归还直到超时
+        if (!waited) {
+            waitCount++;
+            waited = true;
+        }
+        if (connectionAvailable.wait_until(lock, deadline) == std::cv_status::timeout &&
+            idleConnections.empty() && totalConnections >= options.maxSize) {
+            timeoutCount++;
+            setLastError("获取数据库连接超时（" + std::to_string(timeout.count()) + "ms）");
+            return PooledConnection();
+        }
+    }
+}
+
+void MySqlConnectionPool::release(MySqlConnection* conn, bool broken) {
+    if (!conn) {
+        return;
+    }
+
+    // 上一条语句因断线失败的连接不再放回池中
+    if (!broken && conn->handle && isConnectionLostError(mysql_errno(conn->handle))) {
+        broken = true;
+    }
+    // 借用方设置的语句时限只对这次借用有效，恢复失败的连接直接丢弃
+    if (!broken && conn->statementTimeoutMs != 0 && !applyStatementTimeout(conn, 0)) {
+        broken = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!broken && !shuttingDown) {
+            conn->lastUsed = std::chrono::steady_clock::now();
+            idleConnections.push_back(conn);
+            connectionAvailable.notify_one();
+            return;
+        }
+        totalConnections--;
+    }
+
+    if (broken) {
+        brokenCount++;
+    }
+    closeConnection(conn);
+    connectionAvailable.notify_one();
+}
+
+void MySqlConnectionPool::reaperLoop() {
+    auto interval = std::chrono::seconds(std::max(1, std::min(options.idleTimeoutSeconds, options.healthCheckSeconds)));
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (!shuttingDown) {
+        reaperWakeup.wait_for(lock, interval, [this]() { return shuttingDown; });
+        if (shuttingDown) {
+            break;
+        }
+        lock.unlock();
+        reapIdleConnections();
+        lock.lock();
+    }
+}
+
+void MySqlConnectionPool::reapIdleConnections() {
+    std::vector<MySqlConnection*> toClose;
+    int missing = 0;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        auto now = std::chrono::steady_clock::now();
+        auto idleTimeout = std::chrono::seconds(options.idleTimeoutSeconds);
+
+        // 头部是最久未使用的连接，回收到 minSize 为止
+        while (!idleConnections.empty() && totalConnections > options.minSize &&
+               now - idleConnections.front()->lastUsed >= idleTimeout) {
+            toClose.push_back(idleConnections.front());
+            idleConnections.pop_front();
+            totalConnections--;
+        }
+
+        // 断线替换后补足最小连接数（同样先占位）
+        missing = options.minSize - totalConnections;
+        if (missing > 0) {
+            totalConnections += missing;
+        }
+    }
+
+    for (MySqlConnection* conn : toClose) {
+        closeConnection(conn);
+    }
+    reapedCount += toClose.size();
+
+    for (int i = 0; i < missing; ++i) {
+        MySqlConnection* conn = openConnection();
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (conn && !shuttingDown) {
+            idleConnections.push_back(conn);
+            connectionAvailable.notify_one();
+        } else {
+            totalConnections--;
+            if (conn) {
+                closeConnection(conn);
+            }
+        }
+    }
+}
+
+MySqlPoolStats MySqlConnectionPool::getStats() {
+    MySqlPoolStats stats;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stats.totalConnections = totalConnections;
+        stats.idleConnections = static_cast<int>(idleConnections.size());
+        stats.inUseConnections = totalConnections - stats.idleConnections;
+    }
+    stats.checkouts = checkoutCount;
+    stats.waits = waitCount;
+    stats.timeouts = timeoutCount;
+    stats.reaped = reapedCount;
+    stats.brokenReplaced = brokenCount;
+    return stats;
+}
+
+void MySqlConnectionPool::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    lastError = error;
+}
+
+std::string MySqlConnectionPool::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError;
+}
+
+bool MySqlConnectionPool::isConnectionLostError(unsigned int errorCode) {
+    return errorCode == 2006 || errorCode == 2013;
+}
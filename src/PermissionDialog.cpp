@@ -244,7 +244,6 @@ void PermissionDialog::loadUsers()
     if (!m_cliHandler) return;
     
     try {
-        m_users = m_cliHandler->getAllUsersForUI();
         refreshUserList();
     } catch (const std::exception& e) {
         QMessageBox::warning(this, "错误", QString("加载用户失败: %1").arg(e.what()));
@@ -294,14 +293,21 @@ void PermissionDialog::refreshRoleList()
 
 void PermissionDialog::refreshUserList()
 {
-    m_userTable->setRowCount(m_users.size());
-    
-    for (size_t i = 0; i < m_users.size(); ++i) {
-        const User& user = m_users[i];
-        m_userTable->setItem(i, 0, new QTableWidgetItem(QString::number(user.id)));
-        m_userTable->setItem(i, 1, new QTableWidgetItem(safeFromStdString(user.username)));
-        m_userTable->setItem(i, 2, new QTableWidgetItem(safeFromStdString(user.email)));
-    }
+    // 用户表可能很大：逐行流式填充表格，不在内存中保留完整的用户列表
+    m_userTable->setUpdatesEnabled(false);
+    m_userTable->setRowCount(0);
+
+    int row = 0;
+    m_cliHandler->forEachUserForUI([this, &row](const User& user) {
+        m_userTable->insertRow(row);
+        m_userTable->setItem(row, 0, new QTableWidgetItem(QString::number(user.id)));
+        m_userTable->setItem(row, 1, new QTableWidgetItem(safeFromStdString(user.username)));
+        m_userTable->setItem(row, 2, new QTableWidgetItem(safeFromStdString(user.email)));
+        row++;
+        return true;
+    });
+
+    m_userTable->setUpdatesEnabled(true);
 }
 
 void PermissionDialog::refreshMenuTree()
@@ -1,13 +1,32 @@
 #include "PermissionManager.h"
-#include "DatabaseManager.h"
+#include "StorageBackend.h"
 #include "Logger.h"
+#include "TransactionScope.h"
 #include <sstream>
 #include <algorithm>
 
-PermissionManager::PermissionManager(DatabaseManager* dbManager) 
+namespace {
+    // 列：id, role_name, role_code, description, is_active, is_system, created_at, updated_at, created_by, updated_by
+    Role roleFromRow(const QueryResult::Row& row) {
+        Role role;
+        role.id = row.getInt("id");
+        role.role_name = row.getString("role_name");
+        role.role_code = row.getString("role_code");
+        role.description = row.getString("description");
+        role.is_active = row.getBool("is_active");
+        role.is_system = row.getBool("is_system");
+        role.created_at = row.getTimestamp("created_at");
+        role.updated_at = row.getTimestamp("updated_at");
+        role.created_by = row.getInt("created_by");
+        role.updated_by = row.getInt("updated_by");
+        return role;
+    }
+}
+
+PermissionManager::PermissionManager(StorageBackend* dbManager) 
     : dbManager(dbManager) {
     if (!dbManager) {
-        LOG_ERROR("DatabaseManager 指针为空");
+        LOG_ERROR("存储后端指针为空");
     }
 }
 
@@ -61,6 +80,30 @@ ButtonType PermissionManager::stringToButtonType(const std::string& typeStr) {
     return ButtonType::CUSTOM;
 }
 
+// 列：id, name, code, parent_id, type, url, icon, permission_key, button_type, sort_order,
+// is_visible, is_active, description, created_at, updated_at, created_by, updated_by
+MenuItem PermissionManager::menuFromRow(const QueryResult::Row& row) {
+    MenuItem menu;
+    menu.id = row.getInt("id");
+    menu.name = row.getString("name");
+    menu.code = row.getString("code");
+    menu.parent_id = row.getInt("parent_id");
+    menu.type = stringToMenuType(row.getString("type"));
+    menu.url = row.getString("url");
+    menu.icon = row.getString("icon");
+    menu.permission_key = row.getString("permission_key");
+    menu.button_type = stringToButtonType(row.getString("button_type"));
+    menu.sort_order = row.getInt("sort_order");
+    menu.is_visible = row.getBool("is_visible");
+    menu.is_active = row.getBool("is_active");
+    menu.description = row.getString("description");
+    menu.created_at = row.getTimestamp("created_at");
+    menu.updated_at = row.getTimestamp("updated_at");
+    menu.created_by = row.getInt("created_by");
+    menu.updated_by = row.getInt("updated_by");
+    return menu;
+}
+
 // 角色管理
 Result<Role> PermissionManager::createRole(const std::string& roleName, const std::string& roleCode, 
                                          const std::string& description, bool isSystem) {
@@ -101,24 +144,12 @@ Result<Role> PermissionManager::getRoleById(int roleId) {
         return Result<Role>::Error("查询角色失败: " + result.message);
     }
 
-    auto rows = result.data.value();
+    const QueryResult& rows = result.data.value();
     if (rows.empty()) {
         return Result<Role>::Error("角色不存在");
     }
 
-    Role role;
-    auto& row = rows[0];
-    role.id = std::stoi(row["id"]);
-    role.role_name = row["role_name"];
-    role.role_code = row["role_code"];
-    role.description = row["description"];
-    role.is_active = row["is_active"] == "1";
-    role.is_system = row["is_system"] == "1";
-    role.created_by = row["created_by"].empty() ? 0 : std::stoi(row["created_by"]);
-    role.updated_by = row["updated_by"].empty() ? 0 : std::stoi(row["updated_by"]);
-    // TODO: 解析时间字段
-    role.created_at = std::chrono::system_clock::now();
-    role.updated_at = std::chrono::system_clock::now();
+    Role role = roleFromRow(rows[0]);
 
     // 缓存结果
     roleCache[roleId] = role;
@@ -140,23 +171,12 @@ Result<Role> PermissionManager::getRoleByCode(const std::string& roleCode) {
         return Result<Role>::Error("查询角色失败: " + result.message);
     }
 
-    auto rows = result.data.value();
+    const QueryResult& rows = result.data.value();
     if (rows.empty()) {
         return Result<Role>::Error("角色不存在");
     }
 
-    Role role;
-    auto& row = rows[0];
-    role.id = std::stoi(row["id"]);
-    role.role_name = row["role_name"];
-    role.role_code = row["role_code"];
-    role.description = row["description"];
-    role.is_active = row["is_active"] == "1";
-    role.is_system = row["is_system"] == "1";
-    role.created_by = row["created_by"].empty() ? 0 : std::stoi(row["created_by"]);
-    role.updated_by = row["updated_by"].empty() ? 0 : std::stoi(row["updated_by"]);
-    role.created_at = std::chrono::system_clock::now();
-    role.updated_at = std::chrono::system_clock::now();
+    Role role = roleFromRow(rows[0]);
 
     // 缓存结果
     roleCache[role.id] = role;
@@ -179,18 +199,9 @@ Result<std::vector<Role>> PermissionManager::getAllRoles() {
     }
 
     std::vector<Role> roles;
+    roles.reserve(result.data->rowCount());
     for (const auto& row : result.data.value()) {
-        Role role;
-        role.id = std::stoi(row.at("id"));
-        role.role_name = row.at("role_name");
-        role.role_code = row.at("role_code");
-        role.description = row.at("description");
-        role.is_active = row.at("is_active") == "1";
-        role.is_system = row.at("is_system") == "1";
-        role.created_by = row.at("created_by").empty() ? 0 : std::stoi(row.at("created_by"));
-        role.updated_by = row.at("updated_by").empty() ? 0 : std::stoi(row.at("updated_by"));
-        role.created_at = std::chrono::system_clock::now();
-        role.updated_at = std::chrono::system_clock::now();
+        Role role = roleFromRow(row);
 
         roles.push_back(role);
         
@@ -217,25 +228,9 @@ Result<std::vector<MenuItem>> PermissionManager::getAllMenus() {
     }
 
     std::vector<MenuItem> menus;
+    menus.reserve(result.data->rowCount());
     for (const auto& row : result.data.value()) {
-        MenuItem menu;
-        menu.id = std::stoi(row.at("id"));
-        menu.name = row.at("name");
-        menu.code = row.at("code");
-        menu.parent_id = row.at("parent_id").empty() ? 0 : std::stoi(row.at("parent_id"));
-        menu.type = stringToMenuType(row.at("type"));
-        menu.url = row.at("url");
-        menu.icon = row.at("icon");
-        menu.permission_key = row.at("permission_key");
-        menu.button_type = stringToButtonType(row.at("button_type"));
-        menu.sort_order = std::stoi(row.at("sort_order"));
-        menu.is_visible = row.at("is_visible") == "1";
-        menu.is_active = row.at("is_active") == "1";
-        menu.description = row.at("description");
-        menu.created_by = row.at("created_by").empty() ? 0 : std::stoi(row.at("created_by"));
-        menu.updated_by = row.at("updated_by").empty() ? 0 : std::stoi(row.at("updated_by"));
-        menu.created_at = std::chrono::system_clock::now();
-        menu.updated_at = std::chrono::system_clock::now();
+        MenuItem menu = menuFromRow(row);
 
         menus.push_back(menu);
     }
@@ -297,7 +292,8 @@ Result<bool> PermissionManager::assignRoleToUser(int userId, int roleId, int ass
 
     std::string sql = "INSERT INTO user_roles (user_id, role_id, assigned_by) VALUES (" +
                       std::to_string(userId) + ", " + std::to_string(roleId) + ", " +
-                      std::to_string(assignedBy) + ") ON DUPLICATE KEY UPDATE is_active = TRUE;";
+                      std::to_string(assignedBy) + ")" +
+                      dbManager->upsertClause("user_id, role_id", "is_active = TRUE") + ";";
 
     auto result = dbManager->executeQuery(sql);
     if (!result.success) {
@@ -338,7 +334,8 @@ Result<std::vector<Role>> PermissionManager::getUserRoles(int userId) {
                       "r.is_system, r.created_at, r.updated_at, r.created_by, r.updated_by "
                       "FROM roles r JOIN user_roles ur ON r.id = ur.role_id "
                       "WHERE ur.user_id = " + std::to_string(userId) + " AND ur.is_active = TRUE "
-                      "AND r.is_active = TRUE AND (ur.expires_at IS NULL OR ur.expires_at > NOW());";
+                      "AND r.is_active = TRUE AND (ur.expires_at IS NULL OR ur.expires_at > " +
+                      dbManager->currentTimestampSql() + ");";
 
     auto result = dbManager->executeQuery(sql);
     if (!result.success) {
@@ -346,18 +343,9 @@ Result<std::vector<Role>> PermissionManager::getUserRoles(int userId) {
     }
 
     std::vector<Role> roles;
+    roles.reserve(result.data->rowCount());
     for (const auto& row : result.data.value()) {
-        Role role;
-        role.id = std::stoi(row.at("id"));
-        role.role_name = row.at("role_name");
-        role.role_code = row.at("role_code");
-        role.description = row.at("description");
-        role.is_active = row.at("is_active") == "1";
-        role.is_system = row.at("is_system") == "1";
-        role.created_by = row.at("created_by").empty() ? 0 : std::stoi(row.at("created_by"));
-        role.updated_by = row.at("updated_by").empty() ? 0 : std::stoi(row.at("updated_by"));
-        role.created_at = std::chrono::system_clock::now();
-        role.updated_at = std::chrono::system_clock::now();
+        Role role = roleFromRow(row);
 
         roles.push_back(role);
     }
@@ -372,8 +360,8 @@ Result<bool> PermissionManager::grantMenuToRole(int roleId, int menuId) {
     }
 
     std::string sql = "INSERT INTO role_menus (role_id, menu_id, is_granted) VALUES (" +
-                      std::to_string(roleId) + ", " + std::to_string(menuId) + ", TRUE) "
-                      "ON DUPLICATE KEY UPDATE is_granted = TRUE;";
+                      std::to_string(roleId) + ", " + std::to_string(menuId) + ", TRUE)" +
+                      dbManager->upsertClause("role_id, menu_id", "is_granted = TRUE") + ";";
 
     auto result = dbManager->executeQuery(sql);
     if (!result.success) {
@@ -420,12 +408,12 @@ Result<bool> PermissionManager::hasPermission(int userId, const std::string& per
         return Result<bool>::Error("检查权限失败: " + result.message);
     }
 
-    auto rows = result.data.value();
+    const QueryResult& rows = result.data.value();
     if (rows.empty()) {
         return Result<bool>::Success(false);
     }
 
-    int count = std::stoi(rows[0].at("count"));
+    int count = rows[0].getInt("count");
     return Result<bool>::Success(count > 0);
 }
 
@@ -443,12 +431,12 @@ Result<bool> PermissionManager::hasMenuAccess(int userId, const std::string& men
         return Result<bool>::Error("检查菜单权限失败: " + result.message);
     }
 
-    auto rows = result.data.value();
+    const QueryResult& rows = result.data.value();
     if (rows.empty()) {
         return Result<bool>::Success(false);
     }
 
-    int count = std::stoi(rows[0].at("count"));
+    int count = rows[0].getInt("count");
     return Result<bool>::Success(count > 0);
 }
 
@@ -505,30 +493,12 @@ Result<MenuItem> PermissionManager::getMenuById(int menuId) {
         return Result<MenuItem>::Error("查询菜单失败: " + result.message);
     }
 
-    auto rows = result.data.value();
+    const QueryResult& rows = result.data.value();
     if (rows.empty()) {
         return Result<MenuItem>::Error("菜单不存在");
     }
 
-    MenuItem menu;
-    auto& row = rows[0];
-    menu.id = std::stoi(row["id"]);
-    menu.name = row["name"];
-    menu.code = row["code"];
-    menu.parent_id = row["parent_id"].empty() ? 0 : std::stoi(row["parent_id"]);
-    menu.type = stringToMenuType(row["type"]);
-    menu.url = row["url"];
-    menu.icon = row["icon"];
-    menu.permission_key = row["permission_key"];
-    menu.button_type = stringToButtonType(row["button_type"]);
-    menu.sort_order = std::stoi(row["sort_order"]);
-    menu.is_visible = row["is_visible"] == "1";
-    menu.is_active = row["is_active"] == "1";
-    menu.description = row["description"];
-    menu.created_by = row["created_by"].empty() ? 0 : std::stoi(row["created_by"]);
-    menu.updated_by = row["updated_by"].empty() ? 0 : std::stoi(row["updated_by"]);
-    menu.created_at = std::chrono::system_clock::now();
-    menu.updated_at = std::chrono::system_clock::now();
+    MenuItem menu = menuFromRow(rows[0]);
 
     return Result<MenuItem>::Success(menu);
 }
@@ -548,30 +518,12 @@ Result<MenuItem> PermissionManager::getMenuByCode(const std::string& code) {
         return Result<MenuItem>::Error("查询菜单失败: " + result.message);
     }
 
-    auto rows = result.data.value();
+    const QueryResult& rows = result.data.value();
     if (rows.empty()) {
         return Result<MenuItem>::Error("菜单不存在");
     }
 
-    MenuItem menu;
-    auto& row = rows[0];
-    menu.id = std::stoi(row["id"]);
-    menu.name = row["name"];
-    menu.code = row["code"];
-    menu.parent_id = row["parent_id"].empty() ? 0 : std::stoi(row["parent_id"]);
-    menu.type = stringToMenuType(row["type"]);
-    menu.url = row["url"];
-    menu.icon = row["icon"];
-    menu.permission_key = row["permission_key"];
-    menu.button_type = stringToButtonType(row["button_type"]);
-    menu.sort_order = std::stoi(row["sort_order"]);
-    menu.is_visible = row["is_visible"] == "1";
-    menu.is_active = row["is_active"] == "1";
-    menu.description = row["description"];
-    menu.created_by = row["created_by"].empty() ? 0 : std::stoi(row["created_by"]);
-    menu.updated_by = row["updated_by"].empty() ? 0 : std::stoi(row["updated_by"]);
-    menu.created_at = std::chrono::system_clock::now();
-    menu.updated_at = std::chrono::system_clock::now();
+    MenuItem menu = menuFromRow(rows[0]);
 
     return Result<MenuItem>::Success(menu);
 }
@@ -637,25 +589,9 @@ Result<std::vector<MenuItem>> PermissionManager::getRoleMenus(int roleId) {
     }
 
     std::vector<MenuItem> menus;
+    menus.reserve(result.data->rowCount());
     for (const auto& row : result.data.value()) {
-        MenuItem menu;
-        menu.id = std::stoi(row.at("id"));
-        menu.name = row.at("name");
-        menu.code = row.at("code");
-        menu.parent_id = row.at("parent_id").empty() ? 0 : std::stoi(row.at("parent_id"));
-        menu.type = stringToMenuType(row.at("type"));
-        menu.url = row.at("url");
-        menu.icon = row.at("icon");
-        menu.permission_key = row.at("permission_key");
-        menu.button_type = stringToButtonType(row.at("button_type"));
-        menu.sort_order = std::stoi(row.at("sort_order"));
-        menu.is_visible = row.at("is_visible") == "1";
-        menu.is_active = row.at("is_active") == "1";
-        menu.description = row.at("description");
-        menu.created_by = row.at("created_by").empty() ? 0 : std::stoi(row.at("created_by"));
-        menu.updated_by = row.at("updated_by").empty() ? 0 : std::stoi(row.at("updated_by"));
-        menu.created_at = std::chrono::system_clock::now();
-        menu.updated_at = std::chrono::system_clock::now();
+        MenuItem menu = menuFromRow(row);
 
         menus.push_back(menu);
     }
@@ -680,18 +616,9 @@ Result<std::vector<Role>> PermissionManager::getMenuRoles(int menuId) {
     }
 
     std::vector<Role> roles;
+    roles.reserve(result.data->rowCount());
     for (const auto& row : result.data.value()) {
-        Role role;
-        role.id = std::stoi(row.at("id"));
-        role.role_name = row.at("role_name");
-        role.role_code = row.at("role_code");
-        role.description = row.at("description");
-        role.is_active = row.at("is_active") == "1";
-        role.is_system = row.at("is_system") == "1";
-        role.created_by = row.at("created_by").empty() ? 0 : std::stoi(row.at("created_by"));
-        role.updated_by = row.at("updated_by").empty() ? 0 : std::stoi(row.at("updated_by"));
-        role.created_at = std::chrono::system_clock::now();
-        role.updated_at = std::chrono::system_clock::now();
+        Role role = roleFromRow(row);
 
         roles.push_back(role);
     }
@@ -733,37 +660,31 @@ Result<bool> PermissionManager::batchGrantMenusToRole(int roleId, const std::vec
         return Result<bool>::Error("数据库未连接");
     }
 
-    // 开始事务
-    if (!dbManager->beginTransaction()) {
-        return Result<bool>::Error("开始事务失败");
-    }
-
     try {
-        // 1. 先撤销该角色的所有菜单权限
-        std::string revokeSql = "UPDATE role_menus SET is_granted = FALSE WHERE role_id = " + std::to_string(roleId) + ";";
-        auto revokeResult = dbManager->executeQuery(revokeSql);
-        if (!revokeResult.success) {
-            dbManager->rollbackTransaction();
-            return Result<bool>::Error("撤销现有权限失败: " + revokeResult.message);
-        }
-
-        // 2. 为选中的菜单授予权限
-        for (int menuId : menuIds) {
-            std::string grantSql = "INSERT INTO role_menus (role_id, menu_id, is_granted) VALUES (" +
-                                  std::to_string(roleId) + ", " + std::to_string(menuId) + ", TRUE) "
-                                  "ON DUPLICATE KEY UPDATE is_granted = TRUE;";
-            
-            auto grantResult = dbManager->executeQuery(grantSql);
-            if (!grantResult.success) {
-                dbManager->rollbackTransaction();
-                return Result<bool>::Error("授予菜单权限失败: " + grantResult.message);
+        // 撤销与授予在同一事务中执行；与其他授权操作发生死锁或锁等待超时时整体重做
+        auto result = runTransaction<bool>(dbManager, "batchGrantMenusToRole", [&]() {
+            // 1. 先撤销该角色的所有菜单权限
+            std::string revokeSql = "UPDATE role_menus SET is_granted = FALSE WHERE role_id = " + std::to_string(roleId) + ";";
+            auto revokeResult = dbManager->executeQuery(revokeSql);
+            if (!revokeResult.success) {
+                return Result<bool>::Error("撤销现有权限失败: " + revokeResult.message);
             }
-        }
 
-        // 3. 提交事务
-        if (!dbManager->commitTransaction()) {
-            dbManager->rollbackTransaction();
-            return Result<bool>::Error("提交事务失败");
+            // 2. 为选中的菜单授予权限
+            for (int menuId : menuIds) {
+                std::string grantSql = "INSERT INTO role_menus (role_id, menu_id, is_granted) VALUES (" +
+                                      std::to_string(roleId) + ", " + std::to_string(menuId) + ", TRUE)" +
+                                      dbManager->upsertClause("role_id, menu_id", "is_granted = TRUE") + ";";
+
+                auto grantResult = dbManager->executeQuery(grantSql);
+                if (!grantResult.success) {
+                    return Result<bool>::Error("授予菜单权限失败: " + grantResult.message);
+                }
+            }
+            return Result<bool>::Success(true);
+        });
+        if (!result.success) {
+            return result;
         }
 
         // 清除相关缓存
@@ -771,7 +692,7 @@ Result<bool> PermissionManager::batchGrantMenusToRole(int roleId, const std::vec
 
         return Result<bool>::Success(true);
     } catch (const std::exception& e) {
-        dbManager->rollbackTransaction();
+        // 事务作用域析构时已回滚
         return Result<bool>::Error("批量授权菜单权限时发生异常: " + std::string(e.what()));
     }
 }
@@ -0,0 +1,379 @@
+#include "PreparedStatementCache.h"
+#include "Logger.h"
+#include "TextDecoding.h"
+#include "QueryStats.h"
+#include <cstring>
+#include <cstdio>
+
+namespace {
+    // 字符串列的初始缓冲区大小，超长时按实际长度扩容后重新读取该列
+    const unsigned long INITIAL_STRING_BUFFER = 256;
+
+    bool isIntegerType(enum_field_types type) {
+        switch (type) {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONGLONG:
+            case MYSQL_TYPE_YEAR:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool isTemporalType(enum_field_types type) {
+        return type == MYSQL_TYPE_TIMESTAMP || type == MYSQL_TYPE_DATETIME || type == MYSQL_TYPE_DATE;
+    }
+}
+
+StatementCacheStats StatementCacheCounters::snapshot() const {
+    StatementCacheStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    stats.prepareErrors = prepareErrors;
+    stats.cachedStatements = cachedStatements;
+    return stats;
+}
+
+// ================== PreparedStatementCache ==================
+
+PreparedStatementCache::PreparedStatementCache(MYSQL* connection, StatementCacheCounters* counters, size_t capacity)
+        : connection(connection), counters(counters), capacity(capacity > 0 ? capacity : 1), useTick(0) {
+}
+
+PreparedStatementCache::~PreparedStatementCache() {
+    clear();
+}
+
+MYSQL_STMT* PreparedStatementCache::acquire(const std::string& sql) {
+    auto it = statements.find(sql);
+    if (it != statements.end()) {
+        it->second.lastUsed = ++useTick;
+        if (counters) counters->hits++;
+        return it->second.stmt;
+    }
+
+    if (counters) counters->misses++;
+
+    MYSQL_STMT* stmt = mysql_stmt_init(connection);
+    if (!stmt) {
+        if (counters) counters->prepareErrors++;
+        LOG_ERROR("初始化预处理语句失败: " + std::string(mysql_error(connection)));
+        return nullptr;
+    }
+
+    if (mysql_stmt_prepare(stmt, sql.c_str(), sql.length()) != 0) {
+        if (counters) counters->prepareErrors++;
+        LOG_ERROR("预处理语句失败: " + std::string(mysql_stmt_error(stmt)) + " SQL: " + sql);
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+
+    if (statements.size() >= capacity) {
+        evictLeastRecentlyUsed();
+    }
+
+    statements.emplace(sql, Entry{stmt, ++useTick});
+    if (counters) counters->cachedStatements++;
+    return stmt;
+}
+
+void PreparedStatementCache::invalidate(const std::string& sql) {
+    auto it = statements.find(sql);
+    if (it == statements.end()) {
+        return;
+    }
+    mysql_stmt_close(it->second.stmt);
+    statements.erase(it);
+    if (counters) counters->cachedStatements--;
+}
+
+void PreparedStatementCache::evictLeastRecentlyUsed() {
+    auto victim = statements.end();
+    for (auto it = statements.begin(); it != statements.end(); ++it) {
+        if (victim == statements.end() || it->second.lastUsed < victim->second.lastUsed) {
+            victim = it;
+        }
+    }
+    if (victim == statements.end()) {
+        return;
+    }
+    mysql_stmt_close(victim->second.stmt);
+    statements.erase(victim);
+    if (counters) {
+        counters->evictions++;
+        counters->cachedStatements--;
+    }
+}
+
+void PreparedStatementCache::clear() {
+    for (auto& entry : statements) {
+        mysql_stmt_close(entry.second.stmt);
+    }
+    if (counters) counters->cachedStatements -= statements.size();
+    statements.clear();
+}
+
+// ================== BoundStatement ==================
+
+BoundStatement::BoundStatement(MYSQL_STMT* stmt)
+        : stmt(stmt), executed(false), needsRebind(false) {
+}
+
+BoundStatement::~BoundStatement() {
+    if (stmt && executed) {
+        // 释放客户端缓存的结果集，语句句柄留在缓存中复用
+        mysql_stmt_free_result(stmt);
+    }
+}
+
+BoundStatement& BoundStatement::bind(int value) {
+    return bind(static_cast<long long>(value));
+}
+
+BoundStatement& BoundStatement::bind(long long value) {
+    Param param{};
+    param.type = MYSQL_TYPE_LONGLONG;
+    param.intValue = value;
+    params.push_back(std::move(param));
+    return *this;
+}
+
+BoundStatement& BoundStatement::bind(size_t value) {
+    return bind(static_cast<long long>(value));
+}
+
+BoundStatement& BoundStatement::bind(const std::string& value) {
+    Param param{};
+    param.type = MYSQL_TYPE_STRING;
+    param.stringValue = value;
+    params.push_back(std::move(param));
+    return *this;
+}
+
+BoundStatement& BoundStatement::bindNull() {
+    Param param{};
+    param.type = MYSQL_TYPE_NULL;
+    param.isNull = 1;
+    params.push_back(std::move(param));
+    return *this;
+}
+
+bool BoundStatement::execute() {
+    if (!stmt) {
+        return false;
+    }
+
+    // 参数全部加入后再取地址，避免 vector 扩容导致指针失效
+    paramBinds.assign(params.size(), MYSQL_BIND());
+    for (size_t i = 0; i < params.size(); ++i) {
+        Param& param = params[i];
+        MYSQL_BIND& b = paramBinds[i];
+        std::memset(&b, 0, sizeof(b));
+        b.buffer_type = param.type;
+        b.is_null = &param.isNull;
+        if (param.type == MYSQL_TYPE_LONGLONG) {
+            b.buffer = &param.intValue;
+        } else if (param.type == MYSQL_TYPE_STRING) {
+            param.length = static_cast<unsigned long>(param.stringValue.length());
+            b.buffer = const_cast<char*>(param.stringValue.data());
+            b.buffer_length = param.length;
+            b.length = &param.length;
+        }
+    }
+
+    if (!paramBinds.empty() && mysql_stmt_bind_param(stmt, paramBinds.data()) != 0) {
+        return false;
+    }
+    QueryTimer* timer = QueryTimer::current();
+    if (timer) {
+        // 留给慢查询 EXPLAIN 使用
+        std::vector<QueryParameter> values(params.size());
+        for (size_t i = 0; i < params.size(); ++i) {
+            if (params[i].isNull) {
+                continue;
+            }
+            if (params[i].type == MYSQL_TYPE_LONGLONG) {
+                values[i].kind = QueryParameter::Kind::Integer;
+                values[i].intValue = params[i].intValue;
+            } else {
+                values[i].kind = QueryParameter::Kind::Text;
+                values[i].text = params[i].stringValue;
+            }
+        }
+        timer->setParameters(std::move(values));
+    }
+
+    if (mysql_stmt_execute(stmt) != 0) {
+        return false;
+    }
+    executed = true;
+
+    if (mysql_stmt_field_count(stmt) == 0) {
+        if (timer) {
+            timer->addAffected(mysql_stmt_affected_rows(stmt));
+        }
+        return true;
+    }
+    if (!bindResults()) {
+        return false;
+    }
+    return mysql_stmt_store_result(stmt) == 0;
+}
+
+bool BoundStatement::bindResults() {
+    MYSQL_RES* meta = mysql_stmt_result_metadata(stmt);
+    if (!meta) {
+        return false;
+    }
+
+    unsigned int fieldCount = mysql_num_fields(meta);
+    MYSQL_FIELD* fields = mysql_fetch_fields(meta);
+
+    columns.assign(fieldCount, Column());
+    resultBinds.assign(fieldCount, MYSQL_BIND());
+    for (unsigned int i = 0; i < fieldCount; ++i) {
+        Column& column = columns[i];
+        MYSQL_BIND& b = resultBinds[i];
+        std::memset(&b, 0, sizeof(b));
+        enum_field_types fieldType = static_cast<enum_field_types>(fields[i].type);
+
+        if (isIntegerType(fieldType)) {
+            column.type = MYSQL_TYPE_LONGLONG;
+            b.buffer_type = MYSQL_TYPE_LONGLONG;
+            b.buffer = &column.intValue;
+        } else if (isTemporalType(fieldType)) {
+            column.type = MYSQL_TYPE_DATETIME;
+            b.buffer_type = MYSQL_TYPE_DATETIME;
+            b.buffer = &column.timeValue;
+        } else {
+            column.type = MYSQL_TYPE_STRING;
+            column.buffer.resize(INITIAL_STRING_BUFFER);
+            b.buffer_type = MYSQL_TYPE_STRING;
+            b.buffer = column.buffer.data();
+            b.buffer_length = static_cast<unsigned long>(column.buffer.size());
+        }
+        b.length = &column.length;
+        b.is_null = &column.isNull;
+        b.error = &column.error;
+    }
+    mysql_free_result(meta);
+
+    return mysql_stmt_bind_result(stmt, resultBinds.data()) == 0;
+}
+
+bool BoundStatement::fetch() {
+    if (!executed || columns.empty()) {
+        return false;
+    }
+
+    if (needsRebind) {
+        mysql_stmt_bind_result(stmt, resultBinds.data());
+        needsRebind = false;
+    }
+
+    int rc = mysql_stmt_fetch(stmt);
+    if (rc == MYSQL_NO_DATA || rc == 1) {
+        return false;
+    }
+
+    if (rc == MYSQL_DATA_TRUNCATED) {
+        // 字符串列超出缓冲区：扩容后单独重新读取该列
+        for (size_t i = 0; i < columns.size(); ++i) {
+            Column& column = columns[i];
+            if (column.type != MYSQL_TYPE_STRING || column.isNull || column.length <= column.buffer.size()) {
+                continue;
+            }
+            column.buffer.resize(column.length);
+            resultBinds[i].buffer = column.buffer.data();
+            resultBinds[i].buffer_length = static_cast<unsigned long>(column.buffer.size());
+            mysql_stmt_fetch_column(stmt, &resultBinds[i], static_cast<unsigned int>(i), 0);
+            needsRebind = true;
+        }
+    }
+
+    if (QueryTimer* timer = QueryTimer::current()) {
+        size_t bytes = 0;
+        for (const Column& column : columns) {
+            if (!column.isNull) {
+                bytes += column.length;
+            }
+        }
+        timer->addRow(bytes);
+    }
+    return true;
+}
+
+bool BoundStatement::isNull(size_t index) const {
+    return index >= columns.size() || columns[index].isNull;
+}
+
+int BoundStatement::getInt(size_t index) const {
+    return static_cast<int>(getInt64(index));
+}
+
+long long BoundStatement::getInt64(size_t index) const {
+    if (isNull(index)) {
+        return 0;
+    }
+    const Column& column = columns[index];
+    if (column.type == MYSQL_TYPE_LONGLONG) {
+        return column.intValue;
+    }
+    if (column.type == MYSQL_TYPE_STRING) {
+        // DECIMAL 等按字符串返回的数值列
+        return std::strtoll(getString(index).c_str(), nullptr, 10);
+    }
+    return 0;
+}
+
+std::string BoundStatement::getString(size_t index) const {
+    if (isNull(index)) {
+        return "";
+    }
+    const Column& column = columns[index];
+    if (column.type == MYSQL_TYPE_LONGLONG) {
+        return std::to_string(column.intValue);
+    }
+    if (column.type == MYSQL_TYPE_DATETIME) {
+        // 直接按服务端返回的字段格式化，不经过本地时区换算（可原样作为参数回传）
+        const MYSQL_TIME& t = column.timeValue;
+        char text[32];
+        std::snprintf(text, sizeof(text), "%04u-%02u-%02u %02u:%02u:%02u",
+                      t.year, t.month, t.day, t.hour, t.minute, t.second);
+        return text;
+    }
+    size_t length = std::min(static_cast<size_t>(column.length), column.buffer.size());
+    return std::string(column.buffer.data(), length);
+}
+
+std::chrono::system_clock::time_point BoundStatement::getTimestamp(size_t index) const {
+    if (isNull(index) || columns[index].type != MYSQL_TYPE_DATETIME) {
+        return std::chrono::system_clock::time_point();
+    }
+    const MYSQL_TIME& t = columns[index].timeValue;
+    if (t.month == 0 || t.day == 0) {
+        // 零日期 0000-00-00
+        return std::chrono::system_clock::time_point();
+    }
+    return localDateTimeToTimePoint(static_cast<int>(t.year), t.month, t.day, t.hour, t.minute, t.second);
+}
+
+uint64_t BoundStatement::insertId() const {
+    return stmt ? mysql_stmt_insert_id(stmt) : 0;
+}
+
+uint64_t BoundStatement::affectedRows() const {
+    return stmt ? mysql_stmt_affected_rows(stmt) : 0;
+}
+
+unsigned int BoundStatement::errorCode() const {
+    return stmt ? mysql_stmt_errno(stmt) : 0;
+}
+
+std::string BoundStatement::error() const {
+    return stmt ? std::string(mysql_stmt_error(stmt)) : std::string("预处理语句不可用");
+}
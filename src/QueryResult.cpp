@@ -0,0 +1,118 @@
+#include "QueryResult.h"
+
+QueryResult::QueryResult() : rows(0), affected(0), lastInsertId(0) {
+}
+
+void QueryResult::setColumns(std::vector<std::string> names) {
+    columnNames = std::move(names);
+    columnIndex.clear();
+    for (size_t i = 0; i < columnNames.size(); ++i) {
+        columnIndex.emplace(columnNames[i], i);
+    }
+    buffer.clear();
+    nulls.clear();
+    offsets.assign(1, 0);
+    rows = 0;
+}
+
+void QueryResult::reserve(size_t rowCount) {
+    size_t cells = rowCount * columnNames.size();
+    offsets.reserve(offsets.size() + cells);
+    nulls.reserve(nulls.size() + cells);
+}
+
+void QueryResult::appendRow(const char* const* values, const unsigned long* lengths) {
+    for (size_t i = 0; i < columnNames.size(); ++i) {
+        if (values[i]) {
+            buffer.append(values[i], lengths[i]);
+        }
+        nulls.push_back(values[i] == nullptr);
+        offsets.push_back(buffer.size());
+    }
+    rows++;
+}
+
+void QueryResult::appendCell(const char* data, size_t length) {
+    if (columnNames.empty()) {
+        return;
+    }
+    if (data) {
+        buffer.append(data, length);
+    }
+    nulls.push_back(data == nullptr);
+    offsets.push_back(buffer.size());
+    if (nulls.size() % columnNames.size() == 0) {
+        rows++;
+    }
+}
+
+void QueryResult::setModification(uint64_t affectedRows, uint64_t insertId) {
+    affected = affectedRows;
+    lastInsertId = insertId;
+}
+
+int QueryResult::findColumn(const std::string& name) const {
+    auto it = columnIndex.find(name);
+    return it == columnIndex.end() ? -1 : static_cast<int>(it->second);
+}
+
+bool QueryResult::Row::isNull(size_t column) const {
+    if (column >= result->columnNames.size()) {
+        return true;
+    }
+    return result->nulls[row * result->columnNames.size() + column];
+}
+
+bool QueryResult::Row::isNull(const std::string& column) const {
+    int index = result->findColumn(column);
+    return index < 0 || isNull(static_cast<size_t>(index));
+}
+
+std::string_view QueryResult::Row::getView(size_t column) const {
+    if (isNull(column)) {
+        return std::string_view();
+    }
+    size_t cell = row * result->columnNames.size() + column;
+    size_t begin = result->offsets[cell];
+    return std::string_view(result->buffer.data() + begin, result->offsets[cell + 1] - begin);
+}
+
+std::string_view QueryResult::Row::getView(const std::string& column) const {
+    int index = result->findColumn(column);
+    return index < 0 ? std::string_view() : getView(static_cast<size_t>(index));
+}
+
+std::string QueryResult::Row::getString(size_t column) const {
+    std::string_view value = getView(column);
+    return std::string(value.data(), value.size());
+}
+
+std::string QueryResult::Row::getString(const std::string& column) const {
+    std::string_view value = getView(column);
+    return std::string(value.data(), value.size());
+}
+
+int QueryResult::Row::getInt(size_t column, int defaultValue) const {
+    return parseNumber<int>(getView(column), defaultValue);
+}
+
+int QueryResult::Row::getInt(const std::string& column, int defaultValue) const {
+    return parseNumber<int>(getView(column), defaultValue);
+}
+
+long long QueryResult::Row::getInt64(size_t column, long long defaultValue) const {
+    return parseNumber<long long>(getView(column), defaultValue);
+}
+
+long long QueryResult::Row::getInt64(const std::string& column, long long defaultValue) const {
+    return parseNumber<long long>(getView(column), defaultValue);
+}
+
+std::chrono::system_clock::time_point QueryResult::Row::getTimestamp(const std::string& column,
+                                                                     std::chrono::system_clock::time_point fallback) const {
+    std::chrono::system_clock::time_point value;
+    if (isNull(column) || !parseDateTime(getView(column), value)) {
+        return fallback;
+    }
+    return value;
+}
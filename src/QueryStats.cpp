@@ -0,0 +1,330 @@
+#include "QueryStats.h"
+#include "Logger.h"
+#include <cctype>
+
+namespace {
+    // 当前线程最内层的活动计时器
+    thread_local QueryTimer* activeTimer = nullptr;
+
+    // lastExplained 超过该条目数时整体清空，避免拼接SQL的语句文本无限增长
+    const size_t MAX_EXPLAIN_KEYS = 1024;
+
+    bool isIdentifierChar(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return std::isalnum(u) || c == '_' || c == '$' || c == '@' || u >= 0x80;
+    }
+
+    void updateMax(std::atomic<uint64_t>& target, uint64_t value) {
+        uint64_t previous = target.load();
+        while (value > previous && !target.compare_exchange_weak(previous, value)) {
+        }
+    }
+}
+
+// ================== LatencyHistogram ==================
+
+size_t LatencyHistogram::bucketIndex(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    size_t msb = 0;
+    while ((micros >> (msb + 1)) != 0) {
+        msb++;
+    }
+    size_t index = (msb - 2) * SUB_BUCKETS + static_cast<size_t>((micros >> (msb - 3)) & (SUB_BUCKETS - 1));
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = index / SUB_BUCKETS - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    buckets[bucketIndex(micros)]++;
+    samples++;
+    totalMicros += micros;
+    updateMax(maxMicros, micros);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t total = samples.load();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(q * static_cast<double>(total) + 0.999999);
+    target = std::max<uint64_t>(1, std::min(target, total));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load();
+        if (seen >= target) {
+            // 桶上界可能超过实际最大值，取两者较小者
+            return std::min(bucketUpperBound(i), maxMicros.load());
+        }
+    }
+    return maxMicros.load();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket = 0;
+    }
+    samples = 0;
+    totalMicros = 0;
+    maxMicros = 0;
+}
+
+// ================== redactSqlLiterals ==================
+
+std::string redactSqlLiterals(const std::string& sql, size_t maxLength) {
+    std::string out;
+    out.reserve(std::min(sql.size(), maxLength) + 3);
+
+    size_t i = 0;
+    const size_t n = sql.size();
+    while (i < n && out.size() < maxLength) {
+        char c = sql[i];
+        if (c == '\'' || c == '"') {
+            // 字符串字面量：支持反斜杠转义和连续两个引号
+            size_t j = i + 1;
+            while (j < n) {
+                if (sql[j] == '\\') {
+                    j += 2;
+                    continue;
+                }
+                if (sql[j] == c) {
+                    if (j + 1 < n && sql[j + 1] == c) {
+                        j += 2;
+                        continue;
+                    }
+                    break;
+                }
+                j++;
+            }
+            out += '?';
+            i = std::min(n, j + 1);
+        } else if (c == '`') {
+            // 反引号包围的是标识符，原样保留
+            size_t close = sql.find('`', i + 1);
+            size_t end = close == std::string::npos ? n : close + 1;
+            out.append(sql, i, end - i);
+            i = end;
+        } else if (std::isdigit(static_cast<unsigned char>(c))) {
+            // 标识符整体复制，走到这里的数字一定位于词首：整数、小数、0x 十六进制
+            size_t j = i;
+            while (j < n && (isIdentifierChar(sql[j]) || sql[j] == '.')) {
+                j++;
+            }
+            out += '?';
+            i = j;
+        } else if (isIdentifierChar(c)) {
+            size_t j = i;
+            while (j < n && isIdentifierChar(sql[j])) {
+                j++;
+            }
+            out.append(sql, i, j - i);
+            i = j;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            // 多行SQL压成一行
+            if (!out.empty() && out.back() != ' ') {
+                out += ' ';
+            }
+            i++;
+        } else {
+            out += c;
+            i++;
+        }
+    }
+    while (!out.empty() && out.back() == ' ') {
+        out.pop_back();
+    }
+    if (i < n) {
+        out += "...";
+    }
+    return out;
+}
+
+// ================== QueryStatsRegistry ==================
+
+void QueryStatsRegistry::configure(const QueryProfilingOptions& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+    slowQueryMs = options.slowQueryMs;
+    while (slowLog.size() > options.slowLogSize) {
+        slowLog.pop_back();
+    }
+}
+
+QueryProfilingOptions QueryStatsRegistry::getOptions() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return options;
+}
+
+void QueryStatsRegistry::setExplainer(Explainer newExplainer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    explainer = std::move(newExplainer);
+}
+
+QueryStatsRegistry::MethodEntry& QueryStatsRegistry::entry(const char* method) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = methods[method];
+    if (!slot) {
+        slot = std::make_unique<MethodEntry>();
+    }
+    return *slot;
+}
+
+std::vector<QueryMethodStats> QueryStatsRegistry::snapshot() const {
+    std::vector<QueryMethodStats> result;
+    std::lock_guard<std::mutex> lock(mutex);
+    result.reserve(methods.size());
+    for (const auto& item : methods) {
+        const MethodEntry& entry = *item.second;
+        QueryMethodStats stats;
+        stats.method = item.first;
+        stats.calls = entry.latency.count();
+        if (stats.calls == 0) {
+            continue;
+        }
+        stats.errors = entry.errors;
+        stats.rowsRead = entry.rowsRead;
+        stats.rowsAffected = entry.rowsAffected;
+        stats.bytesRead = entry.bytesRead;
+        stats.p50Micros = entry.latency.percentile(0.5);
+        stats.p99Micros = entry.latency.percentile(0.99);
+        stats.maxMicros = entry.latency.max();
+        stats.totalMicros = entry.latency.total();
+        result.push_back(stats);
+    }
+    // 累计耗时最多的方法排在前面，调优从这里开始
+    std::sort(result.begin(), result.end(), [](const QueryMethodStats& a, const QueryMethodStats& b) {
+        return a.totalMicros > b.totalMicros;
+    });
+    return result;
+}
+
+std::vector<SlowQueryRecord> QueryStatsRegistry::slowQueries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::vector<SlowQueryRecord>(slowLog.begin(), slowLog.end());
+}
+
+void QueryStatsRegistry::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& item : methods) {
+        MethodEntry& entry = *item.second;
+        entry.latency.reset();
+        entry.errors = 0;
+        entry.rowsRead = 0;
+        entry.rowsAffected = 0;
+        entry.bytesRead = 0;
+    }
+    slowLog.clear();
+    lastExplained.clear();
+}
+
+void QueryStatsRegistry::reportSlow(const char* method, uint64_t micros, uint64_t rows,
+                                    const std::string& sql, const std::vector<QueryParameter>& params) {
+    SlowQueryRecord record;
+    record.time = std::chrono::system_clock::now();
+    record.method = method;
+    record.micros = micros;
+    record.rows = rows;
+    record.statement = redactSqlLiterals(sql);
+
+    // 同一条语句限频 EXPLAIN：数据库整体变慢时不要让每个慢调用再多打一次往返
+    Explainer explain;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (options.explainSlowQueries && explainer && !sql.empty()) {
+            auto now = std::chrono::steady_clock::now();
+            if (lastExplained.size() > MAX_EXPLAIN_KEYS) {
+                lastExplained.clear();
+            }
+            auto it = lastExplained.find(record.statement);
+            if (it == lastExplained.end() || now - it->second >= std::chrono::seconds(options.explainIntervalSeconds)) {
+                lastExplained[record.statement] = now;
+                explain = explainer;
+            }
+        }
+    }
+    if (explain) {
+        record.plan = explain(sql, params);
+    }
+
+    LOG_WARNING("慢查询 " + record.method + " 耗时 " + std::to_string(micros / 1000) + "ms, " +
+                std::to_string(rows) + " 行: " + (record.statement.empty() ? "(无语句)" : record.statement) +
+                (record.plan.empty() ? "" : "\n" + record.plan));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    slowLog.push_front(std::move(record));
+    while (slowLog.size() > options.slowLogSize) {
+        slowLog.pop_back();
+    }
+}
+
+// ================== QueryTimer ==================
+
+QueryTimer::QueryTimer(QueryStatsRegistry& registry, const char* method)
+        : registry(registry), method(method), previous(activeTimer), startTime(std::chrono::steady_clock::now()),
+          rowsRead(0), rowsAffected(0), bytesRead(0), errors(0) {
+    activeTimer = this;
+}
+
+QueryTimer::~QueryTimer() {
+    // 先恢复外层计时器：下面的 EXPLAIN 不应记到任何方法上
+    activeTimer = previous;
+
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime).count());
+    try {
+        QueryStatsRegistry::MethodEntry& entry = registry.entry(method);
+        entry.latency.record(micros);
+        entry.errors += errors;
+        entry.rowsRead += rowsRead;
+        entry.rowsAffected += rowsAffected;
+        entry.bytesRead += bytesRead;
+
+        int slowQueryMs = registry.slowQueryMs.load();
+        if (slowQueryMs > 0 && micros >= static_cast<uint64_t>(slowQueryMs) * 1000) {
+            registry.reportSlow(method, micros, rowsRead + rowsAffected, lastSql, lastParams);
+        }
+    } catch (const std::exception& e) {
+        LOG_WARNING("记录查询统计失败: " + std::string(e.what()));
+    }
+}
+
+QueryTimer* QueryTimer::current() {
+    return activeTimer;
+}
+
+void QueryTimer::noteStatement(const std::string& sql) {
+    lastSql = sql;
+    lastParams.clear();
+}
+
+void QueryTimer::setParameters(std::vector<QueryParameter> params) {
+    lastParams = std::move(params);
+}
+
+void QueryTimer::addRow(size_t bytes) {
+    rowsRead++;
+    bytesRead += bytes;
+}
+
+void QueryTimer::addRows(uint64_t rows, uint64_t bytes) {
+    rowsRead += rows;
+    bytesRead += bytes;
+}
+
+void QueryTimer::addAffected(uint64_t rows) {
+    rowsAffected += rows;
+}
+
+void QueryTimer::markFailed() {
+    errors++;
+}
@@ -0,0 +1,481 @@
+#include "RedisAsyncClient.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+namespace {
+    // 每次 recv 至少准备的空间；回复较大时解析器会自行扩容
+    const size_t READ_CHUNK = 16 * 1024;
+    // 有请求在等待回复时事件循环的最长睡眠时间，用于检查响应超时
+    const int TIMEOUT_CHECK_MS = 100;
+
+    int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    RespReply errorReply(std::string_view text) {
+        RespReply reply;
+        reply.type = RespType::Error;
+        reply.text = text;
+        return reply;
+    }
+
+    // 回调抛出的异常不能打断事件循环
+    void invokeHandler(RedisAsyncClient::ReplyHandler& handler, const RespReply& reply, bool ok) {
+        try {
+            handler(reply, ok);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Redis异步回调抛出异常: " + std::string(e.what()));
+        } catch (...) {
+            LOG_ERROR("Redis异步回调抛出未知异常");
+        }
+    }
+}
+
+RedisAsyncClient::RedisAsyncClient(const std::string& host, int port, const std::string& password, int database,
+                                   int timeoutMs, const RedisAsyncOptions& options)
+        : host(host), port(port), password(password), database(database), timeoutMs(timeoutMs),
+          options(options), wakeRequested(false), stopping(false),
+          connected(false), reconnectAtMs(0), inFlightCount(0), submittedCount(0),
+          completedCount(0), failedCount(0), reconnectCount(0),
+          sendOffset(0), lastActivity(std::chrono::steady_clock::now()),
+          backoffMs(options.backoffInitialMs), everConnected(false)
+#ifdef __linux__
+          , epollFd(-1), wakeFd(-1), writeWatched(false)
+#endif
+{
+}
+
+RedisAsyncClient::~RedisAsyncClient() {
+    shutdown();
+#ifdef __linux__
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+    }
+#endif
+}
+
+bool RedisAsyncClient::start() {
+#ifdef __linux__
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        LOG_ERROR("Redis异步客户端创建 epoll/eventfd 失败: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+#endif
+
+    // 事件循环线程尚未启动，在调用线程上建立第一条连接，失败时直接报告给调用方
+    if (!ensureConnected()) {
+        return false;
+    }
+    loopThread = std::thread(&RedisAsyncClient::run, this);
+    LOG_INFO("Redis异步客户端已启动");
+    return true;
+}
+
+void RedisAsyncClient::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    if (loopThread.joinable()) {
+        wake();
+        loopThread.join();
+    }
+    connection.close();
+    connected = false;
+}
+
+void RedisAsyncClient::submit(std::initializer_list<std::string_view> args, ReplyHandler handler) {
+    const char* rejectReason = nullptr;
+    bool needWake = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopping || !loopThread.joinable()) {
+            rejectReason = "Redis异步客户端未启动或已关闭";
+        } else if (inFlightCount >= static_cast<uint64_t>(options.maxPending)) {
+            rejectReason = "Redis异步请求队列已满";
+        } else if (!connected && nowMs() < reconnectAtMs) {
+            // 断线后的退避期内直接失败，不让请求堆积在队列里等重连
+            rejectReason = "Redis异步连接已断开，等待重连";
+        } else {
+            appendRespCommand(outgoing, args);
+            queued.push_back(std::move(handler));
+            inFlightCount++;
+            submittedCount++;
+            needWake = !wakeRequested;
+            wakeRequested = true;
+        }
+    }
+
+    if (rejectReason) {
+        failedCount++;
+        invokeHandler(handler, errorReply(rejectReason), false);
+        return;
+    }
+    if (needWake) {
+        wake();
+    }
+}
+
+RedisAsyncStats RedisAsyncClient::getStats() const {
+    RedisAsyncStats stats;
+    stats.connected = connected;
+    stats.inFlight = inFlightCount;
+    stats.submitted = submittedCount;
+    stats.completed = completedCount;
+    stats.failed = failedCount;
+    stats.reconnects = reconnectCount;
+    return stats;
+}
+
+void RedisAsyncClient::wake() {
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;  // 计数器溢出（EAGAIN）时事件循环已经处于可读状态，无需处理
+#else
+    queueCondition.notify_one();
+#endif
+}
+
+// 取走提交队列：命令并入发送缓冲区，回调移入等待回复的队列，二者顺序保持一致
+bool RedisAsyncClient::drainQueue() {
+    bool wasIdle = inflight.empty();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        wakeRequested = false;
+        if (stopping) {
+            return true;
+        }
+        if (queued.empty()) {
+            return false;
+        }
+        if (sending.empty()) {
+            // 交换而不是拷贝，两块缓冲区轮流复用
+            sending.swap(outgoing);
+            sendOffset = 0;
+        } else {
+            // 上一批还没写完（发送缓冲区满），先丢掉已发出的部分再追加
+            sending.erase(0, sendOffset);
+            sendOffset = 0;
+            sending.append(outgoing);
+            outgoing.clear();
+        }
+        for (auto& handler : queued) {
+            inflight.push_back(std::move(handler));
+        }
+        queued.clear();
+    }
+
+    if (!ensureConnected()) {
+        sending.clear();
+        sendOffset = 0;
+        failAll(inflight, "Redis异步连接已断开，等待重连");
+        return false;
+    }
+    if (wasIdle) {
+        // 从空闲转为有请求在等待，响应超时从现在开始计算
+        lastActivity = std::chrono::steady_clock::now();
+    }
+    return false;
+}
+
+// 连接未建立时尝试建立；断线后的退避期内直接返回false。建连本身是阻塞的，最长 timeoutMs
+bool RedisAsyncClient::ensureConnected() {
+    if (connection.isOpen()) {
+        return true;
+    }
+    if (nowMs() < reconnectAtMs) {
+        return false;
+    }
+
+    std::string error;
+    if (!connection.open(host, port, password, database, timeoutMs, error)) {
+        LOG_WARNING("Redis异步连接失败: " + error + "，" + std::to_string(backoffMs) + "ms 后重试");
+        reconnectAtMs = nowMs() + backoffMs;
+        backoffMs = std::min(backoffMs * 2, options.backoffMaxMs);
+        return false;
+    }
+
+#ifdef __linux__
+    // 握手完成后改为非阻塞，此后收发都由事件循环驱动
+    int fd = connection.nativeHandle();
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    writeWatched = false;
+#endif
+
+    parser.reset();
+    if (everConnected) {
+        reconnectCount++;
+        LOG_INFO("Redis异步连接已恢复");
+    }
+    everConnected = true;
+    backoffMs = options.backoffInitialMs;
+    connected = true;
+    lastActivity = std::chrono::steady_clock::now();
+    return true;
+}
+
+// 连接中断：已发出的请求结果未知，全部以失败结束；退避一段时间后由下一次提交触发重连
+void RedisAsyncClient::connectionLost(const std::string& reason) {
+    LOG_WARNING("Redis异步连接中断: " + reason + "，" + std::to_string(inflight.size()) + " 个请求失败");
+#ifdef __linux__
+    if (connection.isOpen()) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.nativeHandle(), nullptr);
+    }
+    writeWatched = false;
+#endif
+    connection.close();
+    parser.reset();
+    sending.clear();
+    sendOffset = 0;
+    connected = false;
+    reconnectAtMs = nowMs() + backoffMs;
+    backoffMs = std::min(backoffMs * 2, options.backoffMaxMs);
+    failAll(inflight, reason);
+}
+
+void RedisAsyncClient::complete(ReplyHandler& handler, const RespReply& reply, bool ok) {
+    invokeHandler(handler, reply, ok);
+    if (ok) {
+        completedCount++;
+    } else {
+        failedCount++;
+    }
+    inFlightCount--;
+}
+
+void RedisAsyncClient::failAll(std::deque<ReplyHandler>& handlers, const std::string& reason) {
+    // 先整体取出：回调里可能再次提交命令
+    std::deque<ReplyHandler> failing;
+    failing.swap(handlers);
+    RespReply reply = errorReply(reason);
+    for (auto& handler : failing) {
+        complete(handler, reply, false);
+    }
+}
+
+#ifdef __linux__
+
+void RedisAsyncClient::run() {
+    epoll_event events[16];
+    while (true) {
+        int waitMs = inflight.empty() ? -1 : TIMEOUT_CHECK_MS;
+        int count = epoll_wait(epollFd, events, 16, waitMs);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Redis异步事件循环 epoll_wait 失败: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        bool stop = false;
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.fd == wakeFd) {
+                uint64_t value;
+                ssize_t readBytes = ::read(wakeFd, &value, sizeof(value));
+                (void)readBytes;
+                stop = drainQueue();
+                if (!stop && connection.isOpen()) {
+                    flush();
+                }
+                continue;
+            }
+            // 同一批事件中连接可能已经断开并关闭
+            if (!connection.isOpen() || events[i].data.fd != connection.nativeHandle()) {
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !readAvailable()) {
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && connection.isOpen()) {
+                flush();
+            }
+        }
+        if (stop) {
+            break;
+        }
+
+        if (connection.isOpen() && !inflight.empty() &&
+            std::chrono::steady_clock::now() - lastActivity > std::chrono::milliseconds(timeoutMs)) {
+            connectionLost("Redis响应超时");
+        }
+    }
+
+    // 退出前让所有未完成的请求得到回调
+    std::deque<ReplyHandler> remaining;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        outgoing.clear();
+        remaining.swap(queued);
+    }
+    failAll(inflight, "Redis异步客户端已关闭");
+    failAll(remaining, "Redis异步客户端已关闭");
+}
+
+// 尽量写出发送缓冲区；内核缓冲区满时关注 EPOLLOUT，可写后继续
+bool RedisAsyncClient::flush() {
+    int fd = connection.nativeHandle();
+    while (sendOffset < sending.size()) {
+        ssize_t sent = ::send(fd, sending.data() + sendOffset, sending.size() - sendOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            sendOffset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            watchWrite(true);
+            return true;
+        }
+        connectionLost("Redis发送命令失败: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    sending.clear();
+    sendOffset = 0;
+    watchWrite(false);
+    return true;
+}
+
+// 读出socket中已到达的数据，逐条把回复交给最早发出的请求
+bool RedisAsyncClient::readAvailable() {
+    int fd = connection.nativeHandle();
+    RespReply reply;
+    while (true) {
+        char* dest = parser.prepare(READ_CHUNK);
+        size_t writable = parser.writableSize();
+        ssize_t received = ::recv(fd, dest, writable, 0);
+        if (received == 0) {
+            connectionLost("Redis服务端关闭了连接");
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            connectionLost("Redis接收回复失败: " + std::string(std::strerror(errno)));
+            return false;
+        }
+
+        parser.commit(static_cast<size_t>(received));
+        lastActivity = std::chrono::steady_clock::now();
+
+        // 回复指向接收缓冲区，必须在下一次 prepare 之前交给回调
+        while (true) {
+            RespParser::Status status = parser.next(reply);
+            if (status == RespParser::Status::Incomplete) {
+                break;
+            }
+            if (status == RespParser::Status::ProtocolError) {
+                connectionLost("Redis协议错误: " + parser.error());
+                return false;
+            }
+            if (inflight.empty()) {
+                connectionLost("收到没有对应请求的回复: " + reply.describe());
+                return false;
+            }
+            ReplyHandler handler = std::move(inflight.front());
+            inflight.pop_front();
+            complete(handler, reply, true);
+        }
+
+        // 没有读满说明内核缓冲区已空，省掉一次必然返回 EAGAIN 的 recv
+        if (static_cast<size_t>(received) < writable) {
+            return true;
+        }
+    }
+}
+
+void RedisAsyncClient::watchWrite(bool enable) {
+    if (writeWatched == enable) {
+        return;
+    }
+    epoll_event event{};
+    event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.fd = connection.nativeHandle();
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, event.data.fd, &event);
+    writeWatched = enable;
+}
+
+#else
+
+// 没有 epoll 的平台：每轮取走全部排队的命令，作为一条流水线发出后依次读回
+void RedisAsyncClient::run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !queued.empty(); });
+        }
+        if (drainQueue()) {
+            break;
+        }
+        if (!inflight.empty()) {
+            runBatch();
+        }
+    }
+
+    std::deque<ReplyHandler> remaining;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        outgoing.clear();
+        remaining.swap(queued);
+    }
+    failAll(inflight, "Redis异步客户端已关闭");
+    failAll(remaining, "Redis异步客户端已关闭");
+}
+
+void RedisAsyncClient::runBatch() {
+    std::vector<RedisSendSpan> spans{{sending.data() + sendOffset, sending.size() - sendOffset}};
+    if (!connection.send(spans)) {
+        connectionLost("Redis发送命令失败");
+        return;
+    }
+    sending.clear();
+    sendOffset = 0;
+
+    // 连接带有收发超时（见 RedisConnection::open），服务端无响应时 readReply 会失败返回
+    RespReply reply;
+    while (!inflight.empty()) {
+        if (!connection.readReply(reply)) {
+            connectionLost("Redis接收回复失败: " + reply.toString());
+            return;
+        }
+        ReplyHandler handler = std::move(inflight.front());
+        inflight.pop_front();
+        complete(handler, reply, true);
+    }
+}
+
+#endif
@@ -0,0 +1,624 @@
+#include "RedisConnectionPool.h"
+#include "Logger.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <climits>
+#endif
+
+namespace {
+#ifdef _WIN32
+    const size_t MAX_SEND_BUFFERS = 1024;
+#elif defined(IOV_MAX)
+    const size_t MAX_SEND_BUFFERS = IOV_MAX;
+#else
+    const size_t MAX_SEND_BUFFERS = 1024;
+#endif
+
+    void closeSocket(int sockfd) {
+#ifdef _WIN32
+        closesocket(sockfd);
+#else
+        ::close(sockfd);
+#endif
+    }
+
+    void setErrorReply(RespReply& reply, std::string_view text) {
+        reply = RespReply();
+        reply.type = RespType::Error;
+        reply.text = text;
+    }
+}
+
+// ================== RedisConnection ==================
+
+RedisConnection::RedisConnection() : sockfd(-1), requestWritten(false), lastUsed(std::chrono::steady_clock::now()) {
+}
+
+RedisConnection::~RedisConnection() {
+    close();
+}
+
+// 建立Socket连接，并进行认证和数据库选择
+bool RedisConnection::open(const std::string& host, int port, const std::string& password, int database,
+                           int timeoutMs, std::string& error) {
+    close();
+
+    // 创建socket
+    sockfd = static_cast<int>(socket(AF_INET, SOCK_STREAM, 0));
+    if (sockfd < 0) {
+        sockfd = -1;
+        error = "无法创建socket";
+        return false;
+    }
+
+    // 设置为非阻塞模式，便于后续select超时处理
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(sockfd, FIONBIO, &mode);
+#else
+    int flags = fcntl(sockfd, F_GETFL, 0);
+    fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
+#endif
+
+    // 配置服务器地址结构体
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = inet_addr(host.c_str());
+
+    // 发起连接请求
+    int result = ::connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr));
+    if (result < 0) {
+#ifdef _WIN32
+        // Windows下判断是否为非阻塞连接中的正常情况
+        bool pending = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        // Linux下判断是否为非阻塞连接中的正常情况
+        bool pending = errno == EINPROGRESS;
+#endif
+        if (!pending) {
+            close();
+            error = "连接 " + host + ":" + std::to_string(port) + " 失败";
+            return false;
+        }
+    }
+
+    // 使用select等待连接完成，超时则失败
+    fd_set write_fds;
+    FD_ZERO(&write_fds);
+    FD_SET(sockfd, &write_fds);
+
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+
+    result = select(sockfd + 1, nullptr, &write_fds, nullptr, &tv);
+    if (result <= 0) {
+        close();
+        error = "连接 " + host + ":" + std::to_string(port) + " 超时";
+        return false;
+    }
+
+    // 可写只说明连接过程结束，是否成功要看 SO_ERROR（如连接被拒绝）
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+    getsockopt(sockfd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &length);
+    if (socketError != 0) {
+        close();
+        error = "连接 " + host + ":" + std::to_string(port) + " 失败";
+        return false;
+    }
+
+    // 连接成功后恢复为阻塞模式
+#ifdef _WIN32
+    mode = 0;
+    ioctlsocket(sockfd, FIONBIO, &mode);
+#else
+    flags = fcntl(sockfd, F_GETFL, 0);
+    fcntl(sockfd, F_SETFL, flags & ~O_NONBLOCK);
+#endif
+
+    // 收发同样受超时限制：服务器无响应时命令在 timeoutMs 后失败，而不是一直阻塞
+#ifdef _WIN32
+    DWORD ioTimeout = static_cast<DWORD>(timeoutMs);
+#else
+    struct timeval ioTimeout;
+    ioTimeout.tv_sec = timeoutMs / 1000;
+    ioTimeout.tv_usec = (timeoutMs % 1000) * 1000;
+#endif
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&ioTimeout), sizeof(ioTimeout));
+    setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&ioTimeout), sizeof(ioTimeout));
+
+    parser.reset();
+    lastUsed = std::chrono::steady_clock::now();
+    RespReply reply;
+
+    // 如果设置了密码，进行AUTH认证
+    if (!password.empty()) {
+        if (!command({"AUTH", password}, reply) || !reply.isStatus("OK")) {
+            error = "Redis认证失败: " + reply.describe();
+            close();
+            return false;
+        }
+    }
+
+    // 如果指定了数据库，进行SELECT切换
+    if (database != 0) {
+        std::string dbStr = std::to_string(database);
+        if (!command({"SELECT", dbStr}, reply) || !reply.isStatus("OK")) {
+            error = "Redis切换数据库失败: " + reply.describe();
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// 关闭Socket
+void RedisConnection::close() {
+    if (sockfd >= 0) {
+        closeSocket(sockfd);
+        sockfd = -1;
+    }
+    // 未读完的回复随连接一起作废，下次连接从干净的缓冲区开始
+    parser.reset();
+}
+
+// 编码并发送命令，读取一条回复
+bool RedisConnection::command(std::initializer_list<std::string_view> args, RespReply& reply) {
+    requestWritten = false;
+    if (!isOpen()) {
+        setErrorReply(reply, "Redis未连接");
+        return false;
+    }
+
+    // 编码缓冲区复用，稳定后不再分配
+    commandBuffer.clear();
+    appendRespCommand(commandBuffer, args);
+
+    std::vector<RedisSendSpan> spans{{commandBuffer.data(), commandBuffer.size()}};
+    if (!send(spans)) {
+        setErrorReply(reply, "Redis发送命令失败");
+        return false;
+    }
+
+    return readReply(reply);
+}
+
+bool RedisConnection::peerClosed() const {
+#ifdef _WIN32
+    WSAPOLLFD pfd{};
+    pfd.fd = static_cast<SOCKET>(sockfd);
+    pfd.events = POLLRDNORM;
+    return WSAPoll(&pfd, 1, 0) != 0;
+#else
+    struct pollfd pfd{};
+    pfd.fd = sockfd;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, 0) != 0;
+#endif
+}
+
+// 一次系统调用发出多段数据，部分发送时从断点继续
+bool RedisConnection::send(std::vector<RedisSendSpan>& spans) {
+    requestWritten = false;
+    if (!isOpen()) {
+        return false;
+    }
+    if (peerClosed()) {
+        LOG_WARNING("Redis连接已被服务器关闭，断开连接");
+        close();
+        return false;
+    }
+
+    size_t index = 0;
+    while (index < spans.size()) {
+        size_t count = std::min(spans.size() - index, MAX_SEND_BUFFERS);
+        size_t sent = 0;
+#ifdef _WIN32
+        std::vector<WSABUF> buffers(count);
+        for (size_t i = 0; i < count; ++i) {
+            buffers[i].buf = const_cast<char*>(spans[index + i].data);
+            buffers[i].len = static_cast<ULONG>(spans[index + i].length);
+        }
+        DWORD written = 0;
+        if (WSASend(sockfd, buffers.data(), static_cast<DWORD>(count), &written, 0, nullptr, nullptr) != 0) {
+            LOG_ERROR("Redis发送命令失败，断开连接");
+            close();
+            return false;
+        }
+        sent = written;
+#else
+        std::vector<struct iovec> buffers(count);
+        for (size_t i = 0; i < count; ++i) {
+            buffers[i].iov_base = const_cast<char*>(spans[index + i].data);
+            buffers[i].iov_len = spans[index + i].length;
+        }
+        ssize_t written = writev(sockfd, buffers.data(), static_cast<int>(count));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            // 命令可能已发出一部分，连接上的回复顺序无法再对应
+            LOG_ERROR("Redis发送命令失败，断开连接");
+            close();
+            return false;
+        }
+        sent = static_cast<size_t>(written);
+#endif
+        requestWritten = true;
+        // 跳过已完整发出的段，最后一段只发出一部分时调整其起点
+        while (sent > 0 && index < spans.size()) {
+            if (sent >= spans[index].length) {
+                sent -= spans[index].length;
+                index++;
+            } else {
+                spans[index].data += sent;
+                spans[index].length -= sent;
+                sent = 0;
+            }
+        }
+    }
+    return true;
+}
+
+// 读取一条完整回复：直接recv进解析器的缓冲区，数据不足时继续接收
+bool RedisConnection::readReply(RespReply& reply) {
+    while (true) {
+        RespParser::Status status = parser.next(reply);
+        if (status == RespParser::Status::Complete) {
+            lastUsed = std::chrono::steady_clock::now();
+            return true;
+        }
+        if (status == RespParser::Status::ProtocolError) {
+            // 无法确定下一条回复从哪里开始，只能丢弃连接
+            LOG_ERROR("Redis协议错误: " + parser.error());
+            close();
+            setErrorReply(reply, "Redis协议错误");
+            return false;
+        }
+        if (!isOpen()) {
+            setErrorReply(reply, "Redis未连接");
+            return false;
+        }
+
+        char* dest = parser.prepare(4096);
+        int received = recv(sockfd, dest, static_cast<int>(parser.writableSize()), 0);
+        if (received <= 0) {
+            // 断开或超时：缓冲区里的残余数据已无法与后续命令对应
+            LOG_ERROR("Redis连接中断或读取超时");
+            close();
+            setErrorReply(reply, "Redis连接中断或读取超时");
+            return false;
+        }
+        parser.commit(static_cast<size_t>(received));
+    }
+}
+
+// ================== PooledRedisConnection ==================
+
+PooledRedisConnection::PooledRedisConnection() : pool(nullptr), conn(nullptr) {
+}
+
+PooledRedisConnection::PooledRedisConnection(RedisConnectionPool* pool, RedisConnection* conn)
+        : pool(pool), conn(conn) {
+}
+
+PooledRedisConnection::~PooledRedisConnection() {
+    release();
+}
+
+PooledRedisConnection::PooledRedisConnection(PooledRedisConnection&& other) noexcept
+        : pool(other.pool), conn(other.conn) {
+    other.pool = nullptr;
+    other.conn = nullptr;
+}
+
+PooledRedisConnection& PooledRedisConnection::operator=(PooledRedisConnection&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        conn = other.conn;
+        other.pool = nullptr;
+        other.conn = nullptr;
+    }
+    return *this;
+}
+
+void PooledRedisConnection::release() {
+    if (conn && pool) {
+        pool->release(conn);
+    }
+    pool = nullptr;
+    conn = nullptr;
+}
+
+// ================== RedisConnectionPool ==================
+
+RedisConnectionPool::RedisConnectionPool(const std::string& host, int port, const std::string& password,
+                                         int database, int connectTimeoutMs, const RedisPoolOptions& options)
+        : host(host), port(port), password(password), database(database), connectTimeoutMs(connectTimeoutMs),
+          options(options), totalConnections(0), shuttingDown(false),
+          checkoutCount(0), waitCount(0), timeoutCount(0), reconnectCount(0), healthCheckFailureCount(0),
+          breakerTripCount(0), rejectedCount(0), failedCommandCount(0),
+          breakerOpen(false), consecutiveFailures(0), jitter(std::random_device()()) {
+    if (this->options.minSize < 0) this->options.minSize = 0;
+    if (this->options.maxSize < 1) this->options.maxSize = 1;
+    if (this->options.minSize > this->options.maxSize) this->options.minSize = this->options.maxSize;
+    if (this->options.breakerThreshold < 1) this->options.breakerThreshold = 1;
+    if (this->options.backoffInitialMs < 1) this->options.backoffInitialMs = 1;
+    if (this->options.backoffMaxMs < this->options.backoffInitialMs) this->options.backoffMaxMs = this->options.backoffInitialMs;
+    backoff = std::chrono::milliseconds(this->options.backoffInitialMs);
+}
+
+RedisConnectionPool::~RedisConnectionPool() {
+    shutdown();
+}
+
+bool RedisConnectionPool::initialize() {
+    int initialSize = std::max(1, options.minSize);
+    for (int i = 0; i < initialSize; ++i) {
+        auto* conn = new RedisConnection();
+        std::string error;
+        if (!conn->open(host, port, password, database, connectTimeoutMs, error)) {
+            delete conn;
+            setLastError(error);
+            if (i == 0) {
+                LOG_ERROR("无法连接到Redis: " + error);
+                return false;
+            }
+            LOG_WARNING("Redis连接池预建连接不足: " + std::to_string(i) + "/" + std::to_string(initialSize));
+            break;
+        }
+        std::lock_guard<std::mutex> lock(poolMutex);
+        idleConnections.push_back(conn);
+        totalConnections++;
+    }
+
+    LOG_INFO("Redis连接池已启动: min=" + std::to_string(options.minSize) +
+             " max=" + std::to_string(options.maxSize));
+    return true;
+}
+
+void RedisConnectionPool::shutdown() {
+    std::deque<RedisConnection*> toClose;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (shuttingDown) {
+            return;
+        }
+        shuttingDown = true;
+        toClose.swap(idleConnections);
+        totalConnections -= static_cast<int>(toClose.size());
+    }
+    connectionAvailable.notify_all();
+
+    for (RedisConnection* conn : toClose) {
+        delete conn;
+    }
+}
+
+bool RedisConnectionPool::prepareForCheckout(RedisConnection* conn) {
+    if (conn->isOpen() &&
+        std::chrono::steady_clock::now() - conn->lastUsed >= std::chrono::seconds(options.healthCheckSeconds)) {
+        RespReply reply;
+        if (!conn->command({"PING"}, reply) || !reply.isStatus("PONG")) {
+            LOG_WARNING("Redis连接健康检查失败: " + reply.describe());
+            healthCheckFailureCount++;
+            conn->close();
+        }
+    }
+    if (conn->isOpen()) {
+        return true;
+    }
+
+    // 惰性重连：断开的连接在真正需要时才重新建立
+    std::string error;
+    if (!conn->open(host, port, password, database, connectTimeoutMs, error)) {
+        setLastError(error);
+        LOG_WARNING("Redis重新连接失败: " + error);
+        recordFailure();
+        return false;
+    }
+    reconnectCount++;
+    recordSuccess();
+    LOG_INFO("Redis连接已重新建立");
+    return true;
+}
+
+bool RedisConnectionPool::allowCheckout(std::string& error) {
+    if (!breakerOpen) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(breakerMutex);
+    if (!breakerOpen) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < retryAt) {
+        auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(retryAt - now).count();
+        error = "Redis已熔断，" + std::to_string(waitMs) + "ms 后重试";
+        return false;
+    }
+    // 放行本次借用作为探测；探测结果出来之前，其余调用方在下一个退避周期内继续被拒绝
+    retryAt = now + backoff;
+    return true;
+}
+
+void RedisConnectionPool::recordSuccess() {
+    if (!breakerOpen && consecutiveFailures == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(breakerMutex);
+    if (breakerOpen) {
+        LOG_INFO("Redis已恢复，关闭熔断");
+    }
+    breakerOpen = false;
+    consecutiveFailures = 0;
+    backoff = std::chrono::milliseconds(options.backoffInitialMs);
+}
+
+void RedisConnectionPool::recordFailure() {
+    std::lock_guard<std::mutex> lock(breakerMutex);
+    auto now = std::chrono::steady_clock::now();
+    if (breakerOpen) {
+        // 探测失败：退避时间翻倍，加上至多 1/4 的随机抖动，避免多个进程同时探测
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(options.backoffMaxMs));
+        std::uniform_int_distribution<long long> spread(0, backoff.count() / 4);
+        retryAt = now + backoff + std::chrono::milliseconds(spread(jitter));
+        return;
+    }
+    if (++consecutiveFailures >= options.breakerThreshold) {
+        breakerOpen = true;
+        breakerTripCount++;
+        backoff = std::chrono::milliseconds(options.backoffInitialMs);
+        retryAt = now + backoff;
+        LOG_WARNING("Redis连续 " + std::to_string(consecutiveFailures) + " 次连接失败，熔断 " +
+                    std::to_string(backoff.count()) + "ms");
+    }
+}
+
+bool RedisConnectionPool::isAvailable() {
+    if (!breakerOpen) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(breakerMutex);
+    return !breakerOpen || std::chrono::steady_clock::now() >= retryAt;
+}
+
+PooledRedisConnection RedisConnectionPool::acquire() {
+    return acquire(std::chrono::milliseconds(options.checkoutTimeoutMs));
+}
+
+PooledRedisConnection RedisConnectionPool::acquire(std::chrono::milliseconds timeout) {
+    // 熔断期间不碰连接池和socket，直接失败
+    std::string rejection;
+    if (!allowCheckout(rejection)) {
+        rejectedCount++;
+        setLastError(rejection);
+        return PooledRedisConnection();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool waited = false;
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (true) {
+        if (shuttingDown) {
+            return PooledRedisConnection();
+        }
+
+        // 1. 优先复用最近归还的空闲连接（断开的连接排在队首，最后才用到）
+        if (!idleConnections.empty()) {
+            RedisConnection* conn = idleConnections.back();
+            idleConnections.pop_back();
+            lock.unlock();
+
+            if (!prepareForCheckout(conn)) {
+                // 服务器不可达：连接对象保持断开放回池中，本次借用失败而不是继续等待
+                release(conn);
+                return PooledRedisConnection();
+            }
+            checkoutCount++;
+            return PooledRedisConnection(this, conn);
+        }
+
+        // 2. 未达到上限则新建连接（先占位，建连过程不持锁）
+        if (totalConnections < options.maxSize) {
+            totalConnections++;
+            lock.unlock();
+            auto* conn = new RedisConnection();
+            std::string error;
+            if (!conn->open(host, port, password, database, connectTimeoutMs, error)) {
+                delete conn;
+                setLastError(error);
+                LOG_WARNING("Redis连接池新建连接失败: " + error);
+                recordFailure();
+                lock.lock();
+                totalConnections--;
+                connectionAvailable.notify_one();
+                return PooledRedisConnection();
+            }
+            checkoutCount++;
+            return PooledRedisConnection(this, conn);
+        }
+
+        // 3. 连接耗尽，等待归还直到超时
+        if (!waited) {
+            waitCount++;
+            waited = true;
+        }
+        if (connectionAvailable.wait_until(lock, deadline) == std::cv_status::timeout &&
+            idleConnections.empty() && totalConnections >= options.maxSize) {
+            timeoutCount++;
+            setLastError("获取Redis连接超时（" + std::to_string(timeout.count()) + "ms）");
+            return PooledRedisConnection();
+        }
+    }
+}
+
+void RedisConnectionPool::release(RedisConnection* conn) {
+    if (!conn) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!shuttingDown) {
+            // 断开的连接放在队首，下次优先借出仍然可用的连接
+            if (conn->isOpen()) {
+                idleConnections.push_back(conn);
+            } else {
+                idleConnections.push_front(conn);
+            }
+            connectionAvailable.notify_one();
+            return;
+        }
+        totalConnections--;
+    }
+    delete conn;
+}
+
+RedisPoolStats RedisConnectionPool::getStats() {
+    RedisPoolStats stats;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stats.totalConnections = totalConnections;
+        stats.idleConnections = static_cast<int>(idleConnections.size());
+        stats.inUseConnections = totalConnections - stats.idleConnections;
+    }
+    stats.checkouts = checkoutCount;
+    stats.waits = waitCount;
+    stats.timeouts = timeoutCount;
+    stats.reconnects = reconnectCount;
+    stats.healthCheckFailures = healthCheckFailureCount;
+    stats.breakerTrips = breakerTripCount;
+    stats.rejected = rejectedCount;
+    stats.failedCommands = failedCommandCount;
+    stats.breakerOpen = breakerOpen;
+    return stats;
+}
+
+void RedisConnectionPool::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    lastError = error;
+}
+
+std::string RedisConnectionPool::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError;
+}
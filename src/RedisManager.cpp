@@ -1,23 +1,103 @@
 #include "RedisManager.h"
+#include "Logger.h"
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <future>
 
 #ifdef _WIN32
 #include <winsock2.h>
-#include <ws2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
-#else
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <fcntl.h>
 #endif
 
+namespace {
+    // 不小于该长度的值移入流水线单独发送；更小的值拷进命令缓冲区比多一个 iovec 更便宜
+    const size_t PIPELINE_INLINE_LIMIT = 4096;
+
+    // 以下把回复解释为操作结果，同步与异步接口共用
+    Result<bool> interpretSet(const RespReply& reply) {
+        return reply.isStatus("OK") ?
+               Result<bool>::Success(true) :
+               Result<bool>::Error("SET操作失败: " + reply.describe());
+    }
+
+    Result<std::string> interpretGet(const RespReply& reply) {
+        if (reply.type == RespType::Bulk) {
+            // 回复指向接收缓冲区，在归还连接（或回调返回）之前拷贝出来
+            return Result<std::string>::Success(reply.toString(), "获取成功");
+        }
+        if (reply.isNull()) {
+            return Result<std::string>::Error("键不存在");
+        }
+        return Result<std::string>::Error("GET操作失败: " + reply.describe());
+    }
+
+    // DEL / EXISTS：整数回复大于0为true
+    Result<bool> interpretCount(const std::string& operation, const RespReply& reply) {
+        if (reply.type == RespType::Integer) {
+            return Result<bool>::Success(reply.integer > 0);
+        }
+        return Result<bool>::Error(operation + "操作失败: " + reply.describe());
+    }
+
+    Result<bool> interpretExpire(const RespReply& reply) {
+        if (reply.type == RespType::Integer) {
+            return Result<bool>::Success(reply.integer == 1);
+        }
+        return Result<bool>::Error("EXPIRE操作失败: " + reply.describe());
+    }
+
+    Result<Session> parseSession(const Result<std::string>& result) {
+        if (!result.success) {
+            return Result<Session>::Error(result.message);
+        }
+        
+        try {
+            // 解析JSON字符串为Session对象
+            json sessionJson = json::parse(result.data.value());
+            Session session;
+            session.userId = sessionJson["userId"];
+            session.username = sessionJson["username"];
+            session.createdAt = Utils::parseTimestamp(sessionJson["createdAt"]);
+            session.expiresAt = Utils::parseTimestamp(sessionJson["expiresAt"]);
+            
+            return Result<Session>::Success(session);
+        } catch (const std::exception& e) {
+            return Result<Session>::Error("会话数据解析失败: " + std::string(e.what()));
+        }
+    }
+
+    // 把异步客户端的回调转换为操作结果；未启用异步客户端时立即以错误回调
+    template<typename T, typename Interpret>
+    void submitAsync(RedisAsyncClient* client, std::initializer_list<std::string_view> args,
+                     const std::string& operation, Interpret interpret,
+                     std::function<void(const Result<T>&)> callback) {
+        if (!client) {
+            callback(Result<T>::Error(operation + "操作失败: Redis异步客户端未启用"));
+            return;
+        }
+        client->submit(args, [operation, interpret, callback](const RespReply& reply, bool ok) {
+            if (!ok) {
+                callback(Result<T>::Error(operation + "操作失败: " + reply.toString()));
+                return;
+            }
+            callback(interpret(reply));
+        });
+    }
+
+    // 回调式接口包装为 future
+    template<typename T, typename Start>
+    std::future<Result<T>> makeFuture(Start start) {
+        auto promise = std::make_shared<std::promise<Result<T>>>();
+        std::future<Result<T>> future = promise->get_future();
+        start([promise](const Result<T>& result) { promise->set_value(result); });
+        return future;
+    }
+}
+
 RedisManager::RedisManager()
         : host("127.0.0.1"), port(6379), password(""), database(0), timeout(5000),
-          sockfd(-1), connected(false) {
+          connected(false) {
 #ifdef _WIN32
     // Windows下初始化Socket库
     WSADATA wsaData;
@@ -35,187 +115,245 @@ RedisManager::~RedisManager() {
 
 // 连接Redis服务器，支持指定host、port、密码、数据库、超时时间
 bool RedisManager::connect(const std::string& host, int port, const std::string& password,
-                           int database, int timeout) {
+                           int database, int timeout, const RedisPoolOptions& poolOptions,
+                           const RedisAsyncOptions& asyncOptions) {
+    disconnect();
     this->host = host;
     this->port = port;
     this->password = password;
     this->database = database;
     this->timeout = timeout;
     
-    return connectSocket();
-}
-
-// 实际建立Socket连接，并进行认证和数据库选择
-bool RedisManager::connectSocket() {
-    std::lock_guard<std::mutex> lock(redisMutex);
-    
-    // 创建socket
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        return false;
-    }
-    
-    // 设置为非阻塞模式，便于后续select超时处理
-#ifdef _WIN32
-    u_long mode = 1;
-    ioctlsocket(sockfd, FIONBIO, &mode);
-#else
-    int flags = fcntl(sockfd, F_GETFL, 0);
-    fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
-#endif
-    
-    // 配置服务器地址结构体
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    server_addr.sin_addr.s_addr = inet_addr(host.c_str());
-    
-    // 发起连接请求
-    int result = ::connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    if (result < 0) {
-#ifdef _WIN32
-        // Windows下判断是否为非阻塞连接中的正常情况
-        if (WSAGetLastError() != WSAEWOULDBLOCK) {
-            closesocket(sockfd);
-            return false;
-        }
-#else
-        // Linux下判断是否为非阻塞连接中的正常情况
-        if (errno != EINPROGRESS) {
-            close(sockfd);
-            return false;
-        }
-#endif
-    }
-    
-    // 使用select等待连接完成，超时则失败
-    fd_set write_fds;
-    FD_ZERO(&write_fds);
-    FD_SET(sockfd, &write_fds);
-    
-    struct timeval tv;
-    tv.tv_sec = timeout / 1000;
-    tv.tv_usec = (timeout % 1000) * 1000;
-    
-    result = select(sockfd + 1, nullptr, &write_fds, nullptr, &tv);
-    if (result <= 0) {
-#ifdef _WIN32
-        closesocket(sockfd);
-#else
-        close(sockfd);
-#endif
+    // 预建 minSize 条连接，其余在并发调用需要时再建立
+    auto newPool = std::make_unique<RedisConnectionPool>(host, port, password, database, timeout, poolOptions);
+    if (!newPool->initialize()) {
         return false;
     }
-    
-    // 连接成功后恢复为阻塞模式
-#ifdef _WIN32
-    mode = 0;
-    ioctlsocket(sockfd, FIONBIO, &mode);
-#else
-    flags = fcntl(sockfd, F_GETFL, 0);
-    fcntl(sockfd, F_SETFL, flags & ~O_NONBLOCK);
-#endif
-    
+    pool = std::move(newPool);
     connected = true;
     
-    // 如果设置了密码，进行AUTH认证
-    if (!password.empty()) {
-        // 构造RESP协议的AUTH命令
-        std::string authCmd = "*2\r\n$4\r\nAUTH\r\n$" + std::to_string(password.length()) + "\r\n" + password + "\r\n";
-        std::string response = sendCommand(authCmd);
-        if (response.find("+OK") != 0) {
-            disconnect();
-            return false;
-        }
-    }
-    
-    // 如果指定了数据库，进行SELECT切换
-    if (database != 0) {
-        std::string dbStr = std::to_string(database);
-        std::string selectCmd = "*2\r\n$6\r\nSELECT\r\n$" + std::to_string(dbStr.length()) + "\r\n" + dbStr + "\r\n";
-        std::string response = sendCommand(selectCmd);
-        if (response.find("+OK") != 0) {
-            disconnect();
-            return false;
+    // 异步客户端独占一条连接；建立失败不影响同步接口，异步调用直接返回错误
+    if (asyncOptions.enabled) {
+        auto newClient = std::make_unique<RedisAsyncClient>(host, port, password, database, timeout, asyncOptions);
+        if (newClient->start()) {
+            asyncClient = std::move(newClient);
+        } else {
+            LOG_WARNING("Redis异步客户端启动失败，异步接口不可用");
         }
     }
-    
     return true;
 }
 
 // 断开Redis连接
 void RedisManager::disconnect() {
-    std::lock_guard<std::mutex> lock(redisMutex);
-    disconnectSocket();
-}
-
-// 关闭Socket
-void RedisManager::disconnectSocket() {
-    if (sockfd >= 0) {
-#ifdef _WIN32
-        closesocket(sockfd);
-#else
-        close(sockfd);
-#endif
-        sockfd = -1;
-    }
     connected = false;
+    if (asyncClient) {
+        // 未完成的异步请求以失败回调结束
+        asyncClient->shutdown();
+        asyncClient.reset();
+    }
+    if (pool) {
+        pool->shutdown();
+        pool.reset();
+    }
 }
 
-// 判断是否已连接
+// 判断是否已连接；熔断期间返回false，调用方可以立即改走本地逻辑
 bool RedisManager::isConnected() const {
-    return connected && sockfd >= 0;
+    return connected && pool && pool->isAvailable();
 }
 
-// PING命令，检测Redis连接是否存活
-bool RedisManager::ping() {
-    if (!isConnected()) {
-        return false;
+PooledRedisConnection RedisManager::acquire(std::string& error) {
+    // 熔断由连接池判断，拒绝原因与计数都记在连接池里
+    if (!connected || !pool) {
+        error = "Redis未连接";
+        return PooledRedisConnection();
     }
-    
-    // 构造RESP协议的PING命令
-    std::string response = sendCommand("*1\r\n$4\r\nPING\r\n");
-    return response.find("+PONG") == 0;
+    PooledRedisConnection conn = pool->acquire();
+    if (!conn) {
+        error = "获取Redis连接失败: " + pool->getLastError();
+    }
+    return conn;
 }
 
-// 发送命令到Redis服务器
-std::string RedisManager::sendCommand(const std::string& command) {
-    if (!isConnected()) {
-        return "";
+// 借用连接执行一条命令。只有命令还没写入 socket 就失败（借出的连接已被服务器关闭）时才换一条连接重试一次；
+// 已经发出后读回复失败（包括读取超时）时服务器可能已执行，直接返回错误，不重放命令
+bool RedisManager::command(PooledRedisConnection& conn, std::initializer_list<std::string_view> args,
+                           RespReply& reply, std::string& error) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        conn = acquire(error);
+        if (!conn) {
+            // 建连失败已由连接池计入熔断器
+            break;
+        }
+        if (conn->command(args, reply)) {
+            pool->recordSuccess();
+            return true;
+        }
+        error = reply.toString();
+        pool->recordFailure();
+        bool retryable = !conn->wroteRequest();
+        conn.release();
+        if (!retryable) {
+            break;
+        }
     }
-    
-    // 发送命令字符串
-    int sent = send(sockfd, command.c_str(), command.length(), 0);
-    if (sent != static_cast<int>(command.length())) {
-        return "";
+    if (pool) {
+        pool->recordFailedCommand();
     }
-    
-    // 读取响应
-    return readResponse();
+    return false;
 }
 
-// 读取Redis服务器响应
-std::string RedisManager::readResponse() {
-    std::string response;
-    char buffer[4096];
-    
-    while (true) {
-        // 接收数据
-        int received = recv(sockfd, buffer, sizeof(buffer) - 1, 0);
-        if (received <= 0) {
+RedisPoolStats RedisManager::getPoolStats() const {
+    return pool ? pool->getStats() : RedisPoolStats();
+}
+
+bool RedisManager::isAsyncEnabled() const {
+    return asyncClient != nullptr;
+}
+
+RedisAsyncStats RedisManager::getAsyncStats() const {
+    return asyncClient ? asyncClient->getStats() : RedisAsyncStats();
+}
+
+// PING命令，检测Redis连接是否存活
+bool RedisManager::ping() {
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    return command(conn, {"PING"}, reply, error) && reply.isStatus("PONG");
+}
+
+// ================== 流水线 ==================
+RedisPipeline RedisManager::pipeline() {
+    return RedisPipeline(this);
+}
+
+// 借用一条连接，一次发出流水线中的全部命令，再按顺序读回回复；与单条命令一样，只有在写入之前失败时才重试一次
+Result<std::vector<RedisReply>> RedisManager::executePipeline(RedisPipeline& pipeline) {
+    std::string error;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        PooledRedisConnection conn = acquire(error);
+        if (!conn) {
             break;
         }
         
-        buffer[received] = '\0';
-        response += buffer;
+        // 发送会移动各段的起点，每次尝试重新生成
+        std::vector<RedisSendSpan> spans;
+        spans.reserve(pipeline.segments.size() + 1);
+        for (const auto& segment : pipeline.segments) {
+            const char* base = segment.external ? segment.external->data() : pipeline.buffer.data();
+            spans.push_back({base + segment.offset, segment.length});
+        }
+        if (pipeline.inlineStart < pipeline.buffer.size()) {
+            spans.push_back({pipeline.buffer.data() + pipeline.inlineStart, pipeline.buffer.size() - pipeline.inlineStart});
+        }
         
-        // 检查是否收到完整响应（以\r\n结尾）
-        if (response.find("\r\n") != std::string::npos) {
+        std::vector<RedisReply> replies(pipeline.size());
+        bool ok = conn->send(spans);
+        error = "Redis发送流水线失败";
+        RespReply reply;
+        for (size_t i = 0; ok && i < replies.size(); ++i) {
+            if (!conn->readReply(reply)) {
+                ok = false;
+                error = "读取流水线回复失败: " + reply.toString();
+                break;
+            }
+            // 后续 recv 可能搬移接收缓冲区，逐条拷出
+            replies[i].type = reply.type;
+            replies[i].text = reply.toString();
+            replies[i].integer = reply.integer;
+        }
+        if (ok) {
+            pool->recordSuccess();
+            return Result<std::vector<RedisReply>>::Success(replies, "流水线执行成功");
+        }
+        pool->recordFailure();
+        if (conn->wroteRequest()) {
             break;
         }
     }
+    if (pool) {
+        pool->recordFailedCommand();
+    }
+    return Result<std::vector<RedisReply>>::Error(error);
+}
+
+RedisPipeline::RedisPipeline(RedisManager* manager) : manager(manager) {
+}
+
+void RedisPipeline::queue(std::initializer_list<std::string_view> args, std::string* value) {
+    appendRespHeader(buffer, '*', args.size() + (value ? 1 : 0));
+    for (std::string_view arg : args) {
+        appendRespHeader(buffer, '$', arg.size());
+        buffer.append(arg.data(), arg.size());
+        buffer += "\r\n";
+    }
+    commandCount++;
+    if (!value) {
+        return;
+    }
     
-    return response;
+    appendRespHeader(buffer, '$', value->size());
+    if (value->size() < PIPELINE_INLINE_LIMIT) {
+        buffer += *value;
+        buffer += "\r\n";
+        return;
+    }
+    // 大值单独成段：此前的缓冲区内容先记为一段，值之后的 \r\n 归入下一段
+    segments.push_back({inlineStart, buffer.size() - inlineStart, nullptr});
+    largeValues.push_back(std::move(*value));
+    segments.push_back({0, largeValues.back().size(), &largeValues.back()});
+    inlineStart = buffer.size();
+    buffer += "\r\n";
+}
+
+RedisPipeline& RedisPipeline::set(const std::string& key, std::string value, int ttl) {
+    if (ttl > 0) {
+        std::string ttlStr = std::to_string(ttl);
+        queue({"SETEX", key, ttlStr}, &value);
+    } else {
+        queue({"SET", key}, &value);
+    }
+    return *this;
+}
+
+RedisPipeline& RedisPipeline::get(const std::string& key) {
+    queue({"GET", key});
+    return *this;
+}
+
+RedisPipeline& RedisPipeline::del(const std::string& key) {
+    queue({"DEL", key});
+    return *this;
+}
+
+RedisPipeline& RedisPipeline::expire(const std::string& key, int seconds) {
+    std::string secondsStr = std::to_string(seconds);
+    queue({"EXPIRE", key, secondsStr});
+    return *this;
+}
+
+RedisPipeline& RedisPipeline::exists(const std::string& key) {
+    queue({"EXISTS", key});
+    return *this;
+}
+
+void RedisPipeline::clear() {
+    buffer.clear();
+    largeValues.clear();
+    segments.clear();
+    inlineStart = 0;
+    commandCount = 0;
+}
+
+Result<std::vector<RedisReply>> RedisPipeline::execute() {
+    if (commandCount == 0) {
+        return Result<std::vector<RedisReply>>::Success(std::vector<RedisReply>(), "流水线为空");
+    }
+    auto result = manager->executePipeline(*this);
+    clear();
+    return result;
 }
 
 // 对字符串进行转义（主要处理换行符）
@@ -235,137 +373,87 @@ std::string RedisManager::escapeString(const std::string& str) {
 // ================== 基本操作实现 ==================
 // 设置键值，支持可选TTL
 Result<bool> RedisManager::set(const std::string& key, const std::string& value, int ttl) {
-    if (!isConnected()) {
-        return Result<bool>::Error("Redis未连接");
-    }
-    
-    std::string command;
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    bool sent;
     if (ttl > 0) {
-        // 构造SETEX命令，带过期时间
-        command = "*4\r\n$5\r\nSETEX\r\n$" + std::to_string(key.length()) + "\r\n" + key + 
-                  "\r\n$" + std::to_string(std::to_string(ttl).length()) + "\r\n" + std::to_string(ttl) + 
-                  "\r\n$" + std::to_string(value.length()) + "\r\n" + value + "\r\n";
+        // SETEX命令，带过期时间
+        std::string ttlStr = std::to_string(ttl);
+        sent = command(conn, {"SETEX", key, ttlStr, value}, reply, error);
     } else {
-        // 构造SET命令
-        command = "*3\r\n$3\r\nSET\r\n$" + std::to_string(key.length()) + "\r\n" + key + 
-                  "\r\n$" + std::to_string(value.length()) + "\r\n" + value + "\r\n";
+        sent = command(conn, {"SET", key, value}, reply, error);
+    }
+    if (!sent) {
+        return Result<bool>::Error("SET操作失败: " + error);
     }
     
-    std::string response = sendCommand(command);
-    return response.find("+OK") == 0 ? 
-           Result<bool>::Success(true) : 
-           Result<bool>::Error("SET操作失败: " + response);
+    return interpretSet(reply);
 }
 
 // 获取键值
 Result<std::string> RedisManager::get(const std::string& key) {
-    if (!isConnected()) {
-        return Result<std::string>::Error("Redis未连接");
-    }
-    
-    // 构造GET命令
-    std::string command = "*2\r\n$3\r\nGET\r\n$" + std::to_string(key.length()) + "\r\n" + key + "\r\n";
-    std::string response = sendCommand(command);
-    
-    if (response.find("$-1") == 0) {
-        return Result<std::string>::Error("键不存在");
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    if (!command(conn, {"GET", key}, reply, error)) {
+        return Result<std::string>::Error("GET操作失败: " + error);
     }
     
-    // 解析RESP协议的Bulk String响应
-    if (response.find("$") == 0) {
-        size_t pos = response.find("\r\n");
-        if (pos != std::string::npos) {
-            std::string lengthStr = response.substr(1, pos - 1);
-            int length = std::stoi(lengthStr);
-            if (response.length() >= pos + 2 + length) {
-                std::string value = response.substr(pos + 2, length);
-                return Result<std::string>::Success(value, "获取成功");
-            }
-        }
-    }
-    
-    return Result<std::string>::Error("GET操作失败: " + response);
+    return interpretGet(reply);
 }
 
 // 删除键
 Result<bool> RedisManager::del(const std::string& key) {
-    if (!isConnected()) {
-        return Result<bool>::Error("Redis未连接");
-    }
-    
-    // 构造DEL命令
-    std::string command = "*2\r\n$3\r\nDEL\r\n$" + std::to_string(key.length()) + "\r\n" + key + "\r\n";
-    std::string response = sendCommand(command);
-    
-    if (response.find(":1") == 0) {
-        return Result<bool>::Success(true);
-    } else if (response.find(":0") == 0) {
-        return Result<bool>::Success(false);
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    if (!command(conn, {"DEL", key}, reply, error)) {
+        return Result<bool>::Error("DEL操作失败: " + error);
     }
     
-    return Result<bool>::Error("DEL操作失败: " + response);
+    return interpretCount("DEL", reply);
 }
 
 // 判断键是否存在
 Result<bool> RedisManager::exists(const std::string& key) {
-    if (!isConnected()) {
-        return Result<bool>::Error("Redis未连接");
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    if (!command(conn, {"EXISTS", key}, reply, error)) {
+        return Result<bool>::Error("EXISTS操作失败: " + error);
     }
     
-    // 构造EXISTS命令
-    std::string command = "*2\r\n$6\r\nEXISTS\r\n$" + std::to_string(key.length()) + "\r\n" + key + "\r\n";
-    std::string response = sendCommand(command);
-    
-    if (response.find(":1") == 0) {
-        return Result<bool>::Success(true);
-    } else if (response.find(":0") == 0) {
-        return Result<bool>::Success(false);
-    }
-    
-    return Result<bool>::Error("EXISTS操作失败: " + response);
+    return interpretCount("EXISTS", reply);
 }
 
 // 获取键的剩余TTL
 Result<int> RedisManager::ttl(const std::string& key) {
-    if (!isConnected()) {
-        return Result<int>::Error("Redis未连接");
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    if (!command(conn, {"TTL", key}, reply, error)) {
+        return Result<int>::Error("TTL操作失败: " + error);
     }
     
-    // 构造TTL命令
-    std::string command = "*2\r\n$3\r\nTTL\r\n$" + std::to_string(key.length()) + "\r\n" + key + "\r\n";
-    std::string response = sendCommand(command);
-    
-    if (response.find(":") == 0) {
-        size_t pos = response.find("\r\n");
-        if (pos != std::string::npos) {
-            std::string ttlStr = response.substr(1, pos - 1);
-            int ttl = std::stoi(ttlStr);
-            return Result<int>::Success(ttl);
-        }
+    if (reply.type == RespType::Integer) {
+        return Result<int>::Success(static_cast<int>(reply.integer));
     }
     
-    return Result<int>::Error("TTL操作失败: " + response);
+    return Result<int>::Error("TTL操作失败: " + reply.describe());
 }
 
 // 设置键的过期时间
 Result<bool> RedisManager::expire(const std::string& key, int seconds) {
-    if (!isConnected()) {
-        return Result<bool>::Error("Redis未连接");
-    }
-    
-    // 构造EXPIRE命令
     std::string secondsStr = std::to_string(seconds);
-    std::string command = "*3\r\n$7\r\nEXPIRE\r\n$" + std::to_string(key.length()) + "\r\n" + key + 
-                          "\r\n$" + std::to_string(secondsStr.length()) + "\r\n" + secondsStr + "\r\n";
-    std::string response = sendCommand(command);
-    
-    if (response.find(":1") == 0) {
-        return Result<bool>::Success(true);
-    } else if (response.find(":0") == 0) {
-        return Result<bool>::Success(false);
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    if (!command(conn, {"EXPIRE", key, secondsStr}, reply, error)) {
+        return Result<bool>::Error("EXPIRE操作失败: " + error);
     }
     
-    return Result<bool>::Error("EXPIRE操作失败: " + response);
+    return interpretExpire(reply);
 }
 
 // ================== 工具方法实现 ==================
@@ -398,25 +486,7 @@ Result<bool> RedisManager::storeSession(const std::string& sessionToken, const S
 // 获取会话信息，并反序列化为Session对象
 Result<Session> RedisManager::getSession(const std::string& sessionToken) {
     std::string key = generateSessionKey(sessionToken);
-    auto result = get(key);
-    
-    if (!result.success) {
-        return Result<Session>::Error(result.message);
-    }
-    
-    try {
-        // 解析JSON字符串为Session对象
-        json sessionJson = json::parse(result.data.value());
-        Session session;
-        session.userId = sessionJson["userId"];
-        session.username = sessionJson["username"];
-        session.createdAt = Utils::parseTimestamp(sessionJson["createdAt"]);
-        session.expiresAt = Utils::parseTimestamp(sessionJson["expiresAt"]);
-        
-        return Result<Session>::Success(session);
-    } catch (const std::exception& e) {
-        return Result<Session>::Error("会话数据解析失败: " + std::string(e.what()));
-    }
+    return parseSession(get(key));
 }
 
 // 删除会话
@@ -431,19 +501,93 @@ Result<bool> RedisManager::extendSession(const std::string& sessionToken, int tt
     return expire(key, ttl);
 }
 
+// ================== 异步操作 ==================
+// 命令交给异步客户端的事件循环，调用线程不等待回复
+
+void RedisManager::setAsync(const std::string& key, const std::string& value, int ttl,
+                            std::function<void(const Result<bool>&)> callback) {
+    if (ttl > 0) {
+        std::string ttlStr = std::to_string(ttl);
+        submitAsync<bool>(asyncClient.get(), {"SETEX", key, ttlStr, value}, "SET", interpretSet, callback);
+    } else {
+        submitAsync<bool>(asyncClient.get(), {"SET", key, value}, "SET", interpretSet, callback);
+    }
+}
+
+std::future<Result<bool>> RedisManager::setAsync(const std::string& key, const std::string& value, int ttl) {
+    return makeFuture<bool>([&](std::function<void(const Result<bool>&)> callback) {
+        setAsync(key, value, ttl, callback);
+    });
+}
+
+void RedisManager::getAsync(const std::string& key, std::function<void(const Result<std::string>&)> callback) {
+    submitAsync<std::string>(asyncClient.get(), {"GET", key}, "GET", interpretGet, callback);
+}
+
+std::future<Result<std::string>> RedisManager::getAsync(const std::string& key) {
+    return makeFuture<std::string>([&](std::function<void(const Result<std::string>&)> callback) {
+        getAsync(key, callback);
+    });
+}
+
+void RedisManager::delAsync(const std::string& key, std::function<void(const Result<bool>&)> callback) {
+    submitAsync<bool>(asyncClient.get(), {"DEL", key}, "DEL",
+                      [](const RespReply& reply) { return interpretCount("DEL", reply); }, callback);
+}
+
+std::future<Result<bool>> RedisManager::delAsync(const std::string& key) {
+    return makeFuture<bool>([&](std::function<void(const Result<bool>&)> callback) {
+        delAsync(key, callback);
+    });
+}
+
+void RedisManager::existsAsync(const std::string& key, std::function<void(const Result<bool>&)> callback) {
+    submitAsync<bool>(asyncClient.get(), {"EXISTS", key}, "EXISTS",
+                      [](const RespReply& reply) { return interpretCount("EXISTS", reply); }, callback);
+}
+
+std::future<Result<bool>> RedisManager::existsAsync(const std::string& key) {
+    return makeFuture<bool>([&](std::function<void(const Result<bool>&)> callback) {
+        existsAsync(key, callback);
+    });
+}
+
+void RedisManager::expireAsync(const std::string& key, int seconds, std::function<void(const Result<bool>&)> callback) {
+    std::string secondsStr = std::to_string(seconds);
+    submitAsync<bool>(asyncClient.get(), {"EXPIRE", key, secondsStr}, "EXPIRE", interpretExpire, callback);
+}
+
+std::future<Result<bool>> RedisManager::expireAsync(const std::string& key, int seconds) {
+    return makeFuture<bool>([&](std::function<void(const Result<bool>&)> callback) {
+        expireAsync(key, seconds, callback);
+    });
+}
+
+void RedisManager::getSessionAsync(const std::string& sessionToken,
+                                   std::function<void(const Result<Session>&)> callback) {
+    getAsync(generateSessionKey(sessionToken), [callback](const Result<std::string>& result) {
+        callback(parseSession(result));
+    });
+}
+
+std::future<Result<Session>> RedisManager::getSessionAsync(const std::string& sessionToken) {
+    return makeFuture<Session>([&](std::function<void(const Result<Session>&)> callback) {
+        getSessionAsync(sessionToken, callback);
+    });
+}
+
 // 清空当前数据库
 Result<bool> RedisManager::flushdb() {
-    if (!isConnected()) {
-        return Result<bool>::Error("Redis未连接");
+    std::string error;
+    PooledRedisConnection conn;
+    RespReply reply;
+    if (!command(conn, {"FLUSHDB"}, reply, error)) {
+        return Result<bool>::Error("FLUSHDB操作失败: " + error);
     }
     
-    // 构造FLUSHDB命令
-    std::string command = "*1\r\n$7\r\nFLUSHDB\r\n";
-    std::string response = sendCommand(command);
-    
-    if (response.find("+OK") == 0) {
+    if (reply.isStatus("OK")) {
         return Result<bool>::Success(true, "数据库已清空");
     }
     
-    return Result<bool>::Error("FLUSHDB操作失败: " + response);
-}
+    return Result<bool>::Error("FLUSHDB操作失败: " + reply.describe());
+}
\ No newline at end of file
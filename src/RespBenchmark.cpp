@@ -0,0 +1,319 @@
+#include "RespBenchmark.h"
+#include <cstring>
+
+namespace {
+    // 吞吐测试时每次送入的字节数，与 RedisManager 每次 recv 的大小相当
+    const size_t FEED_CHUNK = 16 * 1024;
+
+    const int MAX_GENERATED_DEPTH = 3;
+
+    char tag(RespType type) {
+        return static_cast<char>('A' + static_cast<int>(type));
+    }
+
+    void appendText(std::string& fingerprint, RespType type, const std::string& text) {
+        fingerprint += tag(type);
+        fingerprint += std::to_string(text.size());
+        fingerprint += ':';
+        fingerprint += text;
+    }
+
+    std::string randomWord(std::mt19937_64& rng, size_t maxLength) {
+        static const char letters[] = "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        std::string word(1 + rng() % maxLength, 'a');
+        for (char& c : word) {
+            c = letters[rng() % (sizeof(letters) - 1)];
+        }
+        return word;
+    }
+
+    std::string randomBytes(std::mt19937_64& rng) {
+        // 大多数值较短，约 2% 达到 KB 级（最大 16KB），内容可包含 \r\n 与任意字节
+        size_t length = rng() % 50 == 0 ? rng() % (16 * 1024) : rng() % 64;
+        std::string bytes(length, '\0');
+        for (char& c : bytes) {
+            c = static_cast<char>(rng() % 256);
+        }
+        return bytes;
+    }
+
+    double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+RespBenchmark::RespBenchmark(const RespBenchmarkOptions& options) : options(options) {
+}
+
+void RespBenchmark::fingerprint(const RespReply& reply, std::string& out) {
+    out += tag(reply.type);
+    switch (reply.type) {
+        case RespType::Integer:
+        case RespType::Boolean:
+            out += std::to_string(reply.integer);
+            break;
+        case RespType::Null:
+            break;
+        case RespType::Array:
+        case RespType::Map:
+        case RespType::Set:
+        case RespType::Push:
+            out += std::to_string(reply.count);
+            out += '[';
+            for (size_t i = 0; i < reply.count; ++i) {
+                fingerprint(reply[i], out);
+            }
+            out += ']';
+            break;
+        default:
+            out += std::to_string(reply.text.size());
+            out += ':';
+            out.append(reply.text.data(), reply.text.size());
+            break;
+    }
+}
+
+void RespBenchmark::appendValue(std::mt19937_64& rng, int depth, std::string& expect) {
+    int kind = static_cast<int>(rng() % 100);
+    bool nested = depth < MAX_GENERATED_DEPTH;
+
+    if (kind < 20) {
+        std::string text = kind < 10 ? "OK" : randomWord(rng, 16);
+        stream += "+" + text + "\r\n";
+        appendText(expect, RespType::Status, text);
+    } else if (kind < 35) {
+        long long value = static_cast<long long>(rng()) >> (rng() % 64);
+        stream += ":" + std::to_string(value) + "\r\n";
+        expect += tag(RespType::Integer) + std::to_string(value);
+    } else if (kind < 65 || (kind >= 75 && kind < 90 && !nested)) {
+        std::string bytes = randomBytes(rng);
+        stream += "$" + std::to_string(bytes.size()) + "\r\n" + bytes + "\r\n";
+        appendText(expect, RespType::Bulk, bytes);
+    } else if (kind < 70) {
+        stream += rng() % 2 ? "$-1\r\n" : "*-1\r\n";
+        expect += tag(RespType::Null);
+    } else if (kind < 75) {
+        std::string text = "ERR " + randomWord(rng, 32);
+        stream += "-" + text + "\r\n";
+        appendText(expect, RespType::Error, text);
+    } else if (kind < 85) {
+        size_t count = rng() % 9;
+        stream += "*" + std::to_string(count) + "\r\n";
+        expect += tag(RespType::Array) + std::to_string(count) + "[";
+        for (size_t i = 0; i < count; ++i) {
+            appendValue(rng, depth + 1, expect);
+        }
+        expect += "]";
+    } else if (kind < 90) {
+        size_t pairs = rng() % 5;
+        stream += "%" + std::to_string(pairs) + "\r\n";
+        expect += tag(RespType::Map) + std::to_string(pairs * 2) + "[";
+        for (size_t i = 0; i < pairs * 2; ++i) {
+            appendValue(rng, depth + 1, expect);
+        }
+        expect += "]";
+    } else if (kind < 93) {
+        bool value = rng() % 2 == 0;
+        stream += value ? "#t\r\n" : "#f\r\n";
+        expect += tag(RespType::Boolean) + std::string(value ? "1" : "0");
+    } else if (kind < 96) {
+        std::string text = std::to_string(static_cast<int>(rng() % 100000)) + ".25";
+        stream += "," + text + "\r\n";
+        appendText(expect, RespType::Double, text);
+    } else if (kind < 98) {
+        std::string text = randomWord(rng, 40);
+        stream += "=" + std::to_string(text.size() + 4) + "\r\ntxt:" + text + "\r\n";
+        appendText(expect, RespType::Bulk, text);
+    } else if (kind < 99) {
+        stream += "_\r\n";
+        expect += tag(RespType::Null);
+    } else {
+        // 属性不出现在结果中，指纹只记录其后的回复
+        stream += "|1\r\n+ttl\r\n:" + std::to_string(rng() % 1000) + "\r\n";
+        appendValue(rng, depth, expect);
+    }
+}
+
+void RespBenchmark::generate() {
+    std::mt19937_64 rng(options.seed);
+    stream.clear();
+    expected.clear();
+    expected.reserve(static_cast<size_t>(std::max(0, options.replies)));
+    for (int i = 0; i < options.replies; ++i) {
+        std::string expect;
+        appendValue(rng, 0, expect);
+        expected.push_back(std::move(expect));
+    }
+}
+
+Result<bool> RespBenchmark::checkSplits(std::mt19937_64& rng) {
+    RespParser parser;
+    RespReply reply;
+    std::string actual;
+    for (int round = 0; round < options.splitRounds; ++round) {
+        // 块大小从 1 字节到 16KB 不等：覆盖在任意位置（长度前缀、\r 与 \n 之间、Bulk 内容中）被切开的情况
+        size_t maxChunk = size_t(1) << (rng() % 15);
+        parser.reset();
+        size_t offset = 0;
+        size_t index = 0;
+        while (true) {
+            RespParser::Status status = parser.next(reply);
+            if (status == RespParser::Status::Complete) {
+                actual.clear();
+                fingerprint(reply, actual);
+                if (index >= expected.size() || actual != expected[index]) {
+                    return Result<bool>::Error("第 " + std::to_string(round) + " 轮切分后第 " +
+                                               std::to_string(index) + " 条回复不一致: " + reply.describe());
+                }
+                index++;
+                continue;
+            }
+            if (status == RespParser::Status::ProtocolError) {
+                return Result<bool>::Error("第 " + std::to_string(round) + " 轮切分后第 " +
+                                           std::to_string(index) + " 条回复解析失败: " + parser.error());
+            }
+            if (offset == stream.size()) {
+                break;
+            }
+            size_t length = std::min<size_t>(1 + rng() % maxChunk, stream.size() - offset);
+            parser.feed(stream.data() + offset, length);
+            offset += length;
+        }
+        if (index != expected.size() || parser.buffered() != 0) {
+            return Result<bool>::Error("第 " + std::to_string(round) + " 轮切分后只解析出 " +
+                                       std::to_string(index) + "/" + std::to_string(expected.size()) + " 条回复");
+        }
+    }
+    return Result<bool>::Success(true);
+}
+
+Result<bool> RespBenchmark::checkCorruption(std::mt19937_64& rng, uint64_t& protocolErrors) {
+    if (stream.empty()) {
+        return Result<bool>::Success(true);
+    }
+    RespParser parser;
+    RespReply reply;
+    std::string actual;
+    for (int round = 0; round < options.corruptionRounds; ++round) {
+        size_t start = rng() % stream.size();
+        std::string data = stream.substr(start, 1 + rng() % 512);
+
+        int mutations = 1 + static_cast<int>(rng() % 3);
+        for (int m = 0; m < mutations && !data.empty(); ++m) {
+            size_t at = rng() % data.size();
+            switch (rng() % 4) {
+                case 0:
+                    data[at] = static_cast<char>(rng() % 256);
+                    break;
+                case 1:
+                    data.resize(at);
+                    break;
+                case 2:
+                    data.insert(at, 1, "\r\n*$:-0123456789"[rng() % 16]);
+                    break;
+                default:
+                    // 放大长度前缀或元素个数
+                    data.insert(at, "99999999");
+                    break;
+            }
+        }
+
+        parser.reset();
+        size_t offset = 0;
+        while (true) {
+            RespParser::Status status = parser.next(reply);
+            if (status == RespParser::Status::Complete) {
+                // 遍历全部内容：视图越界时由 sanitizer 报告
+                actual.clear();
+                fingerprint(reply, actual);
+                continue;
+            }
+            if (status == RespParser::Status::ProtocolError) {
+                if (parser.error().empty()) {
+                    return Result<bool>::Error("协议错误没有给出原因");
+                }
+                protocolErrors++;
+                break;
+            }
+            if (offset == data.size()) {
+                break;
+            }
+            size_t length = std::min<size_t>(1 + rng() % 64, data.size() - offset);
+            parser.feed(data.data() + offset, length);
+            offset += length;
+        }
+        if (parser.capacity() > RespParser::MAX_BULK_LENGTH) {
+            return Result<bool>::Error("畸形数据使解析器缓冲区增长到 " + std::to_string(parser.capacity()) + " 字节");
+        }
+    }
+    return Result<bool>::Success(true);
+}
+
+void RespBenchmark::measure(RespBenchmarkReport& report) {
+    RespParser parser;
+    RespReply reply;
+    uint64_t replies = 0;
+    uint64_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(options.durationMs);
+    do {
+        for (size_t offset = 0; offset < stream.size(); offset += FEED_CHUNK) {
+            size_t length = std::min(FEED_CHUNK, stream.size() - offset);
+            // 与 RedisManager 相同：先取得可写空间再写入，模拟 recv 直接写进解析器缓冲区
+            std::memcpy(parser.prepare(length), stream.data() + offset, length);
+            parser.commit(length);
+            while (parser.next(reply) == RespParser::Status::Complete) {
+                replies++;
+            }
+        }
+        bytes += stream.size();
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    double seconds = elapsedSeconds(start);
+    report.replies = replies;
+    report.repliesPerSecond = seconds > 0 ? static_cast<double>(replies) / seconds : 0;
+    report.megabytesPerSecond = seconds > 0 ? static_cast<double>(bytes) / seconds / (1024 * 1024) : 0;
+    report.parserCapacity = parser.capacity();
+}
+
+Result<RespBenchmarkReport> RespBenchmark::run(const std::function<void(const std::string&)>& progress) {
+    auto report = [&](const std::string& text) {
+        if (progress) {
+            progress(text);
+        }
+    };
+
+    RespBenchmarkReport result;
+    generate();
+    result.streamBytes = stream.size();
+    report("生成 " + std::to_string(expected.size()) + " 条回复，共 " + std::to_string(stream.size()) + " 字节");
+
+    std::mt19937_64 rng(options.seed ^ 0x9e3779b97f4a7c15ULL);
+    auto split = checkSplits(rng);
+    if (!split.success) {
+        return Result<RespBenchmarkReport>::Error(split.message);
+    }
+    result.splitRounds = options.splitRounds;
+    report("随机切分检查通过（" + std::to_string(options.splitRounds) + " 轮）");
+
+    auto corruption = checkCorruption(rng, result.protocolErrors);
+    if (!corruption.success) {
+        return Result<RespBenchmarkReport>::Error(corruption.message);
+    }
+    result.corruptionRounds = options.corruptionRounds;
+    report("随机破坏检查通过（" + std::to_string(options.corruptionRounds) + " 轮）");
+
+    measure(result);
+    return Result<RespBenchmarkReport>::Success(result, "RESP 解析器基准测试完成");
+}
+
+std::string RespBenchmark::formatReport(const RespBenchmarkReport& report) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "回复流大小:     " << report.streamBytes << " 字节\n";
+    out << "解析吞吐:       " << report.repliesPerSecond << " 条/秒, " << report.megabytesPerSecond << " MB/秒\n";
+    out << "解析器缓冲区:   " << report.parserCapacity << " 字节\n";
+    out << "随机切分检查:   " << report.splitRounds << " 轮\n";
+    out << "随机破坏检查:   " << report.corruptionRounds << " 轮，其中 " << report.protocolErrors << " 轮识别为协议错误\n";
+    return out.str();
+}
@@ -0,0 +1,331 @@
+#include "RespParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+    // 单行（状态、错误、整数、长度前缀）在缓冲区里找不到行尾时的上限，防止畸形数据让缓冲区无限增长
+    const size_t MAX_INLINE_LENGTH = 64 * 1024;
+
+    // 每个子元素至少占 3 字节（如 "_\r\n"），数据明显不够时不必先为子元素分配槽位
+    const size_t MIN_ELEMENT_BYTES = 3;
+
+    template<typename Args>
+    void appendArgs(std::string& out, const Args& args) {
+        appendRespHeader(out, '*', args.size());
+        for (std::string_view arg : args) {
+            appendRespHeader(out, '$', arg.size());
+            out.append(arg.data(), arg.size());
+            out += "\r\n";
+        }
+    }
+}
+
+// ================== RespReply ==================
+
+bool RespReply::isAggregate() const {
+    return type == RespType::Array || type == RespType::Map || type == RespType::Set || type == RespType::Push;
+}
+
+std::string RespReply::describe(size_t maxLength) const {
+    std::string out;
+    switch (type) {
+        case RespType::Null:
+            out = "(nil)";
+            break;
+        case RespType::Integer:
+            out = "(integer) " + std::to_string(integer);
+            break;
+        case RespType::Boolean:
+            out = integer ? "(true)" : "(false)";
+            break;
+        case RespType::Error:
+            out = "(error) " + std::string(text);
+            break;
+        case RespType::Array:
+        case RespType::Map:
+        case RespType::Set:
+        case RespType::Push:
+            out = "[";
+            for (size_t i = 0; i < count && out.size() < maxLength; ++i) {
+                out += (i == 0 ? "" : ", ") + elements[i].describe(maxLength - out.size());
+            }
+            out += "]";
+            break;
+        default:
+            out = std::string(text.substr(0, maxLength));
+            break;
+    }
+    if (out.size() > maxLength) {
+        out.resize(maxLength);
+        out += "...";
+    }
+    return out;
+}
+
+// ================== RespParser ==================
+
+RespParser::RespParser(size_t initialCapacity) : buffer(std::max<size_t>(initialCapacity, 64)) {
+}
+
+char* RespParser::prepare(size_t minSize) {
+    if (writableSize() < minSize) {
+        // 先把未读数据挪到开头，仍不够再扩容；扩容按倍数增长，摊销后每字节只拷贝常数次
+        size_t unread = buffered();
+        if (readPos > 0) {
+            std::memmove(buffer.data(), buffer.data() + readPos, unread);
+            readPos = 0;
+            writePos = unread;
+        }
+        if (writableSize() < minSize) {
+            buffer.resize(std::max(buffer.size() * 2, writePos + minSize));
+        }
+    }
+    return buffer.data() + writePos;
+}
+
+void RespParser::commit(size_t length) {
+    writePos = std::min(writePos + length, buffer.size());
+}
+
+void RespParser::feed(const char* data, size_t length) {
+    std::memcpy(prepare(length), data, length);
+    commit(length);
+}
+
+void RespParser::reset() {
+    readPos = 0;
+    writePos = 0;
+    incompleteUntil = 0;
+    lastError.clear();
+}
+
+RespParser::Status RespParser::incomplete(size_t needed) {
+    incompleteUntil = needed - readPos;
+    return Status::Incomplete;
+}
+
+RespParser::Status RespParser::fail(const std::string& message) {
+    lastError = message;
+    return Status::ProtocolError;
+}
+
+RespParser::Status RespParser::next(RespReply& reply) {
+    if (!lastError.empty()) {
+        return Status::ProtocolError;
+    }
+    if (buffered() == 0 || buffered() < incompleteUntil) {
+        return Status::Incomplete;
+    }
+
+    nodes.clear();
+    links.clear();
+    nodes.emplace_back();
+    size_t pos = readPos;
+    Status status = parseValue(pos, 0, 0);
+    if (status != Status::Complete) {
+        return status;
+    }
+
+    // nodes 在解析过程中可能扩容，子元素指针等全部槽位确定后再补上
+    for (const auto& link : links) {
+        nodes[link.first].elements = nodes.data() + link.second;
+    }
+    reply = nodes[0];
+    readPos = pos;
+    incompleteUntil = 0;
+    if (readPos == writePos) {
+        // 缓冲区读空时回到开头，下一次 prepare 不必搬移数据（reply 中的视图在写入新数据前仍然有效）
+        readPos = 0;
+        writePos = 0;
+    }
+    return Status::Complete;
+}
+
+RespParser::Status RespParser::parseLine(size_t& pos, std::string_view& line) {
+    const char* start = buffer.data() + pos;
+    size_t available = writePos - pos;
+    const void* newline = std::memchr(start, '\n', std::min(available, MAX_INLINE_LENGTH));
+    if (!newline) {
+        if (available >= MAX_INLINE_LENGTH) {
+            return fail("单行回复超过 " + std::to_string(MAX_INLINE_LENGTH) + " 字节");
+        }
+        return incomplete(writePos + 1);
+    }
+    size_t length = static_cast<const char*>(newline) - start;
+    if (length == 0 || start[length - 1] != '\r') {
+        return fail("行尾缺少 \\r");
+    }
+    line = std::string_view(start, length - 1);
+    pos += length + 1;
+    return Status::Complete;
+}
+
+RespParser::Status RespParser::parseInteger(std::string_view line, long long& value) {
+    if (line.empty()) {
+        return fail("整数为空");
+    }
+    const char* begin = line.data();
+    const char* end = begin + line.size();
+    // from_chars 不接受前导 '+'，RESP 也不会发送
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc() || result.ptr != end) {
+        return fail("无效的整数: " + std::string(line.substr(0, 32)));
+    }
+    return Status::Complete;
+}
+
+RespParser::Status RespParser::parseValue(size_t& pos, size_t slot, size_t depth) {
+    if (depth > MAX_DEPTH) {
+        return fail("回复嵌套超过 " + std::to_string(MAX_DEPTH) + " 层");
+    }
+    if (pos >= writePos) {
+        return incomplete(pos + 1);
+    }
+
+    char prefix = buffer[pos++];
+    std::string_view line;
+    Status status = parseLine(pos, line);
+    if (status != Status::Complete) {
+        return status;
+    }
+
+    RespReply& reply = nodes[slot];
+    switch (prefix) {
+        case '+':
+            reply.type = RespType::Status;
+            reply.text = line;
+            return Status::Complete;
+        case '-':
+            reply.type = RespType::Error;
+            reply.text = line;
+            return Status::Complete;
+        case ',':
+            reply.type = RespType::Double;
+            reply.text = line;
+            return line.empty() ? fail("浮点数为空") : Status::Complete;
+        case '(':
+            reply.type = RespType::BigNumber;
+            reply.text = line;
+            return line.empty() ? fail("大数为空") : Status::Complete;
+        case ':':
+            reply.type = RespType::Integer;
+            return parseInteger(line, reply.integer);
+        case '_':
+            reply.type = RespType::Null;
+            return line.empty() ? Status::Complete : fail("空值后有多余内容");
+        case '#':
+            if (line != "t" && line != "f") {
+                return fail("无效的布尔值");
+            }
+            reply.type = RespType::Boolean;
+            reply.integer = line == "t" ? 1 : 0;
+            return Status::Complete;
+        case '$':
+        case '=':
+        case '!': {
+            if (line == "?") {
+                return fail("不支持 RESP3 流式字符串");
+            }
+            long long length = 0;
+            if ((status = parseInteger(line, length)) != Status::Complete) {
+                return status;
+            }
+            if (length == -1 && prefix == '$') {
+                reply.type = RespType::Null;
+                return Status::Complete;
+            }
+            if (length < 0 || length > MAX_BULK_LENGTH) {
+                return fail("无效的字符串长度: " + std::to_string(length));
+            }
+            // 内容不扫描：长度足够就直接定位到末尾的 \r\n
+            size_t end = pos + static_cast<size_t>(length);
+            if (end + 2 > writePos) {
+                return incomplete(end + 2);
+            }
+            if (buffer[end] != '\r' || buffer[end + 1] != '\n') {
+                return fail("字符串内容后缺少 \\r\\n");
+            }
+            std::string_view content(buffer.data() + pos, static_cast<size_t>(length));
+            pos = end + 2;
+            if (prefix == '=') {
+                // Verbatim 字符串以三字符格式名加冒号开头（如 "txt:"）
+                if (content.size() < 4 || content[3] != ':') {
+                    return fail("无效的 Verbatim 字符串");
+                }
+                content.remove_prefix(4);
+            }
+            // reply 引用的槽位在本分支内没有扩容，仍然有效
+            nodes[slot].type = prefix == '!' ? RespType::Error : RespType::Bulk;
+            nodes[slot].text = content;
+            return Status::Complete;
+        }
+        case '*':
+        case '%':
+        case '~':
+        case '>':
+        case '|': {
+            long long count = 0;
+            if ((status = parseInteger(line, count)) != Status::Complete) {
+                return status;
+            }
+            if (count == -1 && prefix == '*') {
+                reply.type = RespType::Null;
+                return Status::Complete;
+            }
+            if (count < 0 || count > MAX_AGGREGATE_COUNT) {
+                return fail("无效的元素个数: " + std::to_string(count));
+            }
+            size_t elements = static_cast<size_t>(prefix == '%' || prefix == '|' ? count * 2 : count);
+            if (writePos - pos < elements * MIN_ELEMENT_BYTES) {
+                return incomplete(pos + elements * MIN_ELEMENT_BYTES);
+            }
+
+            // 子元素占用一段连续槽位；下面的递归会让 nodes 扩容，之后只通过下标访问
+            size_t first = nodes.size();
+            nodes.resize(first + elements);
+            for (size_t i = 0; i < elements; ++i) {
+                if ((status = parseValue(pos, first + i, depth + 1)) != Status::Complete) {
+                    return status;
+                }
+            }
+
+            if (prefix == '|') {
+                // 属性是附加在下一条回复上的元数据，丢弃后解析真正的回复写入同一槽位；
+                // 计入嵌套层数，连续的属性前缀不会无限递归
+                return parseValue(pos, slot, depth + 1);
+            }
+            RespReply& aggregate = nodes[slot];
+            aggregate.type = prefix == '*' ? RespType::Array
+                           : prefix == '%' ? RespType::Map
+                           : prefix == '~' ? RespType::Set
+                           : RespType::Push;
+            aggregate.count = elements;
+            if (elements > 0) {
+                links.emplace_back(slot, first);
+            }
+            return Status::Complete;
+        }
+        default:
+            return fail(std::string("未知的回复类型: 0x") + "0123456789abcdef"[(prefix >> 4) & 0xF] +
+                        "0123456789abcdef"[prefix & 0xF]);
+    }
+}
+
+// ================== 命令编码 ==================
+
+void appendRespHeader(std::string& out, char prefix, size_t value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out += prefix;
+    out.append(digits, end);
+    out += "\r\n";
+}
+
+void appendRespCommand(std::string& out, std::initializer_list<std::string_view> args) {
+    appendArgs(out, args);
+}
+
+void appendRespCommand(std::string& out, const std::vector<std::string_view>& args) {
+    appendArgs(out, args);
+}
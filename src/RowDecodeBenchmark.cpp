@@ -0,0 +1,242 @@
+#include "RowDecodeBenchmark.h"
+
+namespace {
+    const unsigned int DOCUMENT_FIELDS = 10;
+    const unsigned int USER_FIELDS = 7;
+
+    std::string randomText(std::mt19937_64& rng, size_t minLength, size_t maxLength) {
+        static const char letters[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-.";
+        std::string text(minLength + rng() % (maxLength - minLength + 1), 'a');
+        for (char& c : text) {
+            c = letters[rng() % (sizeof(letters) - 1)];
+        }
+        return text;
+    }
+
+    // 2020-01-01 起约六年内的随机时刻，按本地时间格式化，与 MySQL DATETIME 的文本形式一致
+    std::string randomTimestamp(std::mt19937_64& rng) {
+        auto seconds = std::chrono::seconds(1577836800LL + static_cast<long long>(rng() % (6LL * 365 * 86400)));
+        return Utils::formatTimestamp(std::chrono::system_clock::time_point(seconds));
+    }
+
+    // 改造前 DatabaseManager 中的行映射，保留在这里作为对照
+    void legacyDecodeDocument(MYSQL_ROW row, Document& doc) {
+        doc.id = std::stoi(row[0]);
+        doc.title = row[1] ? row[1] : "";
+        doc.description = row[2] ? row[2] : "";
+        doc.file_path = row[3] ? row[3] : "";
+        doc.minio_key = row[4] ? row[4] : "";
+        doc.owner_id = std::stoi(row[5]);
+        doc.created_at = Utils::parseTimestamp(row[6] ? row[6] : "");
+        doc.updated_at = Utils::parseTimestamp(row[7] ? row[7] : "");
+        doc.file_size = std::stoull(row[8] ? row[8] : "0");
+        doc.content_type = row[9] ? row[9] : "application/octet-stream";
+    }
+
+    void legacyDecodeUser(MYSQL_ROW row, User& user) {
+        user.id = std::stoi(row[0]);
+        user.username = row[1] ? row[1] : "";
+        user.password_hash = row[2] ? row[2] : "";
+        user.email = row[3] ? row[3] : "";
+        user.created_at = Utils::parseTimestamp(row[4] ? row[4] : "");
+        user.last_login = row[5] ? Utils::parseTimestamp(row[5]) : std::chrono::system_clock::now();
+        user.is_active = row[6] && std::stoi(row[6]) != 0;
+    }
+
+    std::string mismatch(const char* table, size_t row, const char* column) {
+        return std::string("解码结果与原值不一致: ") + table + " 第 " + std::to_string(row + 1) + " 行 " + column;
+    }
+}
+
+RowDecodeBenchmark::RowDecodeBenchmark(const RowDecodeBenchmarkOptions& options) : options(options) {
+}
+
+void RowDecodeBenchmark::appendCell(SyntheticRows& rows, std::string value, bool null) {
+    rows.cells.push_back(null ? std::string() : std::move(value));
+    rows.nulls.push_back(null);
+}
+
+void RowDecodeBenchmark::finish(SyntheticRows& rows) {
+    rows.rows.resize(rows.cells.size());
+    rows.lengths.resize(rows.cells.size());
+    for (size_t i = 0; i < rows.cells.size(); ++i) {
+        rows.rows[i] = rows.nulls[i] ? nullptr : &rows.cells[i][0];
+        rows.lengths[i] = static_cast<unsigned long>(rows.cells[i].size());
+    }
+}
+
+void RowDecodeBenchmark::generate() {
+    std::mt19937_64 rng(options.seed);
+    size_t count = static_cast<size_t>(std::max(1, options.rows));
+
+    // documents 查询的列顺序：id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type
+    documents = SyntheticRows();
+    documents.fieldCount = DOCUMENT_FIELDS;
+    for (size_t i = 0; i < count; ++i) {
+        // 随机数按固定顺序取用，保证相同种子在任何编译器下生成相同数据
+        std::string ownerId = std::to_string(1 + rng() % 5000);
+        std::string key = "documents/" + ownerId + "/" + randomText(rng, 16, 32);
+        bool descriptionNull = rng() % 5 == 0;
+        bool contentTypeNull = rng() % 10 == 0;
+        appendCell(documents, std::to_string(i + 1));
+        appendCell(documents, randomText(rng, 8, 60));
+        appendCell(documents, randomText(rng, 0, 200), descriptionNull);
+        appendCell(documents, "/uploads/" + randomText(rng, 8, 40));
+        appendCell(documents, key);
+        appendCell(documents, ownerId);
+        appendCell(documents, randomTimestamp(rng));
+        appendCell(documents, randomTimestamp(rng));
+        appendCell(documents, std::to_string(rng() % 2000000000ULL));
+        appendCell(documents, "application/pdf", contentTypeNull);
+    }
+    finish(documents);
+
+    // users 查询的列顺序：id, username, password_hash, email, created_at, last_login, is_active
+    users = SyntheticRows();
+    users.fieldCount = USER_FIELDS;
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = randomText(rng, 4, 20);
+        bool lastLoginNull = rng() % 4 == 0;
+        bool active = rng() % 8 != 0;
+        appendCell(users, std::to_string(i + 1));
+        appendCell(users, name);
+        appendCell(users, Utils::sha256Hash(name));
+        appendCell(users, name + "@example.com");
+        appendCell(users, randomTimestamp(rng));
+        appendCell(users, randomTimestamp(rng), lastLoginNull);
+        appendCell(users, active ? "1" : "0");
+    }
+    finish(users);
+}
+
+Result<bool> RowDecodeBenchmark::verify() {
+    // 时间按本地时间格式化回文本比较，夏令时回拨的重复小时两种解释格式化后相同
+    Document doc;
+    for (size_t i = 0; i < documents.rowCount(); ++i) {
+        decodeDocument(RowDecoder(documents.row(i), documents.rowLengths(i), documents.fieldCount), doc);
+        const std::string* cell = documents.cells.data() + i * DOCUMENT_FIELDS;
+        bool contentTypeNull = documents.nulls[i * DOCUMENT_FIELDS + 9];
+
+        const char* column = nullptr;
+        if (std::to_string(doc.id) != cell[0]) {
+            column = "id";
+        } else if (doc.title != cell[1] || doc.description != cell[2] || doc.file_path != cell[3] || doc.minio_key != cell[4]) {
+            column = "title/description/file_path/minio_key";
+        } else if (std::to_string(doc.owner_id) != cell[5]) {
+            column = "owner_id";
+        } else if (Utils::formatTimestamp(doc.created_at) != cell[6] || Utils::formatTimestamp(doc.updated_at) != cell[7]) {
+            column = "created_at/updated_at";
+        } else if (std::to_string(doc.file_size) != cell[8]) {
+            column = "file_size";
+        } else if (doc.content_type != (contentTypeNull ? std::string("application/octet-stream") : cell[9])) {
+            column = "content_type";
+        }
+        if (column) {
+            return Result<bool>::Error(mismatch("documents", i, column));
+        }
+    }
+
+    User user;
+    for (size_t i = 0; i < users.rowCount(); ++i) {
+        decodeUser(RowDecoder(users.row(i), users.rowLengths(i), users.fieldCount), user);
+        const std::string* cell = users.cells.data() + i * USER_FIELDS;
+        bool lastLoginNull = users.nulls[i * USER_FIELDS + 5];
+
+        const char* column = nullptr;
+        if (std::to_string(user.id) != cell[0]) {
+            column = "id";
+        } else if (user.username != cell[1] || user.password_hash != cell[2] || user.email != cell[3]) {
+            column = "username/password_hash/email";
+        } else if (Utils::formatTimestamp(user.created_at) != cell[4]) {
+            column = "created_at";
+        } else if (!lastLoginNull && Utils::formatTimestamp(user.last_login) != cell[5]) {
+            column = "last_login";
+        } else if (user.is_active != (cell[6] == "1")) {
+            column = "is_active";
+        }
+        if (column) {
+            return Result<bool>::Error(mismatch("users", i, column));
+        }
+    }
+    return Result<bool>::Success(true);
+}
+
+// 两张表的行交替解码进复用的对象（与流式查询相同），每轮结束检查一次时间；返回每秒解码的行数
+double RowDecodeBenchmark::measure(bool legacy) {
+    Document doc;
+    User user;
+    uint64_t rows = 0;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(options.durationMs);
+    do {
+        for (size_t i = 0; i < documents.rowCount(); ++i) {
+            if (legacy) {
+                legacyDecodeDocument(documents.row(i), doc);
+            } else {
+                decodeDocument(RowDecoder(documents.row(i), documents.rowLengths(i), documents.fieldCount), doc);
+            }
+            checksum += static_cast<uint64_t>(doc.id) + doc.file_size + doc.title.size();
+        }
+        for (size_t i = 0; i < users.rowCount(); ++i) {
+            if (legacy) {
+                legacyDecodeUser(users.row(i), user);
+            } else {
+                decodeUser(RowDecoder(users.row(i), users.rowLengths(i), users.fieldCount), user);
+            }
+            checksum += static_cast<uint64_t>(user.id) + user.username.size();
+        }
+        rows += documents.rowCount() + users.rowCount();
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    // 使用校验和，避免解码结果被整体优化掉
+    volatile uint64_t sink = checksum;
+    (void)sink;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds > 0 ? static_cast<double>(rows) / seconds : 0;
+}
+
+Result<RowDecodeBenchmarkReport> RowDecodeBenchmark::run(const std::function<void(const std::string&)>& progress) {
+    auto report = [&](const std::string& text) {
+        if (progress) {
+            progress(text);
+        }
+    };
+
+    RowDecodeBenchmarkReport result;
+    generate();
+    result.rows = documents.rowCount() + users.rowCount();
+    for (unsigned long length : documents.lengths) {
+        result.rowBytes += length;
+    }
+    for (unsigned long length : users.lengths) {
+        result.rowBytes += length;
+    }
+    report("生成 " + std::to_string(documents.rowCount()) + " 行文档与 " + std::to_string(users.rowCount()) +
+           " 行用户，共 " + std::to_string(result.rowBytes) + " 字节");
+
+    auto verified = verify();
+    if (!verified.success) {
+        return Result<RowDecodeBenchmarkReport>::Error(verified.message);
+    }
+    report("RowDecoder 解码结果校验通过");
+
+    result.legacyRowsPerSecond = measure(true);
+    report("旧映射测试完成");
+    result.decoderRowsPerSecond = measure(false);
+    report("RowDecoder 测试完成");
+    result.speedup = result.legacyRowsPerSecond > 0 ? result.decoderRowsPerSecond / result.legacyRowsPerSecond : 0;
+    return Result<RowDecodeBenchmarkReport>::Success(result, "结果行解码基准测试完成");
+}
+
+std::string RowDecodeBenchmark::formatReport(const RowDecodeBenchmarkReport& report) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "测试数据:       " << report.rows << " 行, " << report.rowBytes << " 字节\n";
+    out << "旧映射:         " << report.legacyRowsPerSecond << " 行/秒（stoi/stoull + parseTimestamp）\n";
+    out << "RowDecoder:     " << report.decoderRowsPerSecond << " 行/秒（from_chars + 原地赋值）\n";
+    out << std::setprecision(2);
+    out << "加速比:         " << report.speedup << "x\n";
+    return out.str();
+}
@@ -0,0 +1,120 @@
+#include "RowDecoder.h"
+#include "QueryStats.h"
+
+RowDecoder::RowDecoder(MYSQL_RES* result, MYSQL_ROW row)
+    : RowDecoder(row, mysql_fetch_lengths(result), mysql_num_fields(result)) {
+}
+
+RowDecoder::RowDecoder(MYSQL_ROW row, const unsigned long* lengths, unsigned int fieldCount)
+    : row(row), lengths(lengths), fieldCount(fieldCount) {
+    // 每行只构造一次解码器，在这里把行数与字节数记到当前方法上
+    if (QueryTimer* timer = QueryTimer::current()) {
+        size_t bytes = 0;
+        for (unsigned int i = 0; lengths && i < fieldCount; ++i) {
+            bytes += lengths[i];
+        }
+        timer->addRow(bytes);
+    }
+}
+
+bool RowDecoder::isNull(size_t index) const {
+    return index >= fieldCount || row[index] == nullptr;
+}
+
+std::string_view RowDecoder::getView(size_t index) const {
+    if (isNull(index)) {
+        return std::string_view();
+    }
+    return std::string_view(row[index], lengths[index]);
+}
+
+int RowDecoder::getInt(size_t index, int defaultValue) const {
+    return parseNumber<int>(getView(index), defaultValue);
+}
+
+long long RowDecoder::getInt64(size_t index, long long defaultValue) const {
+    return parseNumber<long long>(getView(index), defaultValue);
+}
+
+unsigned long long RowDecoder::getUInt64(size_t index, unsigned long long defaultValue) const {
+    return parseNumber<unsigned long long>(getView(index), defaultValue);
+}
+
+void RowDecoder::getString(size_t index, std::string& out, std::string_view defaultValue) const {
+    std::string_view value = isNull(index) ? defaultValue : getView(index);
+    out.assign(value.data(), value.size());
+}
+
+std::string RowDecoder::getString(size_t index) const {
+    std::string_view value = getView(index);
+    return std::string(value.data(), value.size());
+}
+
+std::chrono::system_clock::time_point RowDecoder::getTimestamp(size_t index,
+                                                               std::chrono::system_clock::time_point fallback) const {
+    std::chrono::system_clock::time_point value;
+    if (isNull(index) || !parseDateTime(getView(index), value)) {
+        return fallback;
+    }
+    return value;
+}
+
+QueryResult readQueryResult(MYSQL* db, MYSQL_RES* result) {
+    QueryResult rows;
+    if (!result) {
+        rows.setModification(mysql_affected_rows(db), mysql_insert_id(db));
+        return rows;
+    }
+
+    unsigned int fieldCount = mysql_num_fields(result);
+    MYSQL_FIELD* fields = mysql_fetch_fields(result);
+    std::vector<std::string> names;
+    names.reserve(fieldCount);
+    for (unsigned int i = 0; i < fieldCount; ++i) {
+        names.emplace_back(fields[i].name);
+    }
+    rows.setColumns(std::move(names));
+
+    // store_result 已把全部行取到客户端，可以一次性预留空间
+    rows.reserve(static_cast<size_t>(mysql_num_rows(result)));
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result))) {
+        rows.appendRow(row, mysql_fetch_lengths(result));
+    }
+    rows.shrinkToFit();
+    return rows;
+}
+
+void decodeUser(const RowDecoder& row, User& user) {
+    user.id = row.getInt(0);
+    row.getString(1, user.username);
+    row.getString(2, user.password_hash);
+    row.getString(3, user.email);
+    user.created_at = row.getTimestamp(4);
+    // 从未登录（NULL）时沿用以当前时间占位的约定
+    user.last_login = row.isNull(5) ? std::chrono::system_clock::now() : row.getTimestamp(5);
+    user.is_active = row.getBool(6);
+}
+
+void decodeDocument(const RowDecoder& row, Document& doc) {
+    doc.id = row.getInt(0);
+    row.getString(1, doc.title);
+    row.getString(2, doc.description);
+    row.getString(3, doc.file_path);
+    row.getString(4, doc.minio_key);
+    doc.owner_id = row.getInt(5);
+    doc.created_at = row.getTimestamp(6);
+    doc.updated_at = row.getTimestamp(7);
+    doc.file_size = static_cast<size_t>(row.getUInt64(8));
+    row.getString(9, doc.content_type, "application/octet-stream");
+}
+
+void decodeDocumentShare(const RowDecoder& row, DocumentShare& share) {
+    share.id = row.getInt(0);
+    share.document_id = row.getInt(1);
+    share.shared_by_user_id = row.getInt(2);
+    share.shared_to_user_id = row.getInt(3);
+    share.shared_document_id = row.getInt(4);
+    row.getString(5, share.shared_minio_key);
+    share.created_at = row.getTimestamp(6);
+}
@@ -0,0 +1,2056 @@
+#include "SqliteStorageBackend.h"
+#include "TextDecoding.h"
+#include "Logger.h"
+#include "TransactionScope.h"
+#include <QFileInfo>
+#include <QDir>
+
+namespace {
+    // 当前线程最近一次失败的 SQLite 扩展错误码，开启事务时清零
+    thread_local int lastErrorCode = SQLITE_OK;
+
+    // 软删除条件与 MySQL 后端相同：被删除用户的文档按所有者过滤
+    const std::string DELETED_USER_IDS = "(SELECT id FROM users WHERE deleted_at IS NOT NULL)";
+
+    std::string liveDocument(const std::string& alias = "") {
+        return alias + "deleted_at IS NULL AND " + alias + "owner_id NOT IN " + DELETED_USER_IDS;
+    }
+
+    // 分享的可见条件同样与 MySQL 后端相同：删除用户或文档时分享记录留到 purgeDeleted 清理，读取时隐藏
+    const std::string LIVE_SHARE_INBOX =
+            "share_inbox.shared_by_user_id NOT IN " + DELETED_USER_IDS +
+            " AND NOT EXISTS (SELECT 1 FROM document_shares ds INNER JOIN documents d"
+            " ON d.id = ds.document_id OR d.id = ds.shared_document_id"
+            " WHERE ds.id = share_inbox.id AND d.deleted_at IS NOT NULL)";
+    const std::string LIVE_SHARE =
+            "shared_by_user_id NOT IN " + DELETED_USER_IDS + " AND shared_to_user_id NOT IN " + DELETED_USER_IDS +
+            " AND NOT EXISTS (SELECT 1 FROM documents d WHERE d.id IN (document_shares.document_id, "
+            "document_shares.shared_document_id) AND d.deleted_at IS NOT NULL)";
+
+    const std::string SQL_USER_BY_ID =
+            "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+            "WHERE id = ? AND deleted_at IS NULL";
+    const std::string SQL_USER_BY_USERNAME =
+            "SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+            "WHERE username = ? AND deleted_at IS NULL";
+    const std::string SQL_INSERT_USER =
+            "INSERT INTO users (username, password_hash, email) VALUES (?, ?, ?)";
+    const std::string SQL_DOCUMENT_BY_ID =
+            "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type "
+            "FROM documents WHERE id = ? AND " + liveDocument();
+    const std::string SQL_INSERT_DOCUMENT =
+            "INSERT INTO documents (title, description, file_path, minio_key, owner_id, file_size, content_type) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?)";
+    const std::string SQL_DOCUMENT_SHARE_EXISTS =
+            "SELECT COUNT(*) FROM document_shares WHERE document_id = ? AND shared_by_user_id = ? AND shared_to_user_id = ? AND " +
+            LIVE_SHARE;
+    // share_inbox 中与 documents 同序的列表字段，可直接交给 readDocumentRow
+    const std::string SHARE_INBOX_DOCUMENT_COLUMNS =
+            "document_id, title, description, file_path, minio_key, owner_id, document_created_at, "
+            "document_updated_at, file_size, content_type";
+    // 从分享记录及其副本文档生成收件箱行，调用方追加 WHERE 条件
+    const std::string SQL_FILL_SHARE_INBOX =
+            "INSERT OR IGNORE INTO share_inbox (shared_to_user_id, created_at, id, shared_by_user_id, " +
+            SHARE_INBOX_DOCUMENT_COLUMNS + ") "
+            "SELECT ds.shared_to_user_id, ds.created_at, ds.id, ds.shared_by_user_id, d.id, d.title, d.description, "
+            "d.file_path, ds.shared_minio_key, d.owner_id, d.created_at, d.updated_at, d.file_size, d.content_type "
+            "FROM document_shares ds INNER JOIN documents d ON d.id = ds.shared_document_id";
+    // 分享副本被修改后同步收件箱；minio_key 保持分享时复制出的键
+    const std::string SQL_SYNC_SHARE_INBOX =
+            "UPDATE share_inbox SET (title, description, file_path, owner_id, document_updated_at, file_size, content_type) = "
+            "(SELECT title, description, file_path, owner_id, updated_at, file_size, content_type FROM documents WHERE id = ?) "
+            "WHERE document_id = ?";
+    const std::string SQL_USAGE_STATS =
+            "SELECT user_count, document_count, total_bytes, shares_given, shares_received FROM usage_stats WHERE owner_id = ?";
+
+    const int MAX_PAGE_SIZE = 1000;
+
+    // 列顺序与上面的 SELECT 一致；对象在流式遍历中复用，逐字段覆盖
+    void readUserRow(const SqliteStatement& stmt, User& user) {
+        user.id = stmt.getInt(0);
+        user.username = stmt.getString(1);
+        user.password_hash = stmt.getString(2);
+        user.email = stmt.getString(3);
+        user.created_at = stmt.getTimestamp(4);
+        user.last_login = stmt.isNull(5) ? std::chrono::system_clock::now() : stmt.getTimestamp(5);
+        user.is_active = stmt.getInt(6) != 0;
+    }
+
+    void readDocumentRow(const SqliteStatement& stmt, Document& doc) {
+        doc.id = stmt.getInt(0);
+        doc.title = stmt.getString(1);
+        doc.description = stmt.getString(2);
+        doc.file_path = stmt.getString(3);
+        doc.minio_key = stmt.getString(4);
+        doc.owner_id = stmt.getInt(5);
+        doc.created_at = stmt.getTimestamp(6);
+        doc.updated_at = stmt.getTimestamp(7);
+        doc.file_size = static_cast<size_t>(stmt.getInt64(8));
+        doc.content_type = stmt.getString(9);
+    }
+
+    // 时间列统一存本地时间文本，格式与 MySQL TIMESTAMP 的文本形式一致，分页令牌可以通用。
+    // 修改结构时递增 SCHEMA_VERSION，脚本本身必须可重复执行
+    const int SCHEMA_VERSION = 4;
+    // 从版本 1、2 升级：已有的表补上软删除列（SQLite 没有 ADD COLUMN IF NOT EXISTS），新建的库由 SCHEMA 直接建出
+    const char* SCHEMA_SOFT_DELETE_COLUMNS = R"(
+        ALTER TABLE users ADD COLUMN deleted_at TEXT;
+        ALTER TABLE documents ADD COLUMN deleted_at TEXT;
+    )";
+    const char* SCHEMA = R"(
+        CREATE TABLE IF NOT EXISTS users (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            username TEXT NOT NULL UNIQUE,
+            password_hash TEXT NOT NULL,
+            email TEXT NOT NULL UNIQUE,
+            created_at TEXT NOT NULL DEFAULT (datetime('now', 'localtime')),
+            last_login TEXT,
+            is_active INTEGER NOT NULL DEFAULT 1,
+            deleted_at TEXT
+        );
+
+        CREATE TABLE IF NOT EXISTS documents (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            title TEXT NOT NULL,
+            description TEXT,
+            file_path TEXT,
+            minio_key TEXT,
+            owner_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+            created_at TEXT NOT NULL DEFAULT (datetime('now', 'localtime')),
+            updated_at TEXT NOT NULL DEFAULT (datetime('now', 'localtime')),
+            file_size INTEGER NOT NULL DEFAULT 0,
+            content_type TEXT DEFAULT '',
+            deleted_at TEXT
+        );
+
+        CREATE TABLE IF NOT EXISTS document_shares (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            document_id INTEGER NOT NULL REFERENCES documents(id) ON DELETE CASCADE,
+            shared_by_user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+            shared_to_user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+            shared_document_id INTEGER NOT NULL REFERENCES documents(id) ON DELETE CASCADE,
+            shared_minio_key TEXT,
+            created_at TEXT NOT NULL DEFAULT (datetime('now', 'localtime')),
+            UNIQUE (document_id, shared_by_user_id, shared_to_user_id)
+        );
+
+        -- 分享收件箱：WITHOUT ROWID 表按主键聚簇存放，一个接收人的分享连续存放，列表只做一次主键范围扫描。
+        -- id 与 document_shares.id 相同，删除分享时经外键一并删除
+        CREATE TABLE IF NOT EXISTS share_inbox (
+            shared_to_user_id INTEGER NOT NULL,
+            created_at TEXT NOT NULL,
+            id INTEGER NOT NULL UNIQUE REFERENCES document_shares(id) ON DELETE CASCADE,
+            shared_by_user_id INTEGER NOT NULL,
+            document_id INTEGER NOT NULL,
+            title TEXT NOT NULL,
+            description TEXT,
+            file_path TEXT,
+            minio_key TEXT,
+            owner_id INTEGER NOT NULL,
+            document_created_at TEXT,
+            document_updated_at TEXT,
+            file_size INTEGER NOT NULL DEFAULT 0,
+            content_type TEXT DEFAULT '',
+            PRIMARY KEY (shared_to_user_id, created_at, id)
+        ) WITHOUT ROWID;
+
+        CREATE TABLE IF NOT EXISTS usage_stats (
+            owner_id INTEGER PRIMARY KEY,
+            user_count INTEGER NOT NULL DEFAULT 0,
+            document_count INTEGER NOT NULL DEFAULT 0,
+            total_bytes INTEGER NOT NULL DEFAULT 0,
+            shares_given INTEGER NOT NULL DEFAULT 0,
+            shares_received INTEGER NOT NULL DEFAULT 0,
+            updated_at TEXT NOT NULL DEFAULT (datetime('now', 'localtime'))
+        );
+
+        CREATE TABLE IF NOT EXISTS roles (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            role_name TEXT NOT NULL UNIQUE,
+            role_code TEXT NOT NULL UNIQUE,
+            description TEXT,
+            is_active INTEGER DEFAULT 1,
+            is_system INTEGER DEFAULT 0,
+            created_at TEXT DEFAULT (datetime('now', 'localtime')),
+            updated_at TEXT DEFAULT (datetime('now', 'localtime')),
+            created_by INTEGER,
+            updated_by INTEGER
+        );
+
+        CREATE TABLE IF NOT EXISTS menus (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            code TEXT NOT NULL UNIQUE,
+            parent_id INTEGER DEFAULT NULL REFERENCES menus(id) ON DELETE CASCADE,
+            type TEXT DEFAULT 'MENU' CHECK (type IN ('DIRECTORY', 'MENU', 'BUTTON')),
+            url TEXT,
+            icon TEXT,
+            permission_key TEXT,
+            button_type TEXT CHECK (button_type IN ('ADD', 'EDIT', 'DELETE', 'VIEW', 'EXPORT', 'IMPORT', 'CUSTOM')),
+            sort_order INTEGER DEFAULT 0,
+            is_visible INTEGER DEFAULT 1,
+            is_active INTEGER DEFAULT 1,
+            description TEXT,
+            created_at TEXT DEFAULT (datetime('now', 'localtime')),
+            updated_at TEXT DEFAULT (datetime('now', 'localtime')),
+            created_by INTEGER,
+            updated_by INTEGER
+        );
+
+        CREATE TABLE IF NOT EXISTS user_roles (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+            role_id INTEGER NOT NULL REFERENCES roles(id) ON DELETE CASCADE,
+            assigned_at TEXT DEFAULT (datetime('now', 'localtime')),
+            assigned_by INTEGER,
+            is_active INTEGER DEFAULT 1,
+            expires_at TEXT,
+            UNIQUE (user_id, role_id)
+        );
+
+        CREATE TABLE IF NOT EXISTS role_menus (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            role_id INTEGER NOT NULL REFERENCES roles(id) ON DELETE CASCADE,
+            menu_id INTEGER NOT NULL REFERENCES menus(id) ON DELETE CASCADE,
+            is_granted INTEGER DEFAULT 1,
+            created_at TEXT DEFAULT (datetime('now', 'localtime')),
+            updated_at TEXT DEFAULT (datetime('now', 'localtime')),
+            created_by INTEGER,
+            UNIQUE (role_id, menu_id)
+        );
+
+        -- 视图定义变化时需要重建（版本 4 起排除软删除的用户）
+        DROP VIEW IF EXISTS user_permissions;
+        CREATE VIEW user_permissions AS
+        SELECT
+            u.id AS user_id,
+            u.username,
+            r.id AS role_id,
+            r.role_name,
+            r.role_code,
+            m.id AS menu_id,
+            m.name AS menu_name,
+            m.code AS menu_code,
+            m.type AS menu_type,
+            m.url,
+            m.permission_key,
+            rm.is_granted,
+            ur.is_active AS role_active,
+            ur.expires_at
+        FROM users u
+        JOIN user_roles ur ON u.id = ur.user_id
+        JOIN roles r ON ur.role_id = r.id
+        JOIN role_menus rm ON r.id = rm.role_id
+        JOIN menus m ON rm.menu_id = m.id
+        WHERE u.is_active = 1
+            AND r.is_active = 1
+            AND ur.is_active = 1
+            AND m.is_active = 1
+            AND rm.is_granted = 1
+            AND (ur.expires_at IS NULL OR ur.expires_at > datetime('now', 'localtime'))
+            AND u.deleted_at IS NULL;
+
+        -- 键集分页所需的 (过滤列, created_at, id) 复合索引；SQLite 不会自动为外键子列建索引，级联删除依赖下面几个
+        CREATE INDEX IF NOT EXISTS idx_users_created_id ON users(created_at, id);
+        CREATE INDEX IF NOT EXISTS idx_documents_created_id ON documents(created_at, id);
+        CREATE INDEX IF NOT EXISTS idx_documents_owner_created_id ON documents(owner_id, created_at, id);
+        CREATE INDEX IF NOT EXISTS idx_shares_to_created_id ON document_shares(shared_to_user_id, created_at, id);
+        CREATE INDEX IF NOT EXISTS idx_shares_by ON document_shares(shared_by_user_id);
+        CREATE INDEX IF NOT EXISTS idx_shares_shared_document ON document_shares(shared_document_id);
+        CREATE INDEX IF NOT EXISTS idx_share_inbox_document ON share_inbox(document_id);
+        -- 清理线程按 deleted_at 查找软删除的行
+        CREATE INDEX IF NOT EXISTS idx_users_deleted_at ON users(deleted_at);
+        CREATE INDEX IF NOT EXISTS idx_documents_deleted_at ON documents(deleted_at);
+        CREATE INDEX IF NOT EXISTS idx_menus_parent_id ON menus(parent_id);
+        CREATE INDEX IF NOT EXISTS idx_user_roles_role_id ON user_roles(role_id);
+        CREATE INDEX IF NOT EXISTS idx_role_menus_menu_id ON role_menus(menu_id);
+    )";
+}
+
+// ================== SqliteConnection ==================
+
+SqliteConnection::SqliteConnection() : handle(nullptr), capacity(64), useTick(0) {
+}
+
+SqliteConnection::~SqliteConnection() {
+    close();
+}
+
+bool SqliteConnection::open(const SqliteOptions& options, bool readOnly) {
+    close();
+    capacity = static_cast<size_t>(std::max(1, options.statementCacheSize));
+
+    // 每条连接只被一个线程使用，关闭 SQLite 内部的连接级互斥
+    int flags = (readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(options.filename.c_str(), &handle, flags, nullptr) != SQLITE_OK) {
+        lastError = handle ? sqlite3_errmsg(handle) : "内存不足";
+        close();
+        return false;
+    }
+    sqlite3_busy_timeout(handle, options.busyTimeoutMs);
+    // 每执行约 1000 条虚拟机指令检查一次调用的截止时间与取消，到期时语句以 SQLITE_INTERRUPT 失败
+    sqlite3_progress_handler(handle, 1000, [](void*) { return CallDeadline::interrupted() ? 1 : 0; }, nullptr);
+
+    // 日志模式记录在数据库文件中，由写连接设置一次即可；内存数据库等不支持 WAL 时保持原模式
+    if (!readOnly) {
+        std::string journalMode;
+        sqlite3_exec(handle, "PRAGMA journal_mode = WAL;", [](void* out, int, char** values, char**) {
+            if (values[0]) {
+                *static_cast<std::string*>(out) = values[0];
+            }
+            return 0;
+        }, &journalMode, nullptr);
+        if (journalMode != "wal") {
+            LOG_WARNING("SQLite 未能启用 WAL 模式，当前日志模式: " + journalMode);
+        }
+    }
+
+    // WAL 下 synchronous=NORMAL 只在检查点时 fsync，断电最多丢失最近提交的事务而不会损坏数据库
+    std::string pragmas = "PRAGMA foreign_keys = ON;"
+                          "PRAGMA synchronous = NORMAL;"
+                          "PRAGMA temp_store = MEMORY;"
+                          "PRAGMA mmap_size = " + std::to_string(std::max(0LL, options.mmapSize)) + ";";
+    if (!exec(pragmas)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SqliteConnection::close() {
+    for (auto& item : statements) {
+        sqlite3_finalize(item.second.stmt);
+    }
+    statements.clear();
+    if (handle) {
+        sqlite3_close_v2(handle);
+        handle = nullptr;
+    }
+}
+
+bool SqliteConnection::exec(const std::string& sql) {
+    char* message = nullptr;
+    if (sqlite3_exec(handle, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK) {
+        lastError = message ? message : sqlite3_errmsg(handle);
+        lastErrorCode = sqlite3_extended_errcode(handle);
+        sqlite3_free(message);
+        return false;
+    }
+    return true;
+}
+
+sqlite3_stmt* SqliteConnection::acquire(const std::string& sql) {
+    if (!handle) {
+        lastError = "数据库未连接";
+        return nullptr;
+    }
+
+    auto it = statements.find(sql);
+    if (it != statements.end() && !it->second.inUse) {
+        it->second.lastUsed = ++useTick;
+        it->second.inUse = true;
+        return it->second.stmt;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    unsigned int prepareFlags = it == statements.end() ? SQLITE_PREPARE_PERSISTENT : 0;
+    if (sqlite3_prepare_v3(handle, sql.c_str(), static_cast<int>(sql.size()), prepareFlags, &stmt, nullptr) != SQLITE_OK) {
+        lastError = sqlite3_errmsg(handle);
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    if (it != statements.end()) {
+        // 缓存中的那条正在使用，这条用完即释放
+        return stmt;
+    }
+
+    if (statements.size() >= capacity) {
+        evictLeastRecentlyUsed();
+    }
+    statements.emplace(sql, Entry{stmt, ++useTick, true});
+    return stmt;
+}
+
+void SqliteConnection::release(const std::string& sql, sqlite3_stmt* stmt) {
+    auto it = statements.find(sql);
+    if (it == statements.end() || it->second.stmt != stmt) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    it->second.inUse = false;
+}
+
+void SqliteConnection::evictLeastRecentlyUsed() {
+    auto victim = statements.end();
+    for (auto it = statements.begin(); it != statements.end(); ++it) {
+        if (!it->second.inUse && (victim == statements.end() || it->second.lastUsed < victim->second.lastUsed)) {
+            victim = it;
+        }
+    }
+    if (victim != statements.end()) {
+        sqlite3_finalize(victim->second.stmt);
+        statements.erase(victim);
+    }
+}
+
+long long SqliteConnection::lastInsertId() const {
+    return handle ? static_cast<long long>(sqlite3_last_insert_rowid(handle)) : 0;
+}
+
+int SqliteConnection::changes() const {
+    return handle ? sqlite3_changes(handle) : 0;
+}
+
+// ================== SqliteStatement ==================
+
+SqliteStatement::SqliteStatement(SqliteConnection& conn, const std::string& sql)
+        : conn(&conn), sql(sql), stmt(conn.acquire(sql)), paramIndex(0), failed(false), finished(false) {
+    if (!stmt) {
+        failed = true;
+        errorMessage = conn.error();
+    }
+}
+
+SqliteStatement::~SqliteStatement() {
+    if (stmt) {
+        conn->release(sql, stmt);
+    }
+}
+
+void SqliteStatement::fail() {
+    failed = true;
+    errorMessage = sqlite3_errmsg(conn->get());
+    lastErrorCode = sqlite3_extended_errcode(conn->get());
+}
+
+SqliteStatement& SqliteStatement::bind(int value) {
+    return bind(static_cast<long long>(value));
+}
+
+SqliteStatement& SqliteStatement::bind(long long value) {
+    if (!failed && sqlite3_bind_int64(stmt, ++paramIndex, value) != SQLITE_OK) {
+        fail();
+    }
+    return *this;
+}
+
+SqliteStatement& SqliteStatement::bind(size_t value) {
+    return bind(static_cast<long long>(value));
+}
+
+SqliteStatement& SqliteStatement::bind(const std::string& value) {
+    if (!failed && sqlite3_bind_text(stmt, ++paramIndex, value.data(), static_cast<int>(value.size()),
+                                     SQLITE_TRANSIENT) != SQLITE_OK) {
+        fail();
+    }
+    return *this;
+}
+
+SqliteStatement& SqliteStatement::bindNull() {
+    if (!failed && sqlite3_bind_null(stmt, ++paramIndex) != SQLITE_OK) {
+        fail();
+    }
+    return *this;
+}
+
+bool SqliteStatement::execute() {
+    while (fetch()) {
+    }
+    return ok();
+}
+
+bool SqliteStatement::fetch() {
+    if (failed || finished) {
+        return false;
+    }
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        return true;
+    }
+    finished = true;
+    if (rc != SQLITE_DONE) {
+        fail();
+    }
+    return false;
+}
+
+size_t SqliteStatement::columnCount() const {
+    return stmt ? static_cast<size_t>(sqlite3_column_count(stmt)) : 0;
+}
+
+bool SqliteStatement::isNull(size_t index) const {
+    return sqlite3_column_type(stmt, static_cast<int>(index)) == SQLITE_NULL;
+}
+
+int SqliteStatement::getInt(size_t index) const {
+    return sqlite3_column_int(stmt, static_cast<int>(index));
+}
+
+long long SqliteStatement::getInt64(size_t index) const {
+    return static_cast<long long>(sqlite3_column_int64(stmt, static_cast<int>(index)));
+}
+
+std::string SqliteStatement::getString(size_t index) const {
+    const unsigned char* text = sqlite3_column_text(stmt, static_cast<int>(index));
+    if (!text) {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, static_cast<int>(index)));
+}
+
+std::chrono::system_clock::time_point SqliteStatement::getTimestamp(size_t index,
+                                                                    std::chrono::system_clock::time_point fallback) const {
+    const unsigned char* text = sqlite3_column_text(stmt, static_cast<int>(index));
+    if (!text) {
+        return fallback;
+    }
+    std::string_view view(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, static_cast<int>(index)));
+    std::chrono::system_clock::time_point value;
+    return parseDateTime(view, value) ? value : fallback;
+}
+
+// ================== SqliteStorageBackend ==================
+
+SqliteStorageBackend::ReadLease::ReadLease(SqliteStorageBackend* owner, std::unique_ptr<SqliteConnection> reader,
+                                           SqliteConnection* conn)
+        : owner(owner), reader(std::move(reader)), conn(conn) {
+}
+
+SqliteStorageBackend::ReadLease::ReadLease(ReadLease&& other) noexcept
+        : owner(other.owner), reader(std::move(other.reader)), conn(other.conn) {
+    other.conn = nullptr;
+}
+
+SqliteStorageBackend::ReadLease::~ReadLease() {
+    if (reader) {
+        owner->releaseReader(std::move(reader));
+    }
+}
+
+SqliteStorageBackend::SqliteStorageBackend() : isConnected(false) {
+}
+
+SqliteStorageBackend::~SqliteStorageBackend() {
+    disconnect();
+}
+
+bool SqliteStorageBackend::connect(const SqliteOptions& opts) {
+    if (writer) {
+        disconnect();
+    }
+    options = opts;
+
+    LOG_INFO("打开SQLite数据库: " + options.filename);
+
+    // 数据库文件所在目录不存在时先创建
+    QFileInfo fileInfo(QString::fromUtf8(options.filename));
+    QDir dataDir = fileInfo.absoluteDir();
+    if (!dataDir.exists() && !dataDir.mkpath(".")) {
+        LOG_ERROR("无法创建数据库目录: " + options.filename);
+        return false;
+    }
+
+    auto conn = std::make_unique<SqliteConnection>();
+    if (!conn->open(options, false)) {
+        LOG_ERROR("无法打开SQLite数据库: " + conn->error());
+        return false;
+    }
+    if (!createTables(*conn)) {
+        LOG_ERROR("初始化数据库结构失败");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        writer = std::move(conn);
+    }
+    isConnected = true;
+
+    {
+        // 只读连接在建表之后打开，按配置预建
+        std::lock_guard<std::mutex> lock(readerMutex);
+        for (int i = 0; i < options.readConnections; ++i) {
+            auto reader = std::make_unique<SqliteConnection>();
+            if (!reader->open(options, true)) {
+                LOG_WARNING("打开SQLite只读连接失败: " + reader->error());
+                break;
+            }
+            idleReaders.push_back(std::move(reader));
+        }
+    }
+    LOG_INFO("SQLite数据库已打开: " + options.filename + "，只读连接 " + std::to_string(idleReaders.size()) +
+             " 条，mmap " + std::to_string(options.mmapSize / (1024 * 1024)) + " MB");
+
+    // 首次启用统计表时还没有全局行，按明细表初始化一次
+    auto statsResult = getUsageStats(0);
+    if (!statsResult.success) {
+        auto reconcileResult = reconcileUsageStats();
+        if (!reconcileResult.success) {
+            LOG_WARNING("初始化用量统计失败: " + reconcileResult.message);
+        }
+    }
+
+    auto indexResult = rebuildSearchIndex();
+    if (!indexResult.success) {
+        LOG_WARNING("构建文档搜索索引失败: " + indexResult.message);
+    }
+    return true;
+}
+
+void SqliteStorageBackend::disconnect() {
+    isConnected = false;
+
+    // 当前线程还持有未结束的事务时先回滚，否则下面会等不到写锁
+    if (inTransaction()) {
+        rollbackTransaction();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        idleReaders.clear();
+    }
+
+    std::unique_ptr<SqliteConnection> closing;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        closing = std::move(writer);
+    }
+    searchIndex.clear();
+
+    if (closing) {
+        // 关闭前把 WAL 合并回主文件，并让查询规划器更新统计信息
+        closing->exec("PRAGMA optimize; PRAGMA wal_checkpoint(TRUNCATE);");
+        closing->close();
+        LOG_INFO("SQLite数据库连接已关闭");
+    }
+}
+
+bool SqliteStorageBackend::isConnectionValid() const {
+    return isConnected && writer != nullptr;
+}
+
+SqliteStorageBackend::ReadLease SqliteStorageBackend::acquireReader() {
+    if (!isConnected) {
+        return ReadLease(this, nullptr, nullptr);
+    }
+    if (inTransaction()) {
+        return ReadLease(this, nullptr, writer.get());
+    }
+
+    std::unique_ptr<SqliteConnection> reader;
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        if (!idleReaders.empty()) {
+            reader = std::move(idleReaders.back());
+            idleReaders.pop_back();
+        }
+    }
+
+    if (!reader) {
+        // 只读连接都已借出（例如遍历回调里再次查询），临时新开一条，归还时按上限关闭
+        reader = std::make_unique<SqliteConnection>();
+        if (!reader->open(options, true)) {
+            LOG_WARNING("打开SQLite只读连接失败: " + reader->error());
+            return ReadLease(this, nullptr, nullptr);
+        }
+    }
+    SqliteConnection* conn = reader.get();
+    return ReadLease(this, std::move(reader), conn);
+}
+
+void SqliteStorageBackend::releaseReader(std::unique_ptr<SqliteConnection> reader) {
+    std::lock_guard<std::mutex> lock(readerMutex);
+    if (isConnected && idleReaders.size() < static_cast<size_t>(std::max(1, options.readConnections))) {
+        idleReaders.push_back(std::move(reader));
+    }
+}
+
+template<typename T>
+Result<T> SqliteStorageBackend::runInTransaction(const std::function<Result<T>(SqliteConnection&)>& body) {
+    if (inTransaction()) {
+        return body(*writer);
+    }
+    return runTransaction<T>(this, "sqlite", [&]() {
+        return body(*writer);
+    });
+}
+
+bool SqliteStorageBackend::createTables(SqliteConnection& db) {
+    // 结构版本记在 PRAGMA user_version（只读文件头），已是最新时不执行任何 DDL
+    int version = 0;
+    {
+        SqliteStatement stmt(db, "PRAGMA user_version");
+        if (stmt.fetch()) {
+            version = stmt.getInt(0);
+        }
+        if (!stmt.ok()) {
+            return false;
+        }
+    }
+    if (version >= SCHEMA_VERSION) {
+        return true;
+    }
+
+    // SQLite 的 DDL 是事务性的，建表脚本与版本号一起提交
+    LOG_INFO("升级SQLite数据库结构: " + std::to_string(version) + " -> " + std::to_string(SCHEMA_VERSION));
+    // 从版本 1 升级时回填已有分享的收件箱行
+    std::string script = std::string("BEGIN IMMEDIATE;") + (version > 0 && version < 3 ? SCHEMA_SOFT_DELETE_COLUMNS : "") +
+                         SCHEMA + SQL_FILL_SHARE_INBOX + ";" +
+                         "PRAGMA user_version = " + std::to_string(SCHEMA_VERSION) + ";COMMIT;";
+    if (!db.exec(script)) {
+        std::string error = db.error();
+        db.exec("ROLLBACK;");
+        LOG_ERROR("升级SQLite数据库结构失败: " + error);
+        return false;
+    }
+    return true;
+}
+
+void SqliteStorageBackend::applyIndexChange(std::function<void()> change) {
+    if (inTransaction()) {
+        pendingIndexChanges.push_back(std::move(change));
+        return;
+    }
+    change();
+}
+
+Result<User> SqliteStorageBackend::createUser(const std::string& username, const std::string& passwordHash,
+                                              const std::string& email) {
+    return runInTransaction<User>([&](SqliteConnection& db) {
+        SqliteStatement stmt(db, SQL_INSERT_USER);
+        stmt.bind(username).bind(passwordHash).bind(email);
+        if (!stmt.execute()) {
+            return Result<User>::Error("插入用户失败: " + stmt.error());
+        }
+        int userId = static_cast<int>(db.lastInsertId());
+
+        std::map<int, UsageStats> deltas;
+        deltas[0].userCount = 1;
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<User>::Error("更新用量统计失败: " + db.error());
+        }
+        return fetchUserById(db, userId);
+    });
+}
+
+Result<User> SqliteStorageBackend::getUserById(int userId) {
+    auto conn = acquireReader();
+    if (!conn) {
+        return Result<User>::Error("数据库未连接");
+    }
+    return fetchUserById(*conn, userId);
+}
+
+Result<User> SqliteStorageBackend::fetchUserById(SqliteConnection& db, int userId) {
+    SqliteStatement stmt(db, SQL_USER_BY_ID);
+    stmt.bind(userId);
+    if (!stmt.fetch()) {
+        if (!stmt.ok()) {
+            return Result<User>::Error("查询用户失败: " + stmt.error());
+        }
+        return Result<User>::Error("未找到该用户");
+    }
+    User user;
+    readUserRow(stmt, user);
+    return Result<User>::Success(user);
+}
+
+Result<User> SqliteStorageBackend::getUserByUsername(const std::string& username) {
+    auto conn = acquireReader();
+    if (!conn) {
+        return Result<User>::Error("数据库未连接");
+    }
+
+    SqliteStatement stmt(*conn, SQL_USER_BY_USERNAME);
+    stmt.bind(username);
+    if (!stmt.fetch()) {
+        if (!stmt.ok()) {
+            return Result<User>::Error("查询用户失败: " + stmt.error());
+        }
+        return Result<User>::Error("未找到该用户");
+    }
+    User user;
+    readUserRow(stmt, user);
+    return Result<User>::Success(user);
+}
+
+Result<std::vector<User>> SqliteStorageBackend::getAllUsers(int limit, int offset) {
+    std::vector<User> users;
+    auto result = streamQuery("SELECT id, username, password_hash, email, created_at, last_login, is_active "
+                              "FROM users WHERE deleted_at IS NULL LIMIT ? OFFSET ?",
+                              [&](SqliteStatement& stmt) { stmt.bind(limit).bind(offset); },
+                              [&users](const SqliteStatement& stmt) {
+                                  users.emplace_back();
+                                  readUserRow(stmt, users.back());
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<User>>::Error("查询用户失败: " + result.message);
+    }
+    return Result<std::vector<User>>::Success(users);
+}
+
+Result<bool> SqliteStorageBackend::updateUser(const User& user) {
+    return runInTransaction<bool>([&](SqliteConnection& db) {
+        SqliteStatement stmt(db, "UPDATE users SET username = ?, password_hash = ?, email = ?, is_active = ? "
+                                 "WHERE id = ? AND deleted_at IS NULL");
+        stmt.bind(user.username).bind(user.password_hash).bind(user.email).bind(user.is_active ? 1 : 0).bind(user.id);
+        if (!stmt.execute()) {
+            return Result<bool>::Error("更新用户失败: " + stmt.error());
+        }
+        return Result<bool>::Success(true);
+    });
+}
+
+Result<bool> SqliteStorageBackend::deleteUser(int userId) {
+    auto result = runInTransaction<bool>([&](SqliteConnection& db) {
+        // 软删除：只标记用户行，文档、分享与对象存储中的文件由 purgeDeleted 分批清理。
+        // 用户名与邮箱改写为按 id 生成的占位值，释放唯一键
+        SqliteStatement stmt(db, "UPDATE users SET deleted_at = datetime('now', 'localtime'), username = '" +
+                                 DELETED_USER_PREFIX + "' || id, email = '" + DELETED_USER_PREFIX +
+                                 "' || id WHERE id = ? AND deleted_at IS NULL");
+        stmt.bind(userId);
+        if (!stmt.execute()) {
+            return Result<bool>::Error("删除用户失败: " + stmt.error());
+        }
+        if (db.changes() == 0) {
+            return Result<bool>::Error("用户不存在");
+        }
+
+        // 该用户的统计行即其仍可见的文档与分享计数（单独删除过的文档早已扣除），整行从全局中扣除后删除；
+        // 涉及的分享记录只在读取时隐藏，由 purgeDeleted 分批删除，届时只扣除仍在线的另一方
+        std::map<int, UsageStats> deltas;
+        UsageStats& global = deltas[0];
+        global.userCount -= 1;
+        {
+            SqliteStatement owned(db, "SELECT document_count, total_bytes, shares_given, shares_received "
+                                      "FROM usage_stats WHERE owner_id = ?");
+            owned.bind(userId);
+            if (owned.fetch()) {
+                global.documentCount -= owned.getInt64(0);
+                global.totalBytes -= owned.getInt64(1);
+                global.sharesGiven -= owned.getInt64(2);
+                global.sharesReceived -= owned.getInt64(3);
+            }
+            if (!owned.ok()) {
+                return Result<bool>::Error("读取用量统计失败: " + owned.error());
+            }
+        }
+        SqliteStatement deleteStats(db, "DELETE FROM usage_stats WHERE owner_id = ?");
+        deleteStats.bind(userId);
+        if (!deleteStats.execute() || !applyStatsDeltas(db, deltas)) {
+            return Result<bool>::Error("更新用量统计失败: " + db.error());
+        }
+        return Result<bool>::Success(true);
+    });
+
+    if (result.success) {
+        applyIndexChange([this, userId]() { searchIndex.removeOwner(userId); });
+    }
+    return result;
+}
+
+Result<bool> SqliteStorageBackend::updateUserLastLogin(int userId) {
+    return runInTransaction<bool>([&](SqliteConnection& db) {
+        SqliteStatement stmt(db, "UPDATE users SET last_login = datetime('now', 'localtime') WHERE id = ? AND deleted_at IS NULL");
+        stmt.bind(userId);
+        if (!stmt.execute()) {
+            return Result<bool>::Error("更新最后登录时间失败: " + stmt.error());
+        }
+        return Result<bool>::Success(true);
+    });
+}
+
+Result<Document> SqliteStorageBackend::createDocument(const std::string& title, const std::string& description,
+                                                      const std::string& filePath, const std::string& minioKey,
+                                                      int ownerId, size_t fileSize, const std::string& contentType) {
+    auto result = runInTransaction<Document>([&](SqliteConnection& db) {
+        SqliteStatement stmt(db, SQL_INSERT_DOCUMENT);
+        stmt.bind(title).bind(description).bind(filePath).bind(minioKey)
+            .bind(ownerId).bind(fileSize).bind(contentType);
+        if (!stmt.execute()) {
+            return Result<Document>::Error("插入文档失败: " + stmt.error());
+        }
+        int docId = static_cast<int>(db.lastInsertId());
+
+        std::map<int, UsageStats> deltas;
+        for (int key : {0, ownerId}) {
+            deltas[key].documentCount += 1;
+            deltas[key].totalBytes += static_cast<long long>(fileSize);
+        }
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<Document>::Error("更新用量统计失败: " + db.error());
+        }
+        return fetchDocumentById(db, docId);
+    });
+    if (result.success) {
+        Document doc = result.data.value();
+        applyIndexChange([this, doc]() { searchIndex.addOrUpdate(doc); });
+    }
+    return result;
+}
+
+Result<Document> SqliteStorageBackend::getDocumentById(int docId) {
+    auto conn = acquireReader();
+    if (!conn) {
+        return Result<Document>::Error("数据库未连接");
+    }
+    return fetchDocumentById(*conn, docId);
+}
+
+Result<Document> SqliteStorageBackend::fetchDocumentById(SqliteConnection& db, int docId) {
+    SqliteStatement stmt(db, SQL_DOCUMENT_BY_ID);
+    stmt.bind(docId);
+    if (!stmt.fetch()) {
+        if (!stmt.ok()) {
+            return Result<Document>::Error("查询文档失败: " + stmt.error());
+        }
+        return Result<Document>::Error("未找到该文档");
+    }
+    Document doc;
+    readDocumentRow(stmt, doc);
+    return Result<Document>::Success(doc);
+}
+
+Result<std::vector<Document>> SqliteStorageBackend::getDocumentsByOwner(int ownerId, int limit, int offset) {
+    std::vector<Document> documents;
+    auto result = streamQuery("SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type "
+                              "FROM documents WHERE owner_id = ? AND " + liveDocument() + " LIMIT ? OFFSET ?",
+                              [&](SqliteStatement& stmt) { stmt.bind(ownerId).bind(limit).bind(offset); },
+                              [&documents](const SqliteStatement& stmt) {
+                                  documents.emplace_back();
+                                  readDocumentRow(stmt, documents.back());
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<Document>>::Error("查询文档失败: " + result.message);
+    }
+    return Result<std::vector<Document>>::Success(documents);
+}
+
+Result<std::vector<Document>> SqliteStorageBackend::getAllDocuments(int limit, int offset) {
+    std::vector<Document> documents;
+    auto result = streamQuery("SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type "
+                              "FROM documents WHERE " + liveDocument() + " LIMIT ? OFFSET ?",
+                              [&](SqliteStatement& stmt) { stmt.bind(limit).bind(offset); },
+                              [&documents](const SqliteStatement& stmt) {
+                                  documents.emplace_back();
+                                  readDocumentRow(stmt, documents.back());
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<Document>>::Error("查询文档失败: " + result.message);
+    }
+    return Result<std::vector<Document>>::Success(documents);
+}
+
+Result<bool> SqliteStorageBackend::updateDocument(const Document& doc) {
+    Document indexed;
+    auto result = runInTransaction<bool>([&](SqliteConnection& db) {
+        // 写事务已独占写锁，直接读取旧的 owner_id/file_size 计算字节数增量
+        int ownerId = 0;
+        long long sizeDelta = 0;
+        {
+            SqliteStatement previous(db, "SELECT owner_id, file_size FROM documents WHERE id = ? AND " + liveDocument());
+            previous.bind(doc.id);
+            if (!previous.fetch()) {
+                if (!previous.ok()) {
+                    return Result<bool>::Error("更新文档失败: " + previous.error());
+                }
+                return Result<bool>::Error("文档不存在或未发生更改");
+            }
+            ownerId = previous.getInt(0);
+            sizeDelta = static_cast<long long>(doc.file_size) - previous.getInt64(1);
+        }
+
+        SqliteStatement stmt(db, "UPDATE documents SET title = ?, description = ?, file_path = ?, minio_key = ?, "
+                                 "file_size = ?, content_type = ?, updated_at = datetime('now', 'localtime') WHERE id = ?");
+        stmt.bind(doc.title).bind(doc.description).bind(doc.file_path).bind(doc.minio_key)
+            .bind(doc.file_size).bind(doc.content_type).bind(doc.id);
+        if (!stmt.execute()) {
+            return Result<bool>::Error("更新文档失败: " + stmt.error());
+        }
+
+        // 该文档若是分享副本，接收人的收件箱显示的是它的标题等字段
+        SqliteStatement sync(db, SQL_SYNC_SHARE_INBOX);
+        sync.bind(doc.id).bind(doc.id);
+        if (!sync.execute()) {
+            return Result<bool>::Error("同步分享收件箱失败: " + sync.error());
+        }
+
+        if (sizeDelta != 0) {
+            std::map<int, UsageStats> deltas;
+            deltas[0].totalBytes = sizeDelta;
+            deltas[ownerId].totalBytes = sizeDelta;
+            if (!applyStatsDeltas(db, deltas)) {
+                return Result<bool>::Error("更新用量统计失败: " + db.error());
+            }
+        }
+
+        auto updated = fetchDocumentById(db, doc.id);
+        if (updated.success) {
+            indexed = updated.data.value();
+        }
+        return Result<bool>::Success(true);
+    });
+
+    if (result.success && indexed.id == doc.id) {
+        applyIndexChange([this, indexed]() { searchIndex.addOrUpdate(indexed); });
+    }
+    return result;
+}
+
+Result<bool> SqliteStorageBackend::deleteDocument(int docId) {
+    auto result = runInTransaction<bool>([&](SqliteConnection& db) {
+        int ownerId = 0;
+        long long fileSize = 0;
+        {
+            SqliteStatement previous(db, "SELECT owner_id, file_size FROM documents WHERE id = ? AND " + liveDocument());
+            previous.bind(docId);
+            if (!previous.fetch()) {
+                if (!previous.ok()) {
+                    return Result<bool>::Error("删除文档失败: " + previous.error());
+                }
+                return Result<bool>::Error("文档不存在");
+            }
+            ownerId = previous.getInt(0);
+            fileSize = previous.getInt64(1);
+        }
+
+        // 文档行只做标记：引用它（原件或分享副本）的分享在读取时隐藏，
+        // 连同文档行与对象存储中的文件由 purgeDeleted 在后台分批删除
+        SqliteStatement stmt(db, "UPDATE documents SET deleted_at = datetime('now', 'localtime') WHERE id = ?");
+        stmt.bind(docId);
+        if (!stmt.execute()) {
+            return Result<bool>::Error("删除文档失败: " + stmt.error());
+        }
+
+        std::map<int, UsageStats> deltas;
+        for (int key : {0, ownerId}) {
+            deltas[key].documentCount -= 1;
+            deltas[key].totalBytes -= fileSize;
+        }
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<bool>::Error("更新用量统计失败: " + db.error());
+        }
+        return Result<bool>::Success(true);
+    });
+
+    if (result.success) {
+        applyIndexChange([this, docId]() { searchIndex.remove(docId); });
+    }
+    return result;
+}
+
+Result<DocumentShare> SqliteStorageBackend::createDocumentShare(int documentId, int sharedByUserId, int sharedToUserId,
+                                                                int sharedDocumentId, const std::string& sharedMinioKey) {
+    return runInTransaction<DocumentShare>([&](SqliteConnection& db) {
+        // 同一 (原文档, 分享人, 接收人) 上已失效、尚未清理的旧分享（副本或原文档已删除）会占住唯一键：
+        // 先扣除其计数再物理删除，收件箱中的对应行经外键级联删除
+        std::string deadShare = "document_id = " + std::to_string(documentId) + " AND shared_by_user_id = " +
+                                std::to_string(sharedByUserId) + " AND shared_to_user_id = " +
+                                std::to_string(sharedToUserId) + " AND NOT (" + LIVE_SHARE + ")";
+        std::map<int, UsageStats> deltas;
+        if (!collectShareDeltas(db, deadShare, deltas)) {
+            return Result<DocumentShare>::Error("统计失效分享失败: " + db.error());
+        }
+        SqliteStatement purge(db, "DELETE FROM document_shares WHERE " + deadShare);
+        if (!purge.execute()) {
+            return Result<DocumentShare>::Error("清理失效分享失败: " + purge.error());
+        }
+
+        SqliteStatement stmt(db, "INSERT INTO document_shares (document_id, shared_by_user_id, shared_to_user_id, "
+                                 "shared_document_id, shared_minio_key) VALUES (?, ?, ?, ?, ?)");
+        stmt.bind(documentId).bind(sharedByUserId).bind(sharedToUserId).bind(sharedDocumentId).bind(sharedMinioKey);
+        if (!stmt.execute()) {
+            return Result<DocumentShare>::Error("创建分享记录失败: " + stmt.error());
+        }
+        long long shareId = db.lastInsertId();
+
+        // 同一事务写入接收人的收件箱，列表页不再连接 documents
+        SqliteStatement inbox(db, SQL_FILL_SHARE_INBOX + " WHERE ds.id = ?");
+        inbox.bind(shareId);
+        if (!inbox.execute()) {
+            return Result<DocumentShare>::Error("写入分享收件箱失败: " + inbox.error());
+        }
+        if (db.changes() != 1) {
+            return Result<DocumentShare>::Error("写入分享收件箱失败: 分享副本文档不存在");
+        }
+
+        deltas[0].sharesGiven += 1;
+        deltas[0].sharesReceived += 1;
+        deltas[sharedByUserId].sharesGiven += 1;
+        deltas[sharedToUserId].sharesReceived += 1;
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<DocumentShare>::Error("更新用量统计失败: " + db.error());
+        }
+
+        SqliteStatement select(db, "SELECT id, document_id, shared_by_user_id, shared_to_user_id, shared_document_id, "
+                                   "shared_minio_key, created_at FROM document_shares WHERE id = ?");
+        select.bind(shareId);
+        if (!select.fetch()) {
+            if (!select.ok()) {
+                return Result<DocumentShare>::Error("查询分享记录失败: " + select.error());
+            }
+            return Result<DocumentShare>::Error("分享记录不存在");
+        }
+
+        DocumentShare share;
+        share.id = select.getInt(0);
+        share.document_id = select.getInt(1);
+        share.shared_by_user_id = select.getInt(2);
+        share.shared_to_user_id = select.getInt(3);
+        share.shared_document_id = select.getInt(4);
+        share.shared_minio_key = select.getString(5);
+        share.created_at = select.getTimestamp(6);
+        return Result<DocumentShare>::Success(share);
+    });
+}
+
+Result<std::vector<Document>> SqliteStorageBackend::getSharedDocuments(int userId, int limit, int offset) {
+    // 收件箱主键范围扫描，最新的分享在前；minio_key 列是分享复制出的键
+    std::vector<Document> documents;
+    auto result = streamQuery("SELECT " + SHARE_INBOX_DOCUMENT_COLUMNS + " FROM share_inbox "
+                              "WHERE shared_to_user_id = ? AND " + LIVE_SHARE_INBOX + " ORDER BY created_at DESC, id DESC LIMIT ? OFFSET ?",
+                              [&](SqliteStatement& stmt) { stmt.bind(userId).bind(limit).bind(offset); },
+                              [&documents](const SqliteStatement& stmt) {
+                                  documents.emplace_back();
+                                  readDocumentRow(stmt, documents.back());
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<Document>>::Error("查询分享文档失败: " + result.message);
+    }
+    return Result<std::vector<Document>>::Success(documents);
+}
+
+Result<std::vector<DocumentShare>> SqliteStorageBackend::getDocumentShares(int documentId) {
+    std::vector<DocumentShare> shares;
+    auto result = streamQuery("SELECT id, document_id, shared_by_user_id, shared_to_user_id, shared_document_id, "
+                              "shared_minio_key, created_at FROM document_shares WHERE document_id = ? AND " + LIVE_SHARE,
+                              [&](SqliteStatement& stmt) { stmt.bind(documentId); },
+                              [&shares](const SqliteStatement& stmt) {
+                                  shares.emplace_back();
+                                  DocumentShare& share = shares.back();
+                                  share.id = stmt.getInt(0);
+                                  share.document_id = stmt.getInt(1);
+                                  share.shared_by_user_id = stmt.getInt(2);
+                                  share.shared_to_user_id = stmt.getInt(3);
+                                  share.shared_document_id = stmt.getInt(4);
+                                  share.shared_minio_key = stmt.getString(5);
+                                  share.created_at = stmt.getTimestamp(6);
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<DocumentShare>>::Error("查询分享记录失败: " + result.message);
+    }
+    return Result<std::vector<DocumentShare>>::Success(shares);
+}
+
+Result<bool> SqliteStorageBackend::deleteDocumentShare(int shareId) {
+    return runInTransaction<bool>([&](SqliteConnection& db) {
+        std::map<int, UsageStats> deltas;
+        if (!collectShareDeltas(db, "id = " + std::to_string(shareId), deltas)) {
+            return Result<bool>::Error("删除分享记录失败: " + db.error());
+        }
+
+        // 收件箱中的对应行经外键级联删除
+        SqliteStatement stmt(db, "DELETE FROM document_shares WHERE id = ?");
+        stmt.bind(shareId);
+        if (!stmt.execute()) {
+            return Result<bool>::Error("删除分享记录失败: " + stmt.error());
+        }
+        if (db.changes() == 0) {
+            return Result<bool>::Error("分享记录不存在");
+        }
+
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<bool>::Error("更新用量统计失败: " + db.error());
+        }
+        return Result<bool>::Success(true);
+    });
+}
+
+Result<bool> SqliteStorageBackend::isDocumentShared(int documentId, int sharedByUserId, int sharedToUserId) {
+    auto conn = acquireReader();
+    if (!conn) {
+        return Result<bool>::Error("数据库未连接");
+    }
+
+    SqliteStatement stmt(*conn, SQL_DOCUMENT_SHARE_EXISTS);
+    stmt.bind(documentId).bind(sharedByUserId).bind(sharedToUserId);
+    bool exists = stmt.fetch() && stmt.getInt64(0) > 0;
+    if (!stmt.ok()) {
+        return Result<bool>::Error("查询分享记录失败: " + stmt.error());
+    }
+    return Result<bool>::Success(exists);
+}
+
+Result<std::vector<int>> SqliteStorageBackend::createUsersBatch(const std::vector<User>& users, size_t) {
+    return runInTransaction<std::vector<int>>([&](SqliteConnection& db) {
+        std::vector<int> ids;
+        ids.reserve(users.size());
+        for (size_t i = 0; i < users.size(); ++i) {
+            SqliteStatement stmt(db, SQL_INSERT_USER);
+            stmt.bind(users[i].username).bind(users[i].password_hash).bind(users[i].email);
+            if (!stmt.execute()) {
+                return Result<std::vector<int>>::Error("批量插入失败（第" + std::to_string(i + 1) + "行）: " + stmt.error());
+            }
+            ids.push_back(static_cast<int>(db.lastInsertId()));
+        }
+
+        if (!ids.empty()) {
+            std::map<int, UsageStats> deltas;
+            deltas[0].userCount = static_cast<long long>(ids.size());
+            if (!applyStatsDeltas(db, deltas)) {
+                return Result<std::vector<int>>::Error("更新用量统计失败: " + db.error());
+            }
+        }
+        return Result<std::vector<int>>::Success(ids);
+    });
+}
+
+Result<std::vector<int>> SqliteStorageBackend::createDocumentsBatch(const std::vector<Document>& documents, size_t) {
+    auto result = runInTransaction<std::vector<int>>([&](SqliteConnection& db) {
+        std::vector<int> ids;
+        ids.reserve(documents.size());
+        std::map<int, UsageStats> deltas;
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const Document& doc = documents[i];
+            SqliteStatement stmt(db, SQL_INSERT_DOCUMENT);
+            stmt.bind(doc.title).bind(doc.description).bind(doc.file_path).bind(doc.minio_key)
+                .bind(doc.owner_id).bind(doc.file_size).bind(doc.content_type);
+            if (!stmt.execute()) {
+                return Result<std::vector<int>>::Error("批量插入失败（第" + std::to_string(i + 1) + "行）: " + stmt.error());
+            }
+            ids.push_back(static_cast<int>(db.lastInsertId()));
+            for (int key : {0, doc.owner_id}) {
+                deltas[key].documentCount += 1;
+                deltas[key].totalBytes += static_cast<long long>(doc.file_size);
+            }
+        }
+
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<std::vector<int>>::Error("更新用量统计失败: " + db.error());
+        }
+        return Result<std::vector<int>>::Success(ids);
+    });
+
+    if (result.success && result.data->size() == documents.size()) {
+        // 批量插入不回读，时间戳以本地当前时间近似
+        auto now = std::chrono::system_clock::now();
+        const std::vector<int>& ids = result.data.value();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            Document doc = documents[i];
+            doc.id = ids[i];
+            doc.created_at = now;
+            doc.updated_at = now;
+            applyIndexChange([this, doc]() { searchIndex.addOrUpdate(doc); });
+        }
+    }
+    return result;
+}
+
+Result<std::string> SqliteStorageBackend::fetchKeysetPage(const std::string& columns, const std::string& from,
+                                                          const std::string& fromCondition, const std::string& filter, int filterId, const std::string& keyPrefix,
+                                                          int pageSize, const std::string& pageToken,
+                                                          const std::function<void(const SqliteStatement&)>& onRow) {
+    std::string cursorCreatedAt;
+    long long cursorId = 0;
+    bool hasCursor = !pageToken.empty();
+    if (hasCursor && !decodePageToken(pageToken, cursorCreatedAt, cursorId)) {
+        return Result<std::string>::Error("无效的分页令牌");
+    }
+    pageSize = std::max(1, std::min(pageSize, MAX_PAGE_SIZE));
+
+    // 排序键追加在选择列之后；多取一行用来判断是否还有下一页
+    const std::string createdAtColumn = keyPrefix + "created_at";
+    const std::string idColumn = keyPrefix + "id";
+    // 表自身的可见条件不含参数，放在最前面，绑定顺序不变
+    std::string where = fromCondition;
+    if (!filter.empty()) {
+        where += (where.empty() ? "" : " AND ") + filter;
+    }
+    if (hasCursor) {
+        where += (where.empty() ? "" : " AND ");
+        where += "(" + createdAtColumn + " < ? OR (" + createdAtColumn + " = ? AND " + idColumn + " < ?))";
+    }
+    std::string sql = "SELECT " + columns + ", " + createdAtColumn + ", " + idColumn + " FROM " + from +
+                      (where.empty() ? "" : " WHERE " + where) +
+                      " ORDER BY " + createdAtColumn + " DESC, " + idColumn + " DESC LIMIT ?";
+
+    int rows = 0;
+    std::string lastCreatedAt;
+    long long lastId = 0;
+    bool hasMore = false;
+    auto result = streamQuery(sql,
+                              [&](SqliteStatement& stmt) {
+                                  if (!filter.empty()) {
+                                      stmt.bind(filterId);
+                                  }
+                                  if (hasCursor) {
+                                      stmt.bind(cursorCreatedAt).bind(cursorCreatedAt).bind(cursorId);
+                                  }
+                                  stmt.bind(pageSize + 1);
+                              },
+                              [&](const SqliteStatement& stmt) {
+                                  if (rows == pageSize) {
+                                      // 存在第 pageSize+1 行，说明还有下一页
+                                      hasMore = true;
+                                      return false;
+                                  }
+                                  size_t keyColumn = stmt.columnCount() - 2;
+                                  lastCreatedAt = stmt.getString(keyColumn);
+                                  lastId = stmt.getInt64(keyColumn + 1);
+                                  onRow(stmt);
+                                  rows++;
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::string>::Error("分页查询失败: " + result.message);
+    }
+    return Result<std::string>::Success(hasMore ? encodePageToken(lastCreatedAt, lastId) : std::string(), "查询成功");
+}
+
+Result<Page<User>> SqliteStorageBackend::getUsersPage(int pageSize, const std::string& pageToken) {
+    Page<User> page;
+    auto result = fetchKeysetPage("id, username, password_hash, email, created_at, last_login, is_active",
+                                  "users", "deleted_at IS NULL", "", 0, "", pageSize, pageToken,
+                                  [&page](const SqliteStatement& stmt) {
+                                      page.items.emplace_back();
+                                      readUserRow(stmt, page.items.back());
+                                  });
+    if (!result.success) {
+        return Result<Page<User>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<User>>::Success(page);
+}
+
+Result<Page<Document>> SqliteStorageBackend::getDocumentsByOwnerPage(int ownerId, int pageSize, const std::string& pageToken) {
+    Page<Document> page;
+    auto result = fetchKeysetPage("id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type",
+                                  "documents", liveDocument(), "owner_id = ?", ownerId, "", pageSize, pageToken,
+                                  [&page](const SqliteStatement& stmt) {
+                                      page.items.emplace_back();
+                                      readDocumentRow(stmt, page.items.back());
+                                  });
+    if (!result.success) {
+        return Result<Page<Document>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<Document>>::Success(page);
+}
+
+Result<Page<Document>> SqliteStorageBackend::getAllDocumentsPage(int pageSize, const std::string& pageToken) {
+    Page<Document> page;
+    auto result = fetchKeysetPage("id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type",
+                                  "documents", liveDocument(), "", 0, "", pageSize, pageToken,
+                                  [&page](const SqliteStatement& stmt) {
+                                      page.items.emplace_back();
+                                      readDocumentRow(stmt, page.items.back());
+                                  });
+    if (!result.success) {
+        return Result<Page<Document>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<Document>>::Success(page);
+}
+
+Result<Page<Document>> SqliteStorageBackend::getSharedDocumentsPage(int userId, int pageSize, const std::string& pageToken) {
+    // share_inbox 的主键就是 (shared_to_user_id, created_at, id)，每页一次范围扫描；
+    // 涉及已删除用户或文档的分享在清理前仍在表中，按可见条件过滤
+    Page<Document> page;
+    auto result = fetchKeysetPage(SHARE_INBOX_DOCUMENT_COLUMNS, "share_inbox", LIVE_SHARE_INBOX,
+                                  "shared_to_user_id = ?", userId, "", pageSize, pageToken,
+                                  [&page](const SqliteStatement& stmt) {
+                                      page.items.emplace_back();
+                                      readDocumentRow(stmt, page.items.back());
+                                  });
+    if (!result.success) {
+        return Result<Page<Document>>::Error(result.message);
+    }
+    page.nextPageToken = result.data.value();
+    return Result<Page<Document>>::Success(page);
+}
+
+Result<size_t> SqliteStorageBackend::streamQuery(const std::string& sql, const std::function<void(SqliteStatement&)>& bindParams,
+                                                 const std::function<bool(const SqliteStatement&)>& visitor) {
+    auto conn = acquireReader();
+    if (!conn) {
+        return Result<size_t>::Error("数据库未连接");
+    }
+
+    // sqlite3_step 逐行产出，结果集不会整体驻留内存
+    SqliteStatement stmt(*conn, sql);
+    if (bindParams) {
+        bindParams(stmt);
+    }
+
+    size_t visited = 0;
+    while (stmt.fetch()) {
+        visited++;
+        if (!visitor(stmt)) {
+            return Result<size_t>::Success(visited);
+        }
+    }
+    if (!stmt.ok()) {
+        return Result<size_t>::Error(stmt.error());
+    }
+    return Result<size_t>::Success(visited);
+}
+
+Result<size_t> SqliteStorageBackend::forEachUser(const UserVisitor& visitor) {
+    User user;
+    return streamQuery("SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+                       "WHERE deleted_at IS NULL ORDER BY id",
+                       nullptr,
+                       [&visitor, &user](const SqliteStatement& stmt) {
+                           readUserRow(stmt, user);
+                           return visitor(user);
+                       });
+}
+
+Result<size_t> SqliteStorageBackend::forEachDocument(const DocumentFilter& filter, const DocumentVisitor& visitor) {
+    std::string sql;
+    if (filter.sharedToUserId > 0) {
+        sql = "SELECT " + SHARE_INBOX_DOCUMENT_COLUMNS + " FROM share_inbox WHERE shared_to_user_id = ? AND " + LIVE_SHARE_INBOX;
+        if (filter.ownerId > 0) {
+            sql += " AND owner_id = ?";
+        }
+        sql += " ORDER BY created_at, id";
+    } else {
+        sql = "SELECT id, title, description, file_path, minio_key, owner_id, created_at, updated_at, file_size, content_type FROM documents "
+              "WHERE " + liveDocument();
+        if (filter.ownerId > 0) {
+            sql += " AND owner_id = ?";
+        }
+        sql += " ORDER BY id";
+    }
+
+    Document doc;
+    return streamQuery(sql,
+                       [&filter](SqliteStatement& stmt) {
+                           if (filter.sharedToUserId > 0) {
+                               stmt.bind(filter.sharedToUserId);
+                           }
+                           if (filter.ownerId > 0) {
+                               stmt.bind(filter.ownerId);
+                           }
+                       },
+                       [&visitor, &doc](const SqliteStatement& stmt) {
+                           readDocumentRow(stmt, doc);
+                           return visitor(doc);
+                       });
+}
+
+Result<std::vector<User>> SqliteStorageBackend::searchUsers(const std::string& query, int limit) {
+    std::string pattern = "%" + escapeLikePattern(query) + "%";
+    std::vector<User> users;
+    auto result = streamQuery("SELECT id, username, password_hash, email, created_at, last_login, is_active FROM users "
+                              "WHERE deleted_at IS NULL AND (username LIKE ? ESCAPE '\\' OR email LIKE ? ESCAPE '\\') LIMIT ?",
+                              [&](SqliteStatement& stmt) { stmt.bind(pattern).bind(pattern).bind(limit); },
+                              [&users](const SqliteStatement& stmt) {
+                                  users.emplace_back();
+                                  readUserRow(stmt, users.back());
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<User>>::Error("搜索用户失败: " + result.message);
+    }
+    return Result<std::vector<User>>::Success(users);
+}
+
+Result<std::vector<Document>> SqliteStorageBackend::searchDocuments(const std::string& query, const DocumentSearchOptions& options) {
+    if (options.mode == DocumentSearchMode::FullText) {
+        return Result<std::vector<Document>>::Error("全文索引不可用");
+    }
+
+    std::string sql = "SELECT d.id, d.title, d.description, d.file_path, d.minio_key, d.owner_id, d.created_at, d.updated_at, d.file_size, d.content_type"
+                      " FROM documents d WHERE (d.title LIKE ? ESCAPE '\\' OR d.description LIKE ? ESCAPE '\\')"
+                      " AND " + liveDocument("d.");
+    if (options.ownerId > 0) {
+        sql += " AND d.owner_id = ?";
+    }
+    if (options.visibleToUserId > 0) {
+        sql += " AND (d.owner_id = ? OR EXISTS (SELECT 1 FROM document_shares ds"
+               " WHERE ds.shared_document_id = d.id AND ds.shared_to_user_id = ?))";
+    }
+    sql += " ORDER BY d.id DESC LIMIT ? OFFSET ?";
+
+    std::string pattern = "%" + escapeLikePattern(query) + "%";
+    std::vector<Document> documents;
+    auto result = streamQuery(sql,
+                              [&](SqliteStatement& stmt) {
+                                  stmt.bind(pattern).bind(pattern);
+                                  if (options.ownerId > 0) {
+                                      stmt.bind(options.ownerId);
+                                  }
+                                  if (options.visibleToUserId > 0) {
+                                      stmt.bind(options.visibleToUserId).bind(options.visibleToUserId);
+                                  }
+                                  stmt.bind(std::max(1, std::min(options.limit, MAX_PAGE_SIZE))).bind(std::max(0, options.offset));
+                              },
+                              [&documents](const SqliteStatement& stmt) {
+                                  documents.emplace_back();
+                                  readDocumentRow(stmt, documents.back());
+                                  return true;
+                              });
+    if (!result.success) {
+        return Result<std::vector<Document>>::Error("搜索文档失败: " + result.message);
+    }
+    return Result<std::vector<Document>>::Success(documents);
+}
+
+Result<size_t> SqliteStorageBackend::rebuildSearchIndex() {
+    auto startTime = std::chrono::steady_clock::now();
+    searchIndex.clear();
+
+    auto result = forEachDocument(DocumentFilter(), [this](const Document& doc) {
+        searchIndex.addOrUpdate(doc);
+        return true;
+    });
+    if (!result.success) {
+        return result;
+    }
+    searchIndex.markReady();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    DocumentSearchIndexStats stats = searchIndex.getStats();
+    LOG_INFO("文档搜索索引已构建: " + std::to_string(stats.documents) + " 个文档, " +
+             std::to_string(stats.grams) + " 个bigram, 耗时 " + std::to_string(elapsed.count()) + "ms");
+    return result;
+}
+
+std::vector<Document> SqliteStorageBackend::quickSearchDocuments(const std::string& query, int ownerId, size_t limit,
+                                                                 IndexMatchMode mode) const {
+    return searchIndex.search(query, ownerId, limit, mode);
+}
+
+Result<int> SqliteStorageBackend::getUserCount() {
+    auto result = getUsageStats(0);
+    if (!result.success) {
+        return Result<int>::Error("获取用户数量失败: " + result.message);
+    }
+    return Result<int>::Success(static_cast<int>(result.data->userCount));
+}
+
+Result<int> SqliteStorageBackend::getDocumentCount() {
+    auto result = getUsageStats(0);
+    if (!result.success) {
+        return Result<int>::Error("获取文档数量失败: " + result.message);
+    }
+    return Result<int>::Success(static_cast<int>(result.data->documentCount));
+}
+
+Result<size_t> SqliteStorageBackend::getTotalFileSize() {
+    auto result = getUsageStats(0);
+    if (!result.success) {
+        return Result<size_t>::Error("获取总文件大小失败: " + result.message);
+    }
+    return Result<size_t>::Success(static_cast<size_t>(std::max(0LL, result.data->totalBytes)));
+}
+
+Result<UsageStats> SqliteStorageBackend::getUsageStats(int ownerId) {
+    auto conn = acquireReader();
+    if (!conn) {
+        return Result<UsageStats>::Error("数据库未连接");
+    }
+
+    SqliteStatement stmt(*conn, SQL_USAGE_STATS);
+    stmt.bind(ownerId);
+    UsageStats stats;
+    if (!stmt.fetch()) {
+        if (!stmt.ok()) {
+            return Result<UsageStats>::Error("查询用量统计失败: " + stmt.error());
+        }
+        // 用户还没有任何文档或分享时不存在统计行，计数均为0；全局行缺失说明尚未初始化
+        if (ownerId == 0) {
+            return Result<UsageStats>::Error("用量统计尚未初始化");
+        }
+        return Result<UsageStats>::Success(stats);
+    }
+    stats.userCount = stmt.getInt64(0);
+    stats.documentCount = stmt.getInt64(1);
+    stats.totalBytes = stmt.getInt64(2);
+    stats.sharesGiven = stmt.getInt64(3);
+    stats.sharesReceived = stmt.getInt64(4);
+    return Result<UsageStats>::Success(stats);
+}
+
+bool SqliteStorageBackend::applyStatsDeltas(SqliteConnection& db, const std::map<int, UsageStats>& deltas) {
+    // UPSERT（SQLite 3.24+）；写事务串行执行，不需要额外加锁
+    static const std::string sql =
+            "INSERT INTO usage_stats (owner_id, user_count, document_count, total_bytes, shares_given, shares_received) "
+            "VALUES (?, ?, ?, ?, ?, ?) ON CONFLICT(owner_id) DO UPDATE SET "
+            "user_count = user_count + excluded.user_count, "
+            "document_count = document_count + excluded.document_count, "
+            "total_bytes = total_bytes + excluded.total_bytes, "
+            "shares_given = shares_given + excluded.shares_given, "
+            "shares_received = shares_received + excluded.shares_received, "
+            "updated_at = datetime('now', 'localtime')";
+    for (const auto& item : deltas) {
+        const UsageStats& d = item.second;
+        if (d.userCount == 0 && d.documentCount == 0 && d.totalBytes == 0 && d.sharesGiven == 0 && d.sharesReceived == 0) {
+            continue;
+        }
+        SqliteStatement stmt(db, sql);
+        stmt.bind(item.first).bind(d.userCount).bind(d.documentCount).bind(d.totalBytes)
+            .bind(d.sharesGiven).bind(d.sharesReceived);
+        if (!stmt.execute()) {
+            LOG_ERROR("更新用量统计失败: " + stmt.error());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SqliteStorageBackend::collectShareDeltas(SqliteConnection& db, const std::string& where, std::map<int, UsageStats>& deltas) {
+    // 已删除用户的统计行在删除时已整行从全局扣除，只扣在线的一方
+    SqliteStatement stmt(db, "SELECT ds.shared_by_user_id, ds.shared_to_user_id, COUNT(*), "
+                             "giver.deleted_at IS NULL, receiver.deleted_at IS NULL "
+                             "FROM (SELECT shared_by_user_id, shared_to_user_id FROM document_shares WHERE " + where + ") ds "
+                             "INNER JOIN users giver ON giver.id = ds.shared_by_user_id "
+                             "INNER JOIN users receiver ON receiver.id = ds.shared_to_user_id "
+                             "GROUP BY ds.shared_by_user_id, ds.shared_to_user_id");
+    while (stmt.fetch()) {
+        long long count = stmt.getInt64(2);
+        if (stmt.getInt(3) != 0) {
+            deltas[stmt.getInt(0)].sharesGiven -= count;
+            deltas[0].sharesGiven -= count;
+        }
+        if (stmt.getInt(4) != 0) {
+            deltas[stmt.getInt(1)].sharesReceived -= count;
+            deltas[0].sharesReceived -= count;
+        }
+    }
+    if (!stmt.ok()) {
+        LOG_ERROR("统计分享记录失败: " + stmt.error());
+        return false;
+    }
+    return true;
+}
+
+Result<size_t> SqliteStorageBackend::reconcileUsageStats() {
+    auto before = getUsageStats(0);
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 已软删除的用户和文档不计入；尚未清理的分享与增量维护时一致，只计入在线的一方
+    const std::string live = " WHERE " + liveDocument();
+    const std::string liveGiver = " WHERE shared_by_user_id NOT IN " + DELETED_USER_IDS;
+    const std::string liveReceiver = " WHERE shared_to_user_id NOT IN " + DELETED_USER_IDS;
+    const std::string statements[] = {
+        "DELETE FROM usage_stats",
+        "INSERT INTO usage_stats (owner_id, document_count, total_bytes) "
+        "SELECT owner_id, COUNT(*), COALESCE(SUM(file_size), 0) FROM documents" + live + " GROUP BY owner_id",
+        "INSERT INTO usage_stats (owner_id, shares_given) "
+        "SELECT shared_by_user_id, COUNT(*) FROM document_shares" + liveGiver + " GROUP BY shared_by_user_id "
+        "ON CONFLICT(owner_id) DO UPDATE SET shares_given = excluded.shares_given",
+        "INSERT INTO usage_stats (owner_id, shares_received) "
+        "SELECT shared_to_user_id, COUNT(*) FROM document_shares" + liveReceiver + " GROUP BY shared_to_user_id "
+        "ON CONFLICT(owner_id) DO UPDATE SET shares_received = excluded.shares_received",
+        "INSERT INTO usage_stats (owner_id, user_count, document_count, total_bytes, shares_given, shares_received) "
+        "SELECT 0, (SELECT COUNT(*) FROM users WHERE deleted_at IS NULL), (SELECT COUNT(*) FROM documents" + live + "), "
+        "(SELECT COALESCE(SUM(file_size), 0) FROM documents" + live + "), "
+        "(SELECT COUNT(*) FROM document_shares" + liveGiver + "), (SELECT COUNT(*) FROM document_shares" + liveReceiver + ")"
+    };
+
+    auto result = runInTransaction<size_t>([&](SqliteConnection& db) {
+        size_t written = 0;
+        for (const std::string& sql : statements) {
+            SqliteStatement stmt(db, sql);
+            if (!stmt.execute()) {
+                return Result<size_t>::Error("重算用量统计失败: " + stmt.error());
+            }
+            if (sql.compare(0, 6, "INSERT") == 0) {
+                written += static_cast<size_t>(db.changes());
+            }
+        }
+        return Result<size_t>::Success(written, "用量统计已重算");
+    });
+    if (!result.success) {
+        return result;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    auto after = getUsageStats(0);
+    if (before.success && after.success &&
+        (before.data->userCount != after.data->userCount || before.data->documentCount != after.data->documentCount ||
+         before.data->totalBytes != after.data->totalBytes || before.data->sharesGiven != after.data->sharesGiven)) {
+        LOG_WARNING("用量统计存在偏差已修复: 用户 " + std::to_string(before.data->userCount) + " -> " +
+                    std::to_string(after.data->userCount) + ", 文档 " + std::to_string(before.data->documentCount) +
+                    " -> " + std::to_string(after.data->documentCount) + ", 字节 " +
+                    std::to_string(before.data->totalBytes) + " -> " + std::to_string(after.data->totalBytes));
+    }
+    LOG_INFO("用量统计重算完成，耗时 " + std::to_string(elapsed.count()) + "ms");
+    return result;
+}
+
+Result<size_t> SqliteStorageBackend::purgeShares(int batchSize) {
+    // 与 LIVE_SHARE 相反的四种情况各走一个索引；被删除用户的文档没有逐行标记，
+    // 但引用它们的分享必然以该用户为分享人（原件）或接收人（副本）
+    std::string ids;
+    auto selected = streamQuery("SELECT ds.id FROM document_shares ds INNER JOIN documents d ON d.id = ds.document_id "
+                                "WHERE d.deleted_at IS NOT NULL "
+                                "UNION SELECT ds.id FROM document_shares ds INNER JOIN documents d ON d.id = ds.shared_document_id "
+                                "WHERE d.deleted_at IS NOT NULL "
+                                "UNION SELECT id FROM document_shares WHERE shared_by_user_id IN " + DELETED_USER_IDS +
+                                " UNION SELECT id FROM document_shares WHERE shared_to_user_id IN " + DELETED_USER_IDS +
+                                " LIMIT ?",
+                                [&](SqliteStatement& stmt) { stmt.bind(batchSize); },
+                                [&ids](const SqliteStatement& stmt) {
+                                    ids += (ids.empty() ? "" : ",") + std::to_string(stmt.getInt(0));
+                                    return true;
+                                });
+    if (!selected.success) {
+        return Result<size_t>::Error("查询待清理分享失败: " + selected.message);
+    }
+    if (ids.empty()) {
+        return Result<size_t>::Success(0);
+    }
+
+    // 收件箱中的对应行经外键级联删除
+    return runInTransaction<size_t>([&](SqliteConnection& db) {
+        std::map<int, UsageStats> deltas;
+        if (!collectShareDeltas(db, "id IN (" + ids + ")", deltas)) {
+            return Result<size_t>::Error("统计待清理分享失败: " + db.error());
+        }
+        SqliteStatement stmt(db, "DELETE FROM document_shares WHERE id IN (" + ids + ")");
+        if (!stmt.execute()) {
+            return Result<size_t>::Error("清理分享失败: " + stmt.error());
+        }
+        size_t deleted = static_cast<size_t>(db.changes());
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<size_t>::Error("更新用量统计失败: " + db.error());
+        }
+        return Result<size_t>::Success(deleted);
+    });
+}
+
+Result<PurgeStats> SqliteStorageBackend::purgeBatch(int batchSize, const ObjectRemover& removeObject) {
+    // 先删分享，再删文档与用户：文档或用户行删除时经外键级联的分享会绕过用量统计。
+    // 分享还有积压时本批到此为止，由 purgeDeleted 在批间停顿后继续
+    PurgeStats stats;
+    auto shares = purgeShares(batchSize);
+    if (!shares.success) {
+        return Result<PurgeStats>::Error(shares.message);
+    }
+    stats.shares = shares.data.value();
+    if (stats.shares >= static_cast<size_t>(batchSize)) {
+        return Result<PurgeStats>::Success(stats);
+    }
+
+    // 候选在只读连接上读取：软删除是终态，这些行不会再被修改
+    std::vector<std::pair<int, std::string>> candidates;
+    // 没有对象存储时只取没有文件的文档
+    std::string fileFilter = removeObject ? "" : " AND COALESCE(minio_key, '') = ''";
+    auto selected = streamQuery("SELECT id, minio_key FROM documents "
+                                "WHERE (deleted_at IS NOT NULL OR owner_id IN " + DELETED_USER_IDS + ")" + fileFilter +
+                                " LIMIT ?",
+                                [&](SqliteStatement& stmt) { stmt.bind(batchSize); },
+                                [&candidates](const SqliteStatement& stmt) {
+                                    candidates.emplace_back(stmt.getInt(0), stmt.getString(1));
+                                    return true;
+                                });
+    if (!selected.success) {
+        return Result<PurgeStats>::Error("查询待清理文档失败: " + selected.message);
+    }
+
+    // 文件在事务之外逐个删除，失败的文档保留行等下次重试
+    std::string ids;
+    for (const auto& candidate : candidates) {
+        if (!candidate.second.empty()) {
+            if (!removeObject(candidate.second)) {
+                stats.objectFailures++;
+                continue;
+            }
+            stats.objects++;
+        }
+        ids += (ids.empty() ? "" : ",") + std::to_string(candidate.first);
+    }
+
+    bool documentsDrained = candidates.size() < static_cast<size_t>(batchSize);
+    auto deleted = runInTransaction<PurgeStats>([&](SqliteConnection& db) {
+        PurgeStats rows;
+        // 兜住上一步之后新删除的用户或文档：随文档、用户经外键级联删除的分享先扣统计
+        std::map<int, UsageStats> deltas;
+        if (!ids.empty()) {
+            if (!collectShareDeltas(db, "document_id IN (" + ids + ") OR shared_document_id IN (" + ids + ")", deltas)) {
+                return Result<PurgeStats>::Error("统计待清理分享失败: " + db.error());
+            }
+            SqliteStatement stmt(db, "DELETE FROM documents WHERE id IN (" + ids + ")");
+            if (!stmt.execute()) {
+                return Result<PurgeStats>::Error("清理文档失败: " + stmt.error());
+            }
+            rows.documents = static_cast<size_t>(db.changes());
+        }
+        // 文档不足一批时说明积压已清完，接着删除已没有任何文档的用户
+        if (documentsDrained) {
+            std::string userIds = "SELECT u.id FROM users u WHERE u.deleted_at IS NOT NULL "
+                                  "AND NOT EXISTS (SELECT 1 FROM documents d WHERE d.owner_id = u.id) LIMIT " +
+                                  std::to_string(batchSize);
+            if (!collectShareDeltas(db, "shared_by_user_id IN (" + userIds + ") OR shared_to_user_id IN (" + userIds + ")",
+                                    deltas)) {
+                return Result<PurgeStats>::Error("统计待清理分享失败: " + db.error());
+            }
+            // reconcileUsageStats 之后这些用户可能又有了统计行，一并删除
+            SqliteStatement deleteStats(db, "DELETE FROM usage_stats WHERE owner_id IN (" + userIds + ")");
+            if (!deleteStats.execute()) {
+                return Result<PurgeStats>::Error("清理用户失败: " + deleteStats.error());
+            }
+            SqliteStatement stmt(db, "DELETE FROM users WHERE id IN (" + userIds + ")");
+            if (!stmt.execute()) {
+                return Result<PurgeStats>::Error("清理用户失败: " + stmt.error());
+            }
+            rows.users = static_cast<size_t>(db.changes());
+        }
+        if (!applyStatsDeltas(db, deltas)) {
+            return Result<PurgeStats>::Error("更新用量统计失败: " + db.error());
+        }
+        return Result<PurgeStats>::Success(rows);
+    });
+    if (!deleted.success) {
+        return deleted;
+    }
+
+    stats.documents = deleted.data->documents;
+    stats.users = deleted.data->users;
+    stats.completed = documentsDrained && stats.objectFailures == 0 && stats.users < static_cast<size_t>(batchSize);
+    return Result<PurgeStats>::Success(stats);
+}
+
+Result<PurgeStats> SqliteStorageBackend::purgeDeleted(const PurgeOptions& options, const ObjectRemover& removeObject,
+                                                      const std::function<bool()>& shouldContinue) {
+    if (options.batchSize <= 0) {
+        return Result<PurgeStats>::Error("清理参数无效");
+    }
+    if (inTransaction()) {
+        return Result<PurgeStats>::Error("不能在事务中执行清理");
+    }
+
+    PurgeStats total;
+    auto startTime = std::chrono::steady_clock::now();
+    while (isConnected && (options.maxBatches <= 0 || total.batches < static_cast<size_t>(options.maxBatches))) {
+        if (shouldContinue && !shouldContinue()) {
+            break;
+        }
+        auto batch = purgeBatch(options.batchSize, removeObject);
+        if (!batch.success) {
+            LOG_WARNING("清理中断，已删除文档 " + std::to_string(total.documents) + " 个: " + batch.message);
+            return batch;
+        }
+        const PurgeStats& done = batch.data.value();
+        total.shares += done.shares;
+        total.documents += done.documents;
+        total.objects += done.objects;
+        total.objectFailures += done.objectFailures;
+        total.users += done.users;
+        if (done.shares > 0 || done.documents > 0 || done.users > 0) {
+            total.batches++;
+        }
+        if (done.completed) {
+            total.completed = true;
+            break;
+        }
+        // 整批都是文件删除失败的文档，留到下次运行
+        if (done.shares == 0 && done.documents == 0 && done.users == 0) {
+            break;
+        }
+        // 写连接只有一条，批间停顿让在线写事务插进来
+        if (options.pauseMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.pauseMs));
+        }
+    }
+
+    if (total.shares > 0 || total.documents > 0 || total.users > 0 || total.objectFailures > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        LOG_INFO("清理已删除的分享 " + std::to_string(total.shares) + " 条、文档 " + std::to_string(total.documents) + " 个（文件 " + std::to_string(total.objects) +
+                 " 个，失败 " + std::to_string(total.objectFailures) + " 个）、用户 " + std::to_string(total.users) +
+                 " 个，耗时 " + std::to_string(elapsed.count()) + "ms" + (total.completed ? "" : "，尚未完成"));
+    }
+    return Result<PurgeStats>::Success(total);
+}
+
+bool SqliteStorageBackend::beginTransaction() {
+    if (!isConnected) {
+        return false;
+    }
+    if (inTransaction()) {
+        LOG_WARNING("当前线程已有未结束的事务");
+        return false;
+    }
+
+    lastErrorCode = SQLITE_OK;
+    // 写锁一直持有到提交或回滚，其他线程的写事务在这里排队
+    writerMutex.lock();
+    if (!writer || !writer->exec("BEGIN IMMEDIATE;")) {
+        if (writer) {
+            LOG_WARNING("开启事务失败: " + writer->error());
+        }
+        writerMutex.unlock();
+        return false;
+    }
+    transactionOwner = std::this_thread::get_id();
+    return true;
+}
+
+bool SqliteStorageBackend::commitTransaction() {
+    if (!inTransaction()) {
+        return false;
+    }
+
+    std::vector<std::function<void()>> indexChanges;
+    indexChanges.swap(pendingIndexChanges);
+    savepointMarks.clear();
+
+    bool committed = writer->exec("COMMIT;");
+    if (!committed) {
+        LOG_WARNING("提交事务失败: " + writer->error());
+        writer->exec("ROLLBACK;");
+    }
+    transactionOwner = std::thread::id();
+    writerMutex.unlock();
+
+    if (committed) {
+        // 事务提交后才让索引看到这些变更
+        for (auto& change : indexChanges) {
+            change();
+        }
+    }
+    return committed;
+}
+
+bool SqliteStorageBackend::rollbackTransaction() {
+    if (!inTransaction()) {
+        return false;
+    }
+
+    pendingIndexChanges.clear();
+    savepointMarks.clear();
+    bool rolledBack = writer->exec("ROLLBACK;");
+    transactionOwner = std::thread::id();
+    writerMutex.unlock();
+    return rolledBack;
+}
+
+bool SqliteStorageBackend::createSavepoint(const std::string& name) {
+    if (!inTransaction()) {
+        return false;
+    }
+    if (!writer->exec("SAVEPOINT " + name + ";")) {
+        LOG_WARNING("建立保存点失败: " + writer->error());
+        return false;
+    }
+    savepointMarks.emplace_back(name, pendingIndexChanges.size());
+    return true;
+}
+
+bool SqliteStorageBackend::releaseSavepoint(const std::string& name) {
+    if (!inTransaction()) {
+        return false;
+    }
+    auto mark = std::find_if(savepointMarks.begin(), savepointMarks.end(),
+                             [&name](const std::pair<std::string, size_t>& item) { return item.first == name; });
+    if (mark == savepointMarks.end()) {
+        return false;
+    }
+    // 释放保存点后其中的修改并入外层事务，暂存的索引变更保持不动
+    savepointMarks.erase(mark, savepointMarks.end());
+    return writer->exec("RELEASE SAVEPOINT " + name + ";");
+}
+
+bool SqliteStorageBackend::rollbackToSavepoint(const std::string& name) {
+    if (!inTransaction()) {
+        return false;
+    }
+    auto mark = std::find_if(savepointMarks.begin(), savepointMarks.end(),
+                             [&name](const std::pair<std::string, size_t>& item) { return item.first == name; });
+    if (mark == savepointMarks.end()) {
+        return false;
+    }
+    pendingIndexChanges.resize(std::min(pendingIndexChanges.size(), mark->second));
+    savepointMarks.erase(mark, savepointMarks.end());
+    // ROLLBACK TO 之后保存点仍然存在，再释放掉
+    if (!writer->exec("ROLLBACK TO SAVEPOINT " + name + "; RELEASE SAVEPOINT " + name + ";")) {
+        LOG_WARNING("回滚到保存点失败: " + writer->error());
+        return false;
+    }
+    return true;
+}
+
+bool SqliteStorageBackend::lastErrorRetryable() const {
+    int primary = lastErrorCode & 0xff;
+    return primary == SQLITE_BUSY || primary == SQLITE_LOCKED;
+}
+
+Result<bool> SqliteStorageBackend::vacuum() {
+    if (inTransaction()) {
+        return Result<bool>::Error("事务中不能执行 VACUUM");
+    }
+    if (!isConnected) {
+        return Result<bool>::Error("数据库未连接");
+    }
+
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (!writer || !writer->exec("VACUUM; PRAGMA optimize;")) {
+        return Result<bool>::Error("VACUUM 失败: " + (writer ? writer->error() : std::string("数据库未连接")));
+    }
+    return Result<bool>::Success(true, "VACUUM 完成");
+}
+
+Result<QueryResult> SqliteStorageBackend::executeQuery(const std::string& query) {
+    // 只读语句在只读连接上执行，其余语句进入写事务
+    auto run = [&query](SqliteConnection& db) {
+        sqlite3_stmt* raw = nullptr;
+        if (sqlite3_prepare_v2(db.get(), query.c_str(), static_cast<int>(query.size()), &raw, nullptr) != SQLITE_OK) {
+            std::string message = sqlite3_errmsg(db.get());
+            sqlite3_finalize(raw);
+            return Result<QueryResult>::Error("执行查询失败: " + message);
+        }
+        std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)> stmt(raw, &sqlite3_finalize);
+
+        QueryResult result;
+        int columns = sqlite3_column_count(stmt.get());
+        if (columns > 0) {
+            std::vector<std::string> names;
+            names.reserve(columns);
+            for (int i = 0; i < columns; ++i) {
+                names.emplace_back(sqlite3_column_name(stmt.get(), i));
+            }
+            result.setColumns(std::move(names));
+        }
+
+        int rc;
+        while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+            for (int i = 0; i < columns; ++i) {
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), i));
+                result.appendCell(text, text ? static_cast<size_t>(sqlite3_column_bytes(stmt.get(), i)) : 0);
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            lastErrorCode = sqlite3_extended_errcode(db.get());
+            return Result<QueryResult>::Error("执行查询失败: " + std::string(sqlite3_errmsg(db.get())));
+        }
+        if (columns == 0) {
+            result.setModification(static_cast<uint64_t>(db.changes()), static_cast<uint64_t>(db.lastInsertId()));
+        }
+        return Result<QueryResult>::Success(result);
+    };
+
+    if (!inTransaction()) {
+        auto conn = acquireReader();
+        if (!conn) {
+            return Result<QueryResult>::Error("数据库未连接");
+        }
+        sqlite3_stmt* probe = nullptr;
+        bool readOnly = sqlite3_prepare_v2((*conn).get(), query.c_str(), static_cast<int>(query.size()), &probe, nullptr) == SQLITE_OK &&
+                        probe && sqlite3_stmt_readonly(probe);
+        sqlite3_finalize(probe);
+        if (readOnly) {
+            return run(*conn);
+        }
+    }
+    return runInTransaction<QueryResult>(run);
+}
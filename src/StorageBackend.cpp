@@ -0,0 +1,86 @@
+#include "StorageBackend.h"
+
+namespace {
+    thread_local CallDeadline* currentCall = nullptr;
+}
+
+std::string encodePageToken(const std::string& createdAt, long long id) {
+    static const char* digits = "0123456789abcdef";
+    std::string raw = createdAt + "#" + std::to_string(id);
+    std::string token;
+    token.reserve(raw.size() * 2);
+    for (unsigned char c : raw) {
+        token.push_back(digits[c >> 4]);
+        token.push_back(digits[c & 0x0f]);
+    }
+    return token;
+}
+
+bool decodePageToken(const std::string& token, std::string& createdAt, long long& id) {
+    if (token.empty() || token.size() % 2 != 0) {
+        return false;
+    }
+    std::string raw;
+    raw.reserve(token.size() / 2);
+    auto hexValue = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < token.size(); i += 2) {
+        int hi = hexValue(token[i]);
+        int lo = hexValue(token[i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        raw.push_back(static_cast<char>((hi << 4) | lo));
+    }
+
+    static const std::regex pattern(R"(^(\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2})#(\d+)$)");
+    std::smatch match;
+    if (!std::regex_match(raw, match, pattern)) {
+        return false;
+    }
+    createdAt = match[1];
+    id = std::stoll(match[2]);
+    return true;
+}
+
+std::string escapeLikePattern(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '%' || c == '_' || c == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+CallDeadline::CallDeadline(Clock::time_point deadline, std::function<bool()> isCancelled)
+        : deadline(deadline), isCancelled(std::move(isCancelled)), outer(currentCall) {
+    currentCall = this;
+}
+
+CallDeadline::~CallDeadline() {
+    currentCall = outer;
+}
+
+bool CallDeadline::interrupted() {
+    const CallDeadline* call = currentCall;
+    if (!call) {
+        return false;
+    }
+    return Clock::now() >= call->deadline || (call->isCancelled && call->isCancelled());
+}
+
+long long CallDeadline::remainingMs() {
+    const CallDeadline* call = currentCall;
+    if (!call || call->deadline == Clock::time_point::max()) {
+        return -1;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(call->deadline - Clock::now()).count();
+    return remaining > 0 ? remaining : 0;
+}
@@ -0,0 +1,462 @@
+#include "StorageBenchmark.h"
+#include "QueryStats.h"
+#include "TransactionScope.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace {
+    // 标题与描述用的词表；搜索压测从中取词，保证命中数与数据规模成正比
+    const char* const WORDS[] = {
+        "合同", "报告", "预算", "会议", "纪要", "方案", "设计", "需求", "测试", "发布",
+        "invoice", "report", "budget", "design", "release", "roadmap", "draft", "summary", "archive", "review"
+    };
+    const size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+    const char* const CONTENT_TYPES[] = {"pdf", "docx", "xlsx", "txt", "png", "zip"};
+    const size_t CONTENT_TYPE_COUNT = sizeof(CONTENT_TYPES) / sizeof(CONTENT_TYPES[0]);
+
+    // 各标准库的 std::uniform_int_distribution 实现不同，同一种子会得到不同序列；
+    // 直接对引擎输出取模（mt19937 系列的输出由标准规定），数据集在各平台上一致
+    size_t pick(std::mt19937_64& rng, size_t n) {
+        return static_cast<size_t>(rng() % n);
+    }
+
+    std::string randomTitle(std::mt19937_64& rng, size_t index) {
+        return std::string(WORDS[pick(rng, WORD_COUNT)]) + " " + WORDS[pick(rng, WORD_COUNT)] + " " +
+               std::to_string(index);
+    }
+
+    std::string formatMicros(uint64_t micros) {
+        std::ostringstream out;
+        if (micros >= 1000) {
+            out << std::fixed << std::setprecision(1) << micros / 1000.0 << "ms";
+        } else {
+            out << micros << "us";
+        }
+        return out.str();
+    }
+
+    const size_t SHARE_CHUNK = 500;
+    const auto WARMUP = std::chrono::milliseconds(200);
+}
+
+StorageBenchmark::StorageBenchmark(StorageBackend* backend, const BenchmarkOptions& options)
+        : backend(backend), options(options) {
+}
+
+Result<std::vector<BenchmarkResult>> StorageBenchmark::run(const std::function<void(const std::string&)>& progress) {
+    auto report = [&](const std::string& text) {
+        LOG_INFO("基准测试: " + text);
+        if (progress) {
+            progress(text);
+        }
+    };
+
+    if (!backend || !backend->isConnectionValid()) {
+        return Result<std::vector<BenchmarkResult>>::Error("存储后端未连接");
+    }
+    if (options.users < 2 || options.documents < 1 || options.maxThreads < 1 || options.durationMs < 1) {
+        return Result<std::vector<BenchmarkResult>>::Error("基准测试参数无效：至少需要 2 个用户、1 个文档、1 个线程");
+    }
+
+    auto seeded = seedData(report);
+    if (!seeded.success) {
+        cleanup(report);
+        return Result<std::vector<BenchmarkResult>>::Error(seeded.message);
+    }
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < options.maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(options.maxThreads);
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& item : operations()) {
+        for (int threads : threadCounts) {
+            report(item.first + "，" + std::to_string(threads) + " 线程");
+            results.push_back(measure(item.first, item.second, threads));
+        }
+    }
+
+    if (!options.keepData) {
+        cleanup(report);
+    }
+    return Result<std::vector<BenchmarkResult>>::Success(results, "基准测试完成");
+}
+
+Result<bool> StorageBenchmark::seedData(const std::function<void(const std::string&)>& progress) {
+    const std::string prefix = "bench_" + std::to_string(options.seed) + "_";
+    auto existing = backend->getUserByUsername(prefix + "0");
+    if (existing.success && existing.data.has_value()) {
+        return Result<bool>::Error("目标库中已有种子 " + std::to_string(options.seed) +
+                                   " 生成的数据，请先删除 " + prefix + "* 用户或换一个种子");
+    }
+
+    std::mt19937_64 rng(options.seed);
+    auto started = std::chrono::steady_clock::now();
+
+    // 用户：密码哈希取固定值，生成阶段不在哈希上耗时
+    std::vector<User> users;
+    users.reserve(options.users);
+    std::string passwordHash = Utils::sha256Hash(prefix);
+    for (int i = 0; i < options.users; ++i) {
+        User user;
+        user.id = 0;
+        user.username = prefix + std::to_string(i);
+        user.password_hash = passwordHash;
+        user.email = user.username + "@bench.local";
+        user.is_active = true;
+        users.push_back(user);
+        usernames.push_back(user.username);
+    }
+    progress("生成 " + std::to_string(users.size()) + " 个用户");
+    auto userResult = backend->createUsersBatch(users);
+    if (!userResult.success || !userResult.data.has_value()) {
+        return Result<bool>::Error("创建测试用户失败: " + userResult.message);
+    }
+    userIds = userResult.data.value();
+
+    // 文档：所有者按平方分布偏斜，少数用户拥有大部分文档，接近真实的长尾
+    std::vector<Document> batch;
+    batch.reserve(options.documents);
+    for (int i = 0; i < options.documents; ++i) {
+        uint64_t u = pick(rng, userIds.size());
+        Document doc;
+        doc.id = 0;
+        doc.title = randomTitle(rng, i);
+        doc.description = std::string(WORDS[pick(rng, WORD_COUNT)]) + " " + WORDS[pick(rng, WORD_COUNT)];
+        doc.content_type = CONTENT_TYPES[pick(rng, CONTENT_TYPE_COUNT)];
+        doc.file_path = doc.title + "." + doc.content_type;
+        doc.minio_key = prefix + "doc_" + std::to_string(i);
+        doc.owner_id = userIds[static_cast<size_t>(u * u / userIds.size())];
+        doc.file_size = 1024 + pick(rng, 8 * 1024 * 1024);
+        batch.push_back(doc);
+    }
+    progress("生成 " + std::to_string(batch.size()) + " 个文档");
+    auto docResult = backend->createDocumentsBatch(batch);
+    if (!docResult.success || !docResult.data.has_value()) {
+        return Result<bool>::Error("创建测试文档失败: " + docResult.message);
+    }
+    const std::vector<int>& docIds = docResult.data.value();
+    for (size_t i = 0; i < batch.size() && i < docIds.size(); ++i) {
+        batch[i].id = docIds[i];
+    }
+    documents = batch;
+
+    // 分享：随机 (文档, 接收者) 对，去掉重复和分享给自己的；每条分享对应接收者名下的一份副本
+    std::set<std::pair<size_t, int>> chosen;
+    for (int attempt = 0; static_cast<int>(chosen.size()) < options.shares && attempt < options.shares * 4; ++attempt) {
+        size_t docIndex = pick(rng, documents.size());
+        int toUserId = userIds[pick(rng, userIds.size())];
+        if (toUserId != documents[docIndex].owner_id) {
+            chosen.insert(std::make_pair(docIndex, toUserId));
+        }
+    }
+    shares.assign(chosen.begin(), chosen.end());
+    if (shares.empty()) {
+        return Result<bool>::Success(true, "测试数据已生成");
+    }
+
+    std::vector<Document> copies;
+    copies.reserve(shares.size());
+    for (size_t i = 0; i < shares.size(); ++i) {
+        Document copy = documents[shares[i].first];
+        copy.owner_id = shares[i].second;
+        copy.minio_key = prefix + "share_" + std::to_string(i);
+        copies.push_back(copy);
+    }
+    progress("生成 " + std::to_string(shares.size()) + " 条分享");
+    auto copyResult = backend->createDocumentsBatch(copies);
+    if (!copyResult.success || !copyResult.data.has_value()) {
+        return Result<bool>::Error("创建分享副本失败: " + copyResult.message);
+    }
+    const std::vector<int> copyIds = copyResult.data.value();
+
+    for (size_t begin = 0; begin < shares.size() && begin < copyIds.size(); begin += SHARE_CHUNK) {
+        size_t end = std::min(std::min(shares.size(), copyIds.size()), begin + SHARE_CHUNK);
+        auto chunk = runTransaction<bool>(backend, "benchmarkSeed", [&]() {
+            for (size_t i = begin; i < end; ++i) {
+                const Document& doc = documents[shares[i].first];
+                auto share = backend->createDocumentShare(doc.id, doc.owner_id, shares[i].second,
+                                                          copyIds[i], copies[i].minio_key);
+                if (!share.success) {
+                    return Result<bool>::Error("创建分享失败: " + share.message);
+                }
+            }
+            return Result<bool>::Success(true, "");
+        });
+        if (!chunk.success) {
+            return chunk;
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    progress("测试数据已生成，耗时 " + std::to_string(elapsed.count()) + "ms");
+    return Result<bool>::Success(true, "测试数据已生成");
+}
+
+void StorageBenchmark::cleanup(const std::function<void(const std::string&)>& progress) {
+    if (userIds.empty()) {
+        return;
+    }
+    // 删除用户是软删除，压测中 createDocument 产生的文档也随用户一起不可见
+    size_t failed = 0;
+    for (int userId : userIds) {
+        if (!backend->deleteUser(userId).success) {
+            failed++;
+        }
+    }
+    userIds.clear();
+
+    // 随后立即清理，释放用户名以便同一种子再次运行。测试文档的对象键没有对应文件，直接视为已删除；
+    // 其他待清理数据的文件删不掉，行会保留给后台清理线程
+    const std::string prefix = "bench_" + std::to_string(options.seed) + "_";
+    PurgeOptions purgeOptions;
+    purgeOptions.batchSize = 1000;
+    purgeOptions.pauseMs = 0;
+    purgeOptions.maxBatches = 0;
+    auto purged = backend->purgeDeleted(purgeOptions, [&prefix](const std::string& key) {
+        return key.compare(0, prefix.size(), prefix) == 0;
+    });
+    progress("已删除测试数据" + (failed > 0 ? "，" + std::to_string(failed) + " 个用户删除失败" : std::string()) +
+             (purged.success ? "" : "，清理失败: " + purged.message));
+}
+
+std::vector<std::pair<std::string, StorageBenchmark::Operation>> StorageBenchmark::operations() {
+    std::vector<std::pair<std::string, Operation>> ops;
+    const std::string prefix = "bench_" + std::to_string(options.seed) + "_";
+
+    ops.emplace_back("getUserById", [this](std::mt19937_64& rng) {
+        return backend->getUserById(userIds[pick(rng, userIds.size())]).success;
+    });
+    ops.emplace_back("getUserByUsername", [this](std::mt19937_64& rng) {
+        return backend->getUserByUsername(usernames[pick(rng, usernames.size())]).success;
+    });
+    ops.emplace_back("getDocumentById", [this](std::mt19937_64& rng) {
+        return backend->getDocumentById(documents[pick(rng, documents.size())].id).success;
+    });
+    ops.emplace_back("getDocumentsByOwnerPage", [this](std::mt19937_64& rng) {
+        return backend->getDocumentsByOwnerPage(userIds[pick(rng, userIds.size())], 20).success;
+    });
+    ops.emplace_back("getAllDocumentsPage", [this](std::mt19937_64& rng) {
+        // 先取第一页，再随机翻到下一页，覆盖带令牌的查询
+        auto page = backend->getAllDocumentsPage(20);
+        if (!page.success || !page.data.has_value()) {
+            return false;
+        }
+        if (pick(rng, 2) == 0 || page.data->nextPageToken.empty()) {
+            return true;
+        }
+        return backend->getAllDocumentsPage(20, page.data->nextPageToken).success;
+    });
+    if (!shares.empty()) {
+        ops.emplace_back("getSharedDocumentsPage", [this](std::mt19937_64& rng) {
+            return backend->getSharedDocumentsPage(shares[pick(rng, shares.size())].second, 20).success;
+        });
+        ops.emplace_back("isDocumentShared", [this](std::mt19937_64& rng) {
+            const auto& share = shares[pick(rng, shares.size())];
+            const Document& doc = documents[share.first];
+            return backend->isDocumentShared(doc.id, doc.owner_id, share.second).success;
+        });
+    }
+    ops.emplace_back("searchDocuments", [this](std::mt19937_64& rng) {
+        return backend->searchDocuments(WORDS[pick(rng, WORD_COUNT)], 20).success;
+    });
+    ops.emplace_back("getUsageStats", [this](std::mt19937_64& rng) {
+        return backend->getUsageStats(userIds[pick(rng, userIds.size())]).success;
+    });
+    ops.emplace_back("updateDocument", [this](std::mt19937_64& rng) {
+        Document doc = documents[pick(rng, documents.size())];
+        doc.description = std::string(WORDS[pick(rng, WORD_COUNT)]) + " " + std::to_string(rng() % 100000);
+        return backend->updateDocument(doc).success;
+    });
+    ops.emplace_back("createDocument", [this, prefix](std::mt19937_64& rng) {
+        // 写入的文档归测试用户所有，清理时随用户一起删除
+        uint64_t n = rng();
+        int ownerId = userIds[static_cast<size_t>(n % userIds.size())];
+        std::string title = randomTitle(rng, static_cast<size_t>(n % 1000000));
+        return backend->createDocument(title, "", title + ".txt", prefix + "new_" + std::to_string(n),
+                                       ownerId, 1024, "txt").success;
+    });
+    return ops;
+}
+
+BenchmarkResult StorageBenchmark::measure(const std::string& name, const Operation& operation, int threads) {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> errors{0};
+    std::atomic<bool> measuring{false};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            // 每个线程的随机序列由种子和线程序号决定，重复运行时访问模式一致
+            std::mt19937_64 rng(options.seed + 7919ULL * static_cast<uint64_t>(t + 1));
+            while (!stop.load()) {
+                auto begin = std::chrono::steady_clock::now();
+                bool ok = false;
+                try {
+                    ok = operation(rng);
+                } catch (const std::exception& e) {
+                    LOG_WARNING("基准测试 " + name + " 抛出异常: " + std::string(e.what()));
+                }
+                if (!measuring.load()) {
+                    continue;
+                }
+                latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - begin).count()));
+                if (!ok) {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    // 预热阶段的调用不计入：连接池建连、语句预处理、缓冲池加载都发生在这里
+    std::this_thread::sleep_for(WARMUP);
+    measuring = true;
+    auto started = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.durationMs));
+    measuring = false;
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    BenchmarkResult result;
+    result.operation = name;
+    result.threads = threads;
+    result.operations = latency.count();
+    result.errors = errors;
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    result.opsPerSecond = seconds > 0 ? static_cast<double>(result.operations) / seconds : 0;
+    result.p50Micros = latency.percentile(0.5);
+    result.p99Micros = latency.percentile(0.99);
+    result.maxMicros = latency.max();
+    return result;
+}
+
+std::string StorageBenchmark::formatTable(const std::vector<BenchmarkResult>& results,
+                                          const std::vector<BenchmarkResult>& baseline) {
+    std::ostringstream out;
+    out << std::left << std::setw(26) << "方法" << std::right
+        << std::setw(6) << "线程" << std::setw(10) << "次数" << std::setw(8) << "失败"
+        << std::setw(12) << "ops/s" << std::setw(9) << "加速比"
+        << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "max";
+    if (!baseline.empty()) {
+        out << std::setw(12) << "对比基线";
+    }
+    out << "\n";
+
+    for (const auto& result : results) {
+        // 加速比相对同一方法的单线程吞吐
+        double single = 0;
+        for (const auto& other : results) {
+            if (other.operation == result.operation && other.threads == 1) {
+                single = other.opsPerSecond;
+            }
+        }
+        std::ostringstream speedup;
+        if (single > 0) {
+            speedup << std::fixed << std::setprecision(2) << result.opsPerSecond / single << "x";
+        } else {
+            speedup << "-";
+        }
+
+        out << std::left << std::setw(26) << result.operation << std::right
+            << std::setw(6) << result.threads << std::setw(10) << result.operations << std::setw(8) << result.errors
+            << std::setw(12) << std::fixed << std::setprecision(1) << result.opsPerSecond
+            << std::setw(9) << speedup.str()
+            << std::setw(10) << formatMicros(result.p50Micros) << std::setw(10) << formatMicros(result.p99Micros)
+            << std::setw(10) << formatMicros(result.maxMicros);
+
+        if (!baseline.empty()) {
+            auto match = std::find_if(baseline.begin(), baseline.end(), [&](const BenchmarkResult& base) {
+                return base.operation == result.operation && base.threads == result.threads;
+            });
+            std::ostringstream change;
+            if (match != baseline.end() && match->opsPerSecond > 0) {
+                double percent = (result.opsPerSecond / match->opsPerSecond - 1.0) * 100.0;
+                change << std::showpos << std::fixed << std::setprecision(1) << percent << "%";
+            } else {
+                change << "-";
+            }
+            out << std::setw(12) << change.str();
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+Result<bool> StorageBenchmark::writeJson(const std::vector<BenchmarkResult>& results, const std::string& path) const {
+    json root;
+    root["backend"] = backend ? backend->backendName() : "";
+    root["timestamp"] = Utils::getCurrentTimestamp();
+    root["options"]["users"] = options.users;
+    root["options"]["documents"] = options.documents;
+    root["options"]["shares"] = options.shares;
+    root["options"]["seed"] = options.seed;
+    root["options"]["max_threads"] = options.maxThreads;
+    root["options"]["duration_ms"] = options.durationMs;
+
+    json items = json::array();
+    for (const auto& result : results) {
+        json item;
+        item["operation"] = result.operation;
+        item["threads"] = result.threads;
+        item["operations"] = result.operations;
+        item["errors"] = result.errors;
+        item["ops_per_second"] = result.opsPerSecond;
+        item["p50_us"] = result.p50Micros;
+        item["p99_us"] = result.p99Micros;
+        item["max_us"] = result.maxMicros;
+        items.push_back(item);
+    }
+    root["results"] = items;
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return Result<bool>::Error("无法创建文件: " + path);
+    }
+    file << root.dump(2) << "\n";
+    if (!file.good()) {
+        return Result<bool>::Error("写入文件失败: " + path);
+    }
+    return Result<bool>::Success(true, "基准测试结果已写入 " + path);
+}
+
+Result<std::vector<BenchmarkResult>> StorageBenchmark::readJson(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return Result<std::vector<BenchmarkResult>>::Error("无法打开文件: " + path);
+    }
+
+    try {
+        json root;
+        file >> root;
+        std::vector<BenchmarkResult> results;
+        for (const auto& item : root.at("results")) {
+            BenchmarkResult result;
+            result.operation = item.at("operation").get<std::string>();
+            result.threads = item.at("threads").get<int>();
+            result.operations = item.value("operations", uint64_t(0));
+            result.errors = item.value("errors", uint64_t(0));
+            result.opsPerSecond = item.value("ops_per_second", 0.0);
+            result.p50Micros = item.value("p50_us", uint64_t(0));
+            result.p99Micros = item.value("p99_us", uint64_t(0));
+            result.maxMicros = item.value("max_us", uint64_t(0));
+            results.push_back(result);
+        }
+        return Result<std::vector<BenchmarkResult>>::Success(results, "已读取基线");
+    } catch (const std::exception& e) {
+        return Result<std::vector<BenchmarkResult>>::Error("解析基线文件失败: " + std::string(e.what()));
+    }
+}
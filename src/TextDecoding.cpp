@@ -0,0 +1,87 @@
+#include "TextDecoding.h"
+#include <ctime>
+
+namespace {
+    // 公历日期到 1970-01-01 的天数（proleptic Gregorian，适用于任意年份）
+    long long daysFromCivil(int year, unsigned month, unsigned day) {
+        year -= month <= 2 ? 1 : 0;
+        const long long era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<long long>(doe) - 719468;
+    }
+
+    // 某个本地整点相对 UTC 的偏移（秒），直接映射缓存；夏令时切换也以整点为界
+    struct OffsetSlot {
+        long long hourKey = 0;
+        long long offset = 0;
+        bool valid = false;
+    };
+    const size_t OFFSET_CACHE_SLOTS = 256;
+
+    long long localOffsetForHour(long long hourKey, int year, unsigned month, unsigned day, unsigned hour) {
+        thread_local OffsetSlot slots[OFFSET_CACHE_SLOTS];
+        OffsetSlot& slot = slots[static_cast<size_t>(hourKey) % OFFSET_CACHE_SLOTS];
+        if (slot.valid && slot.hourKey == hourKey) {
+            return slot.offset;
+        }
+
+        std::tm tm = {};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = static_cast<int>(month) - 1;
+        tm.tm_mday = static_cast<int>(day);
+        tm.tm_hour = static_cast<int>(hour);
+        tm.tm_isdst = -1;
+        std::time_t utc = std::mktime(&tm);
+
+        slot.hourKey = hourKey;
+        slot.offset = hourKey * 3600 - static_cast<long long>(utc);
+        slot.valid = true;
+        return slot.offset;
+    }
+
+    // 固定位置上的两位/四位数字
+    bool readDigits(const char* p, size_t count, unsigned& value) {
+        value = 0;
+        for (size_t i = 0; i < count; ++i) {
+            unsigned digit = static_cast<unsigned>(p[i] - '0');
+            if (digit > 9) {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        return true;
+    }
+}
+
+std::chrono::system_clock::time_point localDateTimeToTimePoint(int year, unsigned month, unsigned day,
+                                                               unsigned hour, unsigned minute, unsigned second) {
+    long long hourKey = daysFromCivil(year, month, day) * 24 + hour;
+    long long offset = localOffsetForHour(hourKey, year, month, day, hour);
+    long long seconds = hourKey * 3600 + minute * 60 + second - offset;
+    return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+}
+
+bool parseDateTime(std::string_view text, std::chrono::system_clock::time_point& out) {
+    // YYYY-MM-DD HH:MM:SS，小数秒部分忽略
+    if (text.size() < 19) {
+        return false;
+    }
+    const char* p = text.data();
+    if (p[4] != '-' || p[7] != '-' || (p[10] != ' ' && p[10] != 'T') || p[13] != ':' || p[16] != ':') {
+        return false;
+    }
+
+    unsigned year, month, day, hour, minute, second;
+    if (!readDigits(p, 4, year) || !readDigits(p + 5, 2, month) || !readDigits(p + 8, 2, day) ||
+        !readDigits(p + 11, 2, hour) || !readDigits(p + 14, 2, minute) || !readDigits(p + 17, 2, second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    out = localDateTimeToTimePoint(static_cast<int>(year), month, day, hour, minute, second);
+    return true;
+}
@@ -0,0 +1,111 @@
+#include "TransactionScope.h"
+#include <atomic>
+#include <random>
+
+namespace {
+    // 当前线程的保存点嵌套深度，用于生成唯一的保存点名
+    thread_local int savepointDepth = 0;
+
+    std::atomic<uint64_t> committedCount{0};
+    std::atomic<uint64_t> rolledBackCount{0};
+    std::atomic<uint64_t> retryCount{0};
+    std::atomic<uint64_t> totalMicros{0};
+    std::atomic<uint64_t> maxMicros{0};
+
+    const auto SLOW_TRANSACTION = std::chrono::seconds(1);
+}
+
+TransactionScope::TransactionScope(StorageBackend* backend, const std::string& name)
+        : backend(backend), name(name), nested(false), active(false), startTime(std::chrono::steady_clock::now()) {
+    if (!backend) {
+        return;
+    }
+
+    if (backend->inTransaction()) {
+        nested = true;
+        std::string candidate = "sp_" + std::to_string(savepointDepth + 1);
+        if (backend->createSavepoint(candidate)) {
+            savepoint = candidate;
+            savepointDepth++;
+            active = true;
+        }
+        return;
+    }
+    active = backend->beginTransaction();
+}
+
+TransactionScope::~TransactionScope() {
+    if (active) {
+        rollback();
+    }
+}
+
+bool TransactionScope::commit() {
+    if (!active) {
+        return false;
+    }
+    // 提交失败时后端已经回滚并结束事务，这里不再回滚
+    bool committed = nested ? backend->releaseSavepoint(savepoint) : backend->commitTransaction();
+    finish(committed);
+    return committed;
+}
+
+bool TransactionScope::rollback() {
+    if (!active) {
+        return false;
+    }
+    bool rolledBack = nested ? backend->rollbackToSavepoint(savepoint) : backend->rollbackTransaction();
+    finish(false);
+    return rolledBack;
+}
+
+void TransactionScope::finish(bool committed) {
+    active = false;
+    if (nested) {
+        savepointDepth--;
+        return;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    (committed ? committedCount : rolledBackCount)++;
+    totalMicros += micros;
+    uint64_t previousMax = maxMicros.load();
+    while (micros > previousMax && !maxMicros.compare_exchange_weak(previousMax, micros)) {
+    }
+
+    std::string summary = "事务 " + name + (committed ? " 已提交" : " 已回滚") + "，耗时 " +
+                          std::to_string(micros / 1000) + "." + std::to_string(micros % 1000 / 100) + "ms";
+    if (elapsed >= SLOW_TRANSACTION) {
+        LOG_WARNING("慢" + summary);
+    } else {
+        LOG_DEBUG(summary);
+    }
+}
+
+std::chrono::milliseconds transactionBackoff(int attempt, const TransactionRetryOptions& options) {
+    thread_local std::mt19937 generator(std::random_device{}());
+
+    long long cap = std::max<long long>(1, options.baseBackoff.count());
+    for (int i = 1; i < attempt && cap < options.maxBackoff.count(); ++i) {
+        cap *= 2;
+    }
+    cap = std::min<long long>(cap, std::max<long long>(1, options.maxBackoff.count()));
+    // 完全抖动：冲突的几个事务各自随机错开，而不是同时醒来再次相撞
+    std::uniform_int_distribution<long long> distribution(0, cap);
+    return std::chrono::milliseconds(distribution(generator));
+}
+
+void recordTransactionRetry() {
+    retryCount++;
+}
+
+TransactionStats getTransactionStats() {
+    TransactionStats stats;
+    stats.committed = committedCount;
+    stats.rolledBack = rolledBackCount;
+    stats.retries = retryCount;
+    stats.totalMicros = totalMicros;
+    stats.maxMicros = maxMicros;
+    return stats;
+}
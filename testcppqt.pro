@@ -23,6 +23,7 @@ VCPKG_LIB = D:/vcpkg/vcpkg/installed/x64-windows/lib
 INCLUDEPATH += $$VCPKG_INC
 LIBS += \
     $$VCPKG_LIB/libmariadb.lib \
+    $$VCPKG_LIB/sqlite3.lib \
     $$VCPKG_LIB/libssl.lib \
     $$VCPKG_LIB/libcrypto.lib \
     $$VCPKG_LIB/zlib.lib \
@@ -48,8 +49,25 @@ SOURCES += \
     mainwindow.cpp \
     ChangePasswordDialog.cpp \
     src/AuthManager.cpp \
+    src/StorageBackend.cpp \
+    src/QueryStats.cpp \
+    src/TransactionScope.cpp \
     src/DatabaseManager.cpp \
+    src/SqliteStorageBackend.cpp \
+    src/StorageBenchmark.cpp \
+    src/MySqlConnectionPool.cpp \
+    src/PreparedStatementCache.cpp \
+    src/RowDecoder.cpp \
+    src/QueryResult.cpp \
+    src/TextDecoding.cpp \
+    src/DocumentSearchIndex.cpp \
+    src/AsyncDatabaseManager.cpp \
+    src/RedisConnectionPool.cpp \
+    src/RedisAsyncClient.cpp \
     src/RedisManager.cpp \
+    src/RespBenchmark.cpp \
+    src/RowDecodeBenchmark.cpp \
+    src/RespParser.cpp \
     src/MinioClient.cpp \
     src/CLIHandler.cpp \
     src/Logger.cpp \
@@ -69,11 +87,28 @@ HEADERS += \
     include/CLIHandler.h \
     include/Common.h \
     include/ConfigManager.h \
+    include/StorageBackend.h \
+    include/QueryStats.h \
+    include/TransactionScope.h \
     include/DatabaseManager.h \
+    include/SqliteStorageBackend.h \
+    include/StorageBenchmark.h \
+    include/MySqlConnectionPool.h \
+    include/PreparedStatementCache.h \
+    include/RowDecoder.h \
+    include/QueryResult.h \
+    include/TextDecoding.h \
+    include/DocumentSearchIndex.h \
+    include/AsyncDatabaseManager.h \
     include/ImportExportManager.h \
     include/Logger.h \
     include/MinioClient.h \
+    include/RedisConnectionPool.h \
+    include/RedisAsyncClient.h \
     include/RedisManager.h \
+    include/RespBenchmark.h \
+    include/RowDecodeBenchmark.h \
+    include/RespParser.h \
     include/linenoise.h \
     include/DocListDialog.h \
     mainwindow.h \